@@ -37,7 +37,9 @@
 #include <time.h>
 #include <theia/theia.h>
 #include <chrono>  // NOLINT
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "applications/command_line_helpers.h"
@@ -60,6 +62,10 @@ DEFINE_string(
 // Multithreading.
 DEFINE_int32(num_threads, 1,
              "Number of threads to use for feature extraction and matching.");
+DEFINE_int32(random_seed, -1,
+             "Seed for the random numbers used in matching and reconstruction. "
+             "Runs with the same non-negative seed produce the same results. "
+             "If negative, the random numbers are seeded from the time.");
 
 // Feature and matching options.
 DEFINE_string(
@@ -90,8 +96,28 @@ DEFINE_int32(min_num_inliers_for_valid_match, 30,
              "match.");
 DEFINE_bool(bundle_adjust_two_view_geometry, true,
             "Set to false to turn off 2-view BA.");
+DEFINE_bool(use_sampson_two_view_refinement, true,
+            "Refine the 2-view geometry with a lightweight Sampson error "
+            "minimization instead of a full Ceres BA.");
+DEFINE_bool(defer_cheirality_checks, false,
+            "Score the 2-view RANSAC hypotheses with the Sampson error alone "
+            "and only check the cheirality of the final model's inliers.");
 DEFINE_bool(keep_only_symmetric_matches, true,
             "Performs two-way matching and keeps symmetric matches.");
+DEFINE_bool(perform_guided_matching, false,
+            "Match the unmatched features again along the epipolar lines of "
+            "the verified two-view geometry.");
+DEFINE_bool(select_image_pairs_with_global_descriptors, false,
+            "Only match each image to its most similar images according to a "
+            "global (VLAD) image descriptor instead of matching all pairs.");
+DEFINE_int32(num_nearest_neighbors_for_global_descriptors, 50,
+             "Number of most similar images each image is matched to if "
+             "--select_image_pairs_with_global_descriptors is set.");
+DEFINE_string(exhaustive_matches_file, "",
+              "Matches file of an exhaustive matching of the same images. If "
+              "set along with --select_image_pairs_with_global_descriptors, "
+              "the recall of the image pairs verified in the "
+              "--output_matches_file w.r.t. this file is logged.");
 
 // Reconstruction building options.
 DEFINE_string(reconstruction_estimator, "GLOBAL",
@@ -156,6 +182,19 @@ DEFINE_int32(partial_bundle_adjustment_num_views, 20,
              "When full BA is not being run, partial BA is executed on a "
              "constant number of views specified by this parameter.");
 
+// Hierarchical SfM options.
+DEFINE_int32(hierarchical_max_num_views_per_cluster, 500,
+             "The view graph is partitioned into clusters with at most this "
+             "many views for hierarchical SfM.");
+DEFINE_double(hierarchical_cluster_overlap_ratio, 0.1,
+              "Fraction of views from neighboring clusters that are added to "
+              "each cluster so that clusters can be merged.");
+DEFINE_int32(hierarchical_min_num_overlapping_views, 10,
+             "Minimum number of views from neighboring clusters that are added "
+             "to each cluster.");
+DEFINE_bool(hierarchical_bundle_adjust_all_views_after_merging, false,
+            "Set to true to run full BA after merging the clusters instead of "
+            "only optimizing the views shared between clusters.");
 
 // Triangulation options.
 DEFINE_double(min_triangulation_angle_degrees, 4.0,
@@ -192,6 +231,28 @@ DEFINE_double(sift_peak_threshold, 1.7f,
               "responses. Increase threshold value to reduce the number of "
               "keypoints");
 DEFINE_bool(root_sift, true, "Enables the usage of Root SIFT.");
+DEFINE_int32(sift_num_threads, 1,
+             "Number of threads used to extract the SIFT features of a single "
+             "large image in tiles. This is mostly useful for very large "
+             "images such as panoramas, and is only used if --num_threads=1 "
+             "since the images are otherwise extracted in parallel.");
+DEFINE_int32(max_image_dimension, 0,
+             "If positive, images are downscaled when decoding such that their "
+             "larger dimension is at most this many pixels. Set to 0 to "
+             "extract features at the full resolution.");
+DEFINE_bool(extract_keypoint_colors, false,
+            "Record the colors of the keypoints during feature extraction and "
+            "color the reconstructions with them, so that the images do not "
+            "have to be read again by colorize_reconstruction.");
+
+// Profiling.
+DEFINE_string(profile_output_file, "",
+              "If set, the stages of the pipeline are profiled and their "
+              "timings and counters are written to this file as JSON.");
+DEFINE_string(profile_trace_file, "",
+              "If set, the stages of the pipeline are profiled and written to "
+              "this file in the Chrome trace event format, which can be "
+              "viewed in chrome://tracing or Perfetto.");
 
 using theia::Reconstruction;
 using theia::ReconstructionBuilder;
@@ -216,7 +277,10 @@ ReconstructionBuilderOptions SetReconstructionBuilderOptions() {
     options.sift_parameters.edge_threshold = FLAGS_sift_edge_threshold;
     options.sift_parameters.peak_threshold = FLAGS_sift_peak_threshold;
     options.sift_parameters.root_sift = FLAGS_root_sift;
+    options.sift_parameters.num_threads = FLAGS_sift_num_threads;
   }
+  options.max_image_dimension = FLAGS_max_image_dimension;
+  options.extract_keypoint_colors = FLAGS_extract_keypoint_colors;
 
   options.matching_options.match_out_of_core = FLAGS_match_out_of_core;
   options.matching_options.keypoints_and_descriptors_output_dir =
@@ -226,13 +290,24 @@ ReconstructionBuilderOptions SetReconstructionBuilderOptions() {
   options.matching_strategy =
       StringToMatchingStrategyType(FLAGS_matching_strategy);
   options.matching_options.lowes_ratio = FLAGS_lowes_ratio;
+  options.matching_options.random_seed = FLAGS_random_seed;
   options.matching_options.keep_only_symmetric_matches =
       FLAGS_keep_only_symmetric_matches;
+  options.matching_options.perform_guided_matching =
+      FLAGS_perform_guided_matching;
+  options.matching_options.select_image_pairs_with_global_descriptors =
+      FLAGS_select_image_pairs_with_global_descriptors;
+  options.matching_options.num_nearest_neighbors_for_global_descriptors =
+      FLAGS_num_nearest_neighbors_for_global_descriptors;
   options.min_num_inlier_matches = FLAGS_min_num_inliers_for_valid_match;
   options.geometric_verification_options.estimate_twoview_info_options
       .max_sampson_error_pixels = FLAGS_max_sampson_error_for_verified_match;
+  options.geometric_verification_options.estimate_twoview_info_options
+      .defer_cheirality_checks = FLAGS_defer_cheirality_checks;
   options.geometric_verification_options.bundle_adjustment =
       FLAGS_bundle_adjust_two_view_geometry;
+  options.geometric_verification_options.use_sampson_refinement =
+      FLAGS_use_sampson_two_view_refinement;
 
   options.max_track_length = FLAGS_max_track_length;
 
@@ -242,6 +317,10 @@ ReconstructionBuilderOptions SetReconstructionBuilderOptions() {
   reconstruction_estimator_options.min_num_two_view_inliers =
       FLAGS_min_num_inliers_for_valid_match;
   reconstruction_estimator_options.num_threads = FLAGS_num_threads;
+  if (FLAGS_random_seed >= 0) {
+    reconstruction_estimator_options.rng =
+        std::make_shared<theia::RandomNumberGenerator>(FLAGS_random_seed);
+  }
   reconstruction_estimator_options.intrinsics_to_optimize =
     StringToOptimizeIntrinsicsType(FLAGS_intrinsics_to_optimize);
   options.reconstruct_largest_connected_component =
@@ -287,6 +366,17 @@ ReconstructionBuilderOptions SetReconstructionBuilderOptions() {
   reconstruction_estimator_options.partial_bundle_adjustment_num_views =
       FLAGS_partial_bundle_adjustment_num_views;
 
+  // Hierarchical SfM Options.
+  reconstruction_estimator_options.hierarchical_max_num_views_per_cluster =
+      FLAGS_hierarchical_max_num_views_per_cluster;
+  reconstruction_estimator_options.hierarchical_cluster_overlap_ratio =
+      FLAGS_hierarchical_cluster_overlap_ratio;
+  reconstruction_estimator_options.hierarchical_min_num_overlapping_views =
+      FLAGS_hierarchical_min_num_overlapping_views;
+  reconstruction_estimator_options
+      .hierarchical_bundle_adjust_all_views_after_merging =
+      FLAGS_hierarchical_bundle_adjust_all_views_after_merging;
+
   // Triangulation options (used by all SfM pipelines).
   reconstruction_estimator_options.min_triangulation_angle_degrees =
       FLAGS_min_triangulation_angle_degrees;
@@ -331,6 +421,34 @@ void AddMatchesToReconstructionBuilder(
   }
 }
 
+// Logs the fraction of the image pairs verified by exhaustive matching that are
+// also verified when only the image pairs selected with global descriptors are
+// matched.
+void LogImagePairRecall() {
+  std::vector<std::string> image_files;
+  std::vector<theia::CameraIntrinsicsPrior> camera_intrinsics_prior;
+  std::vector<theia::ImagePairMatch> selected_matches, exhaustive_matches;
+  CHECK(theia::ReadMatchesAndGeometry(FLAGS_output_matches_file,
+                                      &image_files,
+                                      &camera_intrinsics_prior,
+                                      &selected_matches));
+  CHECK(theia::ReadMatchesAndGeometry(FLAGS_exhaustive_matches_file,
+                                      &image_files,
+                                      &camera_intrinsics_prior,
+                                      &exhaustive_matches));
+
+  std::vector<std::pair<std::string, std::string> > selected_pairs;
+  selected_pairs.reserve(selected_matches.size());
+  for (const auto& match : selected_matches) {
+    selected_pairs.emplace_back(match.image1, match.image2);
+  }
+  LOG(INFO) << "Recall of the image pairs selected with global descriptors: "
+            << theia::ComputeImagePairRecall(selected_pairs,
+                                             exhaustive_matches)
+            << " (" << selected_matches.size() << " verified pairs, "
+            << exhaustive_matches.size() << " exhaustively verified pairs)";
+}
+
 void AddImagesToReconstructionBuilder(
     ReconstructionBuilder* reconstruction_builder) {
   std::vector<std::string> image_files;
@@ -366,6 +484,14 @@ void AddImagesToReconstructionBuilder(
 
   // Extract and match features.
   CHECK(reconstruction_builder->ExtractAndMatchFeatures());
+
+  if (FLAGS_select_image_pairs_with_global_descriptors &&
+      !FLAGS_exhaustive_matches_file.empty()) {
+    CHECK(!FLAGS_output_matches_file.empty())
+        << "--output_matches_file must be set to evaluate the recall of the "
+           "selected image pairs.";
+    LogImagePairRecall();
+  }
 }
 
 int main(int argc, char *argv[]) {
@@ -375,6 +501,10 @@ int main(int argc, char *argv[]) {
   CHECK_GT(FLAGS_output_reconstruction.size(), 0)
       << "Must specify a filepath to output the reconstruction.";
 
+  if (!FLAGS_profile_output_file.empty() || !FLAGS_profile_trace_file.empty()) {
+    theia::EnableProfiling();
+  }
+
   const ReconstructionBuilderOptions options =
       SetReconstructionBuilderOptions();
 
@@ -400,4 +530,14 @@ int main(int argc, char *argv[]) {
     CHECK(theia::WriteReconstruction(*reconstructions[i], output_file))
         << "Could not write reconstruction to file.";
   }
+
+  // Write the profile of the stages if desired.
+  if (!FLAGS_profile_output_file.empty()) {
+    CHECK(theia::WriteProfileToJson(FLAGS_profile_output_file))
+        << "Could not write the profile to " << FLAGS_profile_output_file;
+  }
+  if (!FLAGS_profile_trace_file.empty()) {
+    CHECK(theia::WriteProfileToChromeTrace(FLAGS_profile_trace_file))
+        << "Could not write the profile trace to " << FLAGS_profile_trace_file;
+  }
 }
@@ -78,6 +78,8 @@ inline ReconstructionEstimatorType StringToReconstructionEstimatorType(
     return ReconstructionEstimatorType::GLOBAL;
   } else if (reconstruction_estimator == "INCREMENTAL") {
     return ReconstructionEstimatorType::INCREMENTAL;
+  } else if (reconstruction_estimator == "HIERARCHICAL") {
+    return ReconstructionEstimatorType::HIERARCHICAL;
   } else {
     LOG(FATAL)
         << "Invalid reconstruction estimator type. Using GLOBAL instead.";
@@ -68,6 +68,18 @@ DEFINE_double(sift_peak_threshold, 1.7f,
               "responses. Increase threshold value to reduce the number of "
               "keypoints");
 DEFINE_bool(root_sift, true, "Enables the usage of Root SIFT.");
+DEFINE_int32(sift_num_threads, 1,
+             "Number of threads used to extract the SIFT features of a single "
+             "large image in tiles. This is mostly useful for very large "
+             "images such as panoramas, and is only used if --num_threads=1 "
+             "since the images are otherwise extracted in parallel.");
+DEFINE_int32(max_image_dimension, 0,
+             "If positive, images are downscaled when decoding such that their "
+             "larger dimension is at most this many pixels. Set to 0 to "
+             "extract features at the full resolution.");
+DEFINE_int32(num_image_loader_threads, 1,
+             "Number of threads that decode images ahead of the feature "
+             "extraction.");
 
 int main(int argc, char *argv[]) {
   THEIA_GFLAGS_NAMESPACE::ParseCommandLineFlags(&argc, &argv, true);
@@ -95,7 +107,10 @@ int main(int argc, char *argv[]) {
     options.sift_parameters.edge_threshold = FLAGS_sift_edge_threshold;
     options.sift_parameters.peak_threshold = FLAGS_sift_peak_threshold;
     options.sift_parameters.root_sift = FLAGS_root_sift;
+    options.sift_parameters.num_threads = FLAGS_sift_num_threads;
   }
+  options.image_loader_options.max_image_dimension = FLAGS_max_image_dimension;
+  options.image_loader_options.num_threads = FLAGS_num_image_loader_threads;
 
   theia::FeatureExtractor feature_extractor(options);
 
@@ -80,6 +80,13 @@ DEFINE_int32(num_threads, 1,
              "Number of threads to use for feature extraction and matching.");
 DEFINE_string(output_matches_file, "",
               "Filepath that the matches file should be written to.");
+DEFINE_string(profile_output_file, "",
+              "If set, the stages of the pipeline are profiled and their "
+              "timings and counters are written to this file as JSON.");
+DEFINE_string(profile_trace_file, "",
+              "If set, the stages of the pipeline are profiled and written to "
+              "this file in the Chrome trace event format, which can be "
+              "viewed in chrome://tracing or Perfetto.");
 
 void SetMatchingOptions(
     theia::FeatureMatcherOptions* matching_options,
@@ -138,6 +145,10 @@ int main(int argc, char *argv[]) {
   THEIA_GFLAGS_NAMESPACE::ParseCommandLineFlags(&argc, &argv, true);
   google::InitGoogleLogging(argv[0]);
 
+  if (!FLAGS_profile_output_file.empty() || !FLAGS_profile_trace_file.empty()) {
+    theia::EnableProfiling();
+  }
+
   // Get the filepaths of the features files.
   std::vector<std::string> features_filepaths;
   CHECK(theia::GetFilepathsFromWildcard(FLAGS_input_features,
@@ -181,4 +192,14 @@ int main(int argc, char *argv[]) {
   CHECK(theia::WriteMatchesAndGeometry(FLAGS_output_matches_file,
                                        image_filenames, intrinsics, matches))
       << "Could not write the matches to " << FLAGS_output_matches_file;
+
+  // Write the profile of the stages if desired.
+  if (!FLAGS_profile_output_file.empty()) {
+    CHECK(theia::WriteProfileToJson(FLAGS_profile_output_file))
+        << "Could not write the profile to " << FLAGS_profile_output_file;
+  }
+  if (!FLAGS_profile_trace_file.empty()) {
+    CHECK(theia::WriteProfileToChromeTrace(FLAGS_profile_trace_file))
+        << "Could not write the profile trace to " << FLAGS_profile_trace_file;
+  }
 }
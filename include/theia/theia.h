@@ -41,9 +41,12 @@
 #include "theia/image/descriptor/sift_descriptor.h"
 #include "theia/image/image.h"
 #include "theia/image/image_canvas.h"
+#include "theia/image/image_loader.h"
 #include "theia/image/keypoint_detector/keypoint.h"
 #include "theia/image/keypoint_detector/keypoint_detector.h"
+#include "theia/image/keypoint_detector/keypoint_selection.h"
 #include "theia/image/keypoint_detector/sift_detector.h"
+#include "theia/image/keypoint_detector/sift_filter_cache.h"
 #include "theia/image/keypoint_detector/sift_parameters.h"
 #include "theia/io/eigen_serializable.h"
 #include "theia/io/import_nvm_file.h"
@@ -60,6 +63,7 @@
 #include "theia/io/sift_binary_file.h"
 #include "theia/io/sift_text_file.h"
 #include "theia/io/write_bundler_files.h"
+#include "theia/io/write_dense_reconstruction_workspace.h"
 #include "theia/io/write_keypoints_and_descriptors.h"
 #include "theia/io/write_matches.h"
 #include "theia/io/write_matches_deprecated.h"
@@ -73,12 +77,15 @@
 #include "theia/matching/feature_matcher.h"
 #include "theia/matching/feature_matcher_options.h"
 #include "theia/matching/feature_matcher_utils.h"
+#include "theia/matching/guided_epipolar_matcher.h"
 #include "theia/matching/image_pair_match.h"
+#include "theia/matching/image_retrieval.h"
 #include "theia/matching/indexed_feature_match.h"
 #include "theia/math/closed_form_polynomial_solver.h"
 #include "theia/math/distribution.h"
 #include "theia/math/find_polynomial_roots_companion_matrix.h"
 #include "theia/math/find_polynomial_roots_jenkins_traub.h"
+#include "theia/math/find_polynomial_roots_sturm.h"
 #include "theia/math/graph/connected_components.h"
 #include "theia/math/graph/normalized_graph_cut.h"
 #include "theia/math/histogram.h"
@@ -93,12 +100,15 @@
 #include "theia/sfm/bundle_adjustment/bundle_adjustment.h"
 #include "theia/sfm/bundle_adjustment/create_loss_function.h"
 #include "theia/sfm/bundle_adjustment/optimize_relative_position_with_known_rotation.h"
+#include "theia/sfm/bundle_adjustment/refine_two_view_geometry.h"
 #include "theia/sfm/bundle_adjustment/orthogonal_vector_error.h"
 #include "theia/sfm/bundle_adjustment/unit_norm_three_vector_parameterization.h"
 #include "theia/sfm/camera/camera.h"
+#include "theia/sfm/camera/image_undistortion_map.h"
 #include "theia/sfm/camera/project_point_to_image.h"
 #include "theia/sfm/camera/projection_matrix_utils.h"
 #include "theia/sfm/camera/radial_distortion.h"
+#include "theia/sfm/camera/radial_undistortion_table.h"
 #include "theia/sfm/camera/reprojection_error.h"
 #include "theia/sfm/camera_intrinsics_prior.h"
 #include "theia/sfm/colorize_reconstruction.h"
@@ -137,6 +147,7 @@
 #include "theia/sfm/global_pose_estimation/robust_rotation_estimator.h"
 #include "theia/sfm/global_pose_estimation/rotation_estimator.h"
 #include "theia/sfm/global_reconstruction_estimator.h"
+#include "theia/sfm/hierarchical_reconstruction_estimator.h"
 #include "theia/sfm/incremental_reconstruction_estimator.h"
 #include "theia/sfm/localize_view_to_reconstruction.h"
 #include "theia/sfm/pose/dls_impl.h"
@@ -178,6 +189,7 @@
 #include "theia/sfm/verify_two_view_matches.h"
 #include "theia/sfm/view.h"
 #include "theia/sfm/view_graph/orientations_from_view_graph.h"
+#include "theia/sfm/view_graph/partition_view_graph.h"
 #include "theia/sfm/view_graph/remove_disconnected_view_pairs.h"
 #include "theia/sfm/view_graph/triplet_extractor.h"
 #include "theia/sfm/view_graph/view_graph.h"
@@ -201,6 +213,7 @@
 #include "theia/util/lru_cache.h"
 #include "theia/util/map_util.h"
 #include "theia/util/mutable_priority_queue.h"
+#include "theia/util/profiler.h"
 #include "theia/util/random.h"
 #include "theia/util/stringprintf.h"
 #include "theia/util/threadpool.h"
@@ -0,0 +1,165 @@
+// Copyright (C) 2014 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include "theia/benchmark/benchmark.h"
+
+#include <glog/logging.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <fstream>  // NOLINT
+#include <functional>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "theia/util/random.h"
+#include "theia/util/stringprintf.h"
+#include "theia/util/timer.h"
+
+namespace theia {
+
+BenchmarkState::BenchmarkState(const BenchmarkOptions& options,
+                               const int problem_size)
+    : options_(options),
+      problem_size_(problem_size),
+      rng_(options.seed),
+      num_items_per_repetition_(0) {
+  CHECK_GT(options_.min_num_repetitions, 0);
+  CHECK_GE(options_.max_num_repetitions, options_.min_num_repetitions);
+
+  // Some of the synthetic data generators draw from the shared generator, and
+  // AddNoiseToProjection draws from Eigen's Random(), which uses rand().
+  InitRandomGenerator(options_.seed);
+  srand(static_cast<unsigned int>(options_.seed));
+}
+
+void BenchmarkState::Run(const std::function<void()>& function,
+                         const std::function<void()>& reset) {
+  std::vector<double> times;
+  double total_time = 0.0;
+  Timer timer;
+  while (times.size() < options_.max_num_repetitions &&
+         (times.size() < options_.min_num_repetitions ||
+          total_time < options_.min_time_in_seconds)) {
+    if (reset) {
+      reset();
+    }
+    timer.Reset();
+    function();
+    times.emplace_back(timer.ElapsedTimeInSeconds());
+    total_time += times.back();
+  }
+
+  std::sort(times.begin(), times.end());
+  result_.num_repetitions = times.size();
+  result_.min_seconds = times.front();
+  result_.max_seconds = times.back();
+  result_.median_seconds = times[times.size() / 2];
+  result_.mean_seconds = total_time / times.size();
+  if (num_items_per_repetition_ > 0 && result_.median_seconds > 0.0) {
+    result_.items_per_second =
+        num_items_per_repetition_ / result_.median_seconds;
+  }
+}
+
+void BenchmarkState::SetItemsPerRepetition(const int64_t num_items) {
+  num_items_per_repetition_ = num_items;
+}
+
+void BenchmarkState::SetCounter(const std::string& name, const double value) {
+  result_.counters[name] = value;
+}
+
+BenchmarkResult RunBenchmark(const BenchmarkOptions& options,
+                             const Benchmark& benchmark,
+                             const int scale_index) {
+  CHECK_GE(scale_index, 0);
+  CHECK_LT(scale_index, 3);
+  BenchmarkState state(options, benchmark.problem_sizes[scale_index]);
+  benchmark.function(&state);
+  CHECK_GT(state.result().num_repetitions, 0)
+      << "The benchmark " << benchmark.name << " did not call Run().";
+
+  BenchmarkResult result = state.result();
+  result.name = benchmark.name;
+  result.scale = kBenchmarkScaleNames[scale_index];
+  result.problem_size = benchmark.problem_sizes[scale_index];
+  return result;
+}
+
+bool WriteBenchmarkResultsToJson(const BenchmarkOptions& options,
+                                 const std::vector<BenchmarkResult>& results,
+                                 const std::string& output_file) {
+  std::ofstream ofs(output_file.c_str(), std::ios::out);
+  if (!ofs.is_open()) {
+    LOG(ERROR) << "Cannot write the benchmark results to " << output_file;
+    return false;
+  }
+
+  ofs << StringPrintf("{\n  \"seed\": %llu,\n  \"min_time_in_seconds\": %g,\n"
+                      "  \"min_num_repetitions\": %d,\n  \"results\": [",
+                      static_cast<unsigned long long>(options.seed),
+                      options.min_time_in_seconds,
+                      options.min_num_repetitions);
+  for (int i = 0; i < results.size(); i++) {
+    const BenchmarkResult& result = results[i];
+    ofs << (i == 0 ? "\n" : ",\n")
+        << StringPrintf("    {\"name\": \"%s\", \"scale\": \"%s\", "
+                        "\"problem_size\": %d, \"num_repetitions\": %d, "
+                        "\"min_seconds\": %.9g, \"median_seconds\": %.9g, "
+                        "\"mean_seconds\": %.9g, \"max_seconds\": %.9g, "
+                        "\"items_per_second\": %.9g, \"counters\": {",
+                        result.name.c_str(),
+                        result.scale.c_str(),
+                        result.problem_size,
+                        result.num_repetitions,
+                        result.min_seconds,
+                        result.median_seconds,
+                        result.mean_seconds,
+                        result.max_seconds,
+                        result.items_per_second);
+    bool first_counter = true;
+    for (const auto& counter : result.counters) {
+      ofs << (first_counter ? "" : ", ")
+          << StringPrintf("\"%s\": %.9g", counter.first.c_str(),
+                          counter.second);
+      first_counter = false;
+    }
+    ofs << "}}";
+  }
+  ofs << "\n  ]\n}\n";
+  return ofs.good();
+}
+
+}  // namespace theia
@@ -0,0 +1,163 @@
+// Copyright (C) 2014 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#ifndef THEIA_BENCHMARK_BENCHMARK_H_
+#define THEIA_BENCHMARK_BENCHMARK_H_
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "theia/util/random.h"
+#include "theia/util/util.h"
+
+namespace theia {
+
+// A minimal harness for timing the hot paths of the library on synthetic data.
+// Each benchmark is a function that generates its data with the generator of
+// a BenchmarkState and passes the code to time to BenchmarkState::Run. All
+// random numbers are drawn from generators seeded with BenchmarkOptions::seed
+// so that every run of a benchmark processes the same data.
+
+struct BenchmarkOptions {
+  // Each benchmark is repeated until it has run for at least this many seconds
+  // and at least min_num_repetitions times, but at most max_num_repetitions
+  // times.
+  double min_time_in_seconds = 1.0;
+  int min_num_repetitions = 3;
+  int max_num_repetitions = 1000;
+
+  // The seed of the synthetic data and of the randomized algorithms.
+  uint64_t seed = 42;
+};
+
+// The measurements of a benchmark at one problem size.
+struct BenchmarkResult {
+  std::string name;
+  std::string scale;
+  int problem_size = 0;
+  int num_repetitions = 0;
+
+  double min_seconds = 0.0;
+  double median_seconds = 0.0;
+  double mean_seconds = 0.0;
+  double max_seconds = 0.0;
+
+  // The number of items (e.g. descriptors or minimal problems) processed per
+  // second at the median time, or 0 if the benchmark does not count items.
+  double items_per_second = 0.0;
+
+  // Benchmark specific values such as the number of RANSAC iterations of the
+  // last repetition. They are useful to check that the benchmark does the same
+  // work on every machine.
+  std::map<std::string, double> counters;
+};
+
+class BenchmarkState {
+ public:
+  BenchmarkState(const BenchmarkOptions& options, const int problem_size);
+
+  int problem_size() const { return problem_size_; }
+
+  // The generator for the synthetic data and for the algorithms.
+  RandomNumberGenerator* rng() { return &rng_; }
+
+  // The seed that randomized algorithms should be seeded with before each
+  // repetition so that the repetitions do the same work.
+  uint64_t seed() const { return options_.seed; }
+
+  // Times the function repeatedly. If reset is given, it is called before each
+  // repetition without being timed, e.g. to restore the input that the
+  // function modifies.
+  void Run(const std::function<void()>& function,
+           const std::function<void()>& reset = nullptr);
+
+  // Sets the number of items that each repetition processes.
+  void SetItemsPerRepetition(const int64_t num_items);
+
+  void SetCounter(const std::string& name, const double value);
+
+  // Returns the result of Run. The name and scale are not set.
+  const BenchmarkResult& result() const { return result_; }
+
+ private:
+  const BenchmarkOptions options_;
+  const int problem_size_;
+  RandomNumberGenerator rng_;
+  int64_t num_items_per_repetition_;
+  BenchmarkResult result_;
+
+  DISALLOW_COPY_AND_ASSIGN(BenchmarkState);
+};
+
+// The names of the problem scales of the benchmarks.
+static const char* const kBenchmarkScaleNames[] = {"small", "medium", "large"};
+
+struct Benchmark {
+  std::string name;
+
+  // The problem sizes of the small, medium and large scales. The meaning of
+  // the size is specific to the benchmark, e.g. the number of descriptors per
+  // image or the number of views.
+  int problem_sizes[3];
+
+  std::function<void(BenchmarkState*)> function;
+};
+
+// Runs the benchmark at the scale with the given index into
+// kBenchmarkScaleNames.
+BenchmarkResult RunBenchmark(const BenchmarkOptions& options,
+                             const Benchmark& benchmark,
+                             const int scale_index);
+
+// Writes the options and results as a JSON object of the form
+//   {"seed": ..., "min_time_in_seconds": ..., "results": [{"name": ...,
+//    "scale": ..., "problem_size": ..., "num_repetitions": ...,
+//    "min_seconds": ..., "median_seconds": ..., "mean_seconds": ...,
+//    "max_seconds": ..., "items_per_second": ..., "counters": {...}}, ...]}
+// Returns false if the file could not be written.
+bool WriteBenchmarkResultsToJson(const BenchmarkOptions& options,
+                                 const std::vector<BenchmarkResult>& results,
+                                 const std::string& output_file);
+
+// The benchmarks of each module. They are appended to the list of benchmarks.
+void AddMatchingBenchmarks(std::vector<Benchmark>* benchmarks);
+void AddPoseBenchmarks(std::vector<Benchmark>* benchmarks);
+void AddSfmBenchmarks(std::vector<Benchmark>* benchmarks);
+
+}  // namespace theia
+
+#endif  // THEIA_BENCHMARK_BENCHMARK_H_
@@ -0,0 +1,156 @@
+// Copyright (C) 2014 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include <Eigen/Core>
+#include <memory>
+#include <vector>
+
+#include "theia/benchmark/benchmark.h"
+#include "theia/benchmark/synthetic_data.h"
+#include "theia/image/keypoint_detector/keypoint.h"
+#include "theia/matching/brute_force_feature_matcher.h"
+#include "theia/matching/cascade_hasher.h"
+#include "theia/matching/distance.h"
+#include "theia/matching/feature_matcher_options.h"
+#include "theia/matching/image_pair_match.h"
+#include "theia/matching/indexed_feature_match.h"
+#include "theia/util/random.h"
+
+namespace theia {
+
+namespace {
+
+// The fraction of the descriptors of the second image that match a
+// descriptor of the first image.
+static const double kDescriptorOverlap = 0.5;
+static const double kLowesRatio = 0.8;
+
+// Hashes the descriptors of one image. The size is the number of descriptors.
+void HashSiftDescriptors(BenchmarkState* state) {
+  std::vector<Eigen::VectorXf> descriptors1, descriptors2;
+  CreateDescriptorsForImagePair(state->problem_size(),
+                                kDescriptorOverlap,
+                                state->rng(),
+                                &descriptors1,
+                                &descriptors2);
+  CascadeHasher hasher(std::make_shared<RandomNumberGenerator>(state->seed()));
+  CHECK(hasher.Initialize(descriptors1[0].size()));
+
+  state->SetItemsPerRepetition(descriptors1.size());
+  state->Run([&]() { hasher.CreateHashedSiftDescriptors(descriptors1); });
+}
+
+// Matches the hashed descriptors of an image pair. The size is the number of
+// descriptors per image.
+void CascadeHasherMatchImages(BenchmarkState* state) {
+  std::vector<Eigen::VectorXf> descriptors1, descriptors2;
+  CreateDescriptorsForImagePair(state->problem_size(),
+                                kDescriptorOverlap,
+                                state->rng(),
+                                &descriptors1,
+                                &descriptors2);
+  CascadeHasher hasher(std::make_shared<RandomNumberGenerator>(state->seed()));
+  CHECK(hasher.Initialize(descriptors1[0].size()));
+  const HashedImage hashed_image1 =
+      hasher.CreateHashedSiftDescriptors(descriptors1);
+  const HashedImage hashed_image2 =
+      hasher.CreateHashedSiftDescriptors(descriptors2);
+
+  std::vector<IndexedFeatureMatch> matches;
+  state->SetItemsPerRepetition(descriptors1.size());
+  state->Run(
+      [&]() {
+        hasher.MatchImages(hashed_image1,
+                           descriptors1,
+                           hashed_image2,
+                           descriptors2,
+                           kLowesRatio,
+                           &matches);
+      },
+      [&]() { matches.clear(); });
+  state->SetCounter("num_matches", matches.size());
+}
+
+// Matches an image pair exhaustively with symmetric matching and the ratio
+// test. The size is the number of descriptors per image.
+void BruteForceMatchImages(BenchmarkState* state) {
+  std::vector<Eigen::VectorXf> descriptors1, descriptors2;
+  CreateDescriptorsForImagePair(state->problem_size(),
+                                kDescriptorOverlap,
+                                state->rng(),
+                                &descriptors1,
+                                &descriptors2);
+  std::vector<Keypoint> keypoints1, keypoints2;
+  for (int i = 0; i < descriptors1.size(); i++) {
+    keypoints1.emplace_back(state->rng()->RandDouble(0.0, 1000.0),
+                            state->rng()->RandDouble(0.0, 1000.0),
+                            Keypoint::SIFT);
+    keypoints2.emplace_back(state->rng()->RandDouble(0.0, 1000.0),
+                            state->rng()->RandDouble(0.0, 1000.0),
+                            Keypoint::SIFT);
+  }
+
+  FeatureMatcherOptions options;
+  options.num_threads = 1;
+  options.match_out_of_core = false;
+  options.keep_only_symmetric_matches = true;
+  options.use_lowes_ratio = true;
+  options.lowes_ratio = kLowesRatio;
+  options.min_num_feature_matches = 0;
+  BruteForceFeatureMatcher<L2> matcher(options);
+  matcher.AddImage("image1", keypoints1, descriptors1);
+  matcher.AddImage("image2", keypoints2, descriptors2);
+
+  std::vector<ImagePairMatch> matches;
+  state->SetItemsPerRepetition(descriptors1.size());
+  state->Run([&]() { matcher.MatchImages(&matches); },
+             [&]() { matches.clear(); });
+  state->SetCounter("num_matches",
+                    matches.empty() ? 0 : matches[0].correspondences.size());
+}
+
+}  // namespace
+
+void AddMatchingBenchmarks(std::vector<Benchmark>* benchmarks) {
+  benchmarks->push_back(
+      {"CascadeHasher/CreateHashedSiftDescriptors", {1000, 4000, 16000},
+       HashSiftDescriptors});
+  benchmarks->push_back({"CascadeHasher/MatchImages", {1000, 4000, 16000},
+                         CascadeHasherMatchImages});
+  benchmarks->push_back({"BruteForceFeatureMatcher/MatchImages",
+                         {500, 1000, 2000},
+                         BruteForceMatchImages});
+}
+
+}  // namespace theia
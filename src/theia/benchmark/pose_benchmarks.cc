@@ -0,0 +1,365 @@
+// Copyright (C) 2014 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "theia/benchmark/benchmark.h"
+#include "theia/benchmark/synthetic_data.h"
+#include "theia/matching/feature_correspondence.h"
+#include "theia/math/find_polynomial_roots_sturm.h"
+#include "theia/math/polynomial.h"
+#include "theia/math/util.h"
+#include "theia/sfm/create_and_initialize_ransac_variant.h"
+#include "theia/sfm/estimators/estimate_relative_pose.h"
+#include "theia/sfm/pose/five_point_relative_pose.h"
+#include "theia/sfm/pose/perspective_three_point.h"
+#include "theia/sfm/pose/seven_point_fundamental_matrix.h"
+#include "theia/sfm/pose/test_util.h"
+#include "theia/solvers/sample_consensus_estimator.h"
+#include "theia/util/random.h"
+
+namespace theia {
+
+namespace {
+
+// The noise of the synthetic correspondences in normalized coordinates, which
+// is roughly one pixel for a focal length of 1000 pixels.
+static const double kNormalizedNoise = 1e-3;
+
+// Creates noise-free correspondences for a batch of minimal problems with
+// sample_size correspondences each.
+void CreateMinimalProblems(const int sample_size,
+                           BenchmarkState* state,
+                           std::vector<Eigen::Vector2d>* image1_points,
+                           std::vector<Eigen::Vector2d>* image2_points) {
+  std::vector<FeatureCorrespondence> correspondences;
+  Eigen::Matrix3d rotation;
+  Eigen::Vector3d position;
+  CreateTwoViewCorrespondences(sample_size * state->problem_size(),
+                               1.0,
+                               0.0,
+                               state->rng(),
+                               &correspondences,
+                               &rotation,
+                               &position);
+  image1_points->resize(correspondences.size());
+  image2_points->resize(correspondences.size());
+  for (int i = 0; i < correspondences.size(); i++) {
+    (*image1_points)[i] = correspondences[i].feature1;
+    (*image2_points)[i] = correspondences[i].feature2;
+  }
+}
+
+// Solves a batch of noise-free five point problems. The size is the number of
+// minimal problems.
+void SolveFivePointRelativePose(BenchmarkState* state) {
+  static const int kSampleSize = 5;
+  std::vector<Eigen::Vector2d> image1_points, image2_points;
+  CreateMinimalProblems(kSampleSize, state, &image1_points, &image2_points);
+
+  int num_solutions = 0;
+  std::vector<Eigen::Matrix3d> essential_matrices;
+  state->SetItemsPerRepetition(state->problem_size());
+  state->Run([&]() {
+    num_solutions = 0;
+    for (int i = 0; i < state->problem_size(); i++) {
+      essential_matrices.clear();
+      FivePointRelativePose(&image1_points[kSampleSize * i],
+                            &image2_points[kSampleSize * i],
+                            &essential_matrices);
+      num_solutions += essential_matrices.size();
+    }
+  });
+  state->SetCounter("num_solutions", num_solutions);
+}
+
+// Same as SolveFivePointRelativePose, but each sample is copied into
+// std::vectors and passed to the general solver the way RANSAC did before the
+// minimal overload existed. The difference to FivePointRelativePose is the cost
+// of the per-sample allocations.
+void SolveFivePointRelativePoseFromVectors(BenchmarkState* state) {
+  static const int kSampleSize = 5;
+  std::vector<Eigen::Vector2d> image1_points, image2_points;
+  CreateMinimalProblems(kSampleSize, state, &image1_points, &image2_points);
+
+  int num_solutions = 0;
+  std::vector<Eigen::Matrix3d> essential_matrices;
+  state->SetItemsPerRepetition(state->problem_size());
+  state->Run([&]() {
+    num_solutions = 0;
+    for (int i = 0; i < state->problem_size(); i++) {
+      const std::vector<Eigen::Vector2d> sample1(
+          image1_points.begin() + kSampleSize * i,
+          image1_points.begin() + kSampleSize * (i + 1));
+      const std::vector<Eigen::Vector2d> sample2(
+          image2_points.begin() + kSampleSize * i,
+          image2_points.begin() + kSampleSize * (i + 1));
+      essential_matrices.clear();
+      FivePointRelativePose(sample1, sample2, &essential_matrices);
+      num_solutions += essential_matrices.size();
+    }
+  });
+  state->SetCounter("num_solutions", num_solutions);
+}
+
+// Solves a batch of noise-free seven point problems. The size is the number of
+// minimal problems.
+void SolveSevenPointFundamentalMatrix(BenchmarkState* state) {
+  static const int kSampleSize = 7;
+  std::vector<Eigen::Vector2d> image1_points, image2_points;
+  CreateMinimalProblems(kSampleSize, state, &image1_points, &image2_points);
+
+  // The solver takes its input as std::vectors so the samples are split up
+  // before timing.
+  std::vector<std::vector<Eigen::Vector2d> > samples1(state->problem_size());
+  std::vector<std::vector<Eigen::Vector2d> > samples2(state->problem_size());
+  for (int i = 0; i < state->problem_size(); i++) {
+    samples1[i].assign(image1_points.begin() + kSampleSize * i,
+                       image1_points.begin() + kSampleSize * (i + 1));
+    samples2[i].assign(image2_points.begin() + kSampleSize * i,
+                       image2_points.begin() + kSampleSize * (i + 1));
+  }
+
+  int num_solutions = 0;
+  std::vector<Eigen::Matrix3d> fundamental_matrices;
+  state->SetItemsPerRepetition(state->problem_size());
+  state->Run([&]() {
+    num_solutions = 0;
+    for (int i = 0; i < state->problem_size(); i++) {
+      fundamental_matrices.clear();
+      SevenPointFundamentalMatrix(samples1[i],
+                                  samples2[i],
+                                  &fundamental_matrices);
+      num_solutions += fundamental_matrices.size();
+    }
+  });
+  state->SetCounter("num_solutions", num_solutions);
+}
+
+// Creates a batch of quartics with 4 real roots in [-1, 1]. The coefficients
+// are stored in the order expected by the polynomial solvers.
+void CreateQuartics(BenchmarkState* state,
+                    std::vector<Eigen::Matrix<double, 5, 1> >* quartics) {
+  quartics->resize(state->problem_size());
+  for (Eigen::Matrix<double, 5, 1>& quartic : *quartics) {
+    quartic.setZero();
+    quartic(0) = 1.0;
+    // Multiply the polynomial by (x - root) for each root.
+    for (int i = 1; i <= 4; i++) {
+      const double root = state->rng()->RandDouble(-1.0, 1.0);
+      for (int j = i; j > 0; j--) {
+        quartic(j) -= root * quartic(j - 1);
+      }
+    }
+  }
+}
+
+// Finds the roots of a batch of quartics with the companion matrix solver that
+// the minimal solvers used before the Sturm sequence solver. The size is the
+// number of quartics.
+void FindQuarticRootsWithCompanionMatrix(BenchmarkState* state) {
+  std::vector<Eigen::Matrix<double, 5, 1> > quartics;
+  CreateQuartics(state, &quartics);
+
+  int num_roots = 0;
+  Eigen::VectorXd real, imaginary;
+  state->SetItemsPerRepetition(state->problem_size());
+  state->Run([&]() {
+    num_roots = 0;
+    for (const Eigen::Matrix<double, 5, 1>& quartic : quartics) {
+      if (FindPolynomialRoots(quartic, &real, &imaginary)) {
+        num_roots += real.size();
+      }
+    }
+  });
+  state->SetCounter("num_roots", num_roots);
+}
+
+// Same as above with the fixed-size Sturm sequence solver.
+void FindQuarticRootsWithSturmSequence(BenchmarkState* state) {
+  std::vector<Eigen::Matrix<double, 5, 1> > quartics;
+  CreateQuartics(state, &quartics);
+
+  int num_roots = 0;
+  double roots[4];
+  state->SetItemsPerRepetition(state->problem_size());
+  state->Run([&]() {
+    num_roots = 0;
+    for (const Eigen::Matrix<double, 5, 1>& quartic : quartics) {
+      num_roots += FindRealPolynomialRootsSturm<4>(quartic, roots);
+    }
+  });
+  state->SetCounter("num_roots", num_roots);
+}
+
+// Solves a batch of noise-free P3P problems. The size is the number of minimal
+// problems.
+void SolvePoseFromThreePoints(BenchmarkState* state) {
+  static const int kSampleSize = 3;
+  std::vector<Eigen::Vector3d> points;
+  CreateRandomPointsInFrustum(1.0,
+                              1.0,
+                              2.0,
+                              8.0,
+                              kSampleSize * state->problem_size(),
+                              &points);
+
+  // The points are generated in the camera coordinate system. Move them to a
+  // random world coordinate system for each problem.
+  std::vector<Eigen::Vector2d> features(points.size());
+  std::vector<Eigen::Vector3d> world_points(points.size());
+  for (int i = 0; i < state->problem_size(); i++) {
+    const Eigen::Vector3d axis(state->rng()->RandGaussian(0.0, 1.0),
+                               state->rng()->RandGaussian(0.0, 1.0),
+                               state->rng()->RandGaussian(0.0, 1.0));
+    const Eigen::Matrix3d rotation =
+        Eigen::AngleAxisd(state->rng()->RandDouble(0.0, M_PI),
+                          axis.normalized()).toRotationMatrix();
+    const Eigen::Vector3d translation(state->rng()->RandDouble(-1.0, 1.0),
+                                      state->rng()->RandDouble(-1.0, 1.0),
+                                      state->rng()->RandDouble(-1.0, 1.0));
+    for (int j = kSampleSize * i; j < kSampleSize * (i + 1); j++) {
+      features[j] = points[j].hnormalized();
+      world_points[j] = rotation * points[j] + translation;
+    }
+  }
+
+  int num_solutions = 0;
+  std::vector<Eigen::Matrix3d> rotations;
+  std::vector<Eigen::Vector3d> translations;
+  state->SetItemsPerRepetition(state->problem_size());
+  state->Run([&]() {
+    num_solutions = 0;
+    for (int i = 0; i < state->problem_size(); i++) {
+      PoseFromThreePoints(&features[kSampleSize * i],
+                          &world_points[kSampleSize * i],
+                          &rotations,
+                          &translations);
+      num_solutions += rotations.size();
+    }
+  });
+  state->SetCounter("num_solutions", num_solutions);
+}
+
+// Estimates a relative pose with RANSAC from correspondences with 50%
+// outliers. The size is the number of correspondences. The rotation and
+// position errors of the estimate are reported in degrees so that the
+// accuracy of the deferred cheirality checks can be compared with the
+// per-hypothesis checks.
+void RunRelativePoseRansacBenchmark(const bool defer_cheirality_checks,
+                                    BenchmarkState* state) {
+  static const double kInlierRatio = 0.5;
+  std::vector<FeatureCorrespondence> correspondences;
+  Eigen::Matrix3d rotation;
+  Eigen::Vector3d position;
+  CreateTwoViewCorrespondences(state->problem_size(),
+                               kInlierRatio,
+                               kNormalizedNoise,
+                               state->rng(),
+                               &correspondences,
+                               &rotation,
+                               &position);
+
+  RansacParameters params;
+  params.error_thresh = 4.0 * kNormalizedNoise * kNormalizedNoise;
+  params.failure_probability = 0.001;
+  params.max_iterations = 1000;
+
+  RelativePose relative_pose;
+  RansacSummary summary;
+  state->SetItemsPerRepetition(correspondences.size());
+  state->Run(
+      [&]() {
+        EstimateRelativePose(params,
+                             RansacType::RANSAC,
+                             defer_cheirality_checks,
+                             correspondences,
+                             &relative_pose,
+                             &summary);
+      },
+      // Reseed the sampling so that each repetition draws the same samples.
+      [&]() {
+        summary = RansacSummary();
+        params.rng = std::make_shared<RandomNumberGenerator>(state->seed());
+      });
+  state->SetCounter("num_iterations", summary.num_iterations);
+  state->SetCounter("num_inliers", summary.inliers.size());
+
+  const Eigen::AngleAxisd rotation_error(relative_pose.rotation *
+                                         rotation.transpose());
+  const double cos_position_error = Clamp(
+      relative_pose.position.normalized().dot(position), -1.0, 1.0);
+  state->SetCounter("rotation_error_degrees",
+                    RadToDeg(rotation_error.angle()));
+  state->SetCounter("position_error_degrees",
+                    RadToDeg(std::acos(cos_position_error)));
+}
+
+void EstimateRelativePoseWithRansac(BenchmarkState* state) {
+  RunRelativePoseRansacBenchmark(false, state);
+}
+
+void EstimateRelativePoseWithRansacAndDeferredCheirality(
+    BenchmarkState* state) {
+  RunRelativePoseRansacBenchmark(true, state);
+}
+
+}  // namespace
+
+void AddPoseBenchmarks(std::vector<Benchmark>* benchmarks) {
+  benchmarks->push_back({"FivePointRelativePose", {100, 1000, 10000},
+                         SolveFivePointRelativePose});
+  benchmarks->push_back({"FivePointRelativePose/VectorInput",
+                         {100, 1000, 10000},
+                         SolveFivePointRelativePoseFromVectors});
+  benchmarks->push_back({"SevenPointFundamentalMatrix", {100, 1000, 10000},
+                         SolveSevenPointFundamentalMatrix});
+  benchmarks->push_back({"QuarticRoots/CompanionMatrix", {1000, 10000, 100000},
+                         FindQuarticRootsWithCompanionMatrix});
+  benchmarks->push_back({"QuarticRoots/SturmSequence", {1000, 10000, 100000},
+                         FindQuarticRootsWithSturmSequence});
+  benchmarks->push_back({"PoseFromThreePoints", {1000, 10000, 100000},
+                         SolvePoseFromThreePoints});
+  benchmarks->push_back({"EstimateRelativePose/RANSAC", {200, 1000, 5000},
+                         EstimateRelativePoseWithRansac});
+  benchmarks->push_back({"EstimateRelativePose/RANSAC_DeferredCheirality",
+                         {200, 1000, 5000},
+                         EstimateRelativePoseWithRansacAndDeferredCheirality});
+}
+
+}  // namespace theia
@@ -0,0 +1,260 @@
+// Copyright (C) 2014 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include <Eigen/Core>
+#include <glog/logging.h>
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "theia/benchmark/benchmark.h"
+#include "theia/benchmark/synthetic_data.h"
+#include "theia/sfm/bundle_adjustment/bundle_adjustment.h"
+#include "theia/sfm/camera/camera.h"
+#include "theia/sfm/global_pose_estimation/nonlinear_position_estimator.h"
+#include "theia/sfm/global_pose_estimation/robust_rotation_estimator.h"
+#include "theia/sfm/reconstruction.h"
+#include "theia/sfm/track.h"
+#include "theia/sfm/track_builder.h"
+#include "theia/sfm/twoview_info.h"
+#include "theia/sfm/types.h"
+#include "theia/sfm/view.h"
+#include "theia/util/random.h"
+
+namespace theia {
+
+namespace {
+
+// The synthetic reconstructions have this many tracks per view, and each view
+// is paired with this many neighbors on the ring for the global estimators.
+static const int kNumTracksPerView = 50;
+static const int kNumNeighborsPerView = 8;
+static const double kPixelNoise = 0.5;
+static const double kRelativePoseNoiseDegrees = 1.0;
+
+// Builds the tracks of a reconstruction from the matches between consecutive
+// observations. The size is the number of views.
+void BuildTracks(BenchmarkState* state) {
+  Reconstruction ground_truth;
+  CreateRingReconstruction(state->problem_size(),
+                           kNumTracksPerView * state->problem_size(),
+                           kPixelNoise,
+                           state->rng(),
+                           &ground_truth);
+  std::vector<SyntheticFeatureMatch> matches;
+  CreateFeatureMatchesFromReconstruction(ground_truth, state->rng(), &matches);
+
+  // The track builder may only be used once, so the matches are added to a
+  // new one in each repetition. The tracks are added to a reconstruction that
+  // only contains the views of the ground truth.
+  std::vector<ViewId> view_ids = ground_truth.ViewIds();
+  std::sort(view_ids.begin(), view_ids.end());
+  std::unique_ptr<Reconstruction> reconstruction;
+  state->SetItemsPerRepetition(matches.size());
+  state->Run(
+      [&]() {
+        static const int kMaxTrackLength = 50;
+        TrackBuilder track_builder(kMaxTrackLength);
+        for (const SyntheticFeatureMatch& match : matches) {
+          track_builder.AddFeatureCorrespondence(
+              match.view_id1, match.feature1, match.view_id2, match.feature2);
+        }
+        track_builder.BuildTracks(reconstruction.get());
+      },
+      [&]() {
+        reconstruction.reset(new Reconstruction());
+        for (const ViewId view_id : view_ids) {
+          CHECK_EQ(reconstruction->AddView(ground_truth.View(view_id)->Name()),
+                   view_id);
+        }
+      });
+  state->SetCounter("num_matches", matches.size());
+  state->SetCounter("num_tracks", reconstruction->NumTracks());
+}
+
+// Bundle adjusts a reconstruction whose cameras and points have been
+// perturbed. The size is the number of views.
+void BundleAdjust(BenchmarkState* state) {
+  Reconstruction reconstruction;
+  CreateRingReconstruction(state->problem_size(),
+                           kNumTracksPerView * state->problem_size(),
+                           kPixelNoise,
+                           state->rng(),
+                           &reconstruction);
+
+  // Perturb the poses and points once and restore the perturbed cameras
+  // (including the intrinsics, which are optimized as well) and points before
+  // each repetition.
+  const std::vector<ViewId> view_ids = reconstruction.ViewIds();
+  const std::vector<TrackId> track_ids = reconstruction.TrackIds();
+  std::vector<Camera> cameras;
+  for (const ViewId view_id : view_ids) {
+    Camera camera = reconstruction.View(view_id)->Camera();
+    camera.SetOrientationFromAngleAxis(
+        camera.GetOrientationAsAngleAxis() +
+        Eigen::Vector3d(state->rng()->RandGaussian(0.0, 0.01),
+                        state->rng()->RandGaussian(0.0, 0.01),
+                        state->rng()->RandGaussian(0.0, 0.01)));
+    camera.SetPosition(
+        camera.GetPosition() +
+        Eigen::Vector3d(state->rng()->RandGaussian(0.0, 0.05),
+                        state->rng()->RandGaussian(0.0, 0.05),
+                        state->rng()->RandGaussian(0.0, 0.05)));
+    cameras.emplace_back(camera);
+  }
+  std::vector<Eigen::Vector4d> points;
+  for (const TrackId track_id : track_ids) {
+    points.emplace_back(
+        reconstruction.Track(track_id)->Point() +
+        Eigen::Vector4d(state->rng()->RandGaussian(0.0, 0.05),
+                        state->rng()->RandGaussian(0.0, 0.05),
+                        state->rng()->RandGaussian(0.0, 0.05),
+                        0.0));
+  }
+
+  BundleAdjustmentOptions options;
+  options.num_threads = 1;
+  options.verbose = false;
+  BundleAdjustmentSummary summary;
+  state->SetItemsPerRepetition(track_ids.size());
+  state->Run(
+      [&]() { summary = BundleAdjustReconstruction(options, &reconstruction); },
+      [&]() {
+        for (int i = 0; i < view_ids.size(); i++) {
+          *reconstruction.MutableView(view_ids[i])->MutableCamera() =
+              cameras[i];
+        }
+        for (int i = 0; i < track_ids.size(); i++) {
+          *reconstruction.MutableTrack(track_ids[i])->MutablePoint() =
+              points[i];
+        }
+      });
+  state->SetCounter("initial_cost", summary.initial_cost);
+  state->SetCounter("final_cost", summary.final_cost);
+}
+
+// Returns the orientations of the views of the reconstruction with noise
+// added.
+std::unordered_map<ViewId, Eigen::Vector3d> NoisyOrientations(
+    const Reconstruction& reconstruction, RandomNumberGenerator* rng) {
+  std::unordered_map<ViewId, Eigen::Vector3d> orientations;
+  for (const ViewId view_id : reconstruction.ViewIds()) {
+    orientations[view_id] =
+        reconstruction.View(view_id)->Camera().GetOrientationAsAngleAxis() +
+        Eigen::Vector3d(rng->RandGaussian(0.0, 0.05),
+                        rng->RandGaussian(0.0, 0.05),
+                        rng->RandGaussian(0.0, 0.05));
+  }
+  return orientations;
+}
+
+// Estimates the global orientations from noisy relative rotations, starting
+// from noisy orientations. The size is the number of views.
+void EstimateRotations(BenchmarkState* state) {
+  Reconstruction reconstruction;
+  CreateRingReconstruction(
+      state->problem_size(), 0, 0.0, state->rng(), &reconstruction);
+  std::unordered_map<ViewIdPair, TwoViewInfo> view_pairs;
+  CreateViewPairsFromReconstruction(reconstruction,
+                                    kNumNeighborsPerView,
+                                    kRelativePoseNoiseDegrees,
+                                    state->rng(),
+                                    &view_pairs);
+  const std::unordered_map<ViewId, Eigen::Vector3d> initial_orientations =
+      NoisyOrientations(reconstruction, state->rng());
+
+  RobustRotationEstimator::Options options;
+  std::unordered_map<ViewId, Eigen::Vector3d> orientations;
+  state->SetItemsPerRepetition(view_pairs.size());
+  state->Run(
+      [&]() {
+        RobustRotationEstimator rotation_estimator(options);
+        rotation_estimator.EstimateRotations(view_pairs, &orientations);
+      },
+      [&]() { orientations = initial_orientations; });
+  state->SetCounter("num_view_pairs", view_pairs.size());
+}
+
+// Estimates the positions from noisy relative translation directions and the
+// true orientations. The size is the number of views.
+void EstimatePositions(BenchmarkState* state) {
+  Reconstruction reconstruction;
+  CreateRingReconstruction(
+      state->problem_size(), 0, 0.0, state->rng(), &reconstruction);
+  std::unordered_map<ViewIdPair, TwoViewInfo> view_pairs;
+  CreateViewPairsFromReconstruction(reconstruction,
+                                    kNumNeighborsPerView,
+                                    kRelativePoseNoiseDegrees,
+                                    state->rng(),
+                                    &view_pairs);
+  std::unordered_map<ViewId, Eigen::Vector3d> orientations;
+  for (const ViewId view_id : reconstruction.ViewIds()) {
+    orientations[view_id] =
+        reconstruction.View(view_id)->Camera().GetOrientationAsAngleAxis();
+  }
+
+  // The generator of the random initial positions is reseeded for each
+  // repetition to start from the same positions.
+  NonlinearPositionEstimator::Options options;
+  std::unordered_map<ViewId, Eigen::Vector3d> positions;
+  state->SetItemsPerRepetition(view_pairs.size());
+  state->Run(
+      [&]() {
+        NonlinearPositionEstimator position_estimator(options, reconstruction);
+        position_estimator.EstimatePositions(
+            view_pairs, orientations, &positions);
+      },
+      [&]() {
+        options.rng = std::make_shared<RandomNumberGenerator>(state->seed());
+      });
+  state->SetCounter("num_view_pairs", view_pairs.size());
+}
+
+}  // namespace
+
+void AddSfmBenchmarks(std::vector<Benchmark>* benchmarks) {
+  benchmarks->push_back({"TrackBuilder/BuildTracks", {100, 500, 2000},
+                         BuildTracks});
+  benchmarks->push_back({"BundleAdjustReconstruction", {20, 50, 100},
+                         BundleAdjust});
+  benchmarks->push_back({"RobustRotationEstimator/EstimateRotations",
+                         {100, 500, 2000},
+                         EstimateRotations});
+  benchmarks->push_back({"NonlinearPositionEstimator/EstimatePositions",
+                         {50, 200, 500},
+                         EstimatePositions});
+}
+
+}  // namespace theia
@@ -0,0 +1,334 @@
+// Copyright (C) 2014 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include "theia/benchmark/synthetic_data.h"
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <glog/logging.h>
+#include <math.h>
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "theia/math/util.h"
+#include "theia/matching/feature_correspondence.h"
+#include "theia/sfm/camera/camera.h"
+#include "theia/sfm/pose/test_util.h"
+#include "theia/sfm/reconstruction.h"
+#include "theia/sfm/track.h"
+#include "theia/sfm/twoview_info.h"
+#include "theia/sfm/types.h"
+#include "theia/sfm/view.h"
+#include "theia/util/random.h"
+#include "theia/util/stringprintf.h"
+
+namespace theia {
+
+namespace {
+
+static const int kSiftDescriptorDimension = 128;
+
+// The cameras of the ring reconstruction.
+static const double kRingRadius = 10.0;
+static const double kFocalLength = 1000.0;
+static const int kImageSize = 1000;
+
+// Shuffles the elements with the given generator. std::shuffle is not used
+// because its output depends on the standard library.
+template <typename T>
+void Shuffle(RandomNumberGenerator* rng, std::vector<T>* elements) {
+  for (int i = static_cast<int>(elements->size()) - 1; i > 0; i--) {
+    std::swap((*elements)[i], (*elements)[rng->RandInt(0, i)]);
+  }
+}
+
+Eigen::VectorXf NormalizedSiftDescriptor(Eigen::VectorXf descriptor) {
+  descriptor = descriptor.cwiseMax(0.0f);
+  descriptor.normalize();
+  return descriptor;
+}
+
+Eigen::VectorXf RandomSiftDescriptor(RandomNumberGenerator* rng) {
+  Eigen::VectorXf descriptor(kSiftDescriptorDimension);
+  for (int i = 0; i < kSiftDescriptorDimension; i++) {
+    descriptor(i) = rng->RandDouble(0.0, 1.0);
+  }
+  return NormalizedSiftDescriptor(descriptor);
+}
+
+Eigen::Vector3d RandomUnitVector(RandomNumberGenerator* rng) {
+  Eigen::Vector3d vector;
+  do {
+    vector = Eigen::Vector3d(rng->RandGaussian(0.0, 1.0),
+                             rng->RandGaussian(0.0, 1.0),
+                             rng->RandGaussian(0.0, 1.0));
+  } while (vector.squaredNorm() < 1e-12);
+  return vector.normalized();
+}
+
+// Returns a rotation by an angle drawn from a Gaussian with the given standard
+// deviation in degrees around a random axis.
+Eigen::Matrix3d RandomRotation(const double std_dev_degrees,
+                               RandomNumberGenerator* rng) {
+  return Eigen::AngleAxisd(
+             DegToRad(rng->RandGaussian(0.0, std_dev_degrees)),
+             RandomUnitVector(rng)).toRotationMatrix();
+}
+
+}  // namespace
+
+void CreateDescriptorsForImagePair(
+    const int num_descriptors,
+    const double overlap,
+    RandomNumberGenerator* rng,
+    std::vector<Eigen::VectorXf>* descriptors1,
+    std::vector<Eigen::VectorXf>* descriptors2) {
+  CHECK_GE(overlap, 0.0);
+  CHECK_LE(overlap, 1.0);
+  static const double kDescriptorNoise = 0.01;
+
+  descriptors1->resize(num_descriptors);
+  descriptors2->resize(num_descriptors);
+  const int num_overlapping = static_cast<int>(overlap * num_descriptors);
+  for (int i = 0; i < num_descriptors; i++) {
+    (*descriptors1)[i] = RandomSiftDescriptor(rng);
+    if (i < num_overlapping) {
+      Eigen::VectorXf descriptor = (*descriptors1)[i];
+      for (int j = 0; j < kSiftDescriptorDimension; j++) {
+        descriptor(j) += rng->RandGaussian(0.0, kDescriptorNoise);
+      }
+      (*descriptors2)[i] = NormalizedSiftDescriptor(descriptor);
+    } else {
+      (*descriptors2)[i] = RandomSiftDescriptor(rng);
+    }
+  }
+  Shuffle(rng, descriptors2);
+}
+
+void CreateTwoViewCorrespondences(
+    const int num_correspondences,
+    const double inlier_ratio,
+    const double noise,
+    RandomNumberGenerator* rng,
+    std::vector<FeatureCorrespondence>* correspondences,
+    Eigen::Matrix3d* rotation,
+    Eigen::Vector3d* position) {
+  CHECK_NOTNULL(correspondences);
+  CHECK_NOTNULL(rotation);
+  CHECK_NOTNULL(position);
+  CHECK_GE(inlier_ratio, 0.0);
+  CHECK_LE(inlier_ratio, 1.0);
+  static const double kNearPlaneWidth = 1.0;
+  static const double kNearPlaneDepth = 2.0;
+  static const double kFarPlaneDepth = 8.0;
+
+  const int num_inliers = static_cast<int>(inlier_ratio * num_correspondences);
+  std::vector<Eigen::Vector3d> points;
+  CreateRandomPointsInFrustum(kNearPlaneWidth,
+                              kNearPlaneWidth,
+                              kNearPlaneDepth,
+                              kFarPlaneDepth,
+                              num_inliers,
+                              &points);
+
+  // The second camera is rotated by a few degrees and moved sideways.
+  *rotation = RandomRotation(5.0, rng);
+  const Eigen::Vector3d translation(
+      1.0, rng->RandDouble(-0.2, 0.2), rng->RandDouble(-0.2, 0.2));
+  *position = (-rotation->transpose() * translation).normalized();
+
+  correspondences->clear();
+  correspondences->reserve(num_correspondences);
+  for (const Eigen::Vector3d& point : points) {
+    FeatureCorrespondence correspondence;
+    correspondence.feature1 = point.hnormalized();
+    correspondence.feature2 = (*rotation * point + translation).hnormalized();
+    AddNoiseToProjection(noise, &correspondence.feature1);
+    AddNoiseToProjection(noise, &correspondence.feature2);
+    correspondences->emplace_back(correspondence);
+  }
+  for (int i = num_inliers; i < num_correspondences; i++) {
+    FeatureCorrespondence correspondence;
+    correspondence.feature1 =
+        Eigen::Vector2d(rng->RandDouble(-0.5, 0.5), rng->RandDouble(-0.5, 0.5));
+    correspondence.feature2 =
+        Eigen::Vector2d(rng->RandDouble(-0.5, 0.5), rng->RandDouble(-0.5, 0.5));
+    correspondences->emplace_back(correspondence);
+  }
+  Shuffle(rng, correspondences);
+}
+
+void CreateRingReconstruction(const int num_views,
+                              const int num_tracks,
+                              const double pixel_noise,
+                              RandomNumberGenerator* rng,
+                              Reconstruction* reconstruction) {
+  CHECK_GE(num_views, 3);
+  CHECK_NOTNULL(reconstruction);
+  static const int kMinTrackLength = 3;
+  static const int kMaxTrackLength = 6;
+  static const double kPointSpread = 2.0;
+
+  std::vector<ViewId> view_ids(num_views);
+  for (int i = 0; i < num_views; i++) {
+    view_ids[i] = reconstruction->AddView(StringPrintf("view_%d", i));
+    View* view = reconstruction->MutableView(view_ids[i]);
+    view->SetEstimated(true);
+
+    // Place the camera on the ring and point its z-axis at the center.
+    const double angle = 2.0 * M_PI * i / num_views;
+    const Eigen::Vector3d position(kRingRadius * std::cos(angle),
+                                   rng->RandDouble(-1.0, 1.0),
+                                   kRingRadius * std::sin(angle));
+    const Eigen::Vector3d z_axis = -position.normalized();
+    const Eigen::Vector3d x_axis =
+        Eigen::Vector3d::UnitY().cross(z_axis).normalized();
+    Eigen::Matrix3d rotation;
+    rotation.row(0) = x_axis;
+    rotation.row(1) = z_axis.cross(x_axis);
+    rotation.row(2) = z_axis;
+
+    Camera* camera = view->MutableCamera();
+    camera->SetPosition(position);
+    camera->SetOrientationFromRotationMatrix(rotation);
+    camera->SetFocalLength(kFocalLength);
+    camera->SetPrincipalPoint(kImageSize / 2.0, kImageSize / 2.0);
+    camera->SetImageSize(kImageSize, kImageSize);
+  }
+
+  std::vector<std::pair<ViewId, Feature> > observations;
+  for (int i = 0; i < num_tracks; i++) {
+    const Eigen::Vector4d point(rng->RandDouble(-kPointSpread, kPointSpread),
+                                rng->RandDouble(-kPointSpread, kPointSpread),
+                                rng->RandDouble(-kPointSpread, kPointSpread),
+                                1.0);
+    const int first_view = rng->RandInt(0, num_views - 1);
+    const int track_length = std::min(
+        num_views, rng->RandInt(kMinTrackLength, kMaxTrackLength));
+
+    observations.clear();
+    for (int j = 0; j < track_length; j++) {
+      const ViewId view_id = view_ids[(first_view + j) % num_views];
+      Feature feature;
+      const double depth =
+          reconstruction->View(view_id)->Camera().ProjectPoint(point, &feature);
+      CHECK_GT(depth, 0.0);
+      feature += Feature(rng->RandGaussian(0.0, pixel_noise),
+                         rng->RandGaussian(0.0, pixel_noise));
+      observations.emplace_back(view_id, feature);
+    }
+
+    const TrackId track_id = reconstruction->AddTrack(observations);
+    Track* track = reconstruction->MutableTrack(track_id);
+    *track->MutablePoint() = point;
+    track->SetEstimated(true);
+  }
+}
+
+void CreateFeatureMatchesFromReconstruction(
+    const Reconstruction& reconstruction,
+    RandomNumberGenerator* rng,
+    std::vector<SyntheticFeatureMatch>* matches) {
+  matches->clear();
+  std::vector<TrackId> track_ids = reconstruction.TrackIds();
+  std::sort(track_ids.begin(), track_ids.end());
+  for (const TrackId track_id : track_ids) {
+    const Track* track = reconstruction.Track(track_id);
+    std::vector<ViewId> track_view_ids(track->ViewIds().begin(),
+                                       track->ViewIds().end());
+    std::sort(track_view_ids.begin(), track_view_ids.end());
+
+    for (int i = 0; i < track_view_ids.size(); i++) {
+      // Match each observation to the next one, and the last one to the
+      // first, so that the track is found from redundant matches.
+      const ViewId view_id1 = track_view_ids[i];
+      const ViewId view_id2 = track_view_ids[(i + 1) % track_view_ids.size()];
+      SyntheticFeatureMatch match;
+      match.view_id1 = view_id1;
+      match.feature1 = *reconstruction.View(view_id1)->GetFeature(track_id);
+      match.view_id2 = view_id2;
+      match.feature2 = *reconstruction.View(view_id2)->GetFeature(track_id);
+      matches->emplace_back(match);
+    }
+  }
+  Shuffle(rng, matches);
+}
+
+void CreateViewPairsFromReconstruction(
+    const Reconstruction& reconstruction,
+    const int num_neighbors,
+    const double noise_degrees,
+    RandomNumberGenerator* rng,
+    std::unordered_map<ViewIdPair, TwoViewInfo>* view_pairs) {
+  std::vector<ViewId> view_ids = reconstruction.ViewIds();
+  std::sort(view_ids.begin(), view_ids.end());
+  const int num_views = view_ids.size();
+
+  view_pairs->clear();
+  for (int i = 0; i < num_views; i++) {
+    for (int j = 1; j <= num_neighbors && j < num_views; j++) {
+      const ViewId neighbor_id = view_ids[(i + j) % num_views];
+      const ViewId view_id1 = std::min(view_ids[i], neighbor_id);
+      const ViewId view_id2 = std::max(view_ids[i], neighbor_id);
+      const ViewIdPair view_id_pair(view_id1, view_id2);
+      if (view_pairs->count(view_id_pair) > 0) {
+        continue;
+      }
+
+      const Camera& camera1 = reconstruction.View(view_id1)->Camera();
+      const Camera& camera2 = reconstruction.View(view_id2)->Camera();
+      const Eigen::Matrix3d rotation1 =
+          camera1.GetOrientationAsRotationMatrix();
+      const Eigen::Matrix3d rotation2 =
+          camera2.GetOrientationAsRotationMatrix();
+
+      TwoViewInfo info;
+      info.focal_length_1 = camera1.FocalLength();
+      info.focal_length_2 = camera2.FocalLength();
+      const Eigen::AngleAxisd relative_rotation(
+          RandomRotation(noise_degrees, rng) * rotation2 *
+          rotation1.transpose());
+      info.rotation_2 = relative_rotation.angle() * relative_rotation.axis();
+      info.position_2 = RandomRotation(noise_degrees, rng) * rotation1 *
+                        (camera2.GetPosition() - camera1.GetPosition());
+      info.position_2.normalize();
+      info.num_verified_matches = 100;
+      (*view_pairs)[view_id_pair] = info;
+    }
+  }
+}
+
+}  // namespace theia
@@ -0,0 +1,120 @@
+// Copyright (C) 2014 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#ifndef THEIA_BENCHMARK_SYNTHETIC_DATA_H_
+#define THEIA_BENCHMARK_SYNTHETIC_DATA_H_
+
+#include <Eigen/Core>
+#include <unordered_map>
+#include <vector>
+
+#include "theia/matching/feature_correspondence.h"
+#include "theia/sfm/twoview_info.h"
+#include "theia/sfm/types.h"
+#include "theia/util/hash.h"
+
+namespace theia {
+
+class Reconstruction;
+class RandomNumberGenerator;
+
+// Generators of synthetic inputs for the benchmarks. All of them draw their
+// random numbers from the given generator (and, for the helpers of
+// sfm/pose/test_util.h, from the shared generator), so the data only depends
+// on the seed.
+
+// Creates SIFT-like descriptors (128 non-negative entries of unit norm) for an
+// image pair. The first overlap * num_descriptors descriptors of image 2 are
+// noisy copies of descriptors of image 1, and the descriptors of image 2 are
+// shuffled.
+void CreateDescriptorsForImagePair(
+    const int num_descriptors,
+    const double overlap,
+    RandomNumberGenerator* rng,
+    std::vector<Eigen::VectorXf>* descriptors1,
+    std::vector<Eigen::VectorXf>* descriptors2);
+
+// Creates correspondences between two calibrated views in normalized image
+// coordinates. Inliers are projections of random points in the frustum of the
+// first camera with noise added; outliers are random points. The rotation and
+// the unit-norm position of the second camera are returned so that the
+// accuracy of an estimate can be measured.
+void CreateTwoViewCorrespondences(
+    const int num_correspondences,
+    const double inlier_ratio,
+    const double noise,
+    RandomNumberGenerator* rng,
+    std::vector<FeatureCorrespondence>* correspondences,
+    Eigen::Matrix3d* rotation,
+    Eigen::Vector3d* position);
+
+// Creates a reconstruction with num_views cameras on a ring that look at the
+// center and num_tracks points around the center. Each point is observed by
+// 3 to 6 consecutive cameras with pixel noise added to the observations. The
+// views and tracks are estimated.
+void CreateRingReconstruction(const int num_views,
+                              const int num_tracks,
+                              const double pixel_noise,
+                              RandomNumberGenerator* rng,
+                              Reconstruction* reconstruction);
+
+// A feature match between two views as it is passed to the track builder.
+struct SyntheticFeatureMatch {
+  ViewId view_id1;
+  Feature feature1;
+  ViewId view_id2;
+  Feature feature2;
+};
+
+// Returns the matches between the consecutive observations of each track of
+// the reconstruction and between the first and the last observation, in a
+// random order.
+void CreateFeatureMatchesFromReconstruction(
+    const Reconstruction& reconstruction,
+    RandomNumberGenerator* rng,
+    std::vector<SyntheticFeatureMatch>* matches);
+
+// Creates the relative poses between each view and the next num_neighbors
+// views of the reconstruction, with noise (in degrees) added to the relative
+// rotations and translation directions.
+void CreateViewPairsFromReconstruction(
+    const Reconstruction& reconstruction,
+    const int num_neighbors,
+    const double noise_degrees,
+    RandomNumberGenerator* rng,
+    std::unordered_map<ViewIdPair, TwoViewInfo>* view_pairs);
+
+}  // namespace theia
+
+#endif  // THEIA_BENCHMARK_SYNTHETIC_DATA_H_
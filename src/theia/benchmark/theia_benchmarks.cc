@@ -0,0 +1,143 @@
+// Copyright (C) 2014 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <stdio.h>
+#include <regex>  // NOLINT
+#include <sstream>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "theia/benchmark/benchmark.h"
+
+// Runs the benchmarks of the hot paths of the library on synthetic data, e.g.
+//   ./theia_benchmarks --benchmark_filter=Cascade --benchmark_scales=small
+//       --benchmark_output_file=results.json
+DEFINE_string(benchmark_filter, ".*",
+              "Only the benchmarks whose name matches this regular expression "
+              "are run.");
+DEFINE_string(benchmark_scales, "small,medium,large",
+              "Comma-separated list of the problem scales to run. Valid "
+              "scales are small, medium and large.");
+DEFINE_double(benchmark_min_time, 1.0,
+              "Each benchmark is repeated for at least this many seconds.");
+DEFINE_int32(benchmark_min_repetitions, 3,
+             "Each benchmark is repeated at least this many times.");
+DEFINE_int32(benchmark_max_repetitions, 1000,
+             "Each benchmark is repeated at most this many times.");
+DEFINE_int32(benchmark_seed, 42,
+             "Seed of the synthetic data and of the randomized algorithms.");
+DEFINE_string(benchmark_output_file, "",
+              "If set, the results are written to this file as JSON.");
+DEFINE_bool(benchmark_list, false,
+            "List the benchmarks and their problem sizes without running "
+            "them.");
+
+namespace {
+
+// Returns the indices into theia::kBenchmarkScaleNames of the scales in the
+// comma-separated list.
+std::vector<int> ParseScales(const std::string& scales) {
+  std::vector<int> scale_indices;
+  std::stringstream ss(scales);
+  std::string scale;
+  while (std::getline(ss, scale, ',')) {
+    bool found = false;
+    for (int i = 0; i < 3; i++) {
+      if (scale == theia::kBenchmarkScaleNames[i]) {
+        scale_indices.emplace_back(i);
+        found = true;
+      }
+    }
+    CHECK(found) << "Invalid benchmark scale: " << scale;
+  }
+  return scale_indices;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  THEIA_GFLAGS_NAMESPACE::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+
+  std::vector<theia::Benchmark> benchmarks;
+  theia::AddMatchingBenchmarks(&benchmarks);
+  theia::AddPoseBenchmarks(&benchmarks);
+  theia::AddSfmBenchmarks(&benchmarks);
+
+  const std::regex filter(FLAGS_benchmark_filter);
+  const std::vector<int> scale_indices = ParseScales(FLAGS_benchmark_scales);
+
+  theia::BenchmarkOptions options;
+  options.min_time_in_seconds = FLAGS_benchmark_min_time;
+  options.min_num_repetitions = FLAGS_benchmark_min_repetitions;
+  options.max_num_repetitions = FLAGS_benchmark_max_repetitions;
+  options.seed = FLAGS_benchmark_seed;
+
+  if (!FLAGS_benchmark_list) {
+    printf("%-48s %-6s %7s %5s %12s %12s %14s\n", "benchmark", "scale",
+           "size", "reps", "median (ms)", "min (ms)", "items/s");
+  }
+  std::vector<theia::BenchmarkResult> results;
+  for (const theia::Benchmark& benchmark : benchmarks) {
+    if (!std::regex_search(benchmark.name, filter)) {
+      continue;
+    }
+    if (FLAGS_benchmark_list) {
+      printf("%-48s %d %d %d\n", benchmark.name.c_str(),
+             benchmark.problem_sizes[0], benchmark.problem_sizes[1],
+             benchmark.problem_sizes[2]);
+      continue;
+    }
+
+    for (const int scale_index : scale_indices) {
+      const theia::BenchmarkResult result =
+          theia::RunBenchmark(options, benchmark, scale_index);
+      printf("%-48s %-6s %7d %5d %12.4f %12.4f %14.1f\n", result.name.c_str(),
+             result.scale.c_str(), result.problem_size, result.num_repetitions,
+             1e3 * result.median_seconds, 1e3 * result.min_seconds,
+             result.items_per_second);
+      fflush(stdout);
+      results.emplace_back(result);
+    }
+  }
+
+  if (!FLAGS_benchmark_output_file.empty() &&
+      !theia::WriteBenchmarkResultsToJson(options, results,
+                                          FLAGS_benchmark_output_file)) {
+    return 1;
+  }
+  return 0;
+}
@@ -36,6 +36,9 @@
 
 #include <glog/logging.h>
 #include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 #include "theia/image/descriptor/descriptor_extractor.h"
 #include "theia/image/descriptor/sift_descriptor.h"
@@ -58,4 +61,30 @@ std::unique_ptr<DescriptorExtractor> CreateDescriptorExtractor(
   return descriptor_extractor;
 }
 
+DescriptorExtractorPool::DescriptorExtractorPool(
+    const CreateDescriptorExtractorOptions& options)
+    : options_(options) {}
+
+std::unique_ptr<DescriptorExtractor> DescriptorExtractorPool::Acquire() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!descriptor_extractors_.empty()) {
+      std::unique_ptr<DescriptorExtractor> descriptor_extractor =
+          std::move(descriptor_extractors_.back());
+      descriptor_extractors_.pop_back();
+      return descriptor_extractor;
+    }
+  }
+  // Create the extractor outside of the lock so that other threads are not
+  // blocked by the initialization.
+  return CreateDescriptorExtractor(options_);
+}
+
+void DescriptorExtractorPool::Release(
+    std::unique_ptr<DescriptorExtractor> descriptor_extractor) {
+  CHECK_NOTNULL(descriptor_extractor.get());
+  std::lock_guard<std::mutex> lock(mutex_);
+  descriptor_extractors_.emplace_back(std::move(descriptor_extractor));
+}
+
 }  // namespace theia
@@ -36,9 +36,12 @@
 #define THEIA_IMAGE_DESCRIPTOR_CREATE_DESCRIPTOR_EXTRACTOR_H_
 
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include "theia/image/descriptor/descriptor_extractor.h"
 #include "theia/image/keypoint_detector/sift_parameters.h"
+#include "theia/util/util.h"
 
 namespace theia {
 
@@ -62,6 +65,32 @@ struct CreateDescriptorExtractorOptions {
 std::unique_ptr<DescriptorExtractor> CreateDescriptorExtractor(
     const CreateDescriptorExtractorOptions& options);
 
+// A thread-safe pool of descriptor extractors. Descriptor extractors hold
+// buffers (e.g., the SIFT scale space) that are expensive to allocate for large
+// images, so the threads of a threadpool should acquire an extractor for each
+// image and release it afterwards instead of creating a new extractor. An
+// extractor is only created when all existing extractors are in use, so at most
+// one extractor is created per thread.
+class DescriptorExtractorPool {
+ public:
+  explicit DescriptorExtractorPool(
+      const CreateDescriptorExtractorOptions& options);
+
+  // Returns an extractor that is not used by any other thread.
+  std::unique_ptr<DescriptorExtractor> Acquire();
+
+  // Returns the extractor to the pool so that it can be reused.
+  void Release(std::unique_ptr<DescriptorExtractor> descriptor_extractor);
+
+ private:
+  const CreateDescriptorExtractorOptions options_;
+
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<DescriptorExtractor> > descriptor_extractors_;
+
+  DISALLOW_COPY_AND_ASSIGN(DescriptorExtractorPool);
+};
+
 }  // namespace theia
 
 #endif  // THEIA_IMAGE_DESCRIPTOR_CREATE_DESCRIPTOR_EXTRACTOR_H_
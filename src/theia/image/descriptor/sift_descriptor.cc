@@ -35,7 +35,10 @@
 #include "theia/image/descriptor/sift_descriptor.h"
 
 #include <algorithm>
+#include <cmath>
+#include <functional>
 extern "C" {
+#include "vl/imopv.h"
 #include "vl/sift.h"
 }
 #include <vector>
@@ -45,6 +48,8 @@ extern "C" {
 #include "theia/image/image.h"
 #include "theia/image/descriptor/descriptor_extractor.h"
 #include "theia/image/keypoint_detector/keypoint.h"
+#include "theia/image/keypoint_detector/sift_filter_cache.h"
+#include "theia/util/threadpool.h"
 
 namespace theia {
 namespace {
@@ -66,10 +71,237 @@ double GetValidFirstOctave(const int first_octave,
   return valid_first_octave;
 }
 
+// A region of the image that is processed with its own SIFT filter. The
+// keypoints are only kept if they lie within [min_x, max_x) x [min_y, max_y),
+// which allows the region to overlap with other regions.
+struct SiftRegion {
+  int x, y, width, height;
+  double min_x, min_y, max_x, max_y;
+};
+
+// Detects the keypoints in all octaves of the filter and extracts their
+// descriptors. The first octave must have been processed already. Keypoints
+// are returned in the coordinates of the full image.
+void DetectAndExtractInOctaves(const SiftParameters& sift_params,
+                               const SiftRegion& region,
+                               VlSiftFilt* sift_filter,
+                               int vl_status,
+                               std::vector<Keypoint>* keypoints,
+                               std::vector<Eigen::VectorXf>* descriptors) {
+  // Process octaves until you can't anymore.
+  while (vl_status != VL_ERR_EOF) {
+    // Detect the keypoints.
+    vl_sift_detect(sift_filter);
+
+    // Get the keypoints.
+    const VlSiftKeypoint* vl_keypoints = vl_sift_get_keypoints(sift_filter);
+    const int num_keypoints = vl_sift_get_nkeypoints(sift_filter);
+
+    for (int i = 0; i < num_keypoints; ++i) {
+      const double x = vl_keypoints[i].x + region.x;
+      const double y = vl_keypoints[i].y + region.y;
+      if (x < region.min_x || x >= region.max_x ||
+          y < region.min_y || y >= region.max_y) {
+        continue;
+      }
+
+      // Calculate (up to 4) orientations of the keypoint.
+      double angles[4];
+      int num_angles = vl_sift_calc_keypoint_orientations(sift_filter,
+                                                          angles,
+                                                          &vl_keypoints[i]);
+      // If upright sift is enabled, only use the first keypoint at a given
+      // pixel location.
+      if (sift_params.upright_sift && num_angles > 1) {
+        num_angles = 1;
+      }
+
+      for (int j = 0; j < num_angles; ++j) {
+        descriptors->emplace_back(128);
+        vl_sift_calc_keypoint_descriptor(
+            sift_filter, descriptors->back().data(), &vl_keypoints[i],
+            angles[j]);
+
+        Keypoint keypoint(x, y, Keypoint::SIFT);
+        keypoint.set_scale(vl_keypoints[i].sigma);
+        keypoint.set_orientation(angles[j]);
+        keypoint.set_strength(DoGResponse(sift_filter, vl_keypoints[i]));
+        keypoints->push_back(keypoint);
+      }
+    }
+    // The octaves are processed from fine to coarse, so the remaining octaves
+    // may be skipped once enough keypoints have been detected.
+    if (sift_params.max_num_keypoints > 0 &&
+        keypoints->size() >= sift_params.max_num_keypoints) {
+      break;
+    }
+
+    // Attempt to process the next octave.
+    vl_status = vl_sift_process_next_octave(sift_filter);
+  }
+}
+
+// Processes the octaves of the region with the given filter, which must have
+// the size of the region.
+void DetectAndExtractInRegion(const SiftParameters& sift_params,
+                              const float* image_data,
+                              const int image_width,
+                              const SiftRegion& region,
+                              VlSiftFilt* sift_filter,
+                              std::vector<Keypoint>* keypoints,
+                              std::vector<Eigen::VectorXf>* descriptors) {
+  // Copy the region so that its pixels are contiguous.
+  std::vector<float> region_data(region.width * region.height);
+  for (int y = 0; y < region.height; y++) {
+    const float* row = image_data + (region.y + y) * image_width + region.x;
+    std::copy(row, row + region.width, region_data.begin() + y * region.width);
+  }
+
+  const int vl_status =
+      vl_sift_process_first_octave(sift_filter, region_data.data());
+  DetectAndExtractInOctaves(sift_params, region, sift_filter, vl_status,
+                            keypoints, descriptors);
+}
+
+// Processes the octaves [first_octave, first_octave + num_octaves) of the
+// tiles first_tile, first_tile + tile_step, ... one after another. Tiles of
+// the same size share a filter of the cache.
+void DetectAndExtractInTiles(
+    const SiftParameters& sift_params,
+    const float* image_data,
+    const int image_width,
+    const std::vector<SiftRegion>& tiles,
+    const int first_tile,
+    const int tile_step,
+    const int first_octave,
+    const int num_octaves,
+    SiftFilterCache* sift_filter_cache,
+    std::vector<std::vector<Keypoint> >* keypoints,
+    std::vector<std::vector<Eigen::VectorXf> >* descriptors) {
+  for (int i = first_tile; i < tiles.size(); i += tile_step) {
+    VlSiftFilt* sift_filter = sift_filter_cache->GetFilter(
+        tiles[i].width, tiles[i].height, first_octave, num_octaves);
+    DetectAndExtractInRegion(sift_params, image_data, image_width, tiles[i],
+                             sift_filter, &(*keypoints)[i],
+                             &(*descriptors)[i]);
+  }
+}
+
+// Computes the first level of the given octave (> 0) of the scale space of the
+// image in the same way as the SIFT filter does: every octave starts with a
+// smoothing of 1.6 in the units of the octave, and the next octave is obtained
+// by doubling the smoothing and subsampling by a factor of 2. The image is
+// assumed to have a nominal smoothing of 0.5 as in VLFeat.
+void ComputeOctaveBaseImage(const float* image_data,
+                            const int image_width,
+                            const int image_height,
+                            const int octave,
+                            std::vector<float>* base_image,
+                            int* base_width,
+                            int* base_height) {
+  static const double kOctaveSigma = 1.6;
+  static const double kNominalSigma = 0.5;
+
+  std::vector<float> image(image_data,
+                           image_data + image_width * image_height);
+  std::vector<float> smoothed_image(image.size());
+  int width = image_width;
+  int height = image_height;
+  double sigma = kNominalSigma;
+  for (int o = 0; o < octave; o++) {
+    const double smoothing =
+        std::sqrt(4.0 * kOctaveSigma * kOctaveSigma - sigma * sigma);
+    vl_imsmooth_f(smoothed_image.data(), width, image.data(), width, height,
+                  width, smoothing, smoothing);
+
+    const int subsampled_width = width / 2;
+    const int subsampled_height = height / 2;
+    for (int y = 0; y < subsampled_height; y++) {
+      for (int x = 0; x < subsampled_width; x++) {
+        image[y * subsampled_width + x] =
+            smoothed_image[2 * y * width + 2 * x];
+      }
+    }
+    width = subsampled_width;
+    height = subsampled_height;
+    sigma = kOctaveSigma;
+  }
+
+  image.resize(width * height);
+  base_image->swap(image);
+  *base_width = width;
+  *base_height = height;
+}
+
+// Processes the octaves [first_octave, first_octave + num_octaves) of the full
+// image. If the first octave is coarser than the image resolution, the filter
+// starts from the downsampled octave instead of subsampling the image without
+// smoothing so that the keypoints match those of a single filter.
+void DetectAndExtractInCoarseOctaves(
+    const SiftParameters& sift_params,
+    const float* image_data,
+    const int image_width,
+    const int image_height,
+    const int first_octave,
+    const int num_octaves,
+    std::vector<Keypoint>* keypoints,
+    std::vector<Eigen::VectorXf>* descriptors) {
+  const SiftRegion full_image = { 0, 0, image_width, image_height,
+                                  0.0, 0.0, static_cast<double>(image_width),
+                                  static_cast<double>(image_height) };
+  if (first_octave <= 0) {
+    VlSiftFilt* sift_filter = vl_sift_new(image_width, image_height,
+                                          num_octaves, sift_params.num_levels,
+                                          first_octave);
+    vl_sift_set_edge_thresh(sift_filter, sift_params.edge_threshold);
+    vl_sift_set_peak_thresh(sift_filter, sift_params.peak_threshold);
+    DetectAndExtractInRegion(sift_params, image_data, image_width, full_image,
+                             sift_filter, keypoints, descriptors);
+    vl_sift_delete(sift_filter);
+    return;
+  }
+
+  std::vector<float> base_image;
+  int base_width, base_height;
+  ComputeOctaveBaseImage(image_data, image_width, image_height, first_octave,
+                         &base_image, &base_width, &base_height);
+
+  VlSiftFilt* sift_filter = vl_sift_new(base_width, base_height, num_octaves,
+                                        sift_params.num_levels, 0);
+  vl_sift_set_edge_thresh(sift_filter, sift_params.edge_threshold);
+  vl_sift_set_peak_thresh(sift_filter, sift_params.peak_threshold);
+  // The base image is already smoothed, so it must not be smoothed again.
+  sift_filter->sigman = 2.0 * sift_filter->sigma0;
+  const int vl_status =
+      vl_sift_process_first_octave(sift_filter, base_image.data());
+  const SiftRegion base_region = { 0, 0, base_width, base_height,
+                                   0.0, 0.0, static_cast<double>(base_width),
+                                   static_cast<double>(base_height) };
+  const int num_previous_keypoints = keypoints->size();
+  DetectAndExtractInOctaves(sift_params, base_region, sift_filter, vl_status,
+                            keypoints, descriptors);
+  vl_sift_delete(sift_filter);
+
+  // Convert the keypoints to the coordinates of the full image.
+  const double scale = std::pow(2.0, first_octave);
+  for (int i = num_previous_keypoints; i < keypoints->size(); i++) {
+    Keypoint& keypoint = (*keypoints)[i];
+    keypoint.set_x(keypoint.x() * scale);
+    keypoint.set_y(keypoint.y() * scale);
+    keypoint.set_scale(keypoint.scale() * scale);
+  }
+}
+
 }  // namespace
 
-SiftDescriptorExtractor::~SiftDescriptorExtractor() {
-  if (sift_filter_ != nullptr) vl_sift_delete(sift_filter_);
+void SiftDescriptorExtractor::SetSiftFilter(const FloatImage& image) {
+  // Filters are reused for successive calls with images of the same size (e.g.
+  // a video sequence) so that the scale space is not reallocated.
+  const int first_octave = GetValidFirstOctave(sift_params_.first_octave,
+                                               image.Rows(),
+                                               image.Cols());
+  sift_filter_ =
+      sift_filter_cache_.GetFilter(image.Cols(), image.Rows(), first_octave);
 }
 
 bool SiftDescriptorExtractor::ComputeDescriptor(
@@ -79,34 +311,16 @@ bool SiftDescriptorExtractor::ComputeDescriptor(
   CHECK(keypoint.has_scale() && keypoint.has_orientation())
       << "Keypoint must have scale and orientation to compute a SIFT "
       << "descriptor.";
-  // If the filter has been set, but is not usable for the input image (i.e. the
-  // width and height are different) then we must make a new filter. Adding this
-  // statement will save the function from regenerating the filter for
-  // successive calls with images of the same size (e.g. a video sequence).
-  if (sift_filter_ == nullptr || (sift_filter_->width != image.Cols() ||
-                                  sift_filter_->height != image.Rows())) {
-    vl_sift_delete(sift_filter_);
-    const int first_octave =
-        GetValidFirstOctave(sift_params_.first_octave,
-                            image.Rows(), image.Cols());
-    sift_filter_ = vl_sift_new(image.Cols(), image.Rows(),
-                               sift_params_.num_octaves,
-                               sift_params_.num_levels, first_octave);
-  }
+  SetSiftFilter(image);
 
   // Create the vl sift keypoint from the one passed in.
   VlSiftKeypoint sift_keypoint;
   vl_sift_keypoint_init(sift_filter_, &sift_keypoint, keypoint.x(),
                         keypoint.y(), keypoint.scale());
 
-  // The VLFeat functions take in a non-const image pointer so that it can
-  // calculate gaussian pyramids. Obviously, we do not want to break our const
-  // input, so the best solution (for now) is to copy the image.
-  FloatImage mutable_image = image.AsGrayscaleImage();
-
   // Calculate the first octave to process.
-  int vl_status =
-      vl_sift_process_first_octave(sift_filter_, mutable_image.Data());
+  int vl_status = vl_sift_process_first_octave(
+      sift_filter_, image.GrayscaleData(&grayscale_buffer_));
   // Proceed through the octaves we reach the same one as the keypoint.
   while (sift_keypoint.o != sift_filter_->o_cur)
     vl_sift_process_next_octave(sift_filter_);
@@ -129,20 +343,7 @@ bool SiftDescriptorExtractor::ComputeDescriptors(
     const FloatImage& image,
     std::vector<Keypoint>* keypoints,
     std::vector<Eigen::VectorXf>* descriptors) {
-  // If the filter has been set, but is not usable for the input image (i.e. the
-  // width and height are different) then we must make a new filter. Adding this
-  // statement will save the function from regenerating the filter for
-  // successive calls with images of the same size (e.g. a video sequence).
-  if (sift_filter_ == nullptr || (sift_filter_->width != image.Cols() ||
-                                  sift_filter_->height != image.Rows())) {
-    vl_sift_delete(sift_filter_);
-    const int first_octave =
-        GetValidFirstOctave(sift_params_.first_octave,
-                            image.Rows(), image.Cols());
-    sift_filter_ = vl_sift_new(image.Cols(), image.Rows(),
-                               sift_params_.num_octaves,
-                               sift_params_.num_levels, first_octave);
-  }
+  SetSiftFilter(image);
 
   // Create the vl sift keypoint from the one passed in.
   std::vector<VlSiftKeypoint> sift_keypoints(keypoints->size());
@@ -156,14 +357,9 @@ bool SiftDescriptorExtractor::ComputeDescriptors(
                           (*keypoints)[i].y(),
                           (*keypoints)[i].scale());
   }
-  // The VLFeat functions take in a non-const image pointer so that it can
-  // calculate gaussian pyramids. Obviously, we do not want to break our const
-  // input, so the best solution (for now) is to copy the image.
-  FloatImage mutable_image = image.AsGrayscaleImage();
-
   // Calculate the first octave to process.
-  int vl_status =
-      vl_sift_process_first_octave(sift_filter_, mutable_image.Data());
+  int vl_status = vl_sift_process_first_octave(
+      sift_filter_, image.GrayscaleData(&grayscale_buffer_));
 
   // Proceed through the octaves we reach the same one as the keypoint.  We
   // first resize the descriptors vector so that the keypoint indicies will be
@@ -194,75 +390,154 @@ bool SiftDescriptorExtractor::DetectAndExtractDescriptors(
     const FloatImage& image,
     std::vector<Keypoint>* keypoints,
     std::vector<Eigen::VectorXf>* descriptors) {
-  // If the filter has been set, but is not usable for the input image (i.e. the
-  // width and height are different) then we must make a new filter. Adding this
-  // statement will save the function from regenerating the filter for
-  // successive calls with images of the same size (e.g. a video sequence).
-  if (sift_filter_ == nullptr || (sift_filter_->width != image.Cols() ||
-                                  sift_filter_->height != image.Rows())) {
-    vl_sift_delete(sift_filter_);
-    const int first_octave =
-        GetValidFirstOctave(sift_params_.first_octave,
-                            image.Rows(), image.Cols());
-    sift_filter_ = vl_sift_new(image.Cols(), image.Rows(),
-                               sift_params_.num_octaves,
-                               sift_params_.num_levels, first_octave);
-    vl_sift_set_edge_thresh(sift_filter_, sift_params_.edge_threshold);
-    vl_sift_set_peak_thresh(sift_filter_, sift_params_.peak_threshold);
+  if (sift_params_.num_threads > 1 &&
+      std::max(image.Cols(), image.Rows()) > sift_params_.tile_size) {
+    DetectAndExtractDescriptorsInTiles(image, keypoints, descriptors);
+  } else {
+    SetSiftFilter(image);
+
+    // Calculate the first octave to process. VLFeat copies the grayscale
+    // pixels into its own scale space, so the input image does not need to be
+    // copied.
+    const int vl_status = vl_sift_process_first_octave(
+        sift_filter_, image.GrayscaleData(&grayscale_buffer_));
+    const SiftRegion region = { 0, 0, image.Cols(), image.Rows(),
+                                0.0, 0.0, static_cast<double>(image.Cols()),
+                                static_cast<double>(image.Rows()) };
+    DetectAndExtractInOctaves(sift_params_, region, sift_filter_, vl_status,
+                              keypoints, descriptors);
   }
 
-  // The VLFeat functions take in a non-const image pointer so that it can
-  // calculate gaussian pyramids. Obviously, we do not want to break our const
-  // input, so the best solution (for now) is to copy the image.
-  FloatImage mutable_image = image.AsGrayscaleImage();
-
-  // Calculate the first octave to process.
-  int vl_status =
-      vl_sift_process_first_octave(sift_filter_, mutable_image.Data());
-  // Process octaves until you can't anymore.
-  while (vl_status != VL_ERR_EOF) {
-    // Detect the keypoints.
-    vl_sift_detect(sift_filter_);
+  if (sift_params_.root_sift) {
+    for (int i = 0; i < descriptors->size(); i++) {
+      ConvertToRootSift(&(*descriptors)[i]);
+    }
+  }
 
-    // Get the keypoints.
-    const VlSiftKeypoint* vl_keypoints = vl_sift_get_keypoints(sift_filter_);
-    const int num_keypoints = vl_sift_get_nkeypoints(sift_filter_);
+  return true;
+}
 
-    for (int i = 0; i < num_keypoints; ++i) {
-      // Calculate (up to 4) orientations of the keypoint.
-      double angles[4];
-      int num_angles = vl_sift_calc_keypoint_orientations(sift_filter_,
-                                                          angles,
-                                                          &vl_keypoints[i]);
-      // If upright sift is enabled, only use the first keypoint at a given
-      // pixel location.
-      if (sift_params_.upright_sift && num_angles > 1) {
-        num_angles = 1;
-      }
+void SiftDescriptorExtractor::DetectAndExtractDescriptorsInTiles(
+    const FloatImage& image,
+    std::vector<Keypoint>* keypoints,
+    std::vector<Eigen::VectorXf>* descriptors) {
+  const int width = image.Cols();
+  const int height = image.Rows();
+  const int first_octave =
+      GetValidFirstOctave(sift_params_.first_octave, height, width);
+
+  // Determine the number of octaves in the same way as VLFeat.
+  const int num_octaves =
+      sift_params_.num_octaves >= 0
+          ? sift_params_.num_octaves
+          : std::max(static_cast<int>(std::floor(
+                         std::log2(std::min(width, height)))) -
+                         first_octave - 3,
+                     1);
+  const int num_tiled_octaves =
+      std::max(0, std::min(sift_params_.num_tiled_octaves, num_octaves));
+  const int num_full_image_octaves = num_octaves - num_tiled_octaves;
+
+  // The tiles must overlap by the support of the largest keypoints in the
+  // tiled octaves so that the same keypoints and descriptors are computed as
+  // for the full image. The descriptor window has a radius of about 10.6
+  // sigma, and the Gaussian levels of an octave o reach a sigma of
+  // sigma0 * 2^(o + (S + 1) / S) where sigma0 = 1.6 * 2^(1 / S).
+  static const double kSupportInSigmas = 12.0;
+  const int last_tiled_octave = first_octave + num_tiled_octaves - 1;
+  const double num_levels = sift_params_.num_levels;
+  const double max_sigma =
+      1.6 * std::pow(2.0, 1.0 / num_levels) *
+      std::pow(2.0, last_tiled_octave + (num_levels + 1.0) / num_levels);
+  // The tiles are aligned to the subsampling of the coarsest tiled octave so
+  // that the octaves of the tiles are sampled at the same pixels as those of
+  // the full image.
+  const int tile_alignment = 1 << std::max(last_tiled_octave, 0);
+  const int tile_border =
+      tile_alignment * static_cast<int>(std::ceil(
+                           kSupportInSigmas * max_sigma / tile_alignment));
+
+  // Create the overlapping tiles. The interiors of the tiles partition the
+  // image so that each keypoint is kept by exactly one tile.
+  const int tile_size =
+      tile_alignment *
+      std::max(1, sift_params_.tile_size / tile_alignment);
+  std::vector<SiftRegion> tiles;
+  for (int y = 0; y < height && num_tiled_octaves > 0; y += tile_size) {
+    for (int x = 0; x < width; x += tile_size) {
+      SiftRegion tile;
+      tile.x = std::max(0, x - tile_border);
+      tile.y = std::max(0, y - tile_border);
+      tile.width = std::min(width, x + tile_size + tile_border) - tile.x;
+      tile.height = std::min(height, y + tile_size + tile_border) - tile.y;
+      tile.min_x = x;
+      tile.min_y = y;
+      tile.max_x = std::min(x + tile_size, width);
+      tile.max_y = std::min(y + tile_size, height);
+      tiles.emplace_back(tile);
+    }
+  }
 
-      for (int j = 0; j < num_angles; ++j) {
-        descriptors->emplace_back(128);
-        vl_sift_calc_keypoint_descriptor(
-            sift_filter_, descriptors->back().data(), &vl_keypoints[i],
-            angles[j]);
+  // The early termination would depend on the order of the tiles.
+  SiftParameters sift_params = sift_params_;
+  sift_params.max_num_keypoints = 0;
+
+  // Each thread processes every num_tile_threads-th tile with its own filter
+  // cache so that the scale spaces of the tiles are only allocated once per
+  // tile size and thread, and are reused across images.
+  const int num_tile_threads = std::min(sift_params_.num_threads,
+                                        static_cast<int>(tiles.size()));
+  while (tile_sift_filter_caches_.size() < num_tile_threads) {
+    // The tiles at the right and the bottom border of the image may be smaller
+    // than the others, so there are up to 4 tile sizes.
+    static const int kMaxNumTileSizes = 4;
+    tile_sift_filter_caches_.emplace_back(
+        new SiftFilterCache(sift_params_, kMaxNumTileSizes));
+  }
 
-        Keypoint keypoint(vl_keypoints[i].x, vl_keypoints[i].y, Keypoint::SIFT);
-        keypoint.set_scale(vl_keypoints[i].sigma);
-        keypoint.set_orientation(angles[j]);
-        keypoints->push_back(keypoint);
-      }
+  const float* image_data = image.GrayscaleData(&grayscale_buffer_);
+  std::vector<std::vector<Keypoint> > region_keypoints(tiles.size() + 1);
+  std::vector<std::vector<Eigen::VectorXf> > region_descriptors(
+      tiles.size() + 1);
+  {
+    ThreadPool pool(sift_params_.num_threads);
+    for (int i = 0; i < num_tile_threads; i++) {
+      pool.Add(DetectAndExtractInTiles,
+               std::cref(sift_params),
+               image_data,
+               width,
+               std::cref(tiles),
+               i,
+               num_tile_threads,
+               first_octave,
+               num_tiled_octaves,
+               tile_sift_filter_caches_[i].get(),
+               &region_keypoints,
+               &region_descriptors);
     }
-    // Attempt to process the next octave.
-    vl_status = vl_sift_process_next_octave(sift_filter_);
-  }
 
-  if (sift_params_.root_sift) {
-    for (int i = 0; i < descriptors->size(); i++) {
-      ConvertToRootSift(&(*descriptors)[i]);
+    // The coarser octaves are processed on the full image concurrently.
+    if (num_full_image_octaves > 0) {
+      pool.Add(DetectAndExtractInCoarseOctaves,
+               std::cref(sift_params),
+               image_data,
+               width,
+               height,
+               first_octave + num_tiled_octaves,
+               num_full_image_octaves,
+               &region_keypoints.back(),
+               &region_descriptors.back());
     }
   }
 
-  return true;
+  for (int i = 0; i < region_keypoints.size(); i++) {
+    keypoints->insert(keypoints->end(),
+                      region_keypoints[i].begin(),
+                      region_keypoints[i].end());
+    descriptors->insert(descriptors->end(),
+                        region_descriptors[i].begin(),
+                        region_descriptors[i].end());
+  }
 }
 
 // Converts to a RootSIFT descriptor which is proven to provide better matches
@@ -38,10 +38,12 @@
 extern "C" {
 #include <vl/sift.h>
 }
+#include <memory>
 #include <vector>
 
 #include "theia/image/descriptor/descriptor_extractor.h"
 #include "theia/image/keypoint_detector/keypoint.h"
+#include "theia/image/keypoint_detector/sift_filter_cache.h"
 #include "theia/image/keypoint_detector/sift_parameters.h"
 #include "theia/util/util.h"
 
@@ -56,13 +58,15 @@ class SiftDescriptorExtractor : public DescriptorExtractor {
   //  number of image octaves, number of scale levels per octave, and where the
   //  first octave should start.
   explicit SiftDescriptorExtractor(const SiftParameters& detector_params) :
-      sift_params_(detector_params), sift_filter_(nullptr) {}
+      sift_params_(detector_params), sift_filter_cache_(sift_params_),
+      sift_filter_(nullptr) {}
   SiftDescriptorExtractor(int num_octaves, int num_levels, int first_octave)
       : sift_params_(num_octaves, num_levels, first_octave, 10.0f,
                      255.0 * 0.02 / num_levels),
+        sift_filter_cache_(sift_params_),
         sift_filter_(nullptr) {}
   SiftDescriptorExtractor() : SiftDescriptorExtractor(-1, 3, -1) {}
-  ~SiftDescriptorExtractor();
+  ~SiftDescriptorExtractor() {}
 
   // Computes a descriptor at a single keypoint.
   bool ComputeDescriptor(const FloatImage& image,
@@ -84,8 +88,24 @@ class SiftDescriptorExtractor : public DescriptorExtractor {
   // This method is only public so that we can easily test it.
   static void ConvertToRootSift(Eigen::VectorXf* descriptor);
  private:
+  // Sets sift_filter_ to a filter that is usable for the image.
+  void SetSiftFilter(const FloatImage& image);
+
+  // Detects keypoints and extracts descriptors in tiles of the image in
+  // parallel. See SiftParameters::num_threads.
+  void DetectAndExtractDescriptorsInTiles(
+      const FloatImage& image,
+      std::vector<Keypoint>* keypoints,
+      std::vector<Eigen::VectorXf>* descriptors);
+
   const SiftParameters sift_params_;
+  SiftFilterCache sift_filter_cache_;
   VlSiftFilt* sift_filter_;
+  // The filters of the tiles, one cache for each thread.
+  std::vector<std::unique_ptr<SiftFilterCache> > tile_sift_filter_caches_;
+  // Holds the grayscale version of color images so that it is not reallocated
+  // for every image.
+  std::vector<float> grayscale_buffer_;
 
   DISALLOW_COPY_AND_ASSIGN(SiftDescriptorExtractor);
 };
@@ -34,12 +34,17 @@
 
 #include <gflags/gflags.h>
 #include <glog/logging.h>
+#include <cmath>
+#include <set>
 #include <string>
+#include <utility>
+#include <vector>
 #include "gtest/gtest.h"
 
 #include "theia/image/image.h"
 #include "theia/image/keypoint_detector/sift_detector.h"
 #include "theia/image/descriptor/sift_descriptor.h"
+#include "theia/util/random.h"
 
 DEFINE_string(test_img, "image/descriptor/img1.png",
               "Name of test image file.");
@@ -48,6 +53,38 @@ namespace theia {
 
 namespace {
 std::string img_filename = THEIA_DATA_DIR + std::string("/") + FLAGS_test_img;
+// Creates an image with random Gaussian blobs of different sizes.
+FloatImage CreateBlobImage(const int width, const int height) {
+  static const int kNumBlobs = 400;
+  FloatImage image(width, height, 1);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      image(x, y) = 128.0;
+    }
+  }
+
+  for (int i = 0; i < kNumBlobs; i++) {
+    const double center_x = RandDouble(0, width);
+    const double center_y = RandDouble(0, height);
+    const double sigma = RandDouble(1.5, 6.0);
+    const double contrast = RandDouble(-100.0, 100.0);
+    const int radius = static_cast<int>(std::ceil(3.0 * sigma));
+    for (int y = std::max(0, static_cast<int>(center_y) - radius);
+         y <= std::min(height - 1, static_cast<int>(center_y) + radius);
+         y++) {
+      for (int x = std::max(0, static_cast<int>(center_x) - radius);
+           x <= std::min(width - 1, static_cast<int>(center_x) + radius);
+           x++) {
+        const double dx = x - center_x;
+        const double dy = y - center_y;
+        image(x, y) +=
+            contrast * std::exp(-(dx * dx + dy * dy) / (2.0 * sigma * sigma));
+      }
+    }
+  }
+  return image;
+}
+
 }  // namespace
 
 TEST(SiftDescriptor, Sanity) {
@@ -103,4 +140,56 @@ TEST(SiftDescriptor, DifferentImageSizes) {
                                                          &descriptors));
 }
 
+TEST(SiftDescriptor, TiledExtraction) {
+  InitRandomGenerator(59);
+  const FloatImage image = CreateBlobImage(1200, 900);
+
+  SiftParameters sift_params;
+  SiftDescriptorExtractor sift_extractor(sift_params);
+  std::vector<Keypoint> keypoints;
+  std::vector<Eigen::VectorXf> descriptors;
+  EXPECT_TRUE(sift_extractor.DetectAndExtractDescriptors(image,
+                                                         &keypoints,
+                                                         &descriptors));
+
+  SiftParameters tiled_params = sift_params;
+  tiled_params.num_threads = 4;
+  tiled_params.tile_size = 512;
+  SiftDescriptorExtractor tiled_sift_extractor(tiled_params);
+  std::vector<Keypoint> tiled_keypoints;
+  std::vector<Eigen::VectorXf> tiled_descriptors;
+  EXPECT_TRUE(tiled_sift_extractor.DetectAndExtractDescriptors(
+      image, &tiled_keypoints, &tiled_descriptors));
+  ASSERT_EQ(tiled_keypoints.size(), tiled_descriptors.size());
+
+  // The tiles overlap enough that nearly the same keypoints are detected.
+  // Only the coarse octaves, which start from a resmoothed image, may differ
+  // slightly.
+  const double kMaxRelativeDifference = 0.01;
+  EXPECT_GT(keypoints.size(), 0);
+  EXPECT_NEAR(static_cast<double>(tiled_keypoints.size()),
+              static_cast<double>(keypoints.size()),
+              kMaxRelativeDifference * keypoints.size());
+
+  // Keypoints in the overlap of the tiles must not be duplicated, so there are
+  // as many keypoints at the same position as without tiles.
+  std::set<std::pair<double, double> > positions;
+  std::set<std::pair<double, double> > tiled_positions;
+  for (const Keypoint& keypoint : keypoints) {
+    positions.emplace(keypoint.x(), keypoint.y());
+  }
+  for (const Keypoint& keypoint : tiled_keypoints) {
+    tiled_positions.emplace(keypoint.x(), keypoint.y());
+  }
+  EXPECT_EQ(tiled_keypoints.size() - tiled_positions.size(),
+            keypoints.size() - positions.size());
+
+  // The filters of the tiles are reused for the next image.
+  std::vector<Keypoint> repeated_keypoints;
+  std::vector<Eigen::VectorXf> repeated_descriptors;
+  EXPECT_TRUE(tiled_sift_extractor.DetectAndExtractDescriptors(
+      image, &repeated_keypoints, &repeated_descriptors));
+  EXPECT_EQ(repeated_keypoints.size(), tiled_keypoints.size());
+}
+
 }  // namespace theia
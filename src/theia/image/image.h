@@ -90,6 +90,12 @@ template <typename T> class Image {
   void ConvertToGrayscaleImage();
   void ConvertToRGBImage();
 
+  // Returns a pointer to the grayscale pixels of the image without copying the
+  // image if it is already a grayscale image. Otherwise the grayscale pixels are
+  // written to the buffer, which may be reused across calls to avoid allocating
+  // a new image for every conversion.
+  const T* GrayscaleData(std::vector<T>* buffer) const;
+
   // Write image to file.
   void Read(const std::string& filename);
   void Write(const std::string& filename) const;
@@ -214,6 +220,37 @@ template <typename T> Image<T> Image<T>::AsGrayscaleImage() const {
   return gray_image;
 }
 
+template <typename T>
+const T* Image<T>::GrayscaleData(std::vector<T>* buffer) const {
+  if (Channels() == 1) {
+    return Data();
+  }
+
+  const int num_pixels = Rows() * Cols();
+  CHECK_NOTNULL(buffer)->resize(num_pixels);
+  if (Channels() != 3) {
+    const Image<T> gray_image = AsGrayscaleImage();
+    std::copy(gray_image.Data(), gray_image.Data() + num_pixels,
+              buffer->begin());
+    return buffer->data();
+  }
+
+  // This is the same luma conversion that ConvertToGrayscaleImage uses.
+  typedef typename cimg_library::cimg::superset<T, unsigned char>::type Tuchar;
+  typedef typename cimg_library::cimg::superset<Tuchar, float>::type Tfloat;
+  const T* red = Data();
+  const T* green = red + num_pixels;
+  const T* blue = green + num_pixels;
+  for (int i = 0; i < num_pixels; i++) {
+    const Tfloat r = static_cast<Tuchar>(red[i]);
+    const Tfloat g = static_cast<Tuchar>(green[i]);
+    const Tfloat b = static_cast<Tuchar>(blue[i]);
+    const Tfloat y = (66 * r + 129 * g + 25 * b + 128) / 256 + 16;
+    (*buffer)[i] = static_cast<Tuchar>(y < 0 ? 0 : (y > 255 ? 255 : y));
+  }
+  return buffer->data();
+}
+
 template <typename T> Image<T> Image<T>::AsRGBImage() const {
   if (Channels() == 3) {
     VLOG(2) << "Image is already an RGB image. No conversion necessary.";
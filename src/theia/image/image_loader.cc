@@ -0,0 +1,345 @@
+// Copyright (C) 2013 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include "theia/image/image_loader.h"
+
+#include <Eigen/Core>
+#include <glog/logging.h>
+#include <stdio.h>
+#ifdef THEIA_USE_JPEG
+#include <setjmp.h>
+extern "C" {
+#include <jpeglib.h>
+}
+#endif  // THEIA_USE_JPEG
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "theia/image/image.h"
+#include "theia/image/keypoint_detector/keypoint.h"
+
+namespace theia {
+
+namespace {
+
+// Returns the dimensions of an image downscaled such that its larger dimension
+// is at most max_image_dimension.
+void GetDownscaledDimensions(const int max_image_dimension,
+                             const int width,
+                             const int height,
+                             int* scaled_width,
+                             int* scaled_height) {
+  *scaled_width = width;
+  *scaled_height = height;
+  const int max_dimension = std::max(width, height);
+  if (max_image_dimension <= 0 || max_dimension <= max_image_dimension) {
+    return;
+  }
+  const double scale =
+      static_cast<double>(max_image_dimension) / max_dimension;
+  *scaled_width = std::max(1, static_cast<int>(std::round(width * scale)));
+  *scaled_height = std::max(1, static_cast<int>(std::round(height * scale)));
+}
+
+#ifdef THEIA_USE_JPEG
+
+bool IsJpegFile(FILE* file) {
+  unsigned char magic_number[2];
+  const bool is_jpeg = fread(magic_number, 1, 2, file) == 2 &&
+                       magic_number[0] == 0xFF && magic_number[1] == 0xD8;
+  rewind(file);
+  return is_jpeg;
+}
+
+// The default error handler of libjpeg exits the program, so errors are
+// reported by jumping back to the decoding function instead.
+struct JpegErrorManager {
+  jpeg_error_mgr error_manager;
+  jmp_buf setjmp_buffer;
+};
+
+void HandleJpegError(j_common_ptr cinfo) {
+  JpegErrorManager* error_manager =
+      reinterpret_cast<JpegErrorManager*>(cinfo->err);
+  char message[JMSG_LENGTH_MAX];
+  (*cinfo->err->format_message)(cinfo, message);
+  LOG(ERROR) << "Could not decode JPEG image: " << message;
+  longjmp(error_manager->setjmp_buffer, 1);
+}
+
+// Decodes the JPEG image at the smallest DCT scale (1/8, 1/4, 1/2 or 1) that is
+// still at least as large as the requested maximum dimension.
+bool DecodeJpegImage(const ImageLoaderOptions& options,
+                     FILE* file,
+                     cimg_library::CImg<float>* image,
+                     int* original_width,
+                     int* original_height) {
+  jpeg_decompress_struct cinfo;
+  JpegErrorManager error_manager;
+  cinfo.err = jpeg_std_error(&error_manager.error_manager);
+  error_manager.error_manager.error_exit = HandleJpegError;
+  if (setjmp(error_manager.setjmp_buffer)) {
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+
+  jpeg_create_decompress(&cinfo);
+  jpeg_stdio_src(&cinfo, file);
+  jpeg_read_header(&cinfo, TRUE);
+  *original_width = cinfo.image_width;
+  *original_height = cinfo.image_height;
+
+  const bool is_color_image = cinfo.num_components >= 3;
+  cinfo.out_color_space =
+      (options.grayscale || !is_color_image) ? JCS_GRAYSCALE : JCS_RGB;
+  cinfo.scale_num = 1;
+  cinfo.scale_denom = 1;
+  if (options.max_image_dimension > 0) {
+    const int max_dimension =
+        std::max(cinfo.image_width, cinfo.image_height);
+    for (int scale_denom = 8; scale_denom > 1; scale_denom /= 2) {
+      if (max_dimension >= scale_denom * options.max_image_dimension) {
+        cinfo.scale_denom = scale_denom;
+        break;
+      }
+    }
+  }
+  jpeg_start_decompress(&cinfo);
+
+  const int width = cinfo.output_width;
+  const int height = cinfo.output_height;
+  const int num_channels = cinfo.output_components;
+  image->assign(width, height, 1, num_channels);
+  // The row is allocated by libjpeg so that it is freed if decoding fails.
+  JSAMPARRAY row = (*cinfo.mem->alloc_sarray)(
+      reinterpret_cast<j_common_ptr>(&cinfo), JPOOL_IMAGE,
+      width * num_channels, 1);
+  while (cinfo.output_scanline < cinfo.output_height) {
+    const int y = cinfo.output_scanline;
+    jpeg_read_scanlines(&cinfo, row, 1);
+    for (int c = 0; c < num_channels; c++) {
+      float* pixels = image->data(0, y, 0, c);
+      for (int x = 0; x < width; x++) {
+        pixels[x] = row[0][x * num_channels + c];
+      }
+    }
+  }
+  jpeg_finish_decompress(&cinfo);
+  jpeg_destroy_decompress(&cinfo);
+
+  // The luma of JPEG images uses the full range, whereas
+  // Image::ConvertToGrayscaleImage maps colors to the range [16, 235]. The luma
+  // is mapped to the same range so that thresholds (e.g., the SIFT peak
+  // threshold) behave the same regardless of how the image was loaded.
+  if (options.grayscale && is_color_image) {
+    static const float kLumaScale = 219.0f / 255.0f;
+    cimg_for(*image, pixel, float) {
+      *pixel = *pixel * kLumaScale + 16.5f;
+    }
+  }
+  return true;
+}
+
+#endif  // THEIA_USE_JPEG
+
+}  // namespace
+
+bool LoadImage(const ImageLoaderOptions& options,
+               const std::string& filepath,
+               FloatImage* image,
+               Eigen::Vector2d* scale) {
+  CHECK_NOTNULL(image);
+  CHECK_NOTNULL(scale);
+
+  FILE* file = fopen(filepath.c_str(), "rb");
+  if (file == nullptr) {
+    LOG(ERROR) << "Could not open the image file " << filepath;
+    return false;
+  }
+
+  cimg_library::CImg<float> cimg_image;
+  int original_width = 0, original_height = 0;
+  bool decoded_image = false;
+#ifdef THEIA_USE_JPEG
+  if (IsJpegFile(file)) {
+    if (!DecodeJpegImage(options, file, &cimg_image,
+                         &original_width, &original_height)) {
+      fclose(file);
+      return false;
+    }
+    decoded_image = true;
+  }
+#endif  // THEIA_USE_JPEG
+  fclose(file);
+
+  // All other images are read at the full resolution by CImg.
+  if (!decoded_image) {
+    try {
+      cimg_image.load(filepath.c_str());
+    } catch (const cimg_library::CImgException& exception) {
+      LOG(ERROR) << "Could not read the image " << filepath << ": "
+                 << exception.what();
+      return false;
+    }
+    original_width = cimg_image.width();
+    original_height = cimg_image.height();
+    if (options.grayscale && cimg_image.spectrum() == 3) {
+      cimg_image = cimg_image.get_RGBtoYCbCr().channel(0);
+    }
+  }
+
+  // Downscale the remaining factor by averaging the pixels.
+  int scaled_width, scaled_height;
+  GetDownscaledDimensions(options.max_image_dimension,
+                          cimg_image.width(),
+                          cimg_image.height(),
+                          &scaled_width,
+                          &scaled_height);
+  if (scaled_width != cimg_image.width() ||
+      scaled_height != cimg_image.height()) {
+    cimg_image.resize(scaled_width, scaled_height, -100, -100, 2);
+  }
+
+  *image = FloatImage(cimg_image);
+  *scale << static_cast<double>(original_width) / image->Width(),
+      static_cast<double>(original_height) / image->Height();
+  return true;
+}
+
+void ScaleKeypointsToOriginalImage(const Eigen::Vector2d& scale,
+                                   std::vector<Keypoint>* keypoints) {
+  if (scale.x() == 1.0 && scale.y() == 1.0) {
+    return;
+  }
+
+  // Pixel centers are at integer coordinates, so a pixel x of the downscaled
+  // image covers the pixels [(x - 0.5) * scale, (x + 0.5) * scale] of the
+  // original image.
+  const double mean_scale = (scale.x() + scale.y()) / 2.0;
+  for (Keypoint& keypoint : *CHECK_NOTNULL(keypoints)) {
+    keypoint.set_x((keypoint.x() + 0.5) * scale.x() - 0.5);
+    keypoint.set_y((keypoint.y() + 0.5) * scale.y() - 0.5);
+    if (keypoint.has_scale()) {
+      keypoint.set_scale(keypoint.scale() * mean_scale);
+    }
+  }
+}
+
+StreamingImageLoader::StreamingImageLoader(
+    const ImageLoaderOptions& options,
+    const std::vector<std::string>& filepaths)
+    : options_(options),
+      filepaths_(filepaths),
+      next_image_index_(0),
+      num_returned_images_(0),
+      num_pending_images_(0),
+      stop_(false) {
+  CHECK_GT(options_.num_threads, 0);
+  CHECK_GT(options_.max_num_buffered_images, 0);
+  const int num_threads =
+      std::min(options_.num_threads, static_cast<int>(filepaths_.size()));
+  for (int i = 0; i < num_threads; i++) {
+    threads_.emplace_back(&StreamingImageLoader::LoadImages, this);
+  }
+}
+
+StreamingImageLoader::~StreamingImageLoader() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  image_returned_.notify_all();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+void StreamingImageLoader::LoadImages() {
+  while (true) {
+    LoadedImage loaded_image;
+    {
+      // Wait until there is room for another image in the buffer.
+      std::unique_lock<std::mutex> lock(mutex_);
+      image_returned_.wait(lock, [this] {
+        return stop_ ||
+               num_pending_images_ < options_.max_num_buffered_images;
+      });
+      if (stop_ || next_image_index_ == filepaths_.size()) {
+        return;
+      }
+      loaded_image.index = next_image_index_++;
+      ++num_pending_images_;
+    }
+
+    loaded_image.filepath = filepaths_[loaded_image.index];
+    loaded_image.image.reset(new FloatImage());
+    loaded_image.success = LoadImage(options_,
+                                     loaded_image.filepath,
+                                     loaded_image.image.get(),
+                                     &loaded_image.scale);
+
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      loaded_images_.emplace_back(std::move(loaded_image));
+    }
+    image_loaded_.notify_one();
+  }
+}
+
+bool StreamingImageLoader::GetNextImage(LoadedImage* loaded_image) {
+  CHECK_NOTNULL(loaded_image);
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (num_returned_images_ == filepaths_.size()) {
+      return false;
+    }
+    ++num_returned_images_;
+
+    image_loaded_.wait(lock, [this] { return !loaded_images_.empty(); });
+    *loaded_image = std::move(loaded_images_.front());
+    loaded_images_.pop_front();
+    --num_pending_images_;
+  }
+  image_returned_.notify_all();
+  return true;
+}
+
+}  // namespace theia
@@ -0,0 +1,139 @@
+// Copyright (C) 2013 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#ifndef THEIA_IMAGE_IMAGE_LOADER_H_
+#define THEIA_IMAGE_IMAGE_LOADER_H_
+
+#include <Eigen/Core>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "theia/image/image.h"
+#include "theia/image/keypoint_detector/keypoint.h"
+#include "theia/util/util.h"
+
+namespace theia {
+
+struct ImageLoaderOptions {
+  // If positive, images are downscaled such that their larger dimension is at
+  // most this many pixels. When Theia is built with libjpeg, JPEG images are
+  // decoded directly at a reduced resolution with the DCT scaling of libjpeg so
+  // that the full resolution image is never decoded.
+  int max_image_dimension = 0;
+
+  // If true, the images are loaded as grayscale images. Only the luma of JPEG
+  // images is decoded in this case.
+  bool grayscale = false;
+
+  // The number of threads used to decode images by the StreamingImageLoader.
+  int num_threads = 1;
+
+  // The maximum number of images that the StreamingImageLoader decodes ahead of
+  // their use. This bounds the memory used by decoded images.
+  int max_num_buffered_images = 2;
+};
+
+// Loads the image with the options above. The scale is set to the ratio of the
+// original image dimensions to the loaded image dimensions (width, height) so
+// that pixel coordinates can be converted to the original image with
+// ScaleKeypointsToOriginalImage. Returns false if the image could not be read.
+bool LoadImage(const ImageLoaderOptions& options,
+               const std::string& filepath,
+               FloatImage* image,
+               Eigen::Vector2d* scale);
+
+// Converts the position and scale of the keypoints detected in an image loaded
+// by LoadImage to the original image resolution.
+void ScaleKeypointsToOriginalImage(const Eigen::Vector2d& scale,
+                                   std::vector<Keypoint>* keypoints);
+
+// An image that was loaded by the StreamingImageLoader.
+struct LoadedImage {
+  // The index of the image in the filepaths passed to the loader.
+  int index = -1;
+  std::string filepath;
+
+  // If success is false, the image could not be read.
+  bool success = false;
+  std::unique_ptr<FloatImage> image;
+  Eigen::Vector2d scale;
+};
+
+// Loads a list of images in background threads so that decoding overlaps with
+// the processing of previously loaded images. At most max_num_buffered_images
+// images are decoded ahead of the calls to GetNextImage.
+class StreamingImageLoader {
+ public:
+  StreamingImageLoader(const ImageLoaderOptions& options,
+                       const std::vector<std::string>& filepaths);
+  ~StreamingImageLoader();
+
+  // Waits for the next decoded image. Images are returned in the order that
+  // they finish decoding, which is not necessarily the order of the filepaths.
+  // Returns false once all images have been returned. This method is
+  // thread-safe.
+  bool GetNextImage(LoadedImage* loaded_image);
+
+ private:
+  // Decodes images until all images are decoded or the loader is destroyed.
+  void LoadImages();
+
+  const ImageLoaderOptions options_;
+  const std::vector<std::string> filepaths_;
+
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable image_loaded_, image_returned_;
+
+  // The index of the next image to decode.
+  int next_image_index_;
+  // The number of images that have been returned by GetNextImage.
+  int num_returned_images_;
+  // The number of images that are being decoded or have been decoded but not
+  // returned yet.
+  int num_pending_images_;
+  std::deque<LoadedImage> loaded_images_;
+  bool stop_;
+
+  DISALLOW_COPY_AND_ASSIGN(StreamingImageLoader);
+};
+
+}  // namespace theia
+
+#endif  // THEIA_IMAGE_IMAGE_LOADER_H_
@@ -0,0 +1,152 @@
+// Copyright (C) 2013 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+
+#include "theia/image/image.h"
+#include "theia/image/image_loader.h"
+#include "theia/image/keypoint_detector/keypoint.h"
+
+namespace theia {
+
+namespace {
+
+// The test image is 1024 x 679 pixels.
+const std::string img_filename =
+    THEIA_DATA_DIR + std::string("/image/test1.jpg");
+const std::string exif_img_filename =
+    THEIA_DATA_DIR + std::string("/image/exif.jpg");
+
+}  // namespace
+
+TEST(LoadImage, FullResolution) {
+  ImageLoaderOptions options;
+  FloatImage image;
+  Eigen::Vector2d scale;
+  ASSERT_TRUE(LoadImage(options, img_filename, &image, &scale));
+  EXPECT_EQ(image.Cols(), 1024);
+  EXPECT_EQ(image.Rows(), 679);
+  EXPECT_EQ(image.Channels(), 3);
+  EXPECT_EQ(scale.x(), 1.0);
+  EXPECT_EQ(scale.y(), 1.0);
+}
+
+TEST(LoadImage, MaxImageDimension) {
+  ImageLoaderOptions options;
+  options.max_image_dimension = 200;
+  options.grayscale = true;
+  FloatImage image;
+  Eigen::Vector2d scale;
+  ASSERT_TRUE(LoadImage(options, img_filename, &image, &scale));
+  EXPECT_EQ(image.Cols(), 200);
+  EXPECT_EQ(image.Rows(), 133);
+  EXPECT_EQ(image.Channels(), 1);
+  EXPECT_DOUBLE_EQ(scale.x(), 1024.0 / 200.0);
+  EXPECT_DOUBLE_EQ(scale.y(), 679.0 / 133.0);
+
+  // The intensities are in the same range as the grayscale conversion.
+  const float* pixels = image.Data();
+  const int num_pixels = image.Rows() * image.Cols();
+  EXPECT_GE(*std::min_element(pixels, pixels + num_pixels), 0.0f);
+  EXPECT_LE(*std::max_element(pixels, pixels + num_pixels), 255.0f);
+
+  // Smaller images are not upscaled.
+  options.max_image_dimension = 2048;
+  ASSERT_TRUE(LoadImage(options, img_filename, &image, &scale));
+  EXPECT_EQ(image.Cols(), 1024);
+  EXPECT_EQ(image.Rows(), 679);
+}
+
+TEST(LoadImage, MissingFile) {
+  ImageLoaderOptions options;
+  FloatImage image;
+  Eigen::Vector2d scale;
+  EXPECT_FALSE(LoadImage(options, "missing_image.jpg", &image, &scale));
+}
+
+TEST(ScaleKeypointsToOriginalImage, PixelCenters) {
+  std::vector<Keypoint> keypoints(2);
+  keypoints[0] = Keypoint(0.0, 0.0, Keypoint::SIFT);
+  keypoints[0].set_scale(1.0);
+  keypoints[1] = Keypoint(10.0, 20.0, Keypoint::SIFT);
+
+  ScaleKeypointsToOriginalImage(Eigen::Vector2d(4.0, 2.0), &keypoints);
+  // The center of the first pixel is the center of the 4x2 pixel block in the
+  // original image.
+  EXPECT_DOUBLE_EQ(keypoints[0].x(), 1.5);
+  EXPECT_DOUBLE_EQ(keypoints[0].y(), 0.5);
+  EXPECT_DOUBLE_EQ(keypoints[0].scale(), 3.0);
+  EXPECT_DOUBLE_EQ(keypoints[1].x(), 41.5);
+  EXPECT_DOUBLE_EQ(keypoints[1].y(), 40.5);
+  EXPECT_FALSE(keypoints[1].has_scale());
+}
+
+TEST(StreamingImageLoader, ReturnsEachImageOnce) {
+  const std::vector<std::string> filepaths = {
+    img_filename, exif_img_filename, "missing_image.jpg", img_filename,
+    exif_img_filename
+  };
+
+  ImageLoaderOptions options;
+  options.max_image_dimension = 256;
+  options.num_threads = 2;
+  options.max_num_buffered_images = 1;
+  StreamingImageLoader image_loader(options, filepaths);
+
+  std::vector<int> num_times_loaded(filepaths.size(), 0);
+  LoadedImage loaded_image;
+  while (image_loader.GetNextImage(&loaded_image)) {
+    ASSERT_GE(loaded_image.index, 0);
+    ASSERT_LT(loaded_image.index, filepaths.size());
+    ++num_times_loaded[loaded_image.index];
+    EXPECT_EQ(loaded_image.filepath, filepaths[loaded_image.index]);
+    if (loaded_image.filepath == "missing_image.jpg") {
+      EXPECT_FALSE(loaded_image.success);
+      continue;
+    }
+    EXPECT_TRUE(loaded_image.success);
+    EXPECT_EQ(std::max(loaded_image.image->Cols(), loaded_image.image->Rows()),
+              256);
+  }
+
+  for (const int num_times : num_times_loaded) {
+    EXPECT_EQ(num_times, 1);
+  }
+}
+
+}  // namespace theia
@@ -37,6 +37,7 @@
 #include <gflags/gflags.h>
 #include <stdio.h>
 #include <string>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "theia/image/image.h"
@@ -138,6 +139,30 @@ TEST(Image, ConvertToRGBImage) {
   ASSERT_RGB_IMG_EQ(rgb_img, theia_img, rows, cols);
 }
 
+TEST(Image, GrayscaleData) {
+  InitRandomGenerator();
+  FloatImage rgb_img(37, 23, 3);
+  for (int c = 0; c < rgb_img.Channels(); c++) {
+    for (int y = 0; y < rgb_img.Rows(); y++) {
+      for (int x = 0; x < rgb_img.Cols(); x++) {
+        rgb_img(x, y, c) = RandInt(0, 255);
+      }
+    }
+  }
+  const FloatImage gray_img = rgb_img.AsGrayscaleImage();
+
+  std::vector<float> buffer;
+  const float* gray_data = rgb_img.GrayscaleData(&buffer);
+  EXPECT_EQ(gray_data, buffer.data());
+  ASSERT_EQ(buffer.size(), gray_img.Rows() * gray_img.Cols());
+  for (int i = 0; i < buffer.size(); i++) {
+    ASSERT_EQ(gray_data[i], gray_img.Data()[i]);
+  }
+
+  // Grayscale images are not copied.
+  EXPECT_EQ(gray_img.GrayscaleData(&buffer), gray_img.Data());
+}
+
 TEST(Image, IntegralImage) {
   const FloatImage img = FloatImage(img_filename).AsGrayscaleImage();
   Image<double> integral_img;
@@ -0,0 +1,272 @@
+// Copyright (C) 2013 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include "theia/image/keypoint_detector/keypoint_selection.h"
+
+#include <Eigen/Core>
+#include <glog/logging.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include "theia/image/keypoint_detector/keypoint.h"
+
+namespace theia {
+
+namespace {
+
+double KeypointStrength(const Keypoint& keypoint) {
+  return keypoint.has_strength() ? keypoint.strength()
+                                 : std::numeric_limits<double>::lowest();
+}
+
+// Selects the strongest keypoints of each grid cell in a round-robin fashion:
+// first the strongest keypoint of every cell, then the second strongest of
+// every cell, etc. Within each round the strongest keypoints are preferred.
+void SelectKeypointsInGrid(const KeypointSelectionOptions& options,
+                           const std::vector<Keypoint>& keypoints,
+                           const int max_num_keypoints,
+                           std::vector<int>* selected_indices) {
+  double min_x = keypoints[0].x(), max_x = keypoints[0].x();
+  double min_y = keypoints[0].y(), max_y = keypoints[0].y();
+  for (const Keypoint& keypoint : keypoints) {
+    min_x = std::min(min_x, keypoint.x());
+    max_x = std::max(max_x, keypoint.x());
+    min_y = std::min(min_y, keypoint.y());
+    max_y = std::max(max_y, keypoint.y());
+  }
+  const double cell_size =
+      std::max(1.0, std::max(max_x - min_x, max_y - min_y) /
+                        std::max(1, options.num_grid_cells));
+  const int num_cols = static_cast<int>((max_x - min_x) / cell_size) + 1;
+
+  std::vector<int> cells(keypoints.size());
+  for (int i = 0; i < keypoints.size(); i++) {
+    const int col = static_cast<int>((keypoints[i].x() - min_x) / cell_size);
+    const int row = static_cast<int>((keypoints[i].y() - min_y) / cell_size);
+    cells[i] = row * num_cols + col;
+  }
+
+  // Sort the keypoints by cell and by strength within each cell to determine
+  // the rank of each keypoint within its cell.
+  std::vector<int> order(keypoints.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](const int i, const int j) {
+    if (cells[i] != cells[j]) {
+      return cells[i] < cells[j];
+    }
+    const double strength_i = KeypointStrength(keypoints[i]);
+    const double strength_j = KeypointStrength(keypoints[j]);
+    if (strength_i != strength_j) {
+      return strength_i > strength_j;
+    }
+    return i < j;
+  });
+  std::vector<int> ranks(keypoints.size());
+  for (int i = 0; i < order.size(); i++) {
+    const bool new_cell = i == 0 || cells[order[i]] != cells[order[i - 1]];
+    ranks[order[i]] = new_cell ? 0 : ranks[order[i - 1]] + 1;
+  }
+
+  std::sort(order.begin(), order.end(), [&](const int i, const int j) {
+    if (ranks[i] != ranks[j]) {
+      return ranks[i] < ranks[j];
+    }
+    const double strength_i = KeypointStrength(keypoints[i]);
+    const double strength_j = KeypointStrength(keypoints[j]);
+    if (strength_i != strength_j) {
+      return strength_i > strength_j;
+    }
+    return i < j;
+  });
+  selected_indices->assign(order.begin(), order.begin() + max_num_keypoints);
+}
+
+// Computes the suppression radius of each keypoint, i.e. the distance to the
+// closest keypoint that is significantly stronger, and keeps the keypoints with
+// the largest radii.
+void SelectKeypointsWithANMS(const KeypointSelectionOptions& options,
+                             const std::vector<Keypoint>& keypoints,
+                             const int max_num_keypoints,
+                             std::vector<int>* selected_indices) {
+  // Only stronger keypoints can suppress a keypoint. When the keypoints are
+  // sorted by strength, the keypoints that can suppress a keypoint form a
+  // prefix of the order that only grows for weaker keypoints.
+  std::vector<int> order(keypoints.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](const int i, const int j) {
+    return KeypointStrength(keypoints[i]) > KeypointStrength(keypoints[j]);
+  });
+
+  // The keypoints of the prefix are added to a uniform grid with roughly one
+  // keypoint per cell so that the closest one can be found by searching the
+  // cells around a keypoint instead of all stronger keypoints.
+  double min_x = keypoints[0].x(), max_x = keypoints[0].x();
+  double min_y = keypoints[0].y(), max_y = keypoints[0].y();
+  for (const Keypoint& keypoint : keypoints) {
+    min_x = std::min(min_x, keypoint.x());
+    max_x = std::max(max_x, keypoint.x());
+    min_y = std::min(min_y, keypoint.y());
+    max_y = std::max(max_y, keypoint.y());
+  }
+  const double cell_size =
+      std::max(1.0, std::max(max_x - min_x, max_y - min_y) /
+                        std::ceil(std::sqrt(keypoints.size())));
+  const int num_cols = static_cast<int>((max_x - min_x) / cell_size) + 1;
+  const int num_rows = static_cast<int>((max_y - min_y) / cell_size) + 1;
+  std::vector<std::vector<int> > grid(num_cols * num_rows);
+
+  std::vector<std::pair<double, int> > sq_radii(keypoints.size());
+  int num_suppressing = 0;
+  for (int i = 0; i < order.size(); i++) {
+    const Keypoint& keypoint = keypoints[order[i]];
+    const double strength = KeypointStrength(keypoint);
+    const int col = static_cast<int>((keypoint.x() - min_x) / cell_size);
+    const int row = static_cast<int>((keypoint.y() - min_y) / cell_size);
+
+    while (num_suppressing < i &&
+           strength < options.anms_robustness *
+                          KeypointStrength(keypoints[order[num_suppressing]])) {
+      const Keypoint& stronger_keypoint = keypoints[order[num_suppressing]];
+      const int stronger_col =
+          static_cast<int>((stronger_keypoint.x() - min_x) / cell_size);
+      const int stronger_row =
+          static_cast<int>((stronger_keypoint.y() - min_y) / cell_size);
+      grid[stronger_row * num_cols + stronger_col].emplace_back(
+          order[num_suppressing]);
+      ++num_suppressing;
+    }
+
+    // Search the rings of cells around the keypoint. All keypoints outside of
+    // the first r rings are at least r cells away.
+    double sq_radius = std::numeric_limits<double>::max();
+    const int max_ring = (num_suppressing > 0) ? std::max(num_cols, num_rows)
+                                               : -1;
+    for (int ring = 0; ring <= max_ring; ring++) {
+      for (int r = row - ring; r <= row + ring; r++) {
+        if (r < 0 || r >= num_rows) {
+          continue;
+        }
+        // Only the boundary of the ring is searched.
+        const int step =
+            (r == row - ring || r == row + ring) ? 1 : std::max(1, 2 * ring);
+        for (int c = col - ring; c <= col + ring; c += step) {
+          if (c < 0 || c >= num_cols) {
+            continue;
+          }
+          for (const int index : grid[r * num_cols + c]) {
+            const double dx = keypoint.x() - keypoints[index].x();
+            const double dy = keypoint.y() - keypoints[index].y();
+            sq_radius = std::min(sq_radius, dx * dx + dy * dy);
+          }
+        }
+      }
+      const double searched_distance = ring * cell_size;
+      if (sq_radius <= searched_distance * searched_distance) {
+        break;
+      }
+    }
+    // Ties are broken by strength through the order.
+    sq_radii[i] = std::make_pair(-sq_radius, i);
+  }
+
+  std::partial_sort(sq_radii.begin(),
+                    sq_radii.begin() + max_num_keypoints,
+                    sq_radii.end());
+  selected_indices->resize(max_num_keypoints);
+  for (int i = 0; i < max_num_keypoints; i++) {
+    (*selected_indices)[i] = order[sq_radii[i].second];
+  }
+}
+
+}  // namespace
+
+void SelectKeypoints(const KeypointSelectionOptions& options,
+                     const std::vector<Keypoint>& keypoints,
+                     const int max_num_keypoints,
+                     std::vector<int>* selected_indices) {
+  CHECK_NOTNULL(selected_indices)->clear();
+  const int num_selected = std::max(
+      0, std::min(max_num_keypoints, static_cast<int>(keypoints.size())));
+  if (num_selected == keypoints.size() ||
+      options.selection_type == KeypointSelectionType::FIRST_DETECTED) {
+    selected_indices->resize(num_selected);
+    std::iota(selected_indices->begin(), selected_indices->end(), 0);
+    return;
+  }
+  if (num_selected == 0) {
+    return;
+  }
+
+  switch (options.selection_type) {
+    case KeypointSelectionType::GRID:
+      SelectKeypointsInGrid(options, keypoints, num_selected, selected_indices);
+      break;
+    case KeypointSelectionType::ADAPTIVE_NON_MAXIMAL_SUPPRESSION:
+      SelectKeypointsWithANMS(options, keypoints, num_selected,
+                              selected_indices);
+      break;
+    default:
+      LOG(FATAL) << "Invalid keypoint selection type.";
+  }
+  std::sort(selected_indices->begin(), selected_indices->end());
+}
+
+void SelectKeypointsAndDescriptors(const KeypointSelectionOptions& options,
+                                   const int max_num_keypoints,
+                                   std::vector<Keypoint>* keypoints,
+                                   std::vector<Eigen::VectorXf>* descriptors) {
+  CHECK_NOTNULL(keypoints);
+  CHECK_NOTNULL(descriptors);
+  CHECK_EQ(keypoints->size(), descriptors->size());
+  if (keypoints->size() <= max_num_keypoints) {
+    return;
+  }
+
+  std::vector<int> selected_indices;
+  SelectKeypoints(options, *keypoints, max_num_keypoints, &selected_indices);
+
+  // The indices are sorted, so the selected features can be moved to the front
+  // in place.
+  for (int i = 0; i < selected_indices.size(); i++) {
+    (*keypoints)[i] = (*keypoints)[selected_indices[i]];
+    (*descriptors)[i].swap((*descriptors)[selected_indices[i]]);
+  }
+  keypoints->resize(selected_indices.size());
+  descriptors->resize(selected_indices.size());
+}
+
+}  // namespace theia
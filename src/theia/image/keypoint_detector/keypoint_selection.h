@@ -0,0 +1,91 @@
+// Copyright (C) 2013 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#ifndef THEIA_IMAGE_KEYPOINT_DETECTOR_KEYPOINT_SELECTION_H_
+#define THEIA_IMAGE_KEYPOINT_DETECTOR_KEYPOINT_SELECTION_H_
+
+#include <Eigen/Core>
+#include <vector>
+
+#include "theia/image/keypoint_detector/keypoint.h"
+
+namespace theia {
+
+// Strategies for selecting a subset of the detected keypoints.
+enum class KeypointSelectionType {
+  // Keep the keypoints in the order they were detected. For SIFT this keeps
+  // the keypoints of the finest octaves.
+  FIRST_DETECTED = 0,
+
+  // Divide the image into a grid and select the strongest keypoints of each
+  // cell in a round-robin fashion so that the keypoints are well distributed.
+  GRID = 1,
+
+  // Adaptive non-maximal suppression of "Multi-Image Matching using
+  // Multi-Scale Oriented Patches" by Brown et al. (CVPR 2005): keep the
+  // keypoints with the largest distance to a significantly stronger keypoint.
+  ADAPTIVE_NON_MAXIMAL_SUPPRESSION = 2,
+};
+
+struct KeypointSelectionOptions {
+  KeypointSelectionType selection_type = KeypointSelectionType::GRID;
+
+  // The number of grid cells along the larger image dimension for GRID
+  // selection. Cells are square.
+  int num_grid_cells = 16;
+
+  // A keypoint is only suppressed by keypoints that are stronger by this factor
+  // for ADAPTIVE_NON_MAXIMAL_SUPPRESSION.
+  double anms_robustness = 0.9;
+};
+
+// Selects at most max_num_keypoints of the keypoints based on their strength
+// (e.g., the detector response) and their spatial distribution. Keypoints
+// without a strength are treated as the weakest keypoints. The indices of the
+// selected keypoints are returned in ascending order.
+void SelectKeypoints(const KeypointSelectionOptions& options,
+                     const std::vector<Keypoint>& keypoints,
+                     const int max_num_keypoints,
+                     std::vector<int>* selected_indices);
+
+// Selects the keypoints as above and removes the keypoints and descriptors that
+// were not selected. The descriptors must correspond to the keypoints.
+void SelectKeypointsAndDescriptors(const KeypointSelectionOptions& options,
+                                   const int max_num_keypoints,
+                                   std::vector<Keypoint>* keypoints,
+                                   std::vector<Eigen::VectorXf>* descriptors);
+
+}  // namespace theia
+
+#endif  // THEIA_IMAGE_KEYPOINT_DETECTOR_KEYPOINT_SELECTION_H_
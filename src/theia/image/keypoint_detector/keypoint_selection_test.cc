@@ -0,0 +1,226 @@
+// Copyright (C) 2013 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "gtest/gtest.h"
+
+#include "theia/image/keypoint_detector/keypoint.h"
+#include "theia/image/keypoint_detector/keypoint_selection.h"
+#include "theia/util/random.h"
+
+namespace theia {
+
+namespace {
+
+// Creates a cluster of strong keypoints in the top-left corner of a 640x480
+// image and weaker keypoints spread over the rest of the image. Similar to
+// detector responses, the strengths are distributed exponentially.
+void CreateClusteredKeypoints(std::vector<Keypoint>* keypoints) {
+  InitRandomGenerator();
+  for (int i = 0; i < 200; i++) {
+    Keypoint keypoint(RandDouble(0.0, 20.0), RandDouble(0.0, 20.0),
+                      Keypoint::SIFT);
+    keypoint.set_strength(10.0 * std::exp(RandDouble(0.0, 5.0)));
+    keypoints->emplace_back(keypoint);
+  }
+  for (int i = 0; i < 200; i++) {
+    Keypoint keypoint(RandDouble(0.0, 640.0), RandDouble(0.0, 480.0),
+                      Keypoint::SIFT);
+    keypoint.set_strength(std::exp(RandDouble(0.0, 2.0)));
+    keypoints->emplace_back(keypoint);
+  }
+  // Make sure the full image extent is covered.
+  keypoints->emplace_back(Keypoint(640.0, 480.0, Keypoint::SIFT));
+  keypoints->back().set_strength(1.0);
+}
+
+int NumKeypointsInCorner(const std::vector<Keypoint>& keypoints,
+                         const std::vector<int>& indices) {
+  int num_in_corner = 0;
+  for (const int index : indices) {
+    if (keypoints[index].x() < 20.0 && keypoints[index].y() < 20.0) {
+      ++num_in_corner;
+    }
+  }
+  return num_in_corner;
+}
+
+}  // namespace
+
+TEST(KeypointSelection, FewerKeypointsThanMaximum) {
+  std::vector<Keypoint> keypoints;
+  CreateClusteredKeypoints(&keypoints);
+
+  KeypointSelectionOptions options;
+  std::vector<int> selected_indices;
+  SelectKeypoints(options, keypoints, keypoints.size() + 10, &selected_indices);
+  ASSERT_EQ(selected_indices.size(), keypoints.size());
+  for (int i = 0; i < selected_indices.size(); i++) {
+    EXPECT_EQ(selected_indices[i], i);
+  }
+}
+
+TEST(KeypointSelection, FirstDetected) {
+  std::vector<Keypoint> keypoints;
+  CreateClusteredKeypoints(&keypoints);
+
+  KeypointSelectionOptions options;
+  options.selection_type = KeypointSelectionType::FIRST_DETECTED;
+  std::vector<int> selected_indices;
+  SelectKeypoints(options, keypoints, 50, &selected_indices);
+  ASSERT_EQ(selected_indices.size(), 50);
+  for (int i = 0; i < selected_indices.size(); i++) {
+    EXPECT_EQ(selected_indices[i], i);
+  }
+}
+
+TEST(KeypointSelection, Grid) {
+  std::vector<Keypoint> keypoints;
+  CreateClusteredKeypoints(&keypoints);
+
+  KeypointSelectionOptions options;
+  options.selection_type = KeypointSelectionType::GRID;
+  options.num_grid_cells = 8;
+  const int kNumKeypoints = 100;
+  std::vector<int> selected_indices;
+  SelectKeypoints(options, keypoints, kNumKeypoints, &selected_indices);
+  ASSERT_EQ(selected_indices.size(), kNumKeypoints);
+  EXPECT_TRUE(std::is_sorted(selected_indices.begin(), selected_indices.end()));
+
+  // Selecting the strongest keypoints would only select the cluster. The corner
+  // only covers a single grid cell, so only a few keypoints may be selected.
+  EXPECT_LT(NumKeypointsInCorner(keypoints, selected_indices),
+            kNumKeypoints / 4);
+}
+
+TEST(KeypointSelection, AdaptiveNonMaximalSuppression) {
+  std::vector<Keypoint> keypoints;
+  CreateClusteredKeypoints(&keypoints);
+
+  KeypointSelectionOptions options;
+  options.selection_type =
+      KeypointSelectionType::ADAPTIVE_NON_MAXIMAL_SUPPRESSION;
+  const int kNumKeypoints = 100;
+  std::vector<int> selected_indices;
+  SelectKeypoints(options, keypoints, kNumKeypoints, &selected_indices);
+  ASSERT_EQ(selected_indices.size(), kNumKeypoints);
+  EXPECT_TRUE(std::is_sorted(selected_indices.begin(), selected_indices.end()));
+  EXPECT_LT(NumKeypointsInCorner(keypoints, selected_indices),
+            kNumKeypoints / 4);
+
+  // The strongest keypoint is never suppressed.
+  int strongest_index = 0;
+  for (int i = 1; i < keypoints.size(); i++) {
+    if (keypoints[i].strength() > keypoints[strongest_index].strength()) {
+      strongest_index = i;
+    }
+  }
+  EXPECT_TRUE(std::binary_search(selected_indices.begin(),
+                                 selected_indices.end(),
+                                 strongest_index));
+}
+
+TEST(KeypointSelection, AdaptiveNonMaximalSuppressionIsExact) {
+  std::vector<Keypoint> keypoints;
+  CreateClusteredKeypoints(&keypoints);
+
+  KeypointSelectionOptions options;
+  options.selection_type =
+      KeypointSelectionType::ADAPTIVE_NON_MAXIMAL_SUPPRESSION;
+
+  // Compute the suppression radii by comparing all pairs of keypoints.
+  std::vector<std::pair<double, int> > sq_radii(keypoints.size());
+  for (int i = 0; i < keypoints.size(); i++) {
+    double sq_radius = std::numeric_limits<double>::max();
+    for (int j = 0; j < keypoints.size(); j++) {
+      if (keypoints[i].strength() >=
+          options.anms_robustness * keypoints[j].strength()) {
+        continue;
+      }
+      const double dx = keypoints[i].x() - keypoints[j].x();
+      const double dy = keypoints[i].y() - keypoints[j].y();
+      sq_radius = std::min(sq_radius, dx * dx + dy * dy);
+    }
+    sq_radii[i] = std::make_pair(sq_radius, i);
+  }
+  std::sort(sq_radii.begin(), sq_radii.end());
+
+  const int kNumKeypoints = 100;
+  std::vector<int> selected_indices;
+  SelectKeypoints(options, keypoints, kNumKeypoints, &selected_indices);
+  ASSERT_EQ(selected_indices.size(), kNumKeypoints);
+
+  // The radius of every selected keypoint must be at least as large as the
+  // radius of every keypoint that was not selected.
+  const double min_selected_sq_radius =
+      sq_radii[sq_radii.size() - kNumKeypoints].first;
+  for (const auto& sq_radius : sq_radii) {
+    const bool is_selected = std::binary_search(
+        selected_indices.begin(), selected_indices.end(), sq_radius.second);
+    if (is_selected) {
+      EXPECT_GE(sq_radius.first, min_selected_sq_radius);
+    } else {
+      EXPECT_LE(sq_radius.first, min_selected_sq_radius);
+    }
+  }
+}
+
+TEST(KeypointSelection, DescriptorsRemainAligned) {
+  std::vector<Keypoint> keypoints;
+  CreateClusteredKeypoints(&keypoints);
+  std::vector<Eigen::VectorXf> descriptors(keypoints.size());
+  for (int i = 0; i < keypoints.size(); i++) {
+    descriptors[i] = Eigen::VectorXf::Constant(2, 0.0f);
+    descriptors[i](0) = keypoints[i].x();
+    descriptors[i](1) = keypoints[i].y();
+  }
+
+  KeypointSelectionOptions options;
+  const int kNumKeypoints = 100;
+  SelectKeypointsAndDescriptors(options, kNumKeypoints, &keypoints,
+                                &descriptors);
+  ASSERT_EQ(keypoints.size(), kNumKeypoints);
+  ASSERT_EQ(descriptors.size(), kNumKeypoints);
+  for (int i = 0; i < keypoints.size(); i++) {
+    EXPECT_EQ(descriptors[i](0), static_cast<float>(keypoints[i].x()));
+    EXPECT_EQ(descriptors[i](1), static_cast<float>(keypoints[i].y()));
+  }
+}
+
+}  // namespace theia
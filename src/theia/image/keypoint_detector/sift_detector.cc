@@ -44,36 +44,18 @@ extern "C" {
 #include "theia/image/keypoint_detector/keypoint.h"
 
 namespace theia {
-SiftDetector::~SiftDetector() {
-  if (sift_filter_ != nullptr)
-    vl_sift_delete(sift_filter_);
-}
 
 bool SiftDetector::DetectKeypoints(const FloatImage& image,
                                    std::vector<Keypoint>* keypoints) {
-  // If the filter has been set, but is not usable for the input image (i.e. the
-  // width and height are different) then we must make a new filter. Adding this
-  // statement will save the function from regenerating the filter for
-  // successive calls with images of the same size (e.g. a video sequence).
-  if (sift_filter_ == nullptr || (sift_filter_->width != image.Cols() ||
-                                  sift_filter_->height != image.Rows())) {
-    vl_sift_delete(sift_filter_);
-    sift_filter_ = vl_sift_new(image.Cols(), image.Rows(),
-                               sift_params_.num_octaves,
-                               sift_params_.num_levels,
-                               sift_params_.first_octave);
-    vl_sift_set_edge_thresh(sift_filter_, sift_params_.edge_threshold);
-    vl_sift_set_peak_thresh(sift_filter_, sift_params_.peak_threshold);
-  }
-
-  // The VLFeat functions take in a non-const image pointer so that it can
-  // calculate gaussian pyramids. Obviously, we do not want to break our const
-  // input, so the best solution (for now) is to copy the image.
-  FloatImage mutable_image(image.AsGrayscaleImage());
+  // Filters are reused for successive calls with images of the same size (e.g.
+  // a video sequence) so that the scale space is not reallocated.
+  sift_filter_ = sift_filter_cache_.GetFilter(image.Cols(), image.Rows(),
+                                              sift_params_.first_octave);
 
-  // Calculate the first octave to process.
-  int vl_status = vl_sift_process_first_octave(sift_filter_,
-                                               mutable_image.Data());
+  // Calculate the first octave to process. VLFeat copies the grayscale pixels
+  // into its own scale space, so the input image does not need to be copied.
+  int vl_status = vl_sift_process_first_octave(
+      sift_filter_, image.GrayscaleData(&grayscale_buffer_));
   // Reserve an amount that is slightly larger than what a typical detector
   // would return.
   keypoints->reserve(2000);
@@ -101,9 +83,17 @@ bool SiftDetector::DetectKeypoints(const FloatImage& image,
         Keypoint keypoint(vl_keypoints[i].x, vl_keypoints[i].y, Keypoint::SIFT);
         keypoint.set_scale(vl_keypoints[i].sigma);
         keypoint.set_orientation(angles[j]);
+        keypoint.set_strength(DoGResponse(sift_filter_, vl_keypoints[i]));
         keypoints->push_back(keypoint);
       }
     }
+    // The octaves are processed from fine to coarse, so the remaining octaves
+    // may be skipped once enough keypoints have been detected.
+    if (sift_params_.max_num_keypoints > 0 &&
+        keypoints->size() >= sift_params_.max_num_keypoints) {
+      break;
+    }
+
     // Attempt to process the next octave.
     vl_status = vl_sift_process_next_octave(sift_filter_);
   }
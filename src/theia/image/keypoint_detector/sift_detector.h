@@ -43,6 +43,7 @@ extern "C" {
 
 #include "theia/image/keypoint_detector/keypoint_detector.h"
 #include "theia/image/keypoint_detector/keypoint.h"
+#include "theia/image/keypoint_detector/sift_filter_cache.h"
 #include "theia/image/keypoint_detector/sift_parameters.h"
 #include "theia/util/util.h"
 
@@ -58,19 +59,25 @@ class SiftDetector : public KeypointDetector {
   //  number of image octaves, number of scale levels per octave, and where the
   //  first octave should start.
   explicit SiftDetector(const SiftParameters& sift_params) :
-      sift_params_(sift_params), sift_filter_(nullptr) {}
+      sift_params_(sift_params), sift_filter_cache_(sift_params_),
+      sift_filter_(nullptr) {}
   SiftDetector(int num_octaves, int num_levels, int first_octave)
       : sift_params_(num_octaves, num_levels, first_octave),
+        sift_filter_cache_(sift_params_),
         sift_filter_(nullptr) {}
   SiftDetector() : SiftDetector(-1, 3, 0) {}
-  ~SiftDetector();
+  ~SiftDetector() {}
 
   // Given an image, detect keypoints using the sift descriptor.
   bool DetectKeypoints(const FloatImage& image,
                        std::vector<Keypoint>* keypoints);
  private:
   const SiftParameters sift_params_;
+  SiftFilterCache sift_filter_cache_;
   VlSiftFilt* sift_filter_;
+  // Holds the grayscale version of color images so that it is not reallocated
+  // for every image.
+  std::vector<float> grayscale_buffer_;
 
   DISALLOW_COPY_AND_ASSIGN(SiftDetector);
 };
@@ -0,0 +1,114 @@
+// Copyright (C) 2013 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include "theia/image/keypoint_detector/sift_filter_cache.h"
+
+extern "C" {
+#include <vl/sift.h>
+}
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace theia {
+
+// The scale space of a single 24 megapixel image takes several hundred
+// megabytes, so by default only the filters for two image sizes (e.g.,
+// portrait and landscape) are kept.
+SiftFilterCache::SiftFilterCache(const SiftParameters& sift_params,
+                                 const int max_num_filters)
+    : sift_params_(sift_params), max_num_filters_(max_num_filters) {
+  CHECK_GT(max_num_filters_, 0);
+}
+
+SiftFilterCache::~SiftFilterCache() {
+  for (const CachedFilter& cached_filter : sift_filters_) {
+    vl_sift_delete(cached_filter.sift_filter);
+  }
+}
+
+VlSiftFilt* SiftFilterCache::GetFilter(const int width,
+                                       const int height,
+                                       const int first_octave) {
+  return GetFilter(width, height, first_octave, sift_params_.num_octaves);
+}
+
+VlSiftFilt* SiftFilterCache::GetFilter(const int width,
+                                       const int height,
+                                       const int first_octave,
+                                       const int num_octaves) {
+  for (int i = 0; i < sift_filters_.size(); i++) {
+    const VlSiftFilt* sift_filter = sift_filters_[i].sift_filter;
+    if (sift_filter->width == width && sift_filter->height == height &&
+        sift_filter->o_min == first_octave &&
+        sift_filters_[i].num_octaves == num_octaves) {
+      // Move the filter to the front to mark it as the most recently used.
+      std::rotate(sift_filters_.begin(), sift_filters_.begin() + i,
+                  sift_filters_.begin() + i + 1);
+      return sift_filters_.front().sift_filter;
+    }
+  }
+
+  if (sift_filters_.size() >= max_num_filters_) {
+    vl_sift_delete(sift_filters_.back().sift_filter);
+    sift_filters_.pop_back();
+  }
+
+  CachedFilter cached_filter;
+  cached_filter.num_octaves = num_octaves;
+  cached_filter.sift_filter = vl_sift_new(width, height,
+                                          num_octaves,
+                                          sift_params_.num_levels,
+                                          first_octave);
+  vl_sift_set_edge_thresh(cached_filter.sift_filter,
+                          sift_params_.edge_threshold);
+  vl_sift_set_peak_thresh(cached_filter.sift_filter,
+                          sift_params_.peak_threshold);
+  sift_filters_.insert(sift_filters_.begin(), cached_filter);
+  return cached_filter.sift_filter;
+}
+
+double DoGResponse(const VlSiftFilt* sift_filter,
+                   const VlSiftKeypoint& keypoint) {
+  const int width = sift_filter->octave_width;
+  const int height = sift_filter->octave_height;
+  return std::abs(
+      sift_filter->dog[(keypoint.is - sift_filter->s_min) * width * height +
+                       keypoint.iy * width + keypoint.ix]);
+}
+
+}  // namespace theia
@@ -0,0 +1,100 @@
+// Copyright (C) 2013 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#ifndef THEIA_IMAGE_KEYPOINT_DETECTOR_SIFT_FILTER_CACHE_H_
+#define THEIA_IMAGE_KEYPOINT_DETECTOR_SIFT_FILTER_CACHE_H_
+
+extern "C" {
+#include <vl/sift.h>
+}
+
+#include <vector>
+
+#include "theia/image/keypoint_detector/sift_parameters.h"
+#include "theia/util/util.h"
+
+namespace theia {
+
+// A VLFeat SIFT filter allocates the scale space for a fixed image size, which
+// is expensive for large images. This class keeps the filters of the most
+// recently used image sizes so that a detector or descriptor extractor that is
+// reused across images (e.g., alternating portrait and landscape images) does
+// not reallocate the scale space for every image.
+class SiftFilterCache {
+ public:
+  // Keeps at most max_num_filters filters.
+  explicit SiftFilterCache(const SiftParameters& sift_params,
+                           const int max_num_filters = 2);
+  ~SiftFilterCache();
+
+  // Returns a filter for images of the given size. If no such filter is cached,
+  // a new filter starting at first_octave is created and the least recently
+  // used filter may be deleted. The filter is owned by the cache and is only
+  // valid until the next call to this method.
+  VlSiftFilt* GetFilter(const int width,
+                        const int height,
+                        const int first_octave);
+
+  // Same as above, but the filter only processes num_octaves octaves instead
+  // of SiftParameters::num_octaves.
+  VlSiftFilt* GetFilter(const int width,
+                        const int height,
+                        const int first_octave,
+                        const int num_octaves);
+
+ private:
+  struct CachedFilter {
+    // The number of octaves that the filter was requested with, which may be
+    // negative to process all octaves.
+    int num_octaves;
+    VlSiftFilt* sift_filter;
+  };
+
+  const SiftParameters sift_params_;
+  const int max_num_filters_;
+
+  // The cached filters, ordered from most to least recently used.
+  std::vector<CachedFilter> sift_filters_;
+
+  DISALLOW_COPY_AND_ASSIGN(SiftFilterCache);
+};
+
+// Returns the magnitude of the difference of Gaussians response of a keypoint
+// detected in the current octave of the filter.
+double DoGResponse(const VlSiftFilt* sift_filter,
+                   const VlSiftKeypoint& keypoint);
+
+}  // namespace theia
+
+#endif  // THEIA_IMAGE_KEYPOINT_DETECTOR_SIFT_FILTER_CACHE_H_
@@ -0,0 +1,99 @@
+// Copyright (C) 2013 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+extern "C" {
+#include <vl/sift.h>
+}
+#include "gtest/gtest.h"
+
+#include "theia/image/keypoint_detector/sift_filter_cache.h"
+#include "theia/image/keypoint_detector/sift_parameters.h"
+
+namespace theia {
+
+TEST(SiftFilterCache, ReusesFiltersOfTheSameSize) {
+  SiftParameters sift_params;
+  SiftFilterCache sift_filter_cache(sift_params);
+
+  VlSiftFilt* landscape_filter = sift_filter_cache.GetFilter(64, 48, 0);
+  EXPECT_EQ(landscape_filter->width, 64);
+  EXPECT_EQ(landscape_filter->height, 48);
+  EXPECT_EQ(landscape_filter->peak_thresh, sift_params.peak_threshold);
+  EXPECT_EQ(landscape_filter->edge_thresh, sift_params.edge_threshold);
+  EXPECT_EQ(sift_filter_cache.GetFilter(64, 48, 0), landscape_filter);
+
+  // Alternating between two image sizes does not create new filters.
+  VlSiftFilt* portrait_filter = sift_filter_cache.GetFilter(48, 64, 0);
+  EXPECT_NE(portrait_filter, landscape_filter);
+  EXPECT_EQ(portrait_filter->width, 48);
+  EXPECT_EQ(portrait_filter->height, 64);
+  EXPECT_EQ(sift_filter_cache.GetFilter(64, 48, 0), landscape_filter);
+  EXPECT_EQ(sift_filter_cache.GetFilter(48, 64, 0), portrait_filter);
+}
+
+TEST(SiftFilterCache, EvictsLeastRecentlyUsedFilter) {
+  SiftParameters sift_params;
+  SiftFilterCache sift_filter_cache(sift_params);
+
+  VlSiftFilt* first_filter = sift_filter_cache.GetFilter(64, 48, 0);
+  sift_filter_cache.GetFilter(48, 64, 0);
+  EXPECT_EQ(sift_filter_cache.GetFilter(64, 48, 0), first_filter);
+
+  // The 48x64 filter is the least recently used one and is evicted.
+  VlSiftFilt* third_filter = sift_filter_cache.GetFilter(32, 32, 0);
+  EXPECT_EQ(third_filter->width, 32);
+  EXPECT_EQ(third_filter->height, 32);
+  EXPECT_EQ(sift_filter_cache.GetFilter(64, 48, 0), first_filter);
+}
+
+TEST(SiftFilterCache, DistinguishesOctaves) {
+  SiftParameters sift_params;
+  SiftFilterCache sift_filter_cache(sift_params, 3);
+
+  VlSiftFilt* all_octaves_filter = sift_filter_cache.GetFilter(64, 48, 0);
+  VlSiftFilt* two_octaves_filter = sift_filter_cache.GetFilter(64, 48, 0, 2);
+  VlSiftFilt* upsampled_filter = sift_filter_cache.GetFilter(64, 48, -1);
+  EXPECT_NE(two_octaves_filter, all_octaves_filter);
+  EXPECT_NE(upsampled_filter, all_octaves_filter);
+  EXPECT_NE(upsampled_filter, two_octaves_filter);
+  EXPECT_EQ(two_octaves_filter->O, 2);
+  EXPECT_EQ(upsampled_filter->o_min, -1);
+
+  // All three filters fit in the cache.
+  EXPECT_EQ(sift_filter_cache.GetFilter(64, 48, 0), all_octaves_filter);
+  EXPECT_EQ(sift_filter_cache.GetFilter(64, 48, 0, 2), two_octaves_filter);
+  EXPECT_EQ(sift_filter_cache.GetFilter(64, 48, -1), upsampled_filter);
+}
+
+}  // namespace theia
@@ -68,6 +68,24 @@ struct SiftParameters {
   // location. This is useful for SfM for a number of reasons, especially during
   // geometric verification.
   bool upright_sift = true;
+  // Stop processing octaves once at least this many keypoints have been
+  // detected. Since octaves are processed from fine to coarse, this skips the
+  // coarsest octaves. A value of 0 processes all octaves.
+  int max_num_keypoints = 0;
+
+  // Parallel extraction for large images (e.g., panoramas). If num_threads > 1
+  // and the image is larger than tile_size pixels, the finest
+  // num_tiled_octaves octaves are processed in overlapping tiles of tile_size
+  // pixels in parallel while the coarser octaves are processed on the full
+  // image at the same time. A keypoint is only kept by the tile that contains
+  // it, so there are no duplicate keypoints at the tile borders. This is only
+  // used when detecting and extracting descriptors at the same time, and
+  // max_num_keypoints is ignored in this case. FeatureExtractor and
+  // FeatureExtractorAndMatcher ignore num_threads when they extract several
+  // images in parallel.
+  int num_threads = 1;
+  int tile_size = 2048;
+  int num_tiled_octaves = 2;
 };
 
 #endif  // THEIA_IMAGE_KEYPOINT_DETECTOR_SIFT_PARAMETERS_H_
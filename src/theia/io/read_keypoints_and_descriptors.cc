@@ -49,6 +49,7 @@
 #include "theia/alignment/alignment.h"
 #include "theia/image/keypoint_detector/keypoint.h"
 #include "theia/io/eigen_serializable.h"
+#include "theia/util/profiler.h"
 
 namespace theia {
 
@@ -69,6 +70,7 @@ bool ReadKeypointsAndDescriptors(const std::string& features_file,
 
   cereal::PortableBinaryInputArchive input_archive(features_reader);
   input_archive(*keypoints, *descriptors);
+  AddProfileCount("feature_file_bytes_read", features_reader.tellg());
 
   return true;
 }
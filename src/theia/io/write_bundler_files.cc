@@ -36,6 +36,7 @@
 
 #include <Eigen/Core>
 #include <glog/logging.h>
+#include <algorithm>
 #include <fstream>  // NOLINT
 #include <memory>
 #include <string>
@@ -81,7 +82,10 @@ bool WriteBundleFile(const Reconstruction& reconstruction,
   const Eigen::IOFormat unaligned(Eigen::FullPrecision, Eigen::DontAlignCols);
   // Output all cameras first.
   std::unordered_map<ViewId, int> view_id_to_index;
-  const auto& view_ids = reconstruction.ViewIds();
+  // Sort the views so that the order of the cameras matches the order of the
+  // images in other exported files (e.g., for PMVS).
+  std::vector<ViewId> view_ids = reconstruction.ViewIds();
+  std::sort(view_ids.begin(), view_ids.end());
   for (int i = 0; i < view_ids.size(); i++) {
     view_id_to_index[view_ids[i]] = i;
     const View* view = reconstruction.View(view_ids[i]);
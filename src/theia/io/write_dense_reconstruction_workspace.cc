@@ -0,0 +1,562 @@
+// Copyright (C) 2015 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include "theia/io/write_dense_reconstruction_workspace.h"
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <fstream>  // NOLINT
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "theia/image/image.h"
+#include "theia/io/write_bundler_files.h"
+#include "theia/sfm/camera/camera.h"
+#include "theia/sfm/camera/image_undistortion_map.h"
+#include "theia/sfm/reconstruction.h"
+#include "theia/sfm/reconstruction_estimator_utils.h"
+#include "theia/sfm/track.h"
+#include "theia/sfm/types.h"
+#include "theia/sfm/view.h"
+#include "theia/util/filesystem.h"
+#include "theia/util/hash.h"
+#include "theia/util/map_util.h"
+#include "theia/util/stringprintf.h"
+#include "theia/util/threadpool.h"
+
+namespace theia {
+
+namespace {
+
+bool CreateDirectoryIfDoesNotExist(const std::string& directory) {
+  if (!DirectoryExists(directory) && !CreateDirectory(directory)) {
+    LOG(ERROR) << "Could not create the directory: " << directory;
+    return false;
+  }
+  return true;
+}
+
+bool HasRadialDistortion(const Camera& camera) {
+  return camera.RadialDistortion1() != 0 || camera.RadialDistortion2() != 0;
+}
+
+// Removes the radial distortion from the camera and the features of the view.
+void UndistortView(View* view) {
+  Camera* camera = view->MutableCamera();
+  if (!HasRadialDistortion(*camera)) {
+    return;
+  }
+
+  const std::vector<TrackId> track_ids = view->TrackIds();
+  std::vector<Eigen::Vector2d> features(track_ids.size());
+  for (int i = 0; i < track_ids.size(); i++) {
+    features[i] = *view->GetFeature(track_ids[i]);
+  }
+  std::vector<Eigen::Vector3d> rays;
+  camera->PixelsToUnitDepthRays(features, &rays);
+
+  // Project the rays with the camera without distortion.
+  Eigen::Matrix3d calibration;
+  camera->GetCalibrationMatrix(&calibration);
+  const Eigen::Matrix3d projection =
+      calibration * camera->GetOrientationAsRotationMatrix();
+  for (int i = 0; i < track_ids.size(); i++) {
+    view->AddFeature(track_ids[i], (projection * rays[i]).hnormalized());
+  }
+  camera->SetRadialDistortion(0, 0);
+}
+
+// Shares the undistortion maps between the images of cameras with the same
+// intrinsics and image size. A map is built by the first task that needs it
+// and is released once all images registered for it have been undistorted, so
+// that only the maps of the images being processed are held in memory.
+class UndistortionMapCache {
+ public:
+  // Registers an image that will be undistorted with the map of the camera.
+  // All images must be registered before any map is acquired.
+  void AddImage(const Camera& camera) {
+    ++entries_[GetKey(camera)].num_remaining_images;
+  }
+
+  // Returns the map of the camera, building it if no other task has.
+  std::shared_ptr<const ImageUndistortionMap> Acquire(const Camera& camera) {
+    std::promise<std::shared_ptr<const ImageUndistortionMap> > promise;
+    std::shared_future<std::shared_ptr<const ImageUndistortionMap> > map;
+    bool build_map = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      Entry& entry = FindOrDie(entries_, GetKey(camera));
+      if (!entry.map.valid()) {
+        entry.map = promise.get_future().share();
+        build_map = true;
+      }
+      map = entry.map;
+    }
+
+    // The map is built outside of the lock so that the maps of different
+    // intrinsics are built in parallel.
+    if (build_map) {
+      promise.set_value(std::make_shared<const ImageUndistortionMap>(camera));
+    }
+    return map.get();
+  }
+
+  // Marks one image of the camera as done. The map is dropped from the cache
+  // after the last image of the camera.
+  void Release(const Camera& camera) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::vector<double> key = GetKey(camera);
+    Entry& entry = FindOrDie(entries_, key);
+    if (--entry.num_remaining_images == 0) {
+      entries_.erase(key);
+    }
+  }
+
+  // The intrinsics followed by the image size of the camera.
+  static std::vector<double> GetKey(const Camera& camera) {
+    std::vector<double> key(camera.intrinsics(),
+                            camera.intrinsics() + Camera::kIntrinsicsSize);
+    key.push_back(camera.ImageWidth());
+    key.push_back(camera.ImageHeight());
+    return key;
+  }
+
+ private:
+  struct Entry {
+    int num_remaining_images = 0;
+    std::shared_future<std::shared_ptr<const ImageUndistortionMap> > map;
+  };
+
+  std::mutex mutex_;
+  std::map<std::vector<double>, Entry> entries_;
+};
+
+// Decodes the image, removes the radial distortion of the camera from it and
+// encodes it to the output file. The remap table of the camera is shared by
+// all images with the same intrinsics and by all channels of the image.
+void UndistortAndWriteImage(const Camera& camera,
+                            const bool undistort_image,
+                            const std::string& input_file,
+                            const std::string& output_file,
+                            UndistortionMapCache* undistortion_maps) {
+  const FloatImage image(input_file);
+  if (!undistort_image || !HasRadialDistortion(camera)) {
+    image.Write(output_file);
+    return;
+  }
+
+  std::shared_ptr<const ImageUndistortionMap> undistortion_map;
+  if (camera.ImageWidth() != image.Width() ||
+      camera.ImageHeight() != image.Height()) {
+    LOG(WARNING) << "The image " << input_file << " has a size of "
+                 << image.Width() << "x" << image.Height()
+                 << " but the camera was calibrated for an image size of "
+                 << camera.ImageWidth() << "x" << camera.ImageHeight();
+    Camera camera_of_image = camera;
+    camera_of_image.SetImageSize(image.Width(), image.Height());
+    undistortion_map =
+        std::make_shared<const ImageUndistortionMap>(camera_of_image);
+  } else {
+    undistortion_map = undistortion_maps->Acquire(camera);
+  }
+
+  FloatImage undistorted_image;
+  undistortion_map->Undistort(image, &undistorted_image);
+  undistortion_map.reset();
+  undistortion_maps->Release(camera);
+  undistorted_image.Write(output_file);
+}
+
+// Undistorts and writes all images in parallel. Each task only holds the
+// filenames so that at most num_threads images are decoded at any time. The
+// images are ordered by the intrinsics of their cameras so that the tasks
+// sharing an undistortion map run close together.
+void UndistortAndWriteImages(const DenseReconstructionWorkspaceOptions& options,
+                             const Reconstruction& reconstruction,
+                             const std::vector<ViewId>& view_ids,
+                             const std::vector<std::string>& input_files,
+                             const std::vector<std::string>& output_files) {
+  UndistortionMapCache undistortion_maps;
+  std::vector<std::pair<std::vector<double>, int> > images;
+  images.reserve(view_ids.size());
+  for (int i = 0; i < view_ids.size(); i++) {
+    const Camera& camera = reconstruction.View(view_ids[i])->Camera();
+    if (options.undistort_images && HasRadialDistortion(camera)) {
+      undistortion_maps.AddImage(camera);
+    }
+    images.emplace_back(UndistortionMapCache::GetKey(camera), i);
+  }
+  std::sort(images.begin(), images.end());
+
+  ThreadPool pool(options.num_threads);
+  std::vector<std::future<void> > results;
+  results.reserve(images.size());
+  for (const auto& image : images) {
+    const int i = image.second;
+    results.emplace_back(
+        pool.Add(UndistortAndWriteImage,
+                 std::cref(reconstruction.View(view_ids[i])->Camera()),
+                 options.undistort_images,
+                 std::cref(input_files[i]),
+                 std::cref(output_files[i]),
+                 &undistortion_maps));
+  }
+
+  // Wait for all images. Errors of CImg while reading or writing an image are
+  // raised here, as they were when the images were exported serially.
+  for (std::future<void>& result : results) {
+    result.get();
+  }
+}
+
+bool WritePMVSOptions(const std::string& working_dir,
+                      const int num_threads,
+                      const int num_images) {
+  const std::string options_file = working_dir + "/pmvs_options.txt";
+  std::ofstream ofs(options_file);
+  if (!ofs.is_open()) {
+    LOG(ERROR) << "Cannot open the file: " << options_file << " for writing.";
+    return false;
+  }
+
+  ofs << "level 1" << std::endl;
+  ofs << "csize 2" << std::endl;
+  ofs << "threshold 0.7" << std::endl;
+  ofs << "wsize 7" << std::endl;
+  ofs << "minImageNum 3" << std::endl;
+  ofs << "CPU " << num_threads << std::endl;
+  ofs << "setEdge 0" << std::endl;
+  ofs << "useBound 0" << std::endl;
+  ofs << "useVisData 0" << std::endl;
+  ofs << "sequence -1" << std::endl;
+  ofs << "timages -1 0 " << num_images << std::endl;
+  ofs << "oimages 0" << std::endl;
+  return true;
+}
+
+bool WritePMVSWorkspace(const DenseReconstructionWorkspaceOptions& options,
+                        const Reconstruction& reconstruction,
+                        const Reconstruction& distorted_reconstruction,
+                        const std::vector<ViewId>& view_ids,
+                        const std::vector<std::string>& image_files,
+                        const std::string& output_directory) {
+  const std::string visualize_dir = output_directory + "/visualize";
+  const std::string txt_dir = output_directory + "/txt";
+  const std::string models_dir = output_directory + "/models";
+  if (!CreateDirectoryIfDoesNotExist(visualize_dir) ||
+      !CreateDirectoryIfDoesNotExist(txt_dir) ||
+      !CreateDirectoryIfDoesNotExist(models_dir)) {
+    return false;
+  }
+
+  // Format for printing eigen matrices.
+  const Eigen::IOFormat unaligned(Eigen::StreamPrecision, Eigen::DontAlignCols);
+
+  // The projection matrices of the cameras in the form of %08d.txt.
+  std::vector<std::string> output_image_files(view_ids.size());
+  for (int i = 0; i < view_ids.size(); i++) {
+    output_image_files[i] =
+        StringPrintf("%s/%08d.jpg", visualize_dir.c_str(), i);
+
+    const std::string txt_file =
+        StringPrintf("%s/%08d.txt", txt_dir.c_str(), i);
+    std::ofstream ofs(txt_file);
+    if (!ofs.is_open()) {
+      LOG(ERROR) << "Cannot open the file: " << txt_file << " for writing.";
+      return false;
+    }
+    Matrix3x4d projection_matrix;
+    reconstruction.View(view_ids[i])->Camera().GetProjectionMatrix(
+        &projection_matrix);
+    ofs << "CONTOUR" << std::endl;
+    ofs << projection_matrix.format(unaligned);
+  }
+
+  UndistortAndWriteImages(options,
+                          distorted_reconstruction,
+                          view_ids,
+                          image_files,
+                          output_image_files);
+
+  const std::string lists_file = output_directory + "/list.txt";
+  const std::string bundle_file = output_directory + "/bundle.rd.out";
+  return WritePMVSOptions(output_directory,
+                          options.num_threads,
+                          view_ids.size()) &&
+         WriteBundlerFiles(reconstruction, lists_file, bundle_file);
+}
+
+// Writes the cameras.txt, images.txt, and points3D.txt files of COLMAP. Each
+// view is written with its own PINHOLE camera. The image and camera ids are the
+// (1-based) position of the view in view_ids.
+bool WriteCOLMAPSparseReconstruction(const Reconstruction& reconstruction,
+                                     const std::vector<ViewId>& view_ids,
+                                     const std::string& sparse_dir) {
+  std::ofstream cameras_file(sparse_dir + "/cameras.txt");
+  std::ofstream images_file(sparse_dir + "/images.txt");
+  std::ofstream points_file(sparse_dir + "/points3D.txt");
+  if (!cameras_file.is_open() || !images_file.is_open() ||
+      !points_file.is_open()) {
+    LOG(ERROR) << "Cannot open the files in " << sparse_dir << " for writing.";
+    return false;
+  }
+  cameras_file.precision(17);
+  images_file.precision(17);
+  points_file.precision(17);
+
+  cameras_file << "# CAMERA_ID, MODEL, WIDTH, HEIGHT, PARAMS[]" << std::endl;
+  images_file << "# IMAGE_ID, QW, QX, QY, QZ, TX, TY, TZ, CAMERA_ID, NAME"
+              << std::endl
+              << "# POINTS2D[] as (X, Y, POINT3D_ID)" << std::endl;
+
+  // The index of the observation of each track in the POINTS2D list of the
+  // image, which the track of points3D.txt refers to.
+  std::unordered_map<std::pair<ViewId, TrackId>, int> observation_index;
+  std::unordered_map<ViewId, int> view_id_to_image_id;
+  for (int i = 0; i < view_ids.size(); i++) {
+    const int image_id = i + 1;
+    view_id_to_image_id[view_ids[i]] = image_id;
+    const View* view = reconstruction.View(view_ids[i]);
+    const Camera& camera = view->Camera();
+    if (camera.Skew() != 0) {
+      LOG(WARNING) << "The skew of the camera of view " << view->Name()
+                   << " is ignored since COLMAP does not model skew.";
+    }
+
+    cameras_file << image_id << " PINHOLE " << camera.ImageWidth() << " "
+                 << camera.ImageHeight() << " " << camera.FocalLength() << " "
+                 << camera.FocalLength() * camera.AspectRatio() << " "
+                 << camera.PrincipalPointX() << " "
+                 << camera.PrincipalPointY() << std::endl;
+
+    // COLMAP stores the world-to-camera transformation.
+    const Eigen::Matrix3d rotation = camera.GetOrientationAsRotationMatrix();
+    const Eigen::Quaterniond orientation(rotation);
+    const Eigen::Vector3d translation = -rotation * camera.GetPosition();
+    images_file << image_id << " " << orientation.w() << " " << orientation.x()
+                << " " << orientation.y() << " " << orientation.z() << " "
+                << translation.x() << " " << translation.y() << " "
+                << translation.z() << " " << image_id << " " << view->Name()
+                << std::endl;
+
+    std::vector<TrackId> track_ids = view->TrackIds();
+    std::sort(track_ids.begin(), track_ids.end());
+    for (int j = 0; j < track_ids.size(); j++) {
+      const Feature& feature = *view->GetFeature(track_ids[j]);
+      observation_index[std::make_pair(view_ids[i], track_ids[j])] = j;
+      images_file << (j == 0 ? "" : " ") << feature.x() << " " << feature.y()
+                  << " " << track_ids[j];
+    }
+    images_file << std::endl;
+  }
+
+  points_file << "# POINT3D_ID, X, Y, Z, R, G, B, ERROR, "
+                 "TRACK[] as (IMAGE_ID, POINT2D_IDX)" << std::endl;
+  std::vector<TrackId> track_ids = reconstruction.TrackIds();
+  std::sort(track_ids.begin(), track_ids.end());
+  for (const TrackId track_id : track_ids) {
+    const Track* track = reconstruction.Track(track_id);
+    std::vector<ViewId> views_in_track(track->ViewIds().begin(),
+                                       track->ViewIds().end());
+    std::sort(views_in_track.begin(), views_in_track.end());
+
+    // The mean reprojection error of the point.
+    double reprojection_error = 0;
+    for (const ViewId view_id : views_in_track) {
+      const View* view = reconstruction.View(view_id);
+      Eigen::Vector2d reprojection;
+      view->Camera().ProjectPoint(track->Point(), &reprojection);
+      reprojection_error += (reprojection - *view->GetFeature(track_id)).norm();
+    }
+    reprojection_error /= views_in_track.size();
+
+    const Eigen::Vector3d point = track->Point().hnormalized();
+    points_file << track_id << " " << point.x() << " " << point.y() << " "
+                << point.z() << " " << static_cast<int>(track->Color()[0])
+                << " " << static_cast<int>(track->Color()[1]) << " "
+                << static_cast<int>(track->Color()[2]) << " "
+                << reprojection_error;
+    for (const ViewId view_id : views_in_track) {
+      points_file << " " << FindOrDie(view_id_to_image_id, view_id) << " "
+                  << FindOrDie(observation_index,
+                               std::make_pair(view_id, track_id));
+    }
+    points_file << std::endl;
+  }
+  return true;
+}
+
+// Writes the configuration files of COLMAP's dense stereo, which match each
+// image with automatically chosen source images.
+bool WriteCOLMAPStereoConfiguration(const Reconstruction& reconstruction,
+                                    const std::vector<ViewId>& view_ids,
+                                    const std::string& stereo_dir) {
+  if (!CreateDirectoryIfDoesNotExist(stereo_dir + "/depth_maps") ||
+      !CreateDirectoryIfDoesNotExist(stereo_dir + "/normal_maps") ||
+      !CreateDirectoryIfDoesNotExist(stereo_dir + "/consistency_graphs")) {
+    return false;
+  }
+
+  std::ofstream patch_match_file(stereo_dir + "/patch-match.cfg");
+  std::ofstream fusion_file(stereo_dir + "/fusion.cfg");
+  if (!patch_match_file.is_open() || !fusion_file.is_open()) {
+    LOG(ERROR) << "Cannot open the files in " << stereo_dir << " for writing.";
+    return false;
+  }
+  for (const ViewId view_id : view_ids) {
+    const std::string& name = reconstruction.View(view_id)->Name();
+    patch_match_file << name << std::endl << "__auto__, 20" << std::endl;
+    fusion_file << name << std::endl;
+  }
+  return true;
+}
+
+bool WriteCOLMAPWorkspace(const DenseReconstructionWorkspaceOptions& options,
+                          const Reconstruction& reconstruction,
+                          const Reconstruction& distorted_reconstruction,
+                          const std::vector<ViewId>& view_ids,
+                          const std::vector<std::string>& image_files,
+                          const std::string& output_directory) {
+  const std::string images_dir = output_directory + "/images";
+  const std::string sparse_dir = output_directory + "/sparse";
+  const std::string stereo_dir = output_directory + "/stereo";
+  if (!CreateDirectoryIfDoesNotExist(images_dir) ||
+      !CreateDirectoryIfDoesNotExist(sparse_dir) ||
+      !CreateDirectoryIfDoesNotExist(stereo_dir)) {
+    return false;
+  }
+
+  if (!WriteCOLMAPSparseReconstruction(reconstruction, view_ids, sparse_dir) ||
+      !WriteCOLMAPStereoConfiguration(reconstruction, view_ids, stereo_dir)) {
+    return false;
+  }
+
+  std::vector<std::string> output_image_files(view_ids.size());
+  for (int i = 0; i < view_ids.size(); i++) {
+    output_image_files[i] =
+        images_dir + "/" + reconstruction.View(view_ids[i])->Name();
+  }
+  UndistortAndWriteImages(options,
+                          distorted_reconstruction,
+                          view_ids,
+                          image_files,
+                          output_image_files);
+  return true;
+}
+
+}  // namespace
+
+bool WriteDenseReconstructionWorkspace(
+    const DenseReconstructionWorkspaceOptions& options,
+    const Reconstruction& reconstruction,
+    const std::vector<std::string>& image_files,
+    const std::string& output_directory) {
+  CHECK_GT(options.num_threads, 0);
+  if (!CreateDirectoryIfDoesNotExist(output_directory)) {
+    return false;
+  }
+
+  // Only export the estimated views that we have an image for.
+  Reconstruction estimated_reconstruction;
+  CreateEstimatedSubreconstruction(reconstruction, &estimated_reconstruction);
+  std::unordered_map<ViewId, std::string> image_file_for_view;
+  for (const std::string& image_file : image_files) {
+    std::string image_name;
+    CHECK(GetFilenameFromFilepath(image_file, true, &image_name));
+    const ViewId view_id = estimated_reconstruction.ViewIdFromName(image_name);
+    if (view_id != kInvalidViewId) {
+      image_file_for_view[view_id] = image_file;
+    }
+  }
+
+  for (const ViewId view_id : estimated_reconstruction.ViewIds()) {
+    if (!ContainsKey(image_file_for_view, view_id)) {
+      estimated_reconstruction.RemoveView(view_id);
+    }
+  }
+  if (estimated_reconstruction.NumViews() == 0) {
+    LOG(ERROR) << "None of the images belong to an estimated view.";
+    return false;
+  }
+
+  std::vector<ViewId> view_ids = estimated_reconstruction.ViewIds();
+  std::sort(view_ids.begin(), view_ids.end());
+  std::vector<std::string> view_image_files(view_ids.size());
+  for (int i = 0; i < view_ids.size(); i++) {
+    view_image_files[i] = FindOrDie(image_file_for_view, view_ids[i]);
+  }
+
+  // The images are undistorted with the original cameras while the workspace
+  // describes the undistorted cameras and features.
+  Reconstruction undistorted_reconstruction = estimated_reconstruction;
+  if (options.undistort_images) {
+    for (const ViewId view_id : view_ids) {
+      UndistortView(undistorted_reconstruction.MutableView(view_id));
+    }
+  }
+
+  LOG(INFO) << "Exporting " << view_ids.size()
+            << " views to the dense reconstruction workspace "
+            << output_directory;
+  switch (options.format) {
+    case DenseReconstructionWorkspaceFormat::PMVS:
+      return WritePMVSWorkspace(options,
+                                undistorted_reconstruction,
+                                estimated_reconstruction,
+                                view_ids,
+                                view_image_files,
+                                output_directory);
+    case DenseReconstructionWorkspaceFormat::COLMAP:
+      return WriteCOLMAPWorkspace(options,
+                                  undistorted_reconstruction,
+                                  estimated_reconstruction,
+                                  view_ids,
+                                  view_image_files,
+                                  output_directory);
+    default:
+      LOG(FATAL) << "Invalid dense reconstruction workspace format.";
+  }
+  return false;
+}
+
+}  // namespace theia
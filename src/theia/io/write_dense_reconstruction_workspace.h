@@ -0,0 +1,88 @@
+// Copyright (C) 2015 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#ifndef THEIA_IO_WRITE_DENSE_RECONSTRUCTION_WORKSPACE_H_
+#define THEIA_IO_WRITE_DENSE_RECONSTRUCTION_WORKSPACE_H_
+
+#include <string>
+#include <vector>
+
+namespace theia {
+
+class Reconstruction;
+
+// The layout of the dense reconstruction workspace.
+enum class DenseReconstructionWorkspaceFormat {
+  // visualize/%08d.jpg images, txt/%08d.txt projection matrices, the
+  // bundle.rd.out and list.txt Bundler files, and pmvs_options.txt.
+  PMVS = 0,
+
+  // The layout of COLMAP's image_undistorter: the images in images/, the
+  // cameras.txt, images.txt, and points3D.txt text files in sparse/, and the
+  // patch-match.cfg and fusion.cfg files in stereo/. OpenMVS imports this
+  // layout with InterfaceCOLMAP.
+  COLMAP = 1,
+};
+
+struct DenseReconstructionWorkspaceOptions {
+  DenseReconstructionWorkspaceFormat format =
+      DenseReconstructionWorkspaceFormat::PMVS;
+
+  // The number of threads used to undistort and write the images. Each thread
+  // decodes, undistorts, and encodes one image at a time so at most
+  // num_threads images are held in memory. For PMVS, this is also the number
+  // of threads written to pmvs_options.txt.
+  int num_threads = 1;
+
+  // Dense reconstruction assumes pinhole cameras. If true, the radial
+  // distortion is removed from the images, the cameras, and the feature
+  // observations. Otherwise, the images are copied as they are.
+  bool undistort_images = true;
+};
+
+// Writes the estimated views and tracks of the reconstruction to a workspace
+// that dense reconstruction (PMVS, COLMAP, or OpenMVS) can be run on. Only the
+// estimated views that have an image in image_files are exported, where the
+// images are matched to the views by their filename. The views are written in
+// the order of their view ids. Returns false if the workspace could not be
+// written.
+bool WriteDenseReconstructionWorkspace(
+    const DenseReconstructionWorkspaceOptions& options,
+    const Reconstruction& reconstruction,
+    const std::vector<std::string>& image_files,
+    const std::string& output_directory);
+
+}  // namespace theia
+
+#endif  // THEIA_IO_WRITE_DENSE_RECONSTRUCTION_WORKSPACE_H_
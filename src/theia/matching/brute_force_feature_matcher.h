@@ -39,6 +39,7 @@
 #include <glog/logging.h>
 
 #include <algorithm>
+#include <utility>
 #include <vector>
 
 #include "theia/matching/feature_correspondence.h"
@@ -63,7 +64,7 @@ class BruteForceFeatureMatcher : public FeatureMatcher<DistanceMetric> {
   bool MatchImagePair(
       const KeypointsAndDescriptors& features1,
       const KeypointsAndDescriptors& features2,
-      std::vector<FeatureCorrespondence>* matched_featuers) override;
+      std::vector<IndexedFeatureMatch>* indexed_matches) override;
 
   void GetFilteredMatches(const Eigen::MatrixXf& match_distances,
                           std::vector<IndexedFeatureMatch>* matches) const;
@@ -78,12 +79,10 @@ template <class DistanceMetric>
 bool BruteForceFeatureMatcher<DistanceMetric>::MatchImagePair(
     const KeypointsAndDescriptors& features1,
     const KeypointsAndDescriptors& features2,
-    std::vector<FeatureCorrespondence>* matched_features) {
+    std::vector<IndexedFeatureMatch>* indexed_matches) {
 
   const std::vector<Eigen::VectorXf>& descriptors1 = features1.descriptors;
-  const std::vector<Keypoint>& keypoints1 = features1.keypoints;
   const std::vector<Eigen::VectorXf>& descriptors2 = features2.descriptors;
-  const std::vector<Keypoint>& keypoints2 = features2.keypoints;
 
   const double sq_lowes_ratio =
       this->matcher_options_.lowes_ratio * this->matcher_options_.lowes_ratio;
@@ -149,14 +148,7 @@ bool BruteForceFeatureMatcher<DistanceMetric>::MatchImagePair(
     return false;
   }
 
-  // Convert to FeatureCorrespondences and return true
-  matched_features->resize(matches.size());
-  for (int i = 0; i < matches.size(); i++) {
-    const Keypoint& keypoint1 = keypoints1[matches[i].feature1_ind];
-    const Keypoint& keypoint2 = keypoints2[matches[i].feature2_ind];
-    matched_features->at(i).feature1 = Feature(keypoint1.x(), keypoint1.y());
-    matched_features->at(i).feature2 = Feature(keypoint2.x(), keypoint2.y());
-  }
+  *indexed_matches = std::move(matches);
   return true;
 }
 
@@ -277,4 +277,45 @@ TEST(BruteForceFeatureMatcherTest, SymmetricMatchesOutOfCore) {
   EXPECT_EQ(matches[0].correspondences.size(), 1);
 }
 
+TEST(BruteForceFeatureMatcherTest, SelectImagePairsWithGlobalDescriptors) {
+  // Images "a1" and "a2" observe one scene and images "b1" and "b2" observe
+  // another scene.
+  static const int kNumSceneDescriptors = 20;
+  std::vector<VectorXf> scene_a(kNumSceneDescriptors);
+  std::vector<VectorXf> scene_b(kNumSceneDescriptors);
+  for (int i = 0; i < kNumSceneDescriptors; i++) {
+    scene_a[i] = VectorXf::Random(kNumDescriptorDimensions).normalized();
+    scene_b[i] = VectorXf::Random(kNumDescriptorDimensions).normalized();
+  }
+
+  // Set options.
+  FeatureMatcherOptions options;
+  options.match_out_of_core = false;
+  options.keypoints_and_descriptors_output_dir = "";
+  options.min_num_feature_matches = 0;
+  options.keep_only_symmetric_matches = false;
+  options.use_lowes_ratio = false;
+  options.select_image_pairs_with_global_descriptors = true;
+  options.num_nearest_neighbors_for_global_descriptors = 1;
+  options.num_global_descriptor_visual_words = 4;
+
+  // Add features.
+  std::vector<Keypoint> keypoints(kNumSceneDescriptors);
+  BruteForceFeatureMatcher<L2> matcher(options);
+  matcher.AddImage("a1", keypoints, scene_a);
+  matcher.AddImage("b1", keypoints, scene_b);
+  matcher.AddImage("a2", keypoints, scene_a);
+  matcher.AddImage("b2", keypoints, scene_b);
+
+  // Match features.
+  std::vector<ImagePairMatch> matches;
+  matcher.MatchImages(&matches);
+
+  // Only the images of the same scene should be matched.
+  EXPECT_EQ(matches.size(), 2);
+  for (const ImagePairMatch& match : matches) {
+    EXPECT_EQ(match.image1[0], match.image2[0]);
+  }
+}
+
 }  // namespace theia
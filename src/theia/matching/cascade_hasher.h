@@ -38,8 +38,11 @@
 #include <Eigen/Core>
 #include <stdint.h>
 #include <bitset>
+#include <memory>
 #include <vector>
 
+#include "theia/util/random.h"
+
 namespace theia {
 
 struct IndexedFeatureMatch;
@@ -85,7 +88,11 @@ struct HashedImage {
 // this class we ask that you please cite this paper.
 class CascadeHasher {
  public:
-  CascadeHasher() {}
+  // The hashing projections are drawn from rng. If rng is null, a generator
+  // seeded from the current time is used.
+  explicit CascadeHasher(const std::shared_ptr<RandomNumberGenerator>& rng)
+      : rng_(rng ? rng : std::make_shared<RandomNumberGenerator>()) {}
+  CascadeHasher() : CascadeHasher(nullptr) {}
 
   // Creates the hashing projections. This must be called before using the
   // cascade hasher.
@@ -115,6 +122,8 @@ class CascadeHasher {
   // sift descriptors.
   void BuildBuckets(HashedImage* hashed_image) const;
 
+  std::shared_ptr<RandomNumberGenerator> rng_;
+
   // Number of dimensions of the descriptors.
   int num_dimensions_of_descriptor_;
 
@@ -73,7 +73,7 @@ class CascadeHashingFeatureMatcher : public FeatureMatcher<L2> {
   bool MatchImagePair(
       const KeypointsAndDescriptors& features1,
       const KeypointsAndDescriptors& features2,
-      std::vector<FeatureCorrespondence>* matched_features) override;
+      std::vector<IndexedFeatureMatch>* matches) override;
 
   std::unordered_map<std::string, HashedImage> hashed_images_;
   std::unique_ptr<CascadeHasher> cascade_hasher_;
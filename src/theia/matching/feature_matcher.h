@@ -38,11 +38,13 @@
 #include <glog/logging.h>
 
 #include <algorithm>
+#include <functional>
 #include <limits>
 #include <memory>
 #include <mutex>  // NOLINT
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -51,12 +53,19 @@
 #include "theia/image/keypoint_detector/keypoint.h"
 #include "theia/matching/feature_correspondence.h"
 #include "theia/matching/feature_matcher_options.h"
+#include "theia/matching/guided_epipolar_matcher.h"
 #include "theia/matching/image_pair_match.h"
+#include "theia/matching/image_retrieval.h"
+#include "theia/matching/indexed_feature_match.h"
 #include "theia/sfm/camera_intrinsics_prior.h"
+#include "theia/sfm/feature.h"
 #include "theia/sfm/verify_two_view_matches.h"
 #include "theia/util/filesystem.h"
+#include "theia/util/hash.h"
 #include "theia/util/lru_cache.h"
 #include "theia/util/map_util.h"
+#include "theia/util/profiler.h"
+#include "theia/util/random.h"
 #include "theia/util/threadpool.h"
 #include "theia/util/util.h"
 
@@ -149,11 +158,12 @@ template <class DistanceMetric> class FeatureMatcher {
 
  protected:
   // NOTE: This method should be overridden in the subclass implementations!
-  // Returns true if the image pair is a valid match.
+  // Returns true if the image pair is a valid match. The matches contain the
+  // indices of the matched keypoints.
   virtual bool MatchImagePair(
       const KeypointsAndDescriptors& features1,
       const KeypointsAndDescriptors& features2,
-      std::vector<FeatureCorrespondence>* matched_features) = 0;
+      std::vector<IndexedFeatureMatch>* matches) = 0;
 
   // Performs matching and geometric verification (if desired) on the
   // pairs_to_match_ between the specified indices. This is useful for thread
@@ -162,6 +172,35 @@ template <class DistanceMetric> class FeatureMatcher {
                                         const int end_index,
                                         std::vector<ImagePairMatch>* matches);
 
+  // Selects the image pairs to match by the similarity of the global
+  // descriptors of the images. Returns false if the global descriptors could
+  // not be computed.
+  bool SelectImagePairsWithGlobalDescriptors();
+
+  // Computes the global descriptor of the images in [start_index, end_index).
+  void ComputeGlobalDescriptors(const VladEncoder& encoder,
+                                const int start_index,
+                                const int end_index,
+                                std::vector<Eigen::VectorXf>* descriptors);
+
+  // Appends the matches found by guided matching along the epipolar lines of
+  // the verified two view geometry to the image pair match. The verified
+  // matches must contain the keypoint indices of the correspondences of the
+  // image pair match.
+  void GuidedMatchImagePair(const KeypointsAndDescriptors& features1,
+                            const KeypointsAndDescriptors& features2,
+                            const CameraIntrinsicsPrior& intrinsics1,
+                            const CameraIntrinsicsPrior& intrinsics2,
+                            std::vector<IndexedFeatureMatch>* verified_matches,
+                            ImagePairMatch* image_pair_match);
+
+  // Returns a random number generator seeded from matcher_options_.random_seed
+  // (and the id of a parallel task), or from the current time if the seed is
+  // negative.
+  std::shared_ptr<RandomNumberGenerator> CreateRandomNumberGenerator() const;
+  std::shared_ptr<RandomNumberGenerator> CreateRandomNumberGenerator(
+      const int task_id) const;
+
   // Fetches keypoints and descriptors from disk. This function is utilized by
   // the internal cache to preserve memory.
   static std::shared_ptr<KeypointsAndDescriptors>
@@ -328,10 +367,21 @@ template <class DistanceMetric>
 void FeatureMatcher<DistanceMetric>::MatchImagesWithGeometricVerification(
     const VerifyTwoViewMatchesOptions& verification_options,
     std::vector<ImagePairMatch>* matches) {
+  ScopedProfile profile("MatchImages");
   verification_options_ = verification_options;
-
-  // If SetImagePairsToMatch has not been called, match all image-to-image
-  // pairs.
+  const int initial_num_cache_hits =
+      keypoints_and_descriptors_cache_->NumCacheHits();
+  const int initial_num_cache_misses =
+      keypoints_and_descriptors_cache_->NumCacheMisses();
+
+  // If SetImagePairsToMatch has not been called, select the image pairs with
+  // global descriptors if desired or match all image-to-image pairs otherwise.
+  if (pairs_to_match_.size() == 0 &&
+      matcher_options_.select_image_pairs_with_global_descriptors &&
+      !SelectImagePairsWithGlobalDescriptors()) {
+    LOG(WARNING) << "Could not select image pairs with global descriptors. "
+                    "Matching all image pairs instead.";
+  }
   if (pairs_to_match_.size() == 0) {
     // Compute the total number of potential matches.
     const int num_pairs_to_match =
@@ -368,6 +418,12 @@ void FeatureMatcher<DistanceMetric>::MatchImagesWithGeometricVerification(
   // Wait for all threads to finish.
   pool.reset(nullptr);
 
+  AddProfileCount("feature_cache_hits",
+                  keypoints_and_descriptors_cache_->NumCacheHits() -
+                      initial_num_cache_hits);
+  AddProfileCount("feature_cache_misses",
+                  keypoints_and_descriptors_cache_->NumCacheMisses() -
+                      initial_num_cache_misses);
   VLOG(1) << "Matched " << matches->size() << " image pairs out of "
           << num_matches << " possible image pairs.";
 }
@@ -400,14 +456,32 @@ void FeatureMatcher<DistanceMetric>::MatchAndVerifyImagePairs(
             FeatureFilenameFromImage(image2_name));
     features2->image_name = image2_name;
 
-    if (!MatchImagePair(*features1,
-                        *features2,
-                        &image_pair_match.correspondences)) {
+    std::vector<IndexedFeatureMatch> putative_matches;
+    bool match_success;
+    {
+      ScopedProfile match_profile("MatchImagePair");
+      match_success =
+          MatchImagePair(*features1, *features2, &putative_matches);
+    }
+    AddProfileCount("num_matched_image_pairs", 1);
+    if (!match_success) {
       VLOG(2)
           << "Could not match a sufficient number of features between images "
           << image1_name << " and " << image2_name;
       continue;
     }
+    AddProfileCount("num_putative_matches", putative_matches.size());
+    image_pair_match.correspondences.resize(putative_matches.size());
+    for (int j = 0; j < putative_matches.size(); j++) {
+      const Keypoint& keypoint1 =
+          features1->keypoints[putative_matches[j].feature1_ind];
+      const Keypoint& keypoint2 =
+          features2->keypoints[putative_matches[j].feature2_ind];
+      image_pair_match.correspondences[j].feature1 =
+          Feature(keypoint1.x(), keypoint1.y());
+      image_pair_match.correspondences[j].feature2 =
+          Feature(keypoint2.x(), keypoint2.y());
+    }
 
     // Add images to the valid matches if no geometric verification is required.
     if (!verify_image_pairs_) {
@@ -423,15 +497,26 @@ void FeatureMatcher<DistanceMetric>::MatchAndVerifyImagePairs(
         FindWithDefault(intrinsics_, image1_name, CameraIntrinsicsPrior());
     const CameraIntrinsicsPrior intrinsics2 =
         FindWithDefault(intrinsics_, image2_name, CameraIntrinsicsPrior());
+    // The pair is verified with its own random number generator so that the
+    // result does not depend on which thread verifies it.
+    VerifyTwoViewMatchesOptions verification_options = verification_options_;
+    verification_options.estimate_twoview_info_options.rng =
+        CreateRandomNumberGenerator(i);
     std::vector<int> inliers;
+    bool verification_success;
+    {
+      ScopedProfile verification_profile("VerifyTwoViewMatches");
+      verification_success =
+          VerifyTwoViewMatches(verification_options,
+                               intrinsics1,
+                               intrinsics2,
+                               image_pair_match.correspondences,
+                               &image_pair_match.twoview_info,
+                               &inliers);
+    }
     // Do not add this image pair as a verified match if the verification does
     // not pass.
-    if (!VerifyTwoViewMatches(verification_options_,
-                              intrinsics1,
-                              intrinsics2,
-                              image_pair_match.correspondences,
-                              &image_pair_match.twoview_info,
-                              &inliers)) {
+    if (!verification_success) {
       VLOG(2) << "Geometric verification between images " << image1_name
               << " and " << image2_name << " failed.";
       continue;
@@ -440,17 +525,32 @@ void FeatureMatcher<DistanceMetric>::MatchAndVerifyImagePairs(
     // Output only the inliers.
     const std::vector<FeatureCorrespondence> old_correspondences =
         std::move(image_pair_match.correspondences);
+    std::vector<IndexedFeatureMatch> verified_matches;
     image_pair_match.correspondences.reserve(inliers.size());
+    verified_matches.reserve(inliers.size());
     for (int j = 0; j < inliers.size(); ++j) {
       image_pair_match.correspondences.emplace_back(
           old_correspondences[inliers[j]]);
+      verified_matches.emplace_back(putative_matches[inliers[j]]);
+    }
+
+    // Recover additional matches along the epipolar lines of the verified two
+    // view geometry.
+    if (matcher_options_.perform_guided_matching) {
+      ScopedProfile guided_matching_profile("GuidedMatchImagePair");
+      GuidedMatchImagePair(*features1, *features2, intrinsics1, intrinsics2,
+                           &verified_matches, &image_pair_match);
     }
+
     VLOG(1) << "Images " << image1_name << " and " << image2_name
-            << " were matched with " << inliers.size()
+            << " were matched with "
+            << image_pair_match.correspondences.size()
             << " verified matches and "
             << image_pair_match.twoview_info.num_homography_inliers
             << " homography matches out of " << old_correspondences.size()
             << " putative matches.";
+    AddProfileCount("num_verified_matches",
+                    image_pair_match.correspondences.size());
     {
       std::lock_guard<std::mutex> lock(mutex_);
       matches->push_back(image_pair_match);
@@ -458,6 +558,148 @@ void FeatureMatcher<DistanceMetric>::MatchAndVerifyImagePairs(
   }
 }
 
+template <class DistanceMetric>
+std::shared_ptr<RandomNumberGenerator>
+FeatureMatcher<DistanceMetric>::CreateRandomNumberGenerator() const {
+  if (matcher_options_.random_seed < 0) {
+    return std::make_shared<RandomNumberGenerator>();
+  }
+  return std::make_shared<RandomNumberGenerator>(matcher_options_.random_seed);
+}
+
+template <class DistanceMetric>
+std::shared_ptr<RandomNumberGenerator>
+FeatureMatcher<DistanceMetric>::CreateRandomNumberGenerator(
+    const int task_id) const {
+  if (matcher_options_.random_seed < 0) {
+    return std::make_shared<RandomNumberGenerator>();
+  }
+  return std::make_shared<RandomNumberGenerator>(matcher_options_.random_seed,
+                                                 task_id);
+}
+
+template <class DistanceMetric>
+bool FeatureMatcher<DistanceMetric>::SelectImagePairsWithGlobalDescriptors() {
+  // Train the vocabulary on a random subset of the descriptors of all images.
+  VladEncoderOptions encoder_options;
+  encoder_options.num_visual_words =
+      matcher_options_.num_global_descriptor_visual_words;
+  encoder_options.rng = CreateRandomNumberGenerator();
+  VladEncoder encoder(encoder_options);
+  for (const std::string& image_name : image_names_) {
+    const std::shared_ptr<KeypointsAndDescriptors> features =
+        keypoints_and_descriptors_cache_->Fetch(
+            FeatureFilenameFromImage(image_name));
+    encoder.AddTrainingDescriptors(features->descriptors);
+  }
+  if (!encoder.Train()) {
+    return false;
+  }
+
+  // Compute the global descriptors of all images in parallel.
+  const int num_images = image_names_.size();
+  std::vector<Eigen::VectorXf> global_descriptors(num_images);
+  const int num_threads =
+      std::max(1, std::min(matcher_options_.num_threads, num_images));
+  std::unique_ptr<ThreadPool> pool(new ThreadPool(num_threads));
+  const int interval_step =
+      std::max(1, std::min(this->kMaxThreadingStepSize_,
+                           num_images / num_threads));
+  for (int i = 0; i < num_images; i += interval_step) {
+    pool->Add(&FeatureMatcher::ComputeGlobalDescriptors,
+              this,
+              std::cref(encoder),
+              i,
+              std::min(num_images, i + interval_step),
+              &global_descriptors);
+  }
+  pool.reset(nullptr);
+
+  std::vector<std::pair<int, int> > image_pairs;
+  SelectImagePairsFromGlobalDescriptors(
+      global_descriptors,
+      matcher_options_.num_nearest_neighbors_for_global_descriptors,
+      &image_pairs);
+  pairs_to_match_.reserve(image_pairs.size());
+  for (const auto& image_pair : image_pairs) {
+    pairs_to_match_.emplace_back(image_names_[image_pair.first],
+                                 image_names_[image_pair.second]);
+  }
+  VLOG(1) << "Selected " << pairs_to_match_.size() << " image pairs to match "
+          << "out of " << num_images * (num_images - 1) / 2
+          << " possible image pairs using global descriptors.";
+  return !pairs_to_match_.empty();
+}
+
+template <class DistanceMetric>
+void FeatureMatcher<DistanceMetric>::ComputeGlobalDescriptors(
+    const VladEncoder& encoder,
+    const int start_index,
+    const int end_index,
+    std::vector<Eigen::VectorXf>* descriptors) {
+  for (int i = start_index; i < end_index; i++) {
+    const std::shared_ptr<KeypointsAndDescriptors> features =
+        keypoints_and_descriptors_cache_->Fetch(
+            FeatureFilenameFromImage(image_names_[i]));
+    (*descriptors)[i] = encoder.Encode(features->descriptors);
+  }
+}
+
+template <class DistanceMetric>
+void FeatureMatcher<DistanceMetric>::GuidedMatchImagePair(
+    const KeypointsAndDescriptors& features1,
+    const KeypointsAndDescriptors& features2,
+    const CameraIntrinsicsPrior& intrinsics1,
+    const CameraIntrinsicsPrior& intrinsics2,
+    std::vector<IndexedFeatureMatch>* verified_matches,
+    ImagePairMatch* image_pair_match) {
+  GuidedEpipolarMatcherOptions guided_matcher_options;
+  guided_matcher_options.max_epipolar_distance =
+      matcher_options_.guided_matching_max_epipolar_distance;
+  guided_matcher_options.use_lowes_ratio = matcher_options_.use_lowes_ratio;
+  guided_matcher_options.lowes_ratio = matcher_options_.lowes_ratio;
+  const GuidedEpipolarMatcher guided_matcher(guided_matcher_options,
+                                             features1.keypoints,
+                                             features1.descriptors,
+                                             features2.keypoints,
+                                             features2.descriptors);
+  const int num_verified_matches = verified_matches->size();
+  guided_matcher.GetMatches(
+      FundamentalMatrixFromTwoViewInfo(intrinsics1,
+                                       intrinsics2,
+                                       image_pair_match->twoview_info),
+      verified_matches);
+
+  // SIFT may detect several keypoints at the same position with different
+  // orientations, so a guided match may have the same positions as a verified
+  // match. Such duplicates are not added.
+  std::unordered_set<std::pair<Feature, Feature> > correspondences;
+  for (const FeatureCorrespondence& correspondence :
+       image_pair_match->correspondences) {
+    correspondences.emplace(correspondence.feature1, correspondence.feature2);
+  }
+  int num_guided_matches = 0;
+  for (int i = num_verified_matches; i < verified_matches->size(); i++) {
+    const IndexedFeatureMatch& match = (*verified_matches)[i];
+    const Keypoint& keypoint1 = features1.keypoints[match.feature1_ind];
+    const Keypoint& keypoint2 = features2.keypoints[match.feature2_ind];
+    FeatureCorrespondence correspondence;
+    correspondence.feature1 = Feature(keypoint1.x(), keypoint1.y());
+    correspondence.feature2 = Feature(keypoint2.x(), keypoint2.y());
+    if (!correspondences
+             .emplace(correspondence.feature1, correspondence.feature2)
+             .second) {
+      continue;
+    }
+    image_pair_match->correspondences.emplace_back(correspondence);
+    ++num_guided_matches;
+  }
+  image_pair_match->twoview_info.num_verified_matches += num_guided_matches;
+  VLOG(2) << num_guided_matches << " matches were added by guided matching "
+          << "between images " << features1.image_name << " and "
+          << features2.image_name;
+}
+
 }  // namespace theia
 
 #endif  // THEIA_MATCHING_FEATURE_MATCHER_H_
@@ -73,6 +73,36 @@ struct FeatureMatcherOptions {
   // Only images that contain more feature matches than this number will be
   // returned.
   int min_num_feature_matches = 30;
+
+  // If true, features that were not matched are matched again after geometric
+  // verification by searching only among the features that lie close to their
+  // epipolar lines in the other image (see GuidedEpipolarMatcher). This
+  // recovers matches that were rejected by the lowes ratio test and results in
+  // longer tracks. Only applies to matching with geometric verification.
+  bool perform_guided_matching = false;
+
+  // The maximum distance in pixels of a guided match to its epipolar line.
+  double guided_matching_max_epipolar_distance = 4.0;
+
+  // If true and SetImagePairsToMatch has not been called, only a subset of all
+  // image pairs is matched instead of all N * (N - 1) / 2 pairs. A global VLAD
+  // descriptor (see VladEncoder) is computed for each image from its local
+  // descriptors, and each image is matched to the
+  // num_nearest_neighbors_for_global_descriptors images with the most similar
+  // global descriptors.
+  bool select_image_pairs_with_global_descriptors = false;
+  int num_nearest_neighbors_for_global_descriptors = 50;
+
+  // Number of visual words of the vocabulary used for the global descriptors.
+  int num_global_descriptor_visual_words = 16;
+
+  // Seed of the random numbers used for matching (e.g., the hashing
+  // projections, the vocabulary of the global descriptors and RANSAC during
+  // geometric verification). Each image pair is verified with its own
+  // generator that is seeded from this seed and the index of the pair, so the
+  // matches can be reproduced regardless of the number of threads. If negative,
+  // the generators are seeded from the current time.
+  int random_seed = -1;
 };
 
 }  // namespace theia
@@ -0,0 +1,296 @@
+// Copyright (C) 2014 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include "theia/matching/guided_epipolar_matcher.h"
+
+#include <Eigen/Core>
+#include <Eigen/LU>
+#include <glog/logging.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "theia/image/keypoint_detector/keypoint.h"
+#include "theia/matching/distance.h"
+#include "theia/matching/indexed_feature_match.h"
+#include "theia/sfm/camera/camera.h"
+#include "theia/sfm/camera_intrinsics_prior.h"
+#include "theia/sfm/pose/util.h"
+#include "theia/sfm/set_camera_intrinsics_from_priors.h"
+#include "theia/sfm/twoview_info.h"
+
+namespace theia {
+
+Eigen::Matrix3d FundamentalMatrixFromTwoViewInfo(
+    const CameraIntrinsicsPrior& intrinsics1,
+    const CameraIntrinsicsPrior& intrinsics2,
+    const TwoViewInfo& twoview_info) {
+  Camera camera1, camera2;
+  camera1.SetFocalLength(twoview_info.focal_length_1);
+  SetCameraIntrinsicsFromPriors(intrinsics1, &camera1);
+  camera2.SetFocalLength(twoview_info.focal_length_2);
+  SetCameraIntrinsicsFromPriors(intrinsics2, &camera2);
+  camera2.SetOrientationFromAngleAxis(twoview_info.rotation_2);
+
+  Eigen::Matrix3d calibration1, calibration2;
+  camera1.GetCalibrationMatrix(&calibration1);
+  camera2.GetCalibrationMatrix(&calibration2);
+  const Eigen::Matrix3d rotation = camera2.GetOrientationAsRotationMatrix();
+  const Eigen::Vector3d translation = -rotation * twoview_info.position_2;
+  return calibration2.inverse().transpose() * CrossProductMatrix(translation) *
+         rotation * calibration1.inverse();
+}
+
+GuidedEpipolarMatcher::GuidedEpipolarMatcher(
+    const GuidedEpipolarMatcherOptions& options,
+    const std::vector<Keypoint>& keypoints1,
+    const std::vector<Eigen::VectorXf>& descriptors1,
+    const std::vector<Keypoint>& keypoints2,
+    const std::vector<Eigen::VectorXf>& descriptors2)
+    : options_(options),
+      keypoints1_(keypoints1),
+      descriptors1_(descriptors1),
+      keypoints2_(keypoints2),
+      descriptors2_(descriptors2) {
+  CHECK_EQ(keypoints1_.size(), descriptors1_.size());
+  CHECK_EQ(keypoints2_.size(), descriptors2_.size());
+  CHECK_GT(options_.grid_cell_size, 0.0);
+  BuildGrid();
+}
+
+void GuidedEpipolarMatcher::BuildGrid() {
+  grid_min_x_ = 0.0;
+  grid_min_y_ = 0.0;
+  num_grid_cols_ = 0;
+  num_grid_rows_ = 0;
+  grid_offsets_.assign(1, 0);
+  grid_keypoints_.clear();
+  if (keypoints2_.empty()) {
+    return;
+  }
+
+  double grid_max_x = keypoints2_[0].x();
+  double grid_max_y = keypoints2_[0].y();
+  grid_min_x_ = grid_max_x;
+  grid_min_y_ = grid_max_y;
+  for (const Keypoint& keypoint : keypoints2_) {
+    grid_min_x_ = std::min(grid_min_x_, keypoint.x());
+    grid_min_y_ = std::min(grid_min_y_, keypoint.y());
+    grid_max_x = std::max(grid_max_x, keypoint.x());
+    grid_max_y = std::max(grid_max_y, keypoint.y());
+  }
+  num_grid_cols_ =
+      static_cast<int>((grid_max_x - grid_min_x_) / options_.grid_cell_size) +
+      1;
+  num_grid_rows_ =
+      static_cast<int>((grid_max_y - grid_min_y_) / options_.grid_cell_size) +
+      1;
+
+  // Counting sort of the keypoints by their cell.
+  std::vector<int> keypoint_cells(keypoints2_.size());
+  grid_offsets_.assign(num_grid_cols_ * num_grid_rows_ + 1, 0);
+  for (int i = 0; i < keypoints2_.size(); i++) {
+    const int col = static_cast<int>((keypoints2_[i].x() - grid_min_x_) /
+                                     options_.grid_cell_size);
+    const int row = static_cast<int>((keypoints2_[i].y() - grid_min_y_) /
+                                     options_.grid_cell_size);
+    keypoint_cells[i] = row * num_grid_cols_ + col;
+    ++grid_offsets_[keypoint_cells[i] + 1];
+  }
+  for (int i = 1; i < grid_offsets_.size(); i++) {
+    grid_offsets_[i] += grid_offsets_[i - 1];
+  }
+
+  grid_keypoints_.resize(keypoints2_.size());
+  std::vector<int> cell_fill(grid_offsets_.begin(), grid_offsets_.end() - 1);
+  for (int i = 0; i < keypoints2_.size(); i++) {
+    grid_keypoints_[cell_fill[keypoint_cells[i]]++] = i;
+  }
+}
+
+void GuidedEpipolarMatcher::AddCandidatesInCells(
+    const Eigen::Vector3d& epipolar_line,
+    const int min_col,
+    const int max_col,
+    const int min_row,
+    const int max_row,
+    std::vector<int>* candidates) const {
+  for (int row = min_row; row <= max_row; row++) {
+    for (int col = min_col; col <= max_col; col++) {
+      const int cell = row * num_grid_cols_ + col;
+      for (int i = grid_offsets_[cell]; i < grid_offsets_[cell + 1]; i++) {
+        const Keypoint& keypoint = keypoints2_[grid_keypoints_[i]];
+        const double distance =
+            std::abs(epipolar_line.x() * keypoint.x() +
+                     epipolar_line.y() * keypoint.y() + epipolar_line.z());
+        if (distance <= options_.max_epipolar_distance) {
+          candidates->emplace_back(grid_keypoints_[i]);
+        }
+      }
+    }
+  }
+}
+
+void GuidedEpipolarMatcher::GetCandidates(const Eigen::Vector3d& epipolar_line,
+                                          std::vector<int>* candidates) const {
+  const double a = epipolar_line.x();
+  const double b = epipolar_line.y();
+  const double c = epipolar_line.z();
+  const double cell_size = options_.grid_cell_size;
+
+  // Walk the grid along the dominant direction of the line. In each column (or
+  // row) of cells the band around the line covers a contiguous range of rows
+  // (or columns).
+  if (std::abs(b) >= std::abs(a)) {
+    const double band_height = options_.max_epipolar_distance / std::abs(b);
+    for (int col = 0; col < num_grid_cols_; col++) {
+      const double x0 = grid_min_x_ + col * cell_size;
+      const double x1 = x0 + cell_size;
+      const double y0 = -(a * x0 + c) / b;
+      const double y1 = -(a * x1 + c) / b;
+      const double min_row = std::max(
+          0.0,
+          std::floor((std::min(y0, y1) - band_height - grid_min_y_) /
+                     cell_size));
+      const double max_row = std::min(
+          num_grid_rows_ - 1.0,
+          std::floor((std::max(y0, y1) + band_height - grid_min_y_) /
+                     cell_size));
+      if (min_row <= max_row) {
+        AddCandidatesInCells(epipolar_line, col, col, min_row, max_row,
+                             candidates);
+      }
+    }
+  } else {
+    const double band_width = options_.max_epipolar_distance / std::abs(a);
+    for (int row = 0; row < num_grid_rows_; row++) {
+      const double y0 = grid_min_y_ + row * cell_size;
+      const double y1 = y0 + cell_size;
+      const double x0 = -(b * y0 + c) / a;
+      const double x1 = -(b * y1 + c) / a;
+      const double min_col = std::max(
+          0.0,
+          std::floor((std::min(x0, x1) - band_width - grid_min_x_) /
+                     cell_size));
+      const double max_col = std::min(
+          num_grid_cols_ - 1.0,
+          std::floor((std::max(x0, x1) + band_width - grid_min_x_) /
+                     cell_size));
+      if (min_col <= max_col) {
+        AddCandidatesInCells(epipolar_line, min_col, max_col, row, row,
+                             candidates);
+      }
+    }
+  }
+}
+
+int GuidedEpipolarMatcher::GetMatches(
+    const Eigen::Matrix3d& fundamental_matrix,
+    std::vector<IndexedFeatureMatch>* matches) const {
+  CHECK_NOTNULL(matches);
+
+  // Features that are already matched are not considered.
+  std::vector<bool> is_matched1(keypoints1_.size(), false);
+  std::vector<bool> is_matched2(keypoints2_.size(), false);
+  for (const IndexedFeatureMatch& match : *matches) {
+    is_matched1[match.feature1_ind] = true;
+    is_matched2[match.feature2_ind] = true;
+  }
+
+  const float sq_lowes_ratio = options_.lowes_ratio * options_.lowes_ratio;
+  L2 distance;
+  std::vector<IndexedFeatureMatch> guided_matches;
+  std::vector<int> candidates;
+  for (int i = 0; i < keypoints1_.size(); i++) {
+    if (is_matched1[i]) {
+      continue;
+    }
+
+    Eigen::Vector3d epipolar_line =
+        fundamental_matrix *
+        Eigen::Vector3d(keypoints1_[i].x(), keypoints1_[i].y(), 1.0);
+    const double line_norm = epipolar_line.head<2>().norm();
+    if (line_norm == 0.0) {
+      continue;
+    }
+    epipolar_line /= line_norm;
+
+    candidates.clear();
+    GetCandidates(epipolar_line, &candidates);
+
+    // Find the two nearest neighbors among the candidates.
+    IndexedFeatureMatch best_match(i, -1, std::numeric_limits<float>::max());
+    float second_best_distance = std::numeric_limits<float>::max();
+    for (const int candidate : candidates) {
+      if (is_matched2[candidate]) {
+        continue;
+      }
+      const float candidate_distance =
+          distance(descriptors1_[i], descriptors2_[candidate]);
+      if (candidate_distance < best_match.distance) {
+        second_best_distance = best_match.distance;
+        best_match.feature2_ind = candidate;
+        best_match.distance = candidate_distance;
+      } else if (candidate_distance < second_best_distance) {
+        second_best_distance = candidate_distance;
+      }
+    }
+
+    if (best_match.feature2_ind < 0) {
+      continue;
+    }
+    if (options_.use_lowes_ratio &&
+        best_match.distance >= sq_lowes_ratio * second_best_distance) {
+      continue;
+    }
+    guided_matches.emplace_back(best_match);
+  }
+
+  // Keep the best match for each feature in the second image.
+  std::sort(guided_matches.begin(), guided_matches.end(),
+            CompareFeaturesByDistance);
+  int num_new_matches = 0;
+  for (const IndexedFeatureMatch& match : guided_matches) {
+    if (is_matched2[match.feature2_ind]) {
+      continue;
+    }
+    is_matched2[match.feature2_ind] = true;
+    matches->emplace_back(match);
+    ++num_new_matches;
+  }
+  return num_new_matches;
+}
+
+}  // namespace theia
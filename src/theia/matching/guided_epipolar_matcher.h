@@ -0,0 +1,135 @@
+// Copyright (C) 2014 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#ifndef THEIA_MATCHING_GUIDED_EPIPOLAR_MATCHER_H_
+#define THEIA_MATCHING_GUIDED_EPIPOLAR_MATCHER_H_
+
+#include <Eigen/Core>
+#include <vector>
+
+#include "theia/image/keypoint_detector/keypoint.h"
+#include "theia/matching/indexed_feature_match.h"
+#include "theia/util/util.h"
+
+namespace theia {
+
+struct CameraIntrinsicsPrior;
+struct TwoViewInfo;
+
+struct GuidedEpipolarMatcherOptions {
+  // Candidate matches in the second image must be within this many pixels of
+  // the epipolar line of the feature in the first image.
+  double max_epipolar_distance = 4.0;
+
+  // The keypoints of the second image are indexed in a grid with cells of this
+  // size (in pixels) so that only the cells intersecting the band around an
+  // epipolar line are searched.
+  double grid_cell_size = 32.0;
+
+  // The lowes ratio test is applied among the candidates in the epipolar band.
+  bool use_lowes_ratio = true;
+  float lowes_ratio = 0.8;
+};
+
+// Finds additional feature matches between two images given a fundamental
+// matrix (in pixels) that is already known, e.g. from geometric verification.
+// For each feature in the first image that is not yet matched, only the
+// unmatched features of the second image that lie close to its epipolar line
+// are considered for the nearest neighbor search. This recovers matches that were
+// discarded by the global lowes ratio test at a fraction of the cost of a
+// brute force search. Descriptors are compared with the L2 distance.
+//
+// The keypoints and descriptors are owned by the caller and must remain valid
+// for the lifetime of this object.
+class GuidedEpipolarMatcher {
+ public:
+  GuidedEpipolarMatcher(const GuidedEpipolarMatcherOptions& options,
+                        const std::vector<Keypoint>& keypoints1,
+                        const std::vector<Eigen::VectorXf>& descriptors1,
+                        const std::vector<Keypoint>& keypoints2,
+                        const std::vector<Eigen::VectorXf>& descriptors2);
+
+  // The fundamental matrix maps points in image 1 to epipolar lines in image 2
+  // (i.e., x2' * F * x1 = 0). The input matches are kept and the features they
+  // contain are not matched again. New matches are appended to the matches and
+  // the number of new matches is returned. Each feature is contained in at most
+  // one new match.
+  int GetMatches(const Eigen::Matrix3d& fundamental_matrix,
+                 std::vector<IndexedFeatureMatch>* matches) const;
+
+ private:
+  // Indexes the keypoints of the second image in the grid.
+  void BuildGrid();
+
+  // Returns the indices of all keypoints in the second image within
+  // max_epipolar_distance of the (normalized) epipolar line.
+  void GetCandidates(const Eigen::Vector3d& epipolar_line,
+                     std::vector<int>* candidates) const;
+
+  // Appends the keypoints of the cells in the given range to the candidates if
+  // they are close enough to the epipolar line.
+  void AddCandidatesInCells(const Eigen::Vector3d& epipolar_line,
+                            const int min_col,
+                            const int max_col,
+                            const int min_row,
+                            const int max_row,
+                            std::vector<int>* candidates) const;
+
+  const GuidedEpipolarMatcherOptions options_;
+  const std::vector<Keypoint>& keypoints1_;
+  const std::vector<Eigen::VectorXf>& descriptors1_;
+  const std::vector<Keypoint>& keypoints2_;
+  const std::vector<Eigen::VectorXf>& descriptors2_;
+
+  // The grid is stored as a compressed list: the keypoints of cell i are
+  // grid_keypoints_[grid_offsets_[i]] to grid_keypoints_[grid_offsets_[i + 1]].
+  double grid_min_x_, grid_min_y_;
+  int num_grid_cols_, num_grid_rows_;
+  std::vector<int> grid_offsets_;
+  std::vector<int> grid_keypoints_;
+
+  DISALLOW_COPY_AND_ASSIGN(GuidedEpipolarMatcher);
+};
+
+// Returns the fundamental matrix (in pixels) of the two view info estimated
+// during geometric verification. As in geometric verification, the principal
+// point is set from the prior or to the image center otherwise.
+Eigen::Matrix3d FundamentalMatrixFromTwoViewInfo(
+    const CameraIntrinsicsPrior& intrinsics1,
+    const CameraIntrinsicsPrior& intrinsics2,
+    const TwoViewInfo& twoview_info);
+
+}  // namespace theia
+
+#endif  // THEIA_MATCHING_GUIDED_EPIPOLAR_MATCHER_H_
@@ -0,0 +1,204 @@
+// Copyright (C) 2014 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include <Eigen/Core>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "theia/image/keypoint_detector/keypoint.h"
+#include "theia/matching/guided_epipolar_matcher.h"
+#include "theia/matching/indexed_feature_match.h"
+#include "theia/sfm/camera/camera.h"
+#include "theia/sfm/camera_intrinsics_prior.h"
+#include "theia/sfm/twoview_info.h"
+#include "theia/util/random.h"
+
+namespace theia {
+
+namespace {
+
+static const int kNumPoints = 100;
+static const int kDescriptorDimension = 128;
+static const double kFocalLength = 800.0;
+
+class GuidedEpipolarMatcherTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    InitRandomGenerator();
+
+    intrinsics1_.image_width = 1000;
+    intrinsics1_.image_height = 1000;
+    intrinsics2_ = intrinsics1_;
+
+    twoview_info_.focal_length_1 = kFocalLength;
+    twoview_info_.focal_length_2 = kFocalLength;
+    twoview_info_.rotation_2 = Eigen::Vector3d(0.02, -0.2, 0.01);
+    twoview_info_.position_2 = Eigen::Vector3d(1.0, 0.1, 0.0).normalized();
+
+    camera1_.SetFocalLength(kFocalLength);
+    camera1_.SetPrincipalPoint(500.0, 500.0);
+    camera2_ = camera1_;
+    camera2_.SetOrientationFromAngleAxis(twoview_info_.rotation_2);
+    camera2_.SetPosition(twoview_info_.position_2);
+
+    // Project random points into both images. Each point has a random
+    // descriptor which is slightly perturbed in the second image.
+    while (keypoints1_.size() < kNumPoints) {
+      const Eigen::Vector4d point(RandDouble(-2.0, 2.0),
+                                  RandDouble(-2.0, 2.0),
+                                  RandDouble(4.0, 8.0),
+                                  1.0);
+      Eigen::Vector2d pixel1, pixel2;
+      if (camera1_.ProjectPoint(point, &pixel1) < 0 ||
+          camera2_.ProjectPoint(point, &pixel2) < 0) {
+        continue;
+      }
+      const Eigen::VectorXf descriptor =
+          Eigen::VectorXf::Random(kDescriptorDimension).normalized();
+      keypoints1_.emplace_back(pixel1.x(), pixel1.y(), Keypoint::OTHER);
+      keypoints2_.emplace_back(pixel2.x(), pixel2.y(), Keypoint::OTHER);
+      descriptors1_.emplace_back(descriptor);
+      descriptors2_.emplace_back(
+          (descriptor +
+           0.05 * Eigen::VectorXf::Random(kDescriptorDimension)).normalized());
+    }
+  }
+
+  CameraIntrinsicsPrior intrinsics1_, intrinsics2_;
+  TwoViewInfo twoview_info_;
+  Camera camera1_, camera2_;
+  std::vector<Keypoint> keypoints1_, keypoints2_;
+  std::vector<Eigen::VectorXf> descriptors1_, descriptors2_;
+};
+
+}  // namespace
+
+TEST_F(GuidedEpipolarMatcherTest, FundamentalMatrixFromTwoViewInfo) {
+  const Eigen::Matrix3d fundamental_matrix = FundamentalMatrixFromTwoViewInfo(
+      intrinsics1_, intrinsics2_, twoview_info_);
+  for (int i = 0; i < keypoints1_.size(); i++) {
+    Eigen::Vector3d epipolar_line =
+        fundamental_matrix *
+        Eigen::Vector3d(keypoints1_[i].x(), keypoints1_[i].y(), 1.0);
+    epipolar_line /= epipolar_line.head<2>().norm();
+    EXPECT_LT(std::abs(epipolar_line.dot(
+                  Eigen::Vector3d(keypoints2_[i].x(), keypoints2_[i].y(), 1.0))),
+              1e-6);
+  }
+}
+
+TEST_F(GuidedEpipolarMatcherTest, FundamentalMatrixFromTwoViewInfoWithSkew) {
+  static const double kSkew = 50.0;
+  intrinsics2_.skew.is_set = true;
+  intrinsics2_.skew.value = kSkew;
+  camera2_.SetSkew(kSkew);
+
+  const Eigen::Matrix3d fundamental_matrix = FundamentalMatrixFromTwoViewInfo(
+      intrinsics1_, intrinsics2_, twoview_info_);
+  for (int i = 0; i < kNumPoints; i++) {
+    const Eigen::Vector4d point(RandDouble(-2.0, 2.0),
+                                RandDouble(-2.0, 2.0),
+                                RandDouble(4.0, 8.0),
+                                1.0);
+    Eigen::Vector2d pixel1, pixel2;
+    camera1_.ProjectPoint(point, &pixel1);
+    camera2_.ProjectPoint(point, &pixel2);
+    Eigen::Vector3d epipolar_line = fundamental_matrix * pixel1.homogeneous();
+    epipolar_line /= epipolar_line.head<2>().norm();
+    EXPECT_LT(std::abs(epipolar_line.dot(pixel2.homogeneous())), 1e-6);
+  }
+}
+
+TEST_F(GuidedEpipolarMatcherTest, RecoversUnmatchedFeatures) {
+  // Half of the features are already matched.
+  std::vector<IndexedFeatureMatch> matches;
+  for (int i = 0; i < kNumPoints / 2; i++) {
+    matches.emplace_back(i, i, 0.0);
+  }
+
+  // Add distractors to the second image that have the same descriptor as the
+  // unmatched features but are far from the epipolar lines.
+  for (int i = kNumPoints / 2; i < kNumPoints; i++) {
+    const Eigen::Vector2d offset =
+        60.0 * Eigen::Vector2d::Random().normalized();
+    keypoints2_.emplace_back(keypoints2_[i].x() + offset.x(),
+                             keypoints2_[i].y() + offset.y(),
+                             Keypoint::OTHER);
+    descriptors2_.emplace_back(descriptors1_[i]);
+  }
+
+  GuidedEpipolarMatcherOptions options;
+  options.max_epipolar_distance = 1.0;
+  const GuidedEpipolarMatcher matcher(options,
+                                      keypoints1_,
+                                      descriptors1_,
+                                      keypoints2_,
+                                      descriptors2_);
+  const Eigen::Matrix3d fundamental_matrix = FundamentalMatrixFromTwoViewInfo(
+      intrinsics1_, intrinsics2_, twoview_info_);
+
+  // The distractors may happen to lie near an epipolar line, so only require
+  // that nearly all features are recovered correctly.
+  const int num_new_matches = matcher.GetMatches(fundamental_matrix, &matches);
+  EXPECT_GT(num_new_matches, 0.9 * kNumPoints / 2);
+  EXPECT_EQ(matches.size(), kNumPoints / 2 + num_new_matches);
+
+  int num_correct_matches = 0;
+  for (int i = kNumPoints / 2; i < matches.size(); i++) {
+    if (matches[i].feature1_ind == matches[i].feature2_ind) {
+      ++num_correct_matches;
+    }
+  }
+  EXPECT_GT(num_correct_matches, 0.9 * kNumPoints / 2);
+}
+
+TEST_F(GuidedEpipolarMatcherTest, SkipsMatchedFeatures) {
+  std::vector<IndexedFeatureMatch> matches;
+  for (int i = 0; i < kNumPoints; i++) {
+    matches.emplace_back(i, i, 0.0);
+  }
+
+  const GuidedEpipolarMatcher matcher(GuidedEpipolarMatcherOptions(),
+                                      keypoints1_,
+                                      descriptors1_,
+                                      keypoints2_,
+                                      descriptors2_);
+  EXPECT_EQ(matcher.GetMatches(FundamentalMatrixFromTwoViewInfo(
+                                   intrinsics1_, intrinsics2_, twoview_info_),
+                               &matches),
+            0);
+  EXPECT_EQ(matches.size(), kNumPoints);
+}
+
+}  // namespace theia
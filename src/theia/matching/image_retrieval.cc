@@ -0,0 +1,290 @@
+// Copyright (C) 2014 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include "theia/matching/image_retrieval.h"
+
+#include <Eigen/Core>
+#include <glog/logging.h>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "theia/matching/image_pair_match.h"
+#include "theia/util/hash.h"
+#include "theia/util/random.h"
+
+namespace theia {
+
+namespace {
+
+// The similarities of this many query images are computed with one matrix
+// product when selecting image pairs.
+static const int kQueryBlockSize = 256;
+
+// Stacks the descriptors as the columns of a matrix.
+Eigen::MatrixXf DescriptorsToMatrix(
+    const std::vector<Eigen::VectorXf>& descriptors) {
+  Eigen::MatrixXf matrix(descriptors[0].size(), descriptors.size());
+  for (int i = 0; i < descriptors.size(); i++) {
+    matrix.col(i) = descriptors[i];
+  }
+  return matrix;
+}
+
+// Assigns each column of the data to the closest visual word. Since
+// ||x - w||^2 = ||x||^2 - 2 * w' * x + ||w||^2, this is the word that maximizes
+// w' * x - 0.5 * ||w||^2, which is computed for all descriptors with a single
+// matrix product.
+void AssignToVisualWords(const Eigen::MatrixXf& visual_words,
+                         const Eigen::MatrixXf& data,
+                         std::vector<int>* assignments) {
+  const Eigen::VectorXf half_sq_norms =
+      0.5 * visual_words.colwise().squaredNorm().transpose();
+  Eigen::MatrixXf scores = visual_words.transpose() * data;
+  scores.colwise() -= half_sq_norms;
+
+  assignments->resize(data.cols());
+  for (int i = 0; i < data.cols(); i++) {
+    scores.col(i).maxCoeff(&(*assignments)[i]);
+  }
+}
+
+// Initializes the visual words with k-means++ seeding.
+void InitializeVisualWords(const Eigen::MatrixXf& data,
+                           const int num_visual_words,
+                           RandomNumberGenerator* rng,
+                           Eigen::MatrixXf* visual_words) {
+  visual_words->resize(data.rows(), num_visual_words);
+  visual_words->col(0) = data.col(rng->RandInt(0, data.cols() - 1));
+  Eigen::VectorXf sq_distances =
+      (data.colwise() - visual_words->col(0)).colwise().squaredNorm();
+  for (int i = 1; i < num_visual_words; i++) {
+    // Sample the next word with probability proportional to the squared
+    // distance to the closest word chosen so far.
+    const double threshold = rng->RandDouble(0.0, sq_distances.sum());
+    double cumulative_sq_distance = 0.0;
+    int next_word = data.cols() - 1;
+    for (int j = 0; j < data.cols(); j++) {
+      cumulative_sq_distance += sq_distances(j);
+      if (cumulative_sq_distance >= threshold) {
+        next_word = j;
+        break;
+      }
+    }
+    visual_words->col(i) = data.col(next_word);
+    sq_distances = sq_distances.cwiseMin(
+        (data.colwise() - visual_words->col(i)).colwise().squaredNorm()
+            .transpose());
+  }
+}
+
+}  // namespace
+
+VladEncoder::VladEncoder(const VladEncoderOptions& options)
+    : options_(options),
+      rng_(options.rng ? options.rng
+                       : std::make_shared<RandomNumberGenerator>()),
+      num_descriptors_seen_(0) {
+  CHECK_GT(options_.num_visual_words, 0);
+  CHECK_GT(options_.max_num_training_descriptors, 0);
+}
+
+void VladEncoder::AddTrainingDescriptors(
+    const std::vector<Eigen::VectorXf>& descriptors) {
+  for (const Eigen::VectorXf& descriptor : descriptors) {
+    ++num_descriptors_seen_;
+    if (training_descriptors_.size() < options_.max_num_training_descriptors) {
+      training_descriptors_.emplace_back(descriptor);
+      continue;
+    }
+
+    // Replace a random element so that the training set remains a uniform
+    // sample of all descriptors seen.
+    const int index = rng_->RandInt(0, num_descriptors_seen_ - 1);
+    if (index < training_descriptors_.size()) {
+      training_descriptors_[index] = descriptor;
+    }
+  }
+}
+
+bool VladEncoder::Train() {
+  if (training_descriptors_.size() < options_.num_visual_words) {
+    LOG(WARNING) << "Cannot train a vocabulary of " << options_.num_visual_words
+                 << " visual words from only " << training_descriptors_.size()
+                 << " descriptors.";
+    return false;
+  }
+
+  const Eigen::MatrixXf data = DescriptorsToMatrix(training_descriptors_);
+  InitializeVisualWords(data, options_.num_visual_words, rng_.get(),
+                        &visual_words_);
+
+  // Lloyd iterations.
+  std::vector<int> assignments, previous_assignments;
+  Eigen::VectorXf cluster_sizes(options_.num_visual_words);
+  for (int i = 0; i < options_.num_kmeans_iterations; i++) {
+    AssignToVisualWords(visual_words_, data, &assignments);
+    if (assignments == previous_assignments) {
+      break;
+    }
+
+    visual_words_.setZero();
+    cluster_sizes.setZero();
+    for (int j = 0; j < assignments.size(); j++) {
+      visual_words_.col(assignments[j]) += data.col(j);
+      cluster_sizes(assignments[j]) += 1.0f;
+    }
+    for (int j = 0; j < options_.num_visual_words; j++) {
+      // Re-seed empty clusters with a random descriptor.
+      if (cluster_sizes(j) == 0.0f) {
+        visual_words_.col(j) = data.col(rng_->RandInt(0, data.cols() - 1));
+      } else {
+        visual_words_.col(j) /= cluster_sizes(j);
+      }
+    }
+    previous_assignments.swap(assignments);
+  }
+
+  // The training descriptors are no longer needed.
+  std::vector<Eigen::VectorXf>().swap(training_descriptors_);
+  return true;
+}
+
+Eigen::VectorXf VladEncoder::Encode(
+    const std::vector<Eigen::VectorXf>& descriptors) const {
+  CHECK_GT(visual_words_.cols(), 0)
+      << "The vocabulary must be trained before encoding descriptors.";
+  Eigen::MatrixXf vlad =
+      Eigen::MatrixXf::Zero(visual_words_.rows(), visual_words_.cols());
+  if (descriptors.empty()) {
+    return Eigen::Map<Eigen::VectorXf>(vlad.data(), vlad.size());
+  }
+
+  // Accumulate the residuals to the closest visual word.
+  const Eigen::MatrixXf data = DescriptorsToMatrix(descriptors);
+  std::vector<int> assignments;
+  AssignToVisualWords(visual_words_, data, &assignments);
+  for (int i = 0; i < assignments.size(); i++) {
+    vlad.col(assignments[i]) += data.col(i) - visual_words_.col(assignments[i]);
+  }
+
+  // Intra-normalization followed by signed square root normalization.
+  for (int i = 0; i < vlad.cols(); i++) {
+    const float norm = vlad.col(i).norm();
+    if (norm > 0.0f) {
+      vlad.col(i) /= norm;
+    }
+  }
+  vlad = (vlad.array().sign() * vlad.array().abs().sqrt()).matrix();
+
+  Eigen::VectorXf global_descriptor =
+      Eigen::Map<Eigen::VectorXf>(vlad.data(), vlad.size());
+  const float norm = global_descriptor.norm();
+  if (norm > 0.0f) {
+    global_descriptor /= norm;
+  }
+  return global_descriptor;
+}
+
+void SelectImagePairsFromGlobalDescriptors(
+    const std::vector<Eigen::VectorXf>& global_descriptors,
+    const int num_nearest_neighbors,
+    std::vector<std::pair<int, int> >* image_pairs) {
+  CHECK_NOTNULL(image_pairs)->clear();
+  const int num_images = global_descriptors.size();
+  if (num_images < 2 || num_nearest_neighbors <= 0) {
+    return;
+  }
+
+  const Eigen::MatrixXf descriptors = DescriptorsToMatrix(global_descriptors);
+  const int num_neighbors = std::min(num_nearest_neighbors, num_images - 1);
+  std::unordered_set<std::pair<int, int> > selected_pairs;
+  std::vector<std::pair<float, int> > neighbors;
+  neighbors.reserve(num_images - 1);
+  for (int start = 0; start < num_images; start += kQueryBlockSize) {
+    const int block_size = std::min(kQueryBlockSize, num_images - start);
+    const Eigen::MatrixXf similarities =
+        descriptors.transpose() * descriptors.middleCols(start, block_size);
+
+    for (int i = 0; i < block_size; i++) {
+      const int query = start + i;
+      neighbors.clear();
+      for (int j = 0; j < num_images; j++) {
+        if (j != query) {
+          neighbors.emplace_back(similarities(j, i), j);
+        }
+      }
+      std::partial_sort(neighbors.begin(),
+                        neighbors.begin() + num_neighbors,
+                        neighbors.end(),
+                        std::greater<std::pair<float, int> >());
+      for (int j = 0; j < num_neighbors; j++) {
+        selected_pairs.emplace(std::min(query, neighbors[j].second),
+                               std::max(query, neighbors[j].second));
+      }
+    }
+  }
+
+  image_pairs->assign(selected_pairs.begin(), selected_pairs.end());
+  std::sort(image_pairs->begin(), image_pairs->end());
+}
+
+double ComputeImagePairRecall(
+    const std::vector<std::pair<std::string, std::string> >& selected_pairs,
+    const std::vector<ImagePairMatch>& exhaustive_matches) {
+  if (exhaustive_matches.empty()) {
+    return 1.0;
+  }
+
+  std::unordered_set<std::pair<std::string, std::string> > selected;
+  for (const auto& image_pair : selected_pairs) {
+    selected.emplace(std::min(image_pair.first, image_pair.second),
+                     std::max(image_pair.first, image_pair.second));
+  }
+
+  int num_recalled_matches = 0;
+  for (const ImagePairMatch& match : exhaustive_matches) {
+    if (selected.count(std::make_pair(std::min(match.image1, match.image2),
+                                      std::max(match.image1, match.image2)))) {
+      ++num_recalled_matches;
+    }
+  }
+  return static_cast<double>(num_recalled_matches) / exhaustive_matches.size();
+}
+
+}  // namespace theia
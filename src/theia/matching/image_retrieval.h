@@ -0,0 +1,130 @@
+// Copyright (C) 2014 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#ifndef THEIA_MATCHING_IMAGE_RETRIEVAL_H_
+#define THEIA_MATCHING_IMAGE_RETRIEVAL_H_
+
+#include <Eigen/Core>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "theia/matching/image_pair_match.h"
+#include "theia/util/random.h"
+
+namespace theia {
+
+struct VladEncoderOptions {
+  // The number of visual words (k-means clusters) of the vocabulary. The
+  // dimension of the global descriptor is num_visual_words times the dimension
+  // of the local descriptors.
+  int num_visual_words = 16;
+
+  // The vocabulary is trained on a random subset of at most this many of the
+  // local descriptors that are added for training.
+  int max_num_training_descriptors = 50000;
+
+  // Number of Lloyd iterations for k-means.
+  int num_kmeans_iterations = 10;
+
+  // The random number generator used to sample the training descriptors and to
+  // seed k-means. If null, a generator seeded from the current time is used.
+  std::shared_ptr<RandomNumberGenerator> rng;
+};
+
+// Aggregates the local descriptors (e.g., SIFT) of an image into a compact
+// global descriptor with VLAD: "Aggregating local descriptors into a compact
+// image representation" by Jegou et al. (CVPR 2010). The residuals to the
+// nearest visual word are accumulated per word, intra-normalized, power
+// normalized, and the final descriptor has unit L2 norm so that the similarity
+// of two images is the dot product of their global descriptors.
+//
+// Typical use:
+//   VladEncoder encoder(options);
+//   for (const auto& descriptors : descriptors_of_all_images) {
+//     encoder.AddTrainingDescriptors(descriptors);
+//   }
+//   CHECK(encoder.Train());
+//   const Eigen::VectorXf global_descriptor = encoder.Encode(descriptors);
+class VladEncoder {
+ public:
+  explicit VladEncoder(const VladEncoderOptions& options);
+
+  // Adds local descriptors to the training set. A uniform random subset of all
+  // descriptors added is kept (reservoir sampling), so the memory is bounded by
+  // max_num_training_descriptors.
+  void AddTrainingDescriptors(const std::vector<Eigen::VectorXf>& descriptors);
+
+  // Computes the visual vocabulary with k-means. Returns false if there are
+  // fewer training descriptors than visual words.
+  bool Train();
+
+  // Returns the VLAD descriptor of the local descriptors. Train must have been
+  // called successfully beforehand.
+  Eigen::VectorXf Encode(const std::vector<Eigen::VectorXf>& descriptors) const;
+
+  // The visual words, stored as columns.
+  const Eigen::MatrixXf& visual_words() const { return visual_words_; }
+
+ private:
+  const VladEncoderOptions options_;
+  std::shared_ptr<RandomNumberGenerator> rng_;
+  std::vector<Eigen::VectorXf> training_descriptors_;
+  int num_descriptors_seen_;
+  Eigen::MatrixXf visual_words_;
+};
+
+// Selects the image pairs to match from the global descriptors (of unit norm)
+// of all images. For each image, the num_nearest_neighbors images with the most
+// similar global descriptors are chosen. The similarities are computed with
+// blocked matrix products. The output contains each pair once as (i, j) with
+// i < j and is sorted.
+void SelectImagePairsFromGlobalDescriptors(
+    const std::vector<Eigen::VectorXf>& global_descriptors,
+    const int num_nearest_neighbors,
+    std::vector<std::pair<int, int> >* image_pairs);
+
+// Returns the recall of the selected image pairs w.r.t. the image pairs that
+// are successfully matched by exhaustive matching, i.e., the fraction of the
+// exhaustive matches whose image pair is contained in the selected pairs. The
+// order of the images in a pair does not matter. Returns 1 if there are no
+// exhaustive matches.
+double ComputeImagePairRecall(
+    const std::vector<std::pair<std::string, std::string> >& selected_pairs,
+    const std::vector<ImagePairMatch>& exhaustive_matches);
+
+}  // namespace theia
+
+#endif  // THEIA_MATCHING_IMAGE_RETRIEVAL_H_
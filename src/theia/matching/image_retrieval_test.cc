@@ -0,0 +1,181 @@
+// Copyright (C) 2014 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include <Eigen/Core>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "theia/matching/image_pair_match.h"
+#include "theia/matching/image_retrieval.h"
+#include "theia/util/random.h"
+#include "theia/util/stringprintf.h"
+
+namespace theia {
+
+namespace {
+
+static const int kDescriptorDimension = 32;
+
+std::vector<Eigen::VectorXf> RandomDescriptors(const int num_descriptors) {
+  std::vector<Eigen::VectorXf> descriptors(num_descriptors);
+  for (int i = 0; i < num_descriptors; i++) {
+    descriptors[i] = Eigen::VectorXf::Random(kDescriptorDimension).normalized();
+  }
+  return descriptors;
+}
+
+// Returns the descriptors of an image that observes the scene, i.e. a random
+// subset of the scene descriptors with noise.
+std::vector<Eigen::VectorXf> ObserveScene(
+    const std::vector<Eigen::VectorXf>& scene_descriptors) {
+  std::vector<Eigen::VectorXf> descriptors;
+  for (const Eigen::VectorXf& scene_descriptor : scene_descriptors) {
+    if (RandDouble(0.0, 1.0) < 0.7) {
+      descriptors.emplace_back(
+          (scene_descriptor +
+           0.1 * Eigen::VectorXf::Random(kDescriptorDimension)).normalized());
+    }
+  }
+  return descriptors;
+}
+
+}  // namespace
+
+TEST(VladEncoder, TrainingRequiresEnoughDescriptors) {
+  VladEncoderOptions options;
+  options.num_visual_words = 16;
+  VladEncoder encoder(options);
+  encoder.AddTrainingDescriptors(RandomDescriptors(10));
+  EXPECT_FALSE(encoder.Train());
+  encoder.AddTrainingDescriptors(RandomDescriptors(10));
+  EXPECT_TRUE(encoder.Train());
+  EXPECT_EQ(encoder.visual_words().cols(), options.num_visual_words);
+}
+
+TEST(VladEncoder, TrainingSetIsBounded) {
+  InitRandomGenerator();
+  VladEncoderOptions options;
+  options.num_visual_words = 4;
+  options.max_num_training_descriptors = 20;
+  VladEncoder encoder(options);
+  for (int i = 0; i < 10; i++) {
+    encoder.AddTrainingDescriptors(RandomDescriptors(10));
+  }
+  EXPECT_TRUE(encoder.Train());
+}
+
+TEST(VladEncoder, EncodeHasUnitNorm) {
+  InitRandomGenerator();
+  VladEncoderOptions options;
+  options.num_visual_words = 8;
+  VladEncoder encoder(options);
+  encoder.AddTrainingDescriptors(RandomDescriptors(500));
+  ASSERT_TRUE(encoder.Train());
+
+  const Eigen::VectorXf global_descriptor =
+      encoder.Encode(RandomDescriptors(100));
+  EXPECT_EQ(global_descriptor.size(),
+            options.num_visual_words * kDescriptorDimension);
+  EXPECT_NEAR(global_descriptor.norm(), 1.0, 1e-5);
+  EXPECT_EQ(encoder.Encode(std::vector<Eigen::VectorXf>()).norm(), 0.0);
+}
+
+TEST(SelectImagePairsFromGlobalDescriptors, ImagesOfTheSameScene) {
+  static const int kNumScenes = 5;
+  static const int kNumImagesPerScene = 6;
+  InitRandomGenerator();
+
+  // Each image observes one of the scenes.
+  std::vector<std::vector<Eigen::VectorXf> > image_descriptors;
+  for (int i = 0; i < kNumScenes; i++) {
+    const std::vector<Eigen::VectorXf> scene_descriptors =
+        RandomDescriptors(200);
+    for (int j = 0; j < kNumImagesPerScene; j++) {
+      image_descriptors.emplace_back(ObserveScene(scene_descriptors));
+    }
+  }
+
+  VladEncoderOptions options;
+  options.num_visual_words = 16;
+  VladEncoder encoder(options);
+  for (const auto& descriptors : image_descriptors) {
+    encoder.AddTrainingDescriptors(descriptors);
+  }
+  ASSERT_TRUE(encoder.Train());
+  std::vector<Eigen::VectorXf> global_descriptors;
+  for (const auto& descriptors : image_descriptors) {
+    global_descriptors.emplace_back(encoder.Encode(descriptors));
+  }
+
+  std::vector<std::pair<int, int> > image_pairs;
+  SelectImagePairsFromGlobalDescriptors(global_descriptors,
+                                        kNumImagesPerScene - 1,
+                                        &image_pairs);
+
+  // Exactly the pairs of images of the same scene should be selected.
+  EXPECT_EQ(image_pairs.size(),
+            kNumScenes * kNumImagesPerScene * (kNumImagesPerScene - 1) / 2);
+  for (const auto& image_pair : image_pairs) {
+    EXPECT_LT(image_pair.first, image_pair.second);
+    EXPECT_EQ(image_pair.first / kNumImagesPerScene,
+              image_pair.second / kNumImagesPerScene);
+  }
+}
+
+TEST(SelectImagePairsFromGlobalDescriptors, MoreNeighborsThanImages) {
+  const std::vector<Eigen::VectorXf> global_descriptors = RandomDescriptors(4);
+  std::vector<std::pair<int, int> > image_pairs;
+  SelectImagePairsFromGlobalDescriptors(global_descriptors, 10, &image_pairs);
+  EXPECT_EQ(image_pairs.size(), 6);
+}
+
+TEST(ComputeImagePairRecall, Recall) {
+  std::vector<ImagePairMatch> exhaustive_matches(4);
+  for (int i = 0; i < exhaustive_matches.size(); i++) {
+    exhaustive_matches[i].image1 = StringPrintf("%d.jpg", i);
+    exhaustive_matches[i].image2 = StringPrintf("%d.jpg", i + 1);
+  }
+  EXPECT_EQ(ComputeImagePairRecall({}, std::vector<ImagePairMatch>()), 1.0);
+  EXPECT_EQ(ComputeImagePairRecall({}, exhaustive_matches), 0.0);
+
+  // The order of the images in a pair does not matter.
+  const std::vector<std::pair<std::string, std::string> > selected_pairs = {
+    std::make_pair("0.jpg", "1.jpg"), std::make_pair("2.jpg", "1.jpg"),
+    std::make_pair("0.jpg", "3.jpg")};
+  EXPECT_EQ(ComputeImagePairRecall(selected_pairs, exhaustive_matches), 0.5);
+}
+
+}  // namespace theia
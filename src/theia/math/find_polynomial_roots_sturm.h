@@ -0,0 +1,403 @@
+// Copyright (C) 2015 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#ifndef THEIA_MATH_FIND_POLYNOMIAL_ROOTS_STURM_H_
+#define THEIA_MATH_FIND_POLYNOMIAL_ROOTS_STURM_H_
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "theia/math/find_polynomial_roots_companion_matrix.h"
+
+namespace theia {
+
+// Finds the real roots of a polynomial of degree N using a Sturm sequence to
+// isolate the roots followed by a safeguarded Newton-bisection to refine
+// them. The polynomial is assumed to be of the form
+//
+//   sum_{i=0}^N polynomial(i) x^{N-i}.
+//
+// The degree is a compile-time constant so that all intermediate storage lives
+// on the stack. This makes the method well suited for the small polynomials
+// that arise in minimal solvers (e.g. the cubic of the seven point algorithm or
+// the quartic of P3P) which are solved millions of times inside RANSAC. Unlike
+// FindPolynomialRoots, only the real roots are returned. The distinct real
+// roots are written to roots in increasing order and the number of roots found
+// is returned. Leading coefficients that are exactly zero reduce the degree of
+// the polynomial. Polynomials with (nearly) repeated roots are rare in practice
+// and are solved with the companion matrix instead, since the Sturm sequence
+// cannot separate roots that are closer than its numerical precision.
+template <int N>
+int FindRealPolynomialRootsSturm(
+    const Eigen::Matrix<double, N + 1, 1>& polynomial, double* roots);
+
+// ------------------------- Implementation ------------------------------ //
+
+namespace internal {
+
+// Evaluates the polynomial c[0] x^degree + ... + c[degree] and its derivative
+// at x with the Horner scheme.
+inline void EvaluatePolynomialAndDerivative(const double* c,
+                                            const int degree,
+                                            const double x,
+                                            double* value,
+                                            double* derivative) {
+  double v = c[0];
+  double d = 0.0;
+  for (int i = 1; i <= degree; i++) {
+    d = d * x + v;
+    v = v * x + c[i];
+  }
+  *value = v;
+  *derivative = d;
+}
+
+inline double EvaluatePolynomial(const double* c,
+                                 const int degree,
+                                 const double x) {
+  double v = c[0];
+  for (int i = 1; i <= degree; i++) {
+    v = v * x + c[i];
+  }
+  return v;
+}
+
+// The Sturm sequence p_0 = p, p_1 = p', p_{k+1} = -rem(p_{k-1}, p_k) of a
+// polynomial of degree N. The number of distinct real roots in (a, b] is
+// NumSignChanges(a) - NumSignChanges(b).
+template <int N>
+class SturmSequence {
+ public:
+  // The polynomial must be monic and of degree N.
+  explicit SturmSequence(const double* polynomial)
+      : has_repeated_roots_(false) {
+    std::copy(polynomial, polynomial + N + 1, coefficients_[0]);
+    degrees_[0] = N;
+    for (int i = 0; i < N; i++) {
+      coefficients_[1][i] = (N - i) * polynomial[i];
+    }
+    degrees_[1] = N - 1;
+    size_ = 2;
+
+    // The scale of the coefficients is used to decide when a remainder has
+    // become zero because of cancellation. A remainder that is not zero but
+    // still much smaller than the coefficients is dominated by the rounding
+    // errors of the division, so its sign cannot be trusted either. This
+    // happens when two roots are so close that they are nearly repeated.
+    double scale = 0.0;
+    for (int i = 0; i <= N; i++) {
+      scale = std::max(scale, std::abs(polynomial[i]));
+    }
+    const double kZeroTolerance =
+        1e3 * std::numeric_limits<double>::epsilon() * scale;
+    const double kNearlyZeroTolerance =
+        std::sqrt(std::numeric_limits<double>::epsilon()) * scale;
+
+    while (size_ <= N && degrees_[size_ - 1] > 0) {
+      const double* a = coefficients_[size_ - 2];
+      const double* b = coefficients_[size_ - 1];
+      const int degree_a = degrees_[size_ - 2];
+      const int degree_b = degrees_[size_ - 1];
+
+      // Long division of a by b. The remainder is stored in the tail of r.
+      double r[N + 1];
+      std::copy(a, a + degree_a + 1, r);
+      for (int i = 0; i <= degree_a - degree_b; i++) {
+        const double factor = r[i] / b[0];
+        for (int j = 0; j <= degree_b; j++) {
+          r[i + j] -= factor * b[j];
+        }
+      }
+
+      // Negate the remainder and remove the leading zero coefficients.
+      int offset = degree_a - degree_b + 1;
+      int degree_r = degree_b - 1;
+      while (degree_r > 0 && std::abs(r[offset]) <= kZeroTolerance) {
+        ++offset;
+        --degree_r;
+      }
+      if (std::abs(r[offset]) <= kNearlyZeroTolerance) {
+        // The remainder is (nearly) zero so the polynomial has (nearly)
+        // repeated roots and the last element of the sequence approximates
+        // their greatest common divisor.
+        has_repeated_roots_ = true;
+        break;
+      }
+      for (int i = 0; i <= degree_r; i++) {
+        coefficients_[size_][i] = -r[offset + i];
+      }
+      degrees_[size_] = degree_r;
+      ++size_;
+    }
+  }
+
+  // Returns the number of sign changes in the sequence evaluated at x.
+  int NumSignChanges(const double x) const {
+    int num_sign_changes = 0;
+    double previous_value = 0.0;
+    for (int i = 0; i < size_; i++) {
+      const double value = EvaluatePolynomial(coefficients_[i], degrees_[i], x);
+      if (value == 0.0) {
+        continue;
+      }
+      if (previous_value != 0.0 && (value > 0.0) != (previous_value > 0.0)) {
+        ++num_sign_changes;
+      }
+      previous_value = value;
+    }
+    return num_sign_changes;
+  }
+
+  // Returns true if a remainder (nearly) vanished, i.e. the polynomial has
+  // repeated roots or roots that are too close to be told apart. The sign
+  // changes are not reliable around such roots.
+  bool HasRepeatedRoots() const { return has_repeated_roots_; }
+
+ private:
+  double coefficients_[N + 1][N + 1];
+  int degrees_[N + 1];
+  int size_;
+  bool has_repeated_roots_;
+};
+
+// Refines the single root of the monic polynomial p in (lower, upper].
+template <int N>
+double RefineIsolatedRoot(const double* p,
+                          const SturmSequence<N>& sturm_sequence,
+                          double lower,
+                          double upper) {
+  static const int kMaxIterations = 100;
+  static const double kTolerance = std::numeric_limits<double>::epsilon();
+
+  double lower_value = EvaluatePolynomial(p, N, lower);
+  const double upper_value = EvaluatePolynomial(p, N, upper);
+  if (upper_value == 0.0) {
+    return upper;
+  }
+
+  // Roots of even multiplicity do not change the sign of the polynomial so they
+  // are refined by bisection with the Sturm sequence.
+  if ((lower_value > 0.0) == (upper_value > 0.0)) {
+    const int num_sign_changes_upper = sturm_sequence.NumSignChanges(upper);
+    for (int i = 0; i < kMaxIterations && upper - lower >
+         kTolerance * std::max(1.0, std::abs(upper)); i++) {
+      const double mid = 0.5 * (lower + upper);
+      if (sturm_sequence.NumSignChanges(mid) > num_sign_changes_upper) {
+        lower = mid;
+      } else {
+        upper = mid;
+      }
+    }
+    return 0.5 * (lower + upper);
+  }
+
+  // Safeguarded Newton iterations: fall back to bisection whenever the Newton
+  // step leaves the bracket or does not decrease the bracket fast enough.
+  double x = 0.5 * (lower + upper);
+  for (int i = 0; i < kMaxIterations; i++) {
+    double value, derivative;
+    EvaluatePolynomialAndDerivative(p, N, x, &value, &derivative);
+    if (value == 0.0) {
+      return x;
+    }
+    if ((value > 0.0) == (lower_value > 0.0)) {
+      lower = x;
+      lower_value = value;
+    } else {
+      upper = x;
+    }
+
+    double next_x = x - value / derivative;
+    if (!(next_x > lower && next_x < upper)) {
+      next_x = 0.5 * (lower + upper);
+    }
+    const double step = std::abs(next_x - x);
+    x = next_x;
+    if (step <= kTolerance * std::max(1.0, std::abs(x)) ||
+        upper - lower <= kTolerance * std::max(1.0, std::abs(x))) {
+      break;
+    }
+  }
+  return x;
+}
+
+// Recursively bisects (lower, upper] until each interval contains a single
+// root. The roots are output in increasing order.
+template <int N>
+void IsolateRoots(const double* p,
+                  const SturmSequence<N>& sturm_sequence,
+                  const double lower,
+                  const double upper,
+                  const int num_sign_changes_lower,
+                  const int num_sign_changes_upper,
+                  const int depth,
+                  int* num_roots,
+                  double* roots) {
+  static const int kMaxDepth = 64;
+
+  const int num_roots_in_interval =
+      num_sign_changes_lower - num_sign_changes_upper;
+  if (num_roots_in_interval <= 0) {
+    return;
+  }
+  if (num_roots_in_interval == 1) {
+    roots[(*num_roots)++] =
+        RefineIsolatedRoot(p, sturm_sequence, lower, upper);
+    return;
+  }
+
+  // The roots are numerically identical so return them as a single root.
+  const double mid = 0.5 * (lower + upper);
+  if (depth == kMaxDepth || mid <= lower || mid >= upper) {
+    roots[(*num_roots)++] = mid;
+    return;
+  }
+
+  const int num_sign_changes_mid = sturm_sequence.NumSignChanges(mid);
+  IsolateRoots(p, sturm_sequence, lower, mid, num_sign_changes_lower,
+               num_sign_changes_mid, depth + 1, num_roots, roots);
+  IsolateRoots(p, sturm_sequence, mid, upper, num_sign_changes_mid,
+               num_sign_changes_upper, depth + 1, num_roots, roots);
+}
+
+// Finds the real roots of the monic polynomial p of degree N from the
+// eigenvalues of its companion matrix. The eigenvalues of a cluster of nearly
+// repeated roots are inaccurate and may have a small imaginary part, so only
+// the imaginary part relative to the magnitude of the root is checked and the
+// real parts are polished with Newton iterations. Roots that are identical up
+// to the precision of the eigenvalues are returned once.
+template <int N>
+int FindRealRootsWithCompanionMatrix(const double* p, double* roots) {
+  static const double kImaginaryTolerance = 1e-4;
+  static const double kDuplicateTolerance = 1e-7;
+  static const int kMaxNumNewtonIterations = 32;
+
+  const Eigen::VectorXd polynomial =
+      Eigen::Map<const Eigen::Matrix<double, N + 1, 1> >(p);
+  Eigen::VectorXd real, imaginary;
+  if (!FindPolynomialRootsCompanionMatrix(polynomial, &real, &imaginary)) {
+    return 0;
+  }
+
+  int num_roots = 0;
+  for (int i = 0; i < real.size(); i++) {
+    if (std::abs(imaginary(i)) >
+        kImaginaryTolerance * std::max(1.0, std::abs(real(i)))) {
+      continue;
+    }
+
+    // Newton converges only linearly towards a repeated root, so iterate as
+    // long as the value of the polynomial decreases.
+    double x = real(i);
+    double value, derivative;
+    EvaluatePolynomialAndDerivative(p, N, x, &value, &derivative);
+    for (int j = 0; j < kMaxNumNewtonIterations && derivative != 0.0; j++) {
+      const double next_x = x - value / derivative;
+      double next_value, next_derivative;
+      EvaluatePolynomialAndDerivative(p, N, next_x, &next_value,
+                                      &next_derivative);
+      if (!(std::abs(next_value) < std::abs(value))) {
+        break;
+      }
+      x = next_x;
+      value = next_value;
+      derivative = next_derivative;
+    }
+    roots[num_roots++] = x;
+  }
+  std::sort(roots, roots + num_roots);
+  const double* end = std::unique(
+      roots, roots + num_roots, [](const double a, const double b) {
+        return b - a <= kDuplicateTolerance * std::max(1.0, std::abs(b));
+      });
+  return end - roots;
+}
+
+// Finds the roots of a polynomial with a nonzero leading coefficient.
+template <int N>
+struct SturmRootFinder {
+  static int FindRoots(const double* polynomial, double* roots) {
+    if (polynomial[0] == 0.0) {
+      return SturmRootFinder<N - 1>::FindRoots(polynomial + 1, roots);
+    }
+
+    // Make the polynomial monic and bound the magnitude of its roots with the
+    // Cauchy bound.
+    double p[N + 1];
+    p[0] = 1.0;
+    double bound = 0.0;
+    for (int i = 1; i <= N; i++) {
+      p[i] = polynomial[i] / polynomial[0];
+      bound = std::max(bound, std::abs(p[i]));
+    }
+    bound += 1.0;
+
+    const SturmSequence<N> sturm_sequence(p);
+    if (sturm_sequence.HasRepeatedRoots()) {
+      return FindRealRootsWithCompanionMatrix<N>(p, roots);
+    }
+
+    int num_roots = 0;
+    IsolateRoots(p, sturm_sequence, -bound, bound,
+                 sturm_sequence.NumSignChanges(-bound),
+                 sturm_sequence.NumSignChanges(bound), 0, &num_roots, roots);
+    return num_roots;
+  }
+};
+
+template <>
+struct SturmRootFinder<1> {
+  static int FindRoots(const double* polynomial, double* roots) {
+    if (polynomial[0] == 0.0) {
+      return 0;
+    }
+    roots[0] = -polynomial[1] / polynomial[0];
+    return 1;
+  }
+};
+
+}  // namespace internal
+
+template <int N>
+int FindRealPolynomialRootsSturm(
+    const Eigen::Matrix<double, N + 1, 1>& polynomial, double* roots) {
+  static_assert(N >= 1, "The polynomial must be at least of degree one.");
+  return internal::SturmRootFinder<N>::FindRoots(polynomial.data(), roots);
+}
+
+}  // namespace theia
+
+#endif  // THEIA_MATH_FIND_POLYNOMIAL_ROOTS_STURM_H_
@@ -0,0 +1,205 @@
+// Copyright (C) 2015 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "gtest/gtest.h"
+
+#include "theia/math/find_polynomial_roots_companion_matrix.h"
+#include "theia/math/find_polynomial_roots_sturm.h"
+
+namespace theia {
+
+using Eigen::VectorXd;
+
+namespace {
+
+const double kEpsilon = 1e-10;
+
+// Returns the polynomial with the given real roots and leading coefficient.
+template <int N>
+Eigen::Matrix<double, N + 1, 1> PolynomialWithRoots(
+    const double leading_coefficient, const double roots[N]) {
+  Eigen::Matrix<double, N + 1, 1> polynomial =
+      Eigen::Matrix<double, N + 1, 1>::Zero();
+  polynomial(0) = leading_coefficient;
+  for (int i = 0; i < N; i++) {
+    // Multiply by (x - root).
+    for (int j = i + 1; j > 0; j--) {
+      polynomial(j) -= roots[i] * polynomial(j - 1);
+    }
+  }
+  return polynomial;
+}
+
+template <int N>
+void ExpectRoots(const Eigen::Matrix<double, N + 1, 1>& polynomial,
+                 std::vector<double> expected_roots,
+                 const double tolerance) {
+  double roots[N];
+  const int num_roots = FindRealPolynomialRootsSturm<N>(polynomial, roots);
+  std::sort(expected_roots.begin(), expected_roots.end());
+  ASSERT_EQ(num_roots, expected_roots.size());
+  for (int i = 0; i < num_roots; i++) {
+    EXPECT_NEAR(roots[i], expected_roots[i], tolerance);
+  }
+}
+
+}  // namespace
+
+TEST(FindRealPolynomialRootsSturm, Linear) {
+  const Eigen::Vector2d polynomial(2.0, -3.0);
+  ExpectRoots<1>(polynomial, { 1.5 }, kEpsilon);
+}
+
+TEST(FindRealPolynomialRootsSturm, CubicWithDistinctRoots) {
+  const double kRoots[3] = { -2.5, 0.1, 42.0 };
+  ExpectRoots<3>(PolynomialWithRoots<3>(-3.0, kRoots),
+                 { kRoots[0], kRoots[1], kRoots[2] },
+                 kEpsilon);
+}
+
+TEST(FindRealPolynomialRootsSturm, QuarticWithDistinctRoots) {
+  const double kRoots[4] = { 1.23e-3, -0.5, 7.0, 1e3 };
+  ExpectRoots<4>(PolynomialWithRoots<4>(1.0, kRoots),
+                 { kRoots[0], kRoots[1], kRoots[2], kRoots[3] },
+                 1e-8);
+}
+
+TEST(FindRealPolynomialRootsSturm, QuarticWithComplexRoots) {
+  // (x - 1)(x + 2)(x^2 + 2x + 5) has the complex roots -1 +/- 2i.
+  Eigen::Matrix<double, 5, 1> polynomial;
+  polynomial << 1.0, 3.0, 5.0, 1.0, -10.0;
+  ExpectRoots<4>(polynomial, { -2.0, 1.0 }, kEpsilon);
+
+  // x^4 + 1 has no real roots.
+  polynomial << 1.0, 0.0, 0.0, 0.0, 1.0;
+  ExpectRoots<4>(polynomial, {}, kEpsilon);
+}
+
+TEST(FindRealPolynomialRootsSturm, RepeatedRoots) {
+  // (x - 2)^2 (x + 1) has a double root at 2 that does not change sign.
+  const double kRoots[3] = { 2.0, 2.0, -1.0 };
+  ExpectRoots<3>(PolynomialWithRoots<3>(1.0, kRoots), { -1.0, 2.0 }, 1e-7);
+}
+
+TEST(FindRealPolynomialRootsSturm, NearlyRepeatedRoots) {
+  static const int kNumTrials = 10000;
+  static const double kSeparation = 1e-6;
+  // Rounding the coefficients alone perturbs such close roots by about the
+  // separation.
+  static const double kTolerance = 1e-5;
+
+  // The first two roots are too close for the Sturm sequence to separate them.
+  // They may be returned as a single root, but no root may be lost.
+  double expected_roots[4] = { -8.94013, -8.94013 + kSeparation, -6.7166,
+                               -6.7062 };
+  srand(1234);
+  for (int trial = 0; trial < kNumTrials; trial++) {
+    double roots[4];
+    const int num_roots = FindRealPolynomialRootsSturm<4>(
+        PolynomialWithRoots<4>(1.0, expected_roots), roots);
+    ASSERT_GE(num_roots, 3);
+    for (int i = 0; i < 4; i++) {
+      double min_error = std::numeric_limits<double>::max();
+      for (int j = 0; j < num_roots; j++) {
+        min_error = std::min(min_error, std::abs(roots[j] - expected_roots[i]));
+      }
+      ASSERT_LT(min_error, kTolerance) << "Trial " << trial << ", root " << i;
+    }
+
+    // The other roots are kept away from the pair, since clusters of three
+    // roots are even more ill-conditioned.
+    const Eigen::Vector3d random_roots = 10.0 * Eigen::Vector3d::Random();
+    expected_roots[0] = random_roots(0);
+    expected_roots[1] = random_roots(0) + kSeparation;
+    expected_roots[2] = random_roots(1);
+    expected_roots[3] = random_roots(2);
+    if (std::abs(random_roots(1) - random_roots(0)) < 0.1 ||
+        std::abs(random_roots(2) - random_roots(0)) < 0.1) {
+      expected_roots[2] = random_roots(0) + 1.0;
+      expected_roots[3] = random_roots(0) - 1.0;
+    }
+  }
+}
+
+TEST(FindRealPolynomialRootsSturm, LeadingZeros) {
+  // 0 x^3 + 0 x^2 + (x - 3) is treated as a linear polynomial.
+  Eigen::Vector4d polynomial(0.0, 0.0, 1.0, -3.0);
+  ExpectRoots<3>(polynomial, { 3.0 }, kEpsilon);
+
+  // 0 x^4 + (x - 1)(x - 2)(x - 3).
+  const double kRoots[3] = { 1.0, 2.0, 3.0 };
+  Eigen::Matrix<double, 5, 1> quartic;
+  quartic << 0.0, PolynomialWithRoots<3>(1.0, kRoots);
+  ExpectRoots<4>(quartic, { 1.0, 2.0, 3.0 }, kEpsilon);
+}
+
+// The real roots should agree with the roots from the companion matrix method.
+TEST(FindRealPolynomialRootsSturm, AgreesWithCompanionMatrix) {
+  static const int kNumTrials = 1000;
+  static const double kImaginaryTolerance = 1e-12;
+  srand(1234);
+  int num_compared = 0;
+  for (int trial = 0; trial < kNumTrials; trial++) {
+    const Eigen::Matrix<double, 5, 1> polynomial =
+        Eigen::Matrix<double, 5, 1>::Random();
+
+    VectorXd real, imaginary;
+    ASSERT_TRUE(
+        FindPolynomialRootsCompanionMatrix(polynomial, &real, &imaginary));
+    std::vector<double> expected_roots;
+    bool is_ambiguous = false;
+    for (int i = 0; i < real.size(); i++) {
+      if (std::abs(imaginary(i)) <= kImaginaryTolerance) {
+        expected_roots.emplace_back(real(i));
+      } else if (std::abs(imaginary(i)) < 1e-4) {
+        // Nearly repeated roots may be classified either way.
+        is_ambiguous = true;
+      }
+    }
+    if (is_ambiguous) {
+      continue;
+    }
+
+    ExpectRoots<4>(polynomial, expected_roots, 1e-8);
+    ++num_compared;
+  }
+  EXPECT_GT(num_compared, 0.9 * kNumTrials);
+}
+
+}  // namespace theia
@@ -68,30 +68,15 @@ bool SequentialProbabilityRatioTest(const std::vector<double>& residuals,
                                     double epsilon, double decision_threshold,
                                     int* num_tested_points,
                                     double* observed_inlier_ratio) {
-  int observed_num_inliers = 0;
-  double likelihood_ratio = 1.0;
-  for (int i = 0; i < residuals.size(); i++) {
-    // Check whether i-th data point is consistent with the model. Update the
-    // likelihood ratio accordingly.
-    if (residuals[i] < error_thresh) {
-      likelihood_ratio *= sigma / epsilon;
-      observed_num_inliers += 1;
-    } else {
-      likelihood_ratio *= (1.0 - sigma) / (1.0 - epsilon);
-    }
-
-    // If likehood ratio exceeds our decision threshold we can terminate early.
-    if (likelihood_ratio > decision_threshold) {
-      *observed_inlier_ratio = static_cast<double>(observed_num_inliers) /
-                               static_cast<double>(i + 1);
-      *num_tested_points = i + 1;
-      return false;
-    }
-  }
-
-  *observed_inlier_ratio = static_cast<double>(observed_num_inliers) /
-                           static_cast<double>(residuals.size());
-  *num_tested_points = residuals.size();
-  return true;
+  return SequentialProbabilityRatioTest(
+      residuals.size(),
+      [&residuals](const int i) { return residuals[i]; },
+      error_thresh,
+      sigma,
+      epsilon,
+      decision_threshold,
+      num_tested_points,
+      observed_inlier_ratio,
+      nullptr);
 }
 }  // namespace theia
@@ -67,6 +67,67 @@ bool SequentialProbabilityRatioTest(const std::vector<double>& residuals,
                                     int* num_tested_points,
                                     double* observed_inlier_ratio);
 
+// Same as above, but the residuals are evaluated lazily by calling
+// residual(i) for the data points i = 0, 1, ... in order, so a model that is
+// rejected after a few data points does not require the residuals of all
+// num_data data points. If inlier_indices is not null, it is filled with the
+// indices of the tested data points that are inliers. If the test passes, all
+// data points were tested and these are the inliers of the model.
+template <class ResidualFunction>
+bool SequentialProbabilityRatioTest(const int num_data,
+                                    const ResidualFunction& residual,
+                                    double error_thresh, double sigma,
+                                    double epsilon, double decision_threshold,
+                                    int* num_tested_points,
+                                    double* observed_inlier_ratio,
+                                    std::vector<int>* inlier_indices);
+
+// -------------------------- Implementation -------------------------- //
+
+template <class ResidualFunction>
+bool SequentialProbabilityRatioTest(const int num_data,
+                                    const ResidualFunction& residual,
+                                    double error_thresh, double sigma,
+                                    double epsilon, double decision_threshold,
+                                    int* num_tested_points,
+                                    double* observed_inlier_ratio,
+                                    std::vector<int>* inlier_indices) {
+  if (inlier_indices != nullptr) {
+    inlier_indices->clear();
+  }
+
+  const double inlier_likelihood_ratio = sigma / epsilon;
+  const double outlier_likelihood_ratio = (1.0 - sigma) / (1.0 - epsilon);
+  int observed_num_inliers = 0;
+  double likelihood_ratio = 1.0;
+  for (int i = 0; i < num_data; i++) {
+    // Check whether i-th data point is consistent with the model. Update the
+    // likelihood ratio accordingly.
+    if (residual(i) < error_thresh) {
+      likelihood_ratio *= inlier_likelihood_ratio;
+      observed_num_inliers += 1;
+      if (inlier_indices != nullptr) {
+        inlier_indices->emplace_back(i);
+      }
+    } else {
+      likelihood_ratio *= outlier_likelihood_ratio;
+    }
+
+    // If likehood ratio exceeds our decision threshold we can terminate early.
+    if (likelihood_ratio > decision_threshold) {
+      *observed_inlier_ratio = static_cast<double>(observed_num_inliers) /
+                               static_cast<double>(i + 1);
+      *num_tested_points = i + 1;
+      return false;
+    }
+  }
+
+  *observed_inlier_ratio = static_cast<double>(observed_num_inliers) /
+                           static_cast<double>(num_data);
+  *num_tested_points = num_data;
+  return true;
+}
+
 }  // namespace theia
 
 #endif  // THEIA_MATH_PROBABILITY_SEQUENTIAL_PROBABILITY_RATIO_H_
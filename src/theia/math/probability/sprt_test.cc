@@ -183,4 +183,54 @@ TEST(SPRTTest, SequentialProbabilityRatioTestFail) {
   EXPECT_FALSE(sprt_success);
 }
 
+TEST(SPRTTest, LazySequentialProbabilityRatioTest) {
+  // Create a set of points along y=x with a small random pertubation.
+  vector<Point> input_points;
+  for (int i = 0; i < 10000; ++i) {
+    double noise_x = RandDouble(-1, 1);
+    double noise_y = RandDouble(-1, 1);
+    input_points.push_back(Point(i + noise_x, i + noise_y));
+  }
+  LineEstimator estimator;
+  const double error_thresh = 0.5;
+  const double sigma = 0.05;
+  const double epsilon = 0.6;
+  const double decision_threshold =
+      CalculateSPRTDecisionThreshold(sigma, epsilon);
+
+  int num_tested_points;
+  double observed_inlier_ratio;
+  std::vector<int> inlier_indices;
+
+  // The correct line is accepted and the inliers match those of the residuals.
+  Line fitting_line(1.0, 0.0);
+  int num_evaluated_residuals = 0;
+  EXPECT_TRUE(SequentialProbabilityRatioTest(
+      input_points.size(),
+      [&](const int i) {
+        ++num_evaluated_residuals;
+        return estimator.Error(input_points[i], fitting_line);
+      },
+      error_thresh, sigma, epsilon, decision_threshold, &num_tested_points,
+      &observed_inlier_ratio, &inlier_indices));
+  EXPECT_EQ(num_tested_points, input_points.size());
+  EXPECT_EQ(num_evaluated_residuals, input_points.size());
+  EXPECT_EQ(inlier_indices,
+            estimator.GetInliers(input_points, fitting_line, error_thresh));
+
+  // A bad line is rejected after evaluating only a few residuals.
+  Line not_fitting_line(-1.0, 50);
+  num_evaluated_residuals = 0;
+  EXPECT_FALSE(SequentialProbabilityRatioTest(
+      input_points.size(),
+      [&](const int i) {
+        ++num_evaluated_residuals;
+        return estimator.Error(input_points[i], not_fitting_line);
+      },
+      error_thresh, sigma, epsilon, decision_threshold, &num_tested_points,
+      &observed_inlier_ratio, &inlier_indices));
+  EXPECT_EQ(num_evaluated_residuals, num_tested_points);
+  EXPECT_LT(num_tested_points, 100);
+}
+
 }  // namespace theia
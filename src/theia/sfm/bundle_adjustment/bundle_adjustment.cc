@@ -41,6 +41,7 @@
 #include <vector>
 
 #include "theia/util/map_util.h"
+#include "theia/util/profiler.h"
 #include "theia/util/timer.h"
 #include "theia/sfm/bundle_adjustment/create_loss_function.h"
 #include "theia/sfm/camera/camera.h"
@@ -155,6 +156,7 @@ BundleAdjustmentSummary BundleAdjustPartialReconstruction(
     const std::unordered_set<TrackId>& track_ids,
     Reconstruction* reconstruction) {
   CHECK_NOTNULL(reconstruction);
+  ScopedProfile profile("BundleAdjustment");
   BundleAdjustmentSummary summary;
   static const int kTrackSize = 4;
 
@@ -271,6 +273,10 @@ BundleAdjustmentSummary BundleAdjustPartialReconstruction(
   ceres::Solver::Summary solver_summary;
   ceres::Solve(solver_options, &problem, &solver_summary);
   LOG_IF(INFO, options.verbose) << solver_summary.FullReport();
+  AddProfileCount("bundle_adjustment_iterations",
+                  solver_summary.num_successful_steps +
+                      solver_summary.num_unsuccessful_steps);
+  AddProfileCount("bundle_adjustment_residuals", problem.NumResiduals());
 
   // Set the BundleAdjustmentSummary.
   summary.setup_time_in_seconds =
@@ -333,4 +339,23 @@ BundleAdjustmentSummary BundleAdjustTrack(const BundleAdjustmentOptions& options
                                            reconstruction);
 }
 
+// Bundle adjust a set of tracks.
+BundleAdjustmentSummary BundleAdjustTracks(
+    const BundleAdjustmentOptions& options,
+    const std::unordered_set<TrackId>& track_ids,
+    Reconstruction* reconstruction) {
+  std::unordered_set<ViewId> view_ids;
+  BundleAdjustmentOptions ba_options = options;
+  // All views are held constant so the normal equations are block diagonal
+  // with one block per track. The Jacobi preconditioner is then exact and
+  // conjugate gradients converge immediately.
+  ba_options.linear_solver_type = ceres::CGNR;
+  ba_options.preconditioner_type = ceres::JACOBI;
+  ba_options.use_inner_iterations = false;
+  return BundleAdjustPartialReconstruction(ba_options,
+                                           view_ids,
+                                           track_ids,
+                                           reconstruction);
+}
+
 }  // namespace theia
@@ -137,6 +137,14 @@ BundleAdjustmentSummary BundleAdjustTrack(const BundleAdjustmentOptions& options
                                           const TrackId track_id,
                                           Reconstruction* reconstruction);
 
+// Bundle adjust a set of tracks while holding all views constant. The tracks are
+// independent of each other so they are adjusted in a single problem, which is
+// considerably faster than adjusting each track on its own.
+BundleAdjustmentSummary BundleAdjustTracks(
+    const BundleAdjustmentOptions& options,
+    const std::unordered_set<TrackId>& track_ids,
+    Reconstruction* reconstruction);
+
 }  // namespace theia
 
 #endif  // THEIA_SFM_BUNDLE_ADJUSTMENT_BUNDLE_ADJUSTMENT_H_
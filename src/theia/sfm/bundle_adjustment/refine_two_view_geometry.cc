@@ -0,0 +1,368 @@
+// Copyright (C) 2015 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include "theia/sfm/bundle_adjustment/refine_two_view_geometry.h"
+
+#include <ceres/rotation.h>
+#include <Eigen/Core>
+#include <Eigen/Cholesky>
+#include <Eigen/LU>
+#include <glog/logging.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "theia/matching/feature_correspondence.h"
+#include "theia/sfm/camera/camera.h"
+#include "theia/sfm/camera/projection_matrix_utils.h"
+#include "theia/sfm/pose/util.h"
+
+namespace theia {
+
+namespace {
+
+// The relative rotation (3), the translation direction (2), and the focal
+// lengths of camera 1 and camera 2.
+static const int kNumParameters = 7;
+static const int kFocalLength1Index = 5;
+static const int kFocalLength2Index = 6;
+
+typedef Eigen::Matrix<double, kNumParameters, 1> ParameterVector;
+typedef Eigen::Matrix<double, kNumParameters, kNumParameters> ParameterMatrix;
+typedef Eigen::Matrix<double, 9, 1> Vector9d;
+typedef Eigen::Matrix<double, 9, kNumParameters> FundamentalMatrixJacobian;
+
+// Step size used for the numeric derivatives of the fundamental matrix w.r.t.
+// the parameters.
+static const double kNumericDerivativeStep = 1e-6;
+
+// Correspondences with an epipolar gradient smaller than this are ignored.
+static const double kMinSampsonDenominator = 1e-12;
+
+static const double kMinDamping = 1e-12;
+static const double kMaxDamping = 1e12;
+static const double kMinDiagonal = 1e-12;
+
+struct TwoViewGeometry {
+  Eigen::Matrix3d rotation;
+  // The translation is kept at unit norm.
+  Eigen::Vector3d translation;
+  double focal_length1;
+  double focal_length2;
+};
+
+bool IsParameterFree(const TwoViewRefinementOptions& options,
+                     const int parameter) {
+  if (parameter == kFocalLength1Index) {
+    return options.refine_focal_length1;
+  }
+  if (parameter == kFocalLength2Index) {
+    return options.refine_focal_length2;
+  }
+  return true;
+}
+
+Eigen::Matrix3d InverseCalibrationMatrix(const Camera& camera,
+                                         const double focal_length) {
+  Eigen::Matrix3d calibration_matrix;
+  IntrinsicsToCalibrationMatrix(focal_length,
+                                camera.Skew(),
+                                camera.AspectRatio(),
+                                camera.PrincipalPointX(),
+                                camera.PrincipalPointY(),
+                                &calibration_matrix);
+  return calibration_matrix.inverse();
+}
+
+// F = K2^-T * [t]_x * R * K1^-1.
+Eigen::Matrix3d FundamentalMatrixFromGeometry(const Camera& camera1,
+                                              const Camera& camera2,
+                                              const TwoViewGeometry& geometry) {
+  return InverseCalibrationMatrix(camera2, geometry.focal_length2)
+             .transpose() *
+         CrossProductMatrix(geometry.translation) * geometry.rotation *
+         InverseCalibrationMatrix(camera1, geometry.focal_length1);
+}
+
+// Returns an orthonormal basis of the tangent space of the unit sphere at the
+// translation direction.
+Eigen::Matrix<double, 3, 2> TangentBasis(const Eigen::Vector3d& translation) {
+  Eigen::Matrix<double, 3, 2> tangent_basis;
+  tangent_basis.col(0) = translation.unitOrthogonal();
+  tangent_basis.col(1) = translation.cross(tangent_basis.col(0));
+  return tangent_basis;
+}
+
+// Applies the parameter update to the geometry. The rotation is updated on the
+// left, the translation is moved along the tangent space of the sphere, and the
+// focal lengths are updated multiplicatively so that they remain positive.
+TwoViewGeometry UpdateGeometry(const TwoViewGeometry& geometry,
+                               const Eigen::Matrix<double, 3, 2>& tangent_basis,
+                               const ParameterVector& delta) {
+  Eigen::Matrix3d rotation_update;
+  ceres::AngleAxisToRotationMatrix(
+      delta.data(), ceres::ColumnMajorAdapter3x3(rotation_update.data()));
+
+  TwoViewGeometry updated_geometry;
+  updated_geometry.rotation = rotation_update * geometry.rotation;
+  updated_geometry.translation =
+      (geometry.translation + tangent_basis * delta.segment<2>(3))
+          .normalized();
+  updated_geometry.focal_length1 =
+      geometry.focal_length1 * std::exp(delta(kFocalLength1Index));
+  updated_geometry.focal_length2 =
+      geometry.focal_length2 * std::exp(delta(kFocalLength2Index));
+  return updated_geometry;
+}
+
+// Returns the Sampson error of the correspondence in pixels. If the gradient is
+// not NULL, the derivative of the error w.r.t. the entries of the fundamental
+// matrix (in column-major order) is also computed.
+double SampsonError(const Eigen::Matrix3d& fundamental_matrix,
+                    const FeatureCorrespondence& correspondence,
+                    Vector9d* gradient) {
+  const Eigen::Vector3d x1 = correspondence.feature1.homogeneous();
+  const Eigen::Vector3d x2 = correspondence.feature2.homogeneous();
+  const Eigen::Vector3d epiline1 = fundamental_matrix * x1;
+  const Eigen::Vector3d epiline2 = fundamental_matrix.transpose() * x2;
+
+  const double epipolar_error = x2.dot(epiline1);
+  const double denominator =
+      epiline1.head<2>().squaredNorm() + epiline2.head<2>().squaredNorm();
+  if (denominator < kMinSampsonDenominator) {
+    if (gradient != nullptr) {
+      gradient->setZero();
+    }
+    return 0.0;
+  }
+  const double sqrt_denominator = std::sqrt(denominator);
+
+  if (gradient != nullptr) {
+    const Eigen::Vector3d a(epiline1.x(), epiline1.y(), 0.0);
+    const Eigen::Vector3d b(epiline2.x(), epiline2.y(), 0.0);
+    const Eigen::Matrix3d gradient_matrix =
+        x2 * x1.transpose() / sqrt_denominator -
+        epipolar_error / (denominator * sqrt_denominator) *
+            (a * x1.transpose() + x2 * b.transpose());
+    *gradient = Eigen::Map<const Vector9d>(gradient_matrix.data());
+  }
+  return epipolar_error / sqrt_denominator;
+}
+
+double ComputeCost(const Eigen::Matrix3d& fundamental_matrix,
+                   const std::vector<FeatureCorrespondence>& correspondences,
+                   const std::vector<int>& inliers) {
+  double cost = 0.0;
+  for (const int inlier : inliers) {
+    const double error =
+        SampsonError(fundamental_matrix, correspondences[inlier], nullptr);
+    cost += error * error;
+  }
+  return cost;
+}
+
+// Computes the derivative of the fundamental matrix w.r.t. the parameters with
+// central differences. This only requires 2 evaluations of a 3x3 matrix per
+// parameter, independent of the number of correspondences.
+void ComputeFundamentalMatrixJacobian(
+    const TwoViewRefinementOptions& options,
+    const Camera& camera1,
+    const Camera& camera2,
+    const TwoViewGeometry& geometry,
+    const Eigen::Matrix<double, 3, 2>& tangent_basis,
+    FundamentalMatrixJacobian* jacobian) {
+  for (int i = 0; i < kNumParameters; i++) {
+    if (!IsParameterFree(options, i)) {
+      jacobian->col(i).setZero();
+      continue;
+    }
+
+    ParameterVector delta = ParameterVector::Zero();
+    delta(i) = kNumericDerivativeStep;
+    const Eigen::Matrix3d fundamental_matrix_plus =
+        FundamentalMatrixFromGeometry(
+            camera1, camera2, UpdateGeometry(geometry, tangent_basis, delta));
+    const Eigen::Matrix3d fundamental_matrix_minus =
+        FundamentalMatrixFromGeometry(
+            camera1, camera2, UpdateGeometry(geometry, tangent_basis, -delta));
+    const Eigen::Matrix3d derivative =
+        (fundamental_matrix_plus - fundamental_matrix_minus) /
+        (2.0 * kNumericDerivativeStep);
+    jacobian->col(i) = Eigen::Map<const Vector9d>(derivative.data());
+  }
+}
+
+// Accumulates the normal equations J^t * J and J^t * r of the Sampson errors.
+void BuildNormalEquations(
+    const Eigen::Matrix3d& fundamental_matrix,
+    const FundamentalMatrixJacobian& fundamental_matrix_jacobian,
+    const std::vector<FeatureCorrespondence>& correspondences,
+    const std::vector<int>& inliers,
+    ParameterMatrix* jtj,
+    ParameterVector* jtr) {
+  jtj->setZero();
+  jtr->setZero();
+  Vector9d gradient;
+  for (const int inlier : inliers) {
+    const double error = SampsonError(
+        fundamental_matrix, correspondences[inlier], &gradient);
+    const Eigen::Matrix<double, 1, kNumParameters> jacobian_row =
+        gradient.transpose() * fundamental_matrix_jacobian;
+    jtj->noalias() += jacobian_row.transpose() * jacobian_row;
+    jtr->noalias() += jacobian_row.transpose() * error;
+  }
+}
+
+}  // namespace
+
+bool RefineTwoViewGeometry(
+    const TwoViewRefinementOptions& options,
+    const std::vector<FeatureCorrespondence>& correspondences,
+    const std::vector<int>& inliers,
+    Camera* camera1,
+    Camera* camera2,
+    TwoViewRefinementSummary* summary) {
+  CHECK_NOTNULL(camera1);
+  CHECK_NOTNULL(camera2);
+  CHECK_NOTNULL(summary);
+  *summary = TwoViewRefinementSummary();
+
+  int num_free_parameters = 0;
+  for (int i = 0; i < kNumParameters; i++) {
+    if (IsParameterFree(options, i)) {
+      ++num_free_parameters;
+    }
+  }
+  const Eigen::Vector3d position = camera2->GetPosition();
+  const double baseline = position.norm();
+  if (inliers.size() < num_free_parameters || baseline == 0.0) {
+    return false;
+  }
+
+  TwoViewGeometry geometry;
+  geometry.rotation = camera2->GetOrientationAsRotationMatrix();
+  geometry.translation = -geometry.rotation * position / baseline;
+  geometry.focal_length1 = camera1->FocalLength();
+  geometry.focal_length2 = camera2->FocalLength();
+
+  double cost = ComputeCost(
+      FundamentalMatrixFromGeometry(*camera1, *camera2, geometry),
+      correspondences,
+      inliers);
+  summary->initial_cost = cost;
+
+  double damping = options.initial_damping;
+  FundamentalMatrixJacobian fundamental_matrix_jacobian;
+  ParameterMatrix jtj;
+  ParameterVector jtr;
+  while (summary->num_iterations < options.max_num_iterations) {
+    ++summary->num_iterations;
+
+    const Eigen::Matrix<double, 3, 2> tangent_basis =
+        TangentBasis(geometry.translation);
+    ComputeFundamentalMatrixJacobian(options,
+                                     *camera1,
+                                     *camera2,
+                                     geometry,
+                                     tangent_basis,
+                                     &fundamental_matrix_jacobian);
+    BuildNormalEquations(
+        FundamentalMatrixFromGeometry(*camera1, *camera2, geometry),
+        fundamental_matrix_jacobian,
+        correspondences,
+        inliers,
+        &jtj,
+        &jtr);
+
+    // Fixed parameters get an identity block so that their update is zero.
+    for (int i = 0; i < kNumParameters; i++) {
+      if (!IsParameterFree(options, i)) {
+        jtj.row(i).setZero();
+        jtj.col(i).setZero();
+        jtj(i, i) = 1.0;
+      }
+    }
+
+    // Increase the damping until a step that decreases the cost is found.
+    bool step_accepted = false;
+    bool converged = false;
+    while (damping < kMaxDamping) {
+      ParameterMatrix augmented_jtj = jtj;
+      augmented_jtj.diagonal() +=
+          damping * jtj.diagonal().cwiseMax(kMinDiagonal);
+      const ParameterVector delta = -augmented_jtj.ldlt().solve(jtr);
+
+      const TwoViewGeometry updated_geometry =
+          UpdateGeometry(geometry, tangent_basis, delta);
+      const double updated_cost = ComputeCost(
+          FundamentalMatrixFromGeometry(*camera1, *camera2, updated_geometry),
+          correspondences,
+          inliers);
+      if (std::isfinite(updated_cost) && updated_cost < cost) {
+        converged = (cost - updated_cost) < options.function_tolerance * cost ||
+                    delta.norm() < options.parameter_tolerance;
+        geometry = updated_geometry;
+        cost = updated_cost;
+        damping = std::max(damping / 10.0, kMinDamping);
+        step_accepted = true;
+        break;
+      }
+      damping *= 10.0;
+    }
+
+    if (!step_accepted || converged) {
+      break;
+    }
+  }
+
+  summary->final_cost = cost;
+  summary->success =
+      std::isfinite(cost) && cost <= summary->initial_cost;
+  if (!summary->success) {
+    return false;
+  }
+
+  camera2->SetOrientationFromRotationMatrix(geometry.rotation);
+  camera2->SetPosition(-baseline * geometry.rotation.transpose() *
+                       geometry.translation);
+  if (options.refine_focal_length1) {
+    camera1->SetFocalLength(geometry.focal_length1);
+  }
+  if (options.refine_focal_length2) {
+    camera2->SetFocalLength(geometry.focal_length2);
+  }
+  return true;
+}
+
+}  // namespace theia
@@ -0,0 +1,99 @@
+// Copyright (C) 2015 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#ifndef THEIA_SFM_BUNDLE_ADJUSTMENT_REFINE_TWO_VIEW_GEOMETRY_H_
+#define THEIA_SFM_BUNDLE_ADJUSTMENT_REFINE_TWO_VIEW_GEOMETRY_H_
+
+#include <vector>
+
+#include "theia/matching/feature_correspondence.h"
+
+namespace theia {
+
+class Camera;
+
+// Options for the lightweight two-view refinement. The focal lengths are only
+// refined if the corresponding flag is set; all other intrinsics are held
+// constant.
+struct TwoViewRefinementOptions {
+  // Maximum number of Levenberg-Marquardt iterations.
+  int max_num_iterations = 25;
+
+  // The refinement terminates when the relative decrease in cost is below this
+  // threshold or when the norm of the parameter update is below the parameter
+  // tolerance.
+  double function_tolerance = 1e-8;
+  double parameter_tolerance = 1e-10;
+
+  // Initial damping of the Levenberg-Marquardt iterations.
+  double initial_damping = 1e-4;
+
+  // Refine the focal length of camera 1 and/or camera 2.
+  bool refine_focal_length1 = false;
+  bool refine_focal_length2 = false;
+};
+
+struct TwoViewRefinementSummary {
+  bool success = false;
+  int num_iterations = 0;
+
+  // The sum of squared Sampson errors (in pixels^2) over all inliers before and
+  // after refinement.
+  double initial_cost = 0.0;
+  double final_cost = 0.0;
+};
+
+// Refines the relative pose (and optionally the focal lengths) of two cameras
+// by minimizing the Sampson error of the inlier correspondences in pixels. This
+// is a fixed-size Levenberg-Marquardt over the 5 DOF of the relative pose plus
+// up to two focal lengths, so unlike BundleAdjustTwoViews it requires no 3D
+// points, no per-point parameter blocks, and no heap allocations. Only the
+// inlier correspondences given by the indices are used.
+//
+// Camera 1 must be at the origin with identity orientation. The orientation,
+// position (the baseline length is preserved), and optionally the focal
+// lengths of camera 2 (and camera 1) are updated. Radial distortion is ignored.
+// Returns true if the refinement converged to a finite cost that is no worse
+// than the initial cost.
+bool RefineTwoViewGeometry(
+    const TwoViewRefinementOptions& options,
+    const std::vector<FeatureCorrespondence>& correspondences,
+    const std::vector<int>& inliers,
+    Camera* camera1,
+    Camera* camera2,
+    TwoViewRefinementSummary* summary);
+
+}  // namespace theia
+
+#endif  // THEIA_SFM_BUNDLE_ADJUSTMENT_REFINE_TWO_VIEW_GEOMETRY_H_
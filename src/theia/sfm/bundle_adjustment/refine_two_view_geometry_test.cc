@@ -0,0 +1,192 @@
+// Copyright (C) 2015 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "theia/math/util.h"
+#include "theia/matching/feature_correspondence.h"
+#include "theia/sfm/bundle_adjustment/refine_two_view_geometry.h"
+#include "theia/sfm/camera/camera.h"
+#include "theia/sfm/pose/test_util.h"
+#include "theia/util/random.h"
+
+namespace theia {
+
+namespace {
+
+static const int kNumPoints = 200;
+static const double kFocalLength = 800.0;
+
+Camera CreateCamera() {
+  Camera camera;
+  camera.SetImageSize(1000, 1000);
+  camera.SetFocalLength(kFocalLength);
+  camera.SetAspectRatio(1.0);
+  camera.SetSkew(0.0);
+  camera.SetPrincipalPoint(500.0, 500.0);
+  return camera;
+}
+
+void CreateCorrespondences(const Camera& camera1,
+                           const Camera& camera2,
+                           const double pixel_noise,
+                           std::vector<FeatureCorrespondence>* correspondences,
+                           std::vector<int>* inliers) {
+  for (int i = 0; i < kNumPoints; i++) {
+    const Eigen::Vector4d point(RandDouble(-2.0, 2.0),
+                                RandDouble(-2.0, 2.0),
+                                RandDouble(4.0, 8.0),
+                                1.0);
+    FeatureCorrespondence correspondence;
+    if (camera1.ProjectPoint(point, &correspondence.feature1) < 0 ||
+        camera2.ProjectPoint(point, &correspondence.feature2) < 0) {
+      continue;
+    }
+    if (pixel_noise > 0.0) {
+      AddNoiseToProjection(pixel_noise, &correspondence.feature1);
+      AddNoiseToProjection(pixel_noise, &correspondence.feature2);
+    }
+    inliers->emplace_back(correspondences->size());
+    correspondences->emplace_back(correspondence);
+  }
+}
+
+double RotationError(const Camera& camera1, const Camera& camera2) {
+  const Eigen::AngleAxisd rotation_error(
+      camera1.GetOrientationAsRotationMatrix().transpose() *
+      camera2.GetOrientationAsRotationMatrix());
+  return RadToDeg(rotation_error.angle());
+}
+
+double PositionError(const Camera& camera1, const Camera& camera2) {
+  const double cos_angle = camera1.GetPosition().normalized().dot(
+      camera2.GetPosition().normalized());
+  return RadToDeg(std::acos(Clamp(cos_angle, -1.0, 1.0)));
+}
+
+void TestRefinement(const TwoViewRefinementOptions& options,
+                    const double pixel_noise,
+                    const double focal_length_noise,
+                    const double tolerance_degrees) {
+  InitRandomGenerator();
+
+  const Camera camera1 = CreateCamera();
+  Camera camera2 = CreateCamera();
+  camera2.SetOrientationFromAngleAxis(
+      Eigen::Vector3d(0.05, DegToRad(-15.0), 0.02));
+  camera2.SetPosition(Eigen::Vector3d(1.0, 0.1, 0.2));
+
+  std::vector<FeatureCorrespondence> correspondences;
+  std::vector<int> inliers;
+  CreateCorrespondences(camera1, camera2, pixel_noise, &correspondences,
+                        &inliers);
+
+  // Perturb the relative pose and focal lengths.
+  Camera estimated_camera1 = camera1;
+  Camera estimated_camera2 = camera2;
+  estimated_camera2.SetOrientationFromAngleAxis(
+      camera2.GetOrientationAsAngleAxis() + Eigen::Vector3d(0.02, -0.01, 0.02));
+  estimated_camera2.SetPosition(camera2.GetPosition() +
+                                Eigen::Vector3d(0.0, 0.1, -0.05));
+  if (options.refine_focal_length1) {
+    estimated_camera1.SetFocalLength(
+        (1.0 + focal_length_noise) * kFocalLength);
+  }
+  if (options.refine_focal_length2) {
+    estimated_camera2.SetFocalLength(
+        (1.0 - focal_length_noise) * kFocalLength);
+  }
+
+  TwoViewRefinementSummary summary;
+  EXPECT_TRUE(RefineTwoViewGeometry(options,
+                                    correspondences,
+                                    inliers,
+                                    &estimated_camera1,
+                                    &estimated_camera2,
+                                    &summary));
+  EXPECT_TRUE(summary.success);
+  EXPECT_LT(summary.final_cost, summary.initial_cost);
+  EXPECT_LT(RotationError(camera2, estimated_camera2), tolerance_degrees);
+  EXPECT_LT(PositionError(camera2, estimated_camera2), tolerance_degrees);
+  EXPECT_NEAR(estimated_camera1.FocalLength(),
+              kFocalLength,
+              1e2 * tolerance_degrees);
+  EXPECT_NEAR(estimated_camera2.FocalLength(),
+              kFocalLength,
+              1e2 * tolerance_degrees);
+
+  // The first camera must remain fixed.
+  EXPECT_EQ(estimated_camera1.GetPosition(), camera1.GetPosition());
+  EXPECT_EQ(estimated_camera1.GetOrientationAsAngleAxis(),
+            camera1.GetOrientationAsAngleAxis());
+}
+
+}  // namespace
+
+TEST(RefineTwoViewGeometry, NoNoise) {
+  TwoViewRefinementOptions options;
+  TestRefinement(options, 0.0, 0.0, 1e-4);
+}
+
+TEST(RefineTwoViewGeometry, PixelNoise) {
+  TwoViewRefinementOptions options;
+  TestRefinement(options, 1.0, 0.0, 0.5);
+}
+
+TEST(RefineTwoViewGeometry, FocalLengthNoNoise) {
+  TwoViewRefinementOptions options;
+  options.refine_focal_length2 = true;
+  TestRefinement(options, 0.0, 0.05, 1e-4);
+}
+
+TEST(RefineTwoViewGeometry, TooFewInliers) {
+  TwoViewRefinementOptions options;
+  Camera camera1 = CreateCamera();
+  Camera camera2 = CreateCamera();
+  camera2.SetPosition(Eigen::Vector3d(1.0, 0.0, 0.0));
+  const std::vector<FeatureCorrespondence> correspondences(4);
+  const std::vector<int> inliers = { 0, 1, 2, 3 };
+  TwoViewRefinementSummary summary;
+  EXPECT_FALSE(RefineTwoViewGeometry(options,
+                                     correspondences,
+                                     inliers,
+                                     &camera1,
+                                     &camera2,
+                                     &summary));
+}
+
+}  // namespace theia
@@ -42,6 +42,7 @@
 #include "theia/sfm/camera/projection_matrix_utils.h"
 #include "theia/sfm/camera/project_point_to_image.h"
 #include "theia/sfm/camera/radial_distortion.h"
+#include "theia/sfm/camera/radial_undistortion_table.h"
 
 namespace theia {
 
@@ -125,17 +126,22 @@ double Camera::ProjectPoint(const Vector4d& point, Vector2d* pixel) const {
                              pixel->data());
 }
 
+namespace {
+
+// The minimum number of pixels for which PixelsToUnitDepthRays builds a lookup
+// table for the radial distortion. Building the table costs about as much as
+// undistorting a few hundred pixels with the iterative solver.
+static const int kMinNumPixelsForUndistortionTable = 1000;
+
+}  // namespace
+
 Vector3d Camera::PixelToUnitDepthRay(const Vector2d& pixel) const {
   Vector3d direction;
 
   // First, undo the calibration.
-  const double focal_length_y = FocalLength() * AspectRatio();
-  const double y_normalized = (pixel[1] - PrincipalPointY()) / focal_length_y;
-  const double x_normalized =
-      (pixel[0] - PrincipalPointX() - y_normalized * Skew()) / FocalLength();
+  const Vector2d normalized_point = PixelToNormalizedPoint(pixel);
 
   // Undo radial distortion.
-  const Vector2d normalized_point(x_normalized, y_normalized);
   Vector2d undistorted_point;
   RadialUndistortPoint(normalized_point,
                        RadialDistortion1(),
@@ -148,6 +154,71 @@ Vector3d Camera::PixelToUnitDepthRay(const Vector2d& pixel) const {
   return direction;
 }
 
+Vector3d Camera::PixelToUnitDepthRay(
+    const Vector2d& pixel,
+    const RadialUndistortionTable& undistortion_table) const {
+  DCHECK(undistortion_table.IsValidFor(*this))
+      << "The undistortion table was built for different intrinsics.";
+  Vector2d undistorted_point;
+  undistortion_table.UndistortPoint(PixelToNormalizedPoint(pixel),
+                                    &undistorted_point);
+  return GetOrientationAsRotationMatrix().transpose() *
+         undistorted_point.homogeneous();
+}
+
+void Camera::PixelsToUnitDepthRays(const std::vector<Vector2d>& pixels,
+                                   std::vector<Vector3d>* rays) const {
+  CHECK_NOTNULL(rays)->resize(pixels.size());
+  const Matrix3d rotation_transpose =
+      GetOrientationAsRotationMatrix().transpose();
+
+  // Without radial distortion, or for few pixels, the points are undistorted
+  // directly.
+  if ((RadialDistortion1() == 0 && RadialDistortion2() == 0) ||
+      pixels.size() < kMinNumPixelsForUndistortionTable) {
+    for (int i = 0; i < pixels.size(); i++) {
+      Vector2d undistorted_point;
+      RadialUndistortPoint(PixelToNormalizedPoint(pixels[i]),
+                           RadialDistortion1(),
+                           RadialDistortion2(),
+                           &undistorted_point);
+      (*rays)[i] = rotation_transpose * undistorted_point.homogeneous();
+    }
+    return;
+  }
+
+  const RadialUndistortionTable undistortion_table(*this);
+  for (int i = 0; i < pixels.size(); i++) {
+    Vector2d undistorted_point;
+    undistortion_table.UndistortPoint(PixelToNormalizedPoint(pixels[i]),
+                                      &undistorted_point);
+    (*rays)[i] = rotation_transpose * undistorted_point.homogeneous();
+  }
+}
+
+Vector2d Camera::PixelToNormalizedPoint(const Vector2d& pixel) const {
+  const double focal_length_y = FocalLength() * AspectRatio();
+  const double y_normalized = (pixel[1] - PrincipalPointY()) / focal_length_y;
+  const double x_normalized =
+      (pixel[0] - PrincipalPointX() - y_normalized * Skew()) / FocalLength();
+  return Vector2d(x_normalized, y_normalized);
+}
+
+Vector2d Camera::NormalizedPointToPixel(
+    const Vector2d& normalized_point) const {
+  Vector2d distorted_point;
+  RadialDistortPoint(normalized_point[0],
+                     normalized_point[1],
+                     RadialDistortion1(),
+                     RadialDistortion2(),
+                     &distorted_point[0],
+                     &distorted_point[1]);
+  return Vector2d(FocalLength() * distorted_point[0] +
+                      Skew() * distorted_point[1] + PrincipalPointX(),
+                  FocalLength() * AspectRatio() * distorted_point[1] +
+                      PrincipalPointY());
+}
+
   // ----------------------- Getter and Setter methods ---------------------- //
 void Camera::SetPosition(const Vector3d& position) {
   Map<Vector3d>(mutable_extrinsics() + POSITION) = position;
@@ -45,6 +45,8 @@
 
 namespace theia {
 
+class RadialUndistortionTable;
+
 // This class contains the full camera pose information including extrinsic
 // parameters as well as intrinsic parameters. Extrinsic parameters include the
 // camera orientation (as angle-axis) and position, and intrinsic parameters
@@ -122,6 +124,30 @@ class Camera {
   //    d is the depth of the 3D point with respect to the image
   Eigen::Vector3d PixelToUnitDepthRay(const Eigen::Vector2d& pixel) const;
 
+  // Same as above, but the radial distortion is removed with the lookup table,
+  // which must have been built for the current intrinsics of this camera. This
+  // is much faster when many pixels of the same camera are converted.
+  Eigen::Vector3d PixelToUnitDepthRay(
+      const Eigen::Vector2d& pixel,
+      const RadialUndistortionTable& undistortion_table) const;
+
+  // Converts all pixels (e.g., all features of a view) to unit depth rays at
+  // once. A lookup table for the radial distortion is built if there are
+  // enough pixels for it to pay off.
+  void PixelsToUnitDepthRays(const std::vector<Eigen::Vector2d>& pixels,
+                             std::vector<Eigen::Vector3d>* rays) const;
+
+  // Removes the calibration from the pixel and returns the point in normalized
+  // coordinates. The radial distortion is not removed.
+  Eigen::Vector2d PixelToNormalizedPoint(const Eigen::Vector2d& pixel) const;
+
+  // Applies the radial distortion and the calibration to the point in
+  // normalized coordinates (i.e., a point in the camera coordinate system
+  // divided by its depth) and returns the pixel. This is the inverse of
+  // PixelToNormalizedPoint followed by removing the radial distortion.
+  Eigen::Vector2d NormalizedPointToPixel(
+      const Eigen::Vector2d& normalized_point) const;
+
   // ----------------------- Getter and Setter methods ---------------------- //
   void SetPosition(const Eigen::Vector3d& position);
   Eigen::Vector3d GetPosition() const;
@@ -225,4 +225,38 @@ TEST(Camera, ReprojectionTwoDistortion) {
   }
 }
 
+TEST(Camera, NormalizedPointToPixel) {
+  static const double kTolerance = 1e-8;
+  InitRandomGenerator();
+  Camera camera;
+  camera.InitializeFromProjectionMatrix(600, 600, Matrix3x4d::Random());
+  camera.SetSkew(RandDouble(-10.0, 10.0));
+  camera.SetRadialDistortion(RandDouble(0.0, 0.2), RandDouble(0.0, 0.02));
+
+  for (int i = 0; i < 10; i++) {
+    const Vector3d point_in_camera(RandDouble(-2.0, 2.0),
+                                   RandDouble(-2.0, 2.0),
+                                   RandDouble(4.0, 8.0));
+    const Vector4d point =
+        (camera.GetPosition() +
+         camera.GetOrientationAsRotationMatrix().transpose() * point_in_camera)
+            .homogeneous();
+    Vector2d pixel;
+    camera.ProjectPoint(point, &pixel);
+
+    const Vector2d normalized_point = point_in_camera.hnormalized();
+    EXPECT_LT((camera.NormalizedPointToPixel(normalized_point) - pixel).norm(),
+              kTolerance);
+
+    // Without radial distortion, removing the calibration recovers the point.
+    Camera undistorted_camera = camera;
+    undistorted_camera.SetRadialDistortion(0, 0);
+    const Vector2d undistorted_pixel =
+        undistorted_camera.NormalizedPointToPixel(normalized_point);
+    EXPECT_LT((undistorted_camera.PixelToNormalizedPoint(undistorted_pixel) -
+               normalized_point).norm(),
+              kTolerance);
+  }
+}
+
 }  // namespace theia
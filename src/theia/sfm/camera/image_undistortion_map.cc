@@ -0,0 +1,120 @@
+// Copyright (C) 2014 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include "theia/sfm/camera/image_undistortion_map.h"
+
+#include <Eigen/Core>
+#include <glog/logging.h>
+
+#include <cmath>
+#include <vector>
+
+#include "theia/image/image.h"
+#include "theia/sfm/camera/camera.h"
+#include "theia/sfm/camera/radial_distortion.h"
+
+namespace theia {
+
+ImageUndistortionMap::ImageUndistortionMap(const Camera& camera)
+    : undistorted_camera_(camera),
+      width_(camera.ImageWidth()),
+      height_(camera.ImageHeight()) {
+  CHECK_GT(width_, 0) << "The image size of the camera must be set.";
+  CHECK_GT(height_, 0) << "The image size of the camera must be set.";
+  undistorted_camera_.SetRadialDistortion(0, 0);
+
+  Eigen::Matrix3d calibration;
+  camera.GetCalibrationMatrix(&calibration);
+  const Eigen::Matrix3d inverse_calibration = calibration.inverse();
+
+  distorted_pixels_.resize(width_ * height_);
+  for (int y = 0; y < height_; y++) {
+    for (int x = 0; x < width_; x++) {
+      const Eigen::Vector3d undistorted_point =
+          inverse_calibration * Eigen::Vector3d(x, y, 1.0);
+      Eigen::Vector3d distorted_point(0, 0, 1.0);
+      RadialDistortPoint(undistorted_point.x(),
+                         undistorted_point.y(),
+                         camera.RadialDistortion1(),
+                         camera.RadialDistortion2(),
+                         &distorted_point[0],
+                         &distorted_point[1]);
+      distorted_pixels_[y * width_ + x] =
+          (calibration * distorted_point).head<2>().cast<float>();
+    }
+  }
+}
+
+void ImageUndistortionMap::Undistort(const FloatImage& distorted_image,
+                                     FloatImage* undistorted_image) const {
+  CHECK_EQ(distorted_image.Width(), width_);
+  CHECK_EQ(distorted_image.Height(), height_);
+  const int num_channels = distorted_image.Channels();
+  *CHECK_NOTNULL(undistorted_image) =
+      FloatImage(width_, height_, num_channels);
+
+  // The channels of the image are stored as separate planes, so the same
+  // offsets and weights are used for all channels.
+  const int num_pixels = width_ * height_;
+  const float* input = distorted_image.Data();
+  float* output = undistorted_image->Data();
+  for (int i = 0; i < num_pixels; i++) {
+    const Eigen::Vector2f& pixel = distorted_pixels_[i];
+    const int x = static_cast<int>(std::floor(pixel.x()));
+    const int y = static_cast<int>(std::floor(pixel.y()));
+    if (x < 0 || y < 0 || x >= width_ || y >= height_) {
+      for (int c = 0; c < num_channels; c++) {
+        output[c * num_pixels + i] = 0.0f;
+      }
+      continue;
+    }
+
+    // Pixels between the last column or row and the image border are
+    // interpolated with the border pixel as its own neighbor.
+    const int right = (x + 1 < width_) ? 1 : 0;
+    const int below = (y + 1 < height_) ? width_ : 0;
+    const float dx = pixel.x() - x;
+    const float dy = pixel.y() - y;
+    const int top_left = y * width_ + x;
+    for (int c = 0; c < num_channels; c++) {
+      const float* channel = input + c * num_pixels + top_left;
+      const float top = channel[0] + dx * (channel[right] - channel[0]);
+      const float bottom = channel[below] +
+                           dx * (channel[below + right] - channel[below]);
+      output[c * num_pixels + i] = top + dy * (bottom - top);
+    }
+  }
+}
+
+}  // namespace theia
@@ -0,0 +1,86 @@
+// Copyright (C) 2014 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#ifndef THEIA_SFM_CAMERA_IMAGE_UNDISTORTION_MAP_H_
+#define THEIA_SFM_CAMERA_IMAGE_UNDISTORTION_MAP_H_
+
+#include <Eigen/Core>
+#include <vector>
+
+#include "theia/image/image.h"
+#include "theia/sfm/camera/camera.h"
+
+namespace theia {
+
+// A precomputed remap table that removes the radial distortion from the images
+// of a camera. For each pixel of the undistorted image, the table stores the
+// location of the corresponding pixel in the distorted image so that
+// undistorting an image only requires a bilinear lookup per pixel. The
+// undistorted image has the same size and calibration as the input image,
+// i.e. it is the image of UndistortedCamera().
+//
+// The table holds two floats per pixel, so it is meant to be built once per
+// camera and reused for all channels (or images) of that camera.
+class ImageUndistortionMap {
+ public:
+  // Builds the map for the intrinsics of the camera. The image size of the
+  // camera must be set.
+  explicit ImageUndistortionMap(const Camera& camera);
+  ~ImageUndistortionMap() {}
+
+  // The camera with the same pose and calibration as the input camera but
+  // without radial distortion.
+  const Camera& UndistortedCamera() const { return undistorted_camera_; }
+
+  // Returns the location in the distorted image of the pixel (x, y) of the
+  // undistorted image.
+  const Eigen::Vector2f& DistortedPixel(const int x, const int y) const {
+    return distorted_pixels_[y * width_ + x];
+  }
+
+  // Removes the radial distortion from the image. The size of the image must
+  // match the image size of the camera. Pixels of the undistorted image that
+  // map outside of the distorted image are set to zero.
+  void Undistort(const FloatImage& distorted_image,
+                 FloatImage* undistorted_image) const;
+
+ private:
+  Camera undistorted_camera_;
+  int width_, height_;
+  std::vector<Eigen::Vector2f> distorted_pixels_;
+};
+
+}  // namespace theia
+
+#endif  // THEIA_SFM_CAMERA_IMAGE_UNDISTORTION_MAP_H_
@@ -0,0 +1,149 @@
+// Copyright (C) 2014 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include <Eigen/Core>
+#include <glog/logging.h>
+
+#include "gtest/gtest.h"
+#include "theia/image/image.h"
+#include "theia/sfm/camera/camera.h"
+#include "theia/sfm/camera/image_undistortion_map.h"
+
+namespace theia {
+
+using Eigen::Vector2d;
+using Eigen::Vector3d;
+
+namespace {
+
+static const int kImageWidth = 320;
+static const int kImageHeight = 240;
+
+Camera CreateCamera(const double k1, const double k2) {
+  Camera camera;
+  camera.SetImageSize(kImageWidth, kImageHeight);
+  camera.SetFocalLength(300);
+  camera.SetPrincipalPoint(160, 120);
+  camera.SetRadialDistortion(k1, k2);
+  return camera;
+}
+
+// The intensity of the (undistorted) scene at the pixel. The pattern is smooth
+// so that bilinear interpolation reproduces it accurately.
+float Intensity(const Vector2d& undistorted_pixel, const int channel) {
+  return (channel + 1) * (0.5 * undistorted_pixel.x() + undistorted_pixel.y());
+}
+
+// Renders the distorted image of the scene by undistorting every pixel with the
+// iterative solver.
+FloatImage RenderDistortedImage(const Camera& camera) {
+  Camera undistorted_camera = camera;
+  undistorted_camera.SetRadialDistortion(0, 0);
+  Eigen::Matrix3d calibration;
+  camera.GetCalibrationMatrix(&calibration);
+
+  FloatImage image(kImageWidth, kImageHeight, 3);
+  for (int y = 0; y < kImageHeight; y++) {
+    for (int x = 0; x < kImageWidth; x++) {
+      const Vector3d ray = camera.PixelToUnitDepthRay(Vector2d(x, y));
+      const Vector2d undistorted_pixel = (calibration * ray).hnormalized();
+      for (int c = 0; c < 3; c++) {
+        image(x, y, c) = Intensity(undistorted_pixel, c);
+      }
+    }
+  }
+  return image;
+}
+
+void TestUndistortImage(const double k1, const double k2) {
+  const Camera camera = CreateCamera(k1, k2);
+  const FloatImage distorted_image = RenderDistortedImage(camera);
+
+  const ImageUndistortionMap undistortion_map(camera);
+  EXPECT_EQ(undistortion_map.UndistortedCamera().RadialDistortion1(), 0);
+  EXPECT_EQ(undistortion_map.UndistortedCamera().RadialDistortion2(), 0);
+  EXPECT_EQ(undistortion_map.UndistortedCamera().FocalLength(),
+            camera.FocalLength());
+
+  FloatImage undistorted_image;
+  undistortion_map.Undistort(distorted_image, &undistorted_image);
+  ASSERT_EQ(undistorted_image.Width(), kImageWidth);
+  ASSERT_EQ(undistorted_image.Height(), kImageHeight);
+  ASSERT_EQ(undistorted_image.Channels(), 3);
+
+  int num_valid_pixels = 0;
+  for (int y = 0; y < kImageHeight; y++) {
+    for (int x = 0; x < kImageWidth; x++) {
+      // The pixel maps to the distorted pixel, which must be projected back to
+      // the undistorted pixel.
+      const Eigen::Vector2f& distorted_pixel =
+          undistortion_map.DistortedPixel(x, y);
+      if (distorted_pixel.x() < 0 || distorted_pixel.y() < 0 ||
+          distorted_pixel.x() >= kImageWidth ||
+          distorted_pixel.y() >= kImageHeight) {
+        EXPECT_EQ(undistorted_image(x, y, 0), 0);
+        continue;
+      }
+
+      // Beyond the last column or row the border pixels are repeated, so the
+      // intensity is only accurate up to the gradient of the pattern.
+      const bool is_beyond_last_pixel =
+          distorted_pixel.x() > kImageWidth - 1 ||
+          distorted_pixel.y() > kImageHeight - 1;
+      const double tolerance = is_beyond_last_pixel ? 1.0 : 1e-2;
+      ++num_valid_pixels;
+      for (int c = 0; c < 3; c++) {
+        EXPECT_NEAR(undistorted_image(x, y, c), Intensity(Vector2d(x, y), c),
+                    tolerance * (c + 1));
+      }
+    }
+  }
+  EXPECT_GT(num_valid_pixels, kImageWidth * kImageHeight / 2);
+}
+
+}  // namespace
+
+TEST(ImageUndistortionMap, NoDistortion) {
+  TestUndistortImage(0, 0);
+}
+
+TEST(ImageUndistortionMap, BarrelDistortion) {
+  TestUndistortImage(-0.1, 0.01);
+}
+
+TEST(ImageUndistortionMap, PincushionDistortion) {
+  TestUndistortImage(0.05, 0.01);
+}
+
+}  // namespace theia
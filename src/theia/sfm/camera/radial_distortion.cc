@@ -67,8 +67,9 @@ void RadialUndistortPoint(const Eigen::Vector2d& distorted_point,
   const double kEpsilon = 1e-8;
   const int kMaxIter = 10;
 
-  if (std::max(std::abs(distorted_point.x()), std::abs(distorted_point.y())) <
-      kMinRadius) {
+  if ((radial_distortion1 == 0 && radial_distortion2 == 0) ||
+      std::max(std::abs(distorted_point.x()), std::abs(distorted_point.y())) <
+          kMinRadius) {
     *undistorted_point = distorted_point;
     return;
   }
@@ -0,0 +1,154 @@
+// Copyright (C) 2014 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include "theia/sfm/camera/radial_undistortion_table.h"
+
+#include <Eigen/Core>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "theia/sfm/camera/camera.h"
+#include "theia/sfm/camera/radial_distortion.h"
+
+namespace theia {
+
+namespace {
+
+// The number of intervals the squared radius is divided into. The error of the
+// linear interpolation is far below the convergence radius of Newton's method,
+// so a single Newton step is enough to undistort the points up to the
+// precision of the iterative solver.
+static const int kNumIntervals = 512;
+
+// The table covers slightly more than the image so that features that lie on
+// the border of the image after subpixel refinement use the table as well.
+static const double kRadiusMargin = 1.1;
+
+}  // namespace
+
+RadialUndistortionTable::RadialUndistortionTable(const Camera& camera) {
+  std::copy(camera.intrinsics(),
+            camera.intrinsics() + Camera::kIntrinsicsSize,
+            intrinsics_);
+  image_size_[0] = camera.ImageWidth();
+  image_size_[1] = camera.ImageHeight();
+
+  // The distortion is radially symmetric, so the largest radius is attained at
+  // one of the image corners.
+  const double width = image_size_[0] > 0 ? image_size_[0]
+                                           : 2.0 * camera.PrincipalPointX();
+  const double height = image_size_[1] > 0 ? image_size_[1]
+                                            : 2.0 * camera.PrincipalPointY();
+  const Eigen::Vector2d corners[4] = {Eigen::Vector2d(0, 0),
+                                      Eigen::Vector2d(width, 0),
+                                      Eigen::Vector2d(0, height),
+                                      Eigen::Vector2d(width, height)};
+  double max_squared_corner_radius = 0;
+  for (const Eigen::Vector2d& corner : corners) {
+    max_squared_corner_radius =
+        std::max(max_squared_corner_radius,
+                 camera.PixelToNormalizedPoint(corner).squaredNorm());
+  }
+  const double max_radius = std::sqrt(max_squared_corner_radius);
+  max_squared_radius_ = (kRadiusMargin * max_radius) *
+                        (kRadiusMargin * max_radius);
+  if (!std::isfinite(max_squared_radius_) || max_squared_radius_ <= 0) {
+    // The table does not cover any points.
+    max_squared_radius_ = 0;
+    inverse_step_ = 0;
+    return;
+  }
+  inverse_step_ = kNumIntervals / max_squared_radius_;
+
+  // Sample the scale at regularly spaced squared radii.
+  scales_.resize(kNumIntervals + 1);
+  scales_[0] = 1.0;
+  for (int i = 1; i <= kNumIntervals; i++) {
+    const double radius = std::sqrt(i / inverse_step_);
+    Eigen::Vector2d undistorted_point;
+    RadialUndistortPoint(Eigen::Vector2d(radius, 0),
+                         camera.RadialDistortion1(),
+                         camera.RadialDistortion2(),
+                         &undistorted_point);
+    scales_[i] = undistorted_point.x() / radius;
+  }
+}
+
+bool RadialUndistortionTable::IsValidFor(const Camera& camera) const {
+  return std::equal(intrinsics_,
+                    intrinsics_ + Camera::kIntrinsicsSize,
+                    camera.intrinsics()) &&
+         image_size_[0] == camera.ImageWidth() &&
+         image_size_[1] == camera.ImageHeight();
+}
+
+void RadialUndistortionTable::UndistortPoint(
+    const Eigen::Vector2d& distorted_point,
+    Eigen::Vector2d* undistorted_point) const {
+  const double k1 = intrinsics_[Camera::RADIAL_DISTORTION_1];
+  const double k2 = intrinsics_[Camera::RADIAL_DISTORTION_2];
+  const double squared_radius = distorted_point.squaredNorm();
+  if (squared_radius >= max_squared_radius_) {
+    RadialUndistortPoint(distorted_point, k1, k2, undistorted_point);
+    return;
+  }
+
+  // Interpolate the scale linearly between the two closest entries. Rounding
+  // may place a squared radius just below the maximum in the last entry, so the
+  // index is clamped to the last interval.
+  const double position = squared_radius * inverse_step_;
+  const int index = std::min(static_cast<int>(position), kNumIntervals - 1);
+  const double weight = position - index;
+  double scale =
+      scales_[index] + weight * (scales_[index + 1] - scales_[index]);
+
+  // Refine the scale s with a Newton step on the distortion model
+  //   g(s) = s * (1 + k1 * s^2 * r + k2 * s^4 * r^2) - 1 = 0
+  // where r is the squared radius of the distorted point.
+  const double k1_r = k1 * squared_radius;
+  const double k2_r2 = k2 * squared_radius * squared_radius;
+  const double scale_sq = scale * scale;
+  const double g = scale * (1.0 + scale_sq * (k1_r + scale_sq * k2_r2)) - 1.0;
+  const double g_derivative =
+      1.0 + scale_sq * (3.0 * k1_r + 5.0 * scale_sq * k2_r2);
+  if (std::abs(g_derivative) > 1e-8) {
+    scale -= g / g_derivative;
+  }
+
+  *undistorted_point = scale * distorted_point;
+}
+
+}  // namespace theia
@@ -0,0 +1,91 @@
+// Copyright (C) 2014 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#ifndef THEIA_SFM_CAMERA_RADIAL_UNDISTORTION_TABLE_H_
+#define THEIA_SFM_CAMERA_RADIAL_UNDISTORTION_TABLE_H_
+
+#include <Eigen/Core>
+#include <vector>
+
+#include "theia/sfm/camera/camera.h"
+
+namespace theia {
+
+// A lookup table for removing the radial distortion of a camera. Solving for
+// the undistorted point with RadialUndistortPoint requires an iterative root
+// finder for every point, which is costly when all features of a view are
+// undistorted (e.g., for triangulation). Since the distortion model is radial,
+// the undistorted point is the distorted point scaled by a factor that only
+// depends on the squared radius of the distorted point. The table samples this
+// factor over the radii of the image, interpolates it linearly, and refines it
+// with one Newton step which gives the same accuracy as the iterative solver.
+//
+// The table is only valid for the intrinsics it was built for. Use IsValidFor
+// to check whether the intrinsics of the camera have changed since, e.g. after
+// bundle adjustment.
+class RadialUndistortionTable {
+ public:
+  // Builds the table for the current intrinsics of the camera. The table covers
+  // all pixels of the image (with a small margin) if the image size is set.
+  // Otherwise, the image is assumed to be centered at the principal point.
+  explicit RadialUndistortionTable(const Camera& camera);
+  ~RadialUndistortionTable() {}
+
+  // Returns true if the table was built for the current intrinsics and image
+  // size of the camera.
+  bool IsValidFor(const Camera& camera) const;
+
+  // Removes the radial distortion of the point in normalized coordinates (i.e.,
+  // after the calibration has been undone). Points outside of the range of the
+  // table are undistorted with RadialUndistortPoint.
+  void UndistortPoint(const Eigen::Vector2d& distorted_point,
+                      Eigen::Vector2d* undistorted_point) const;
+
+ private:
+  double intrinsics_[Camera::kIntrinsicsSize];
+  int image_size_[2];
+
+  // The squared radius of the distorted points covered by the table, and the
+  // inverse of the spacing of the table entries.
+  double max_squared_radius_;
+  double inverse_step_;
+
+  // The ratio of the undistorted and distorted radius sampled at regular
+  // intervals of the squared distorted radius.
+  std::vector<double> scales_;
+};
+
+}  // namespace theia
+
+#endif  // THEIA_SFM_CAMERA_RADIAL_UNDISTORTION_TABLE_H_
@@ -0,0 +1,162 @@
+// Copyright (C) 2014 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include <Eigen/Core>
+#include <glog/logging.h>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "theia/sfm/camera/camera.h"
+#include "theia/sfm/camera/radial_distortion.h"
+#include "theia/sfm/camera/radial_undistortion_table.h"
+#include "theia/util/random.h"
+
+namespace theia {
+
+using Eigen::Vector2d;
+using Eigen::Vector3d;
+
+namespace {
+
+// The iterative solver converges to a tolerance of 1e-8, while the table is
+// accurate up to machine precision.
+static const double kSolverTolerance = 1e-7;
+static const double kTolerance = 1e-12;
+
+// The normalized radius of the image corners of the camera below is 0.71.
+static const double kMaxRadiusInImage = 0.7;
+
+Camera CreateCamera(const double k1, const double k2) {
+  Camera camera;
+  camera.SetImageSize(1600, 1200);
+  camera.SetFocalLength(1400);
+  camera.SetPrincipalPoint(800, 600);
+  camera.SetRadialDistortion(k1, k2);
+  return camera;
+}
+
+void TestUndistortionTable(const double k1, const double k2) {
+  RandomNumberGenerator rng(53);
+  const Camera camera = CreateCamera(k1, k2);
+  const RadialUndistortionTable undistortion_table(camera);
+
+  // Compare against the iterative solver for points inside and outside of the
+  // image. Inside of the image, distorting the point again must give the input
+  // up to machine precision.
+  for (int i = 0; i < 1000; i++) {
+    const Vector2d distorted_point(rng.RandDouble(-0.8, 0.8),
+                                   rng.RandDouble(-0.6, 0.6));
+    Vector2d expected_undistorted_point, undistorted_point;
+    RadialUndistortPoint(distorted_point, k1, k2, &expected_undistorted_point);
+    undistortion_table.UndistortPoint(distorted_point, &undistorted_point);
+    EXPECT_LT((expected_undistorted_point - undistorted_point).norm(),
+              kSolverTolerance)
+        << "distorted point: " << distorted_point.transpose();
+
+    if (distorted_point.norm() > kMaxRadiusInImage) {
+      continue;
+    }
+    Vector2d redistorted_point;
+    RadialDistortPoint(undistorted_point.x(),
+                       undistorted_point.y(),
+                       k1,
+                       k2,
+                       &redistorted_point.x(),
+                       &redistorted_point.y());
+    EXPECT_LT((distorted_point - redistorted_point).norm(), kTolerance)
+        << "distorted point: " << distorted_point.transpose();
+  }
+}
+
+}  // namespace
+
+TEST(RadialUndistortionTable, ZeroDistortion) {
+  TestUndistortionTable(0.0, 0.0);
+}
+
+TEST(RadialUndistortionTable, OneParameterDistortion) {
+  TestUndistortionTable(-0.1, 0.0);
+  TestUndistortionTable(0.1, 0.0);
+}
+
+TEST(RadialUndistortionTable, TwoParameterDistortion) {
+  TestUndistortionTable(-0.2, 0.05);
+  TestUndistortionTable(0.1, 0.05);
+}
+
+TEST(RadialUndistortionTable, IsValidFor) {
+  Camera camera = CreateCamera(0.1, 0.01);
+  const RadialUndistortionTable undistortion_table(camera);
+  EXPECT_TRUE(undistortion_table.IsValidFor(camera));
+
+  // Changing the extrinsics does not invalidate the table.
+  camera.SetPosition(Vector3d(1.0, 2.0, 3.0));
+  EXPECT_TRUE(undistortion_table.IsValidFor(camera));
+
+  // Changing the intrinsics does, including changes made by bundle adjustment.
+  camera.mutable_intrinsics()[Camera::RADIAL_DISTORTION_1] = 0.2;
+  EXPECT_FALSE(undistortion_table.IsValidFor(camera));
+  camera.SetRadialDistortion(0.1, 0.01);
+  EXPECT_TRUE(undistortion_table.IsValidFor(camera));
+  camera.SetFocalLength(1000);
+  EXPECT_FALSE(undistortion_table.IsValidFor(camera));
+}
+
+TEST(RadialUndistortionTable, PixelsToUnitDepthRays) {
+  RandomNumberGenerator rng(59);
+  Camera camera = CreateCamera(-0.15, 0.02);
+  camera.SetOrientationFromAngleAxis(Vector3d(0.1, -0.2, 0.3));
+
+  // Enough pixels for the lookup table to be used.
+  std::vector<Vector2d> pixels(5000);
+  for (Vector2d& pixel : pixels) {
+    pixel = Vector2d(rng.RandDouble(0, camera.ImageWidth()),
+                     rng.RandDouble(0, camera.ImageHeight()));
+  }
+
+  std::vector<Vector3d> rays;
+  camera.PixelsToUnitDepthRays(pixels, &rays);
+  ASSERT_EQ(rays.size(), pixels.size());
+  const RadialUndistortionTable undistortion_table(camera);
+  for (int i = 0; i < pixels.size(); i++) {
+    const Vector3d expected_ray = camera.PixelToUnitDepthRay(pixels[i]);
+    EXPECT_LT((expected_ray - rays[i]).norm(), kSolverTolerance);
+    EXPECT_LT((rays[i] -
+               camera.PixelToUnitDepthRay(pixels[i], undistortion_table))
+                  .norm(),
+              kTolerance);
+  }
+}
+
+}  // namespace theia
@@ -35,12 +35,18 @@
 #include "theia/sfm/colorize_reconstruction.h"
 
 #include <Eigen/Core>
+#include <glog/logging.h>
 
-#include <mutex>  // NOLINT
-#include <string>
+#include <algorithm>
+#include <cmath>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "theia/image/image.h"
+#include "theia/image/image_loader.h"
+#include "theia/image/keypoint_detector/keypoint.h"
 #include "theia/sfm/reconstruction.h"
 #include "theia/sfm/track.h"
 #include "theia/sfm/types.h"
@@ -52,38 +58,126 @@
 namespace theia {
 namespace {
 
+// The sum of the colors of the observations of each track, indexed by the
+// position of the track in the sorted track ids.
+struct ColorAccumulator {
+  explicit ColorAccumulator(const int num_tracks)
+      : color_sums(num_tracks, Eigen::Vector3f::Zero()),
+        num_observations(num_tracks, 0) {}
+
+  void Add(const ColorAccumulator& accumulator) {
+    for (int i = 0; i < color_sums.size(); i++) {
+      color_sums[i] += accumulator.color_sums[i];
+      num_observations[i] += accumulator.num_observations[i];
+    }
+  }
+
+  std::vector<Eigen::Vector3f> color_sums;
+  std::vector<int> num_observations;
+};
+
+// Returns the pixel of the image nearest to the feature, which is given in the
+// coordinates of the original image.
+void NearestPixel(const FloatImage& image,
+                  const Eigen::Vector2d& scale,
+                  const Feature& feature,
+                  int* x,
+                  int* y) {
+  // Pixel centers are at integer coordinates (see
+  // ScaleKeypointsToOriginalImage).
+  *x = static_cast<int>(std::floor((feature.x() + 0.5) / scale.x()));
+  *y = static_cast<int>(std::floor((feature.y() + 0.5) / scale.y()));
+  *x = std::min(std::max(*x, 0), image.Width() - 1);
+  *y = std::min(std::max(*y, 0), image.Height() - 1);
+}
+
+Eigen::Vector3f PixelColor(const FloatImage& image, const int x, const int y) {
+  if (image.Channels() == 1) {
+    return Eigen::Vector3f::Constant(image(x, y, 0));
+  }
+  return Eigen::Vector3f(image(x, y, 0), image(x, y, 1), image(x, y, 2));
+}
+
 void ExtractColorsFromImage(
-    const std::string& image_file,
+    const LoadedImage& loaded_image,
     const View& view,
-    std::unordered_map<TrackId, Eigen::Vector3f>* colors,
-    std::mutex* mutex_lock) {
-  LOG(INFO) << "Extracting color for features in image: " << image_file;
-  const FloatImage image(image_file);
-
-  const auto& track_ids = view.TrackIds();
-  if (image.Channels() == 3) {
-    for (const TrackId track_id : track_ids) {
-      const Feature feature = *view.GetFeature(track_id);
-      const int x = static_cast<int>(feature.x());
-      const int y = static_cast<int>(feature.y());
-      std::lock_guard<std::mutex> lock(*mutex_lock);
-      (*colors)[track_id] +=
-          Eigen::Vector3f(image(x, y, 0), image(x, y, 1), image(x, y, 2));
-    }
-  } else if (image.Channels() == 1) {
-    for (const TrackId track_id : track_ids) {
-      const Feature feature = *view.GetFeature(track_id);
-      const int x = static_cast<int>(feature.x());
-      const int y = static_cast<int>(feature.y());
-      std::lock_guard<std::mutex> lock(*mutex_lock);
-      (*colors)[track_id] +=
-          Eigen::Vector3f(image(x, y, 0), image(x, y, 0), image(x, y, 0));
-    }
-  } else {
-    LOG(FATAL) << "The image file at: " << image_file
+    const std::unordered_map<TrackId, int>& track_indices,
+    ColorAccumulator* accumulator) {
+  const FloatImage& image = *loaded_image.image;
+  if (image.Channels() != 3 && image.Channels() != 1) {
+    LOG(FATAL) << "The image file at: " << loaded_image.filepath
                << " is not an RGB or a grayscale image so the color cannot be "
                   "extracted.";
   }
+
+  for (const TrackId track_id : view.TrackIds()) {
+    const int* track_index = FindOrNull(track_indices, track_id);
+    if (track_index == nullptr) {
+      continue;
+    }
+
+    int x, y;
+    NearestPixel(image, loaded_image.scale, *view.GetFeature(track_id), &x, &y);
+    accumulator->color_sums[*track_index] += PixelColor(image, x, y);
+    ++accumulator->num_observations[*track_index];
+  }
+}
+
+// Extracts the colors of the images returned by the image loader until all
+// images are processed.
+void ExtractColorsFromImages(
+    const Reconstruction& reconstruction,
+    const std::vector<ViewId>& view_ids,
+    const std::unordered_map<TrackId, int>& track_indices,
+    StreamingImageLoader* image_loader,
+    ColorAccumulator* accumulator) {
+  LoadedImage loaded_image;
+  while (image_loader->GetNextImage(&loaded_image)) {
+    CHECK(loaded_image.success) << "Could not read the image file: "
+                                << loaded_image.filepath;
+    VLOG(2) << "Extracting color for features in image: "
+            << loaded_image.filepath;
+    ExtractColorsFromImage(loaded_image,
+                           *reconstruction.View(view_ids[loaded_image.index]),
+                           track_indices,
+                           accumulator);
+  }
+}
+
+// Sets the color of each track to the mean of its accumulated colors.
+void SetTrackColors(const std::vector<TrackId>& track_ids,
+                    const ColorAccumulator& accumulator,
+                    Reconstruction* reconstruction) {
+  for (int i = 0; i < track_ids.size(); i++) {
+    Track* track = reconstruction->MutableTrack(track_ids[i]);
+    if (accumulator.num_observations[i] == 0) {
+      track->MutableColor()->setZero();
+      continue;
+    }
+    const Eigen::Vector3f color =
+        accumulator.color_sums[i] / accumulator.num_observations[i];
+    *track->MutableColor() = color.cast<uint8_t>();
+  }
+}
+
+// Assigns a compact index to each track so that colors can be accumulated in
+// arrays rather than maps.
+void GetTrackIndices(const Reconstruction& reconstruction,
+                     std::vector<TrackId>* track_ids,
+                     std::unordered_map<TrackId, int>* track_indices) {
+  *track_ids = reconstruction.TrackIds();
+  std::sort(track_ids->begin(), track_ids->end());
+  track_indices->reserve(track_ids->size());
+  for (int i = 0; i < track_ids->size(); i++) {
+    track_indices->emplace((*track_ids)[i], i);
+  }
+}
+
+// Orders positions lexicographically.
+bool PositionIsLess(const Eigen::Vector2f& position1,
+                    const Eigen::Vector2f& position2) {
+  return position1.x() < position2.x() ||
+         (position1.x() == position2.x() && position1.y() < position2.y());
 }
 
 }  // namespace
@@ -96,41 +190,125 @@ void ColorizeReconstruction(const std::string& image_directory,
   CHECK_GT(num_threads, 0);
   CHECK_NOTNULL(reconstruction);
 
-  std::unique_ptr<ThreadPool> pool(new ThreadPool(num_threads));
-  std::mutex mutex_lock;
+  std::vector<TrackId> track_ids;
+  std::unordered_map<TrackId, int> track_indices;
+  GetTrackIndices(*reconstruction, &track_ids, &track_indices);
 
-  // Initialize the colors to be (0, 0, 0).
-  const auto& track_ids = reconstruction->TrackIds();
-  std::unordered_map<TrackId, Eigen::Vector3f> colors;
-  for (const TrackId track_id : track_ids) {
-    colors[track_id].setZero();
+  const std::vector<ViewId> view_ids = reconstruction->ViewIds();
+  std::vector<std::string> image_filepaths(view_ids.size());
+  for (int i = 0; i < view_ids.size(); i++) {
+    image_filepaths[i] =
+        image_directory + reconstruction->View(view_ids[i])->Name();
+    CHECK(FileExists(image_filepaths[i])) << "The image file: "
+                                          << image_filepaths[i]
+                                          << " does not exist!";
   }
 
+  // Decode the images in the background while they are colorized, keeping at
+  // most num_threads images in the buffer.
+  ImageLoaderOptions image_loader_options;
+  image_loader_options.num_threads = num_threads;
+  image_loader_options.max_num_buffered_images = num_threads;
+  StreamingImageLoader image_loader(image_loader_options, image_filepaths);
+
   // For each image, find the color of each feature and add the value to the
-  // colors map.
-  const auto& view_ids = reconstruction->ViewIds();
-  for (const ViewId view_id : view_ids) {
-    const View* view = reconstruction->View(view_id);
-    const std::string image_filepath = image_directory + view->Name();
-    CHECK(FileExists(image_filepath)) << "The image file: " << image_filepath
-                                      << " does not exist!";
-    pool->Add(ExtractColorsFromImage,
-              image_filepath,
-              *view,
-              &colors,
-              &mutex_lock);
+  // accumulator of the thread.
+  std::vector<ColorAccumulator> accumulators(
+      num_threads, ColorAccumulator(track_ids.size()));
+  {
+    ThreadPool pool(num_threads);
+    for (int i = 0; i < num_threads; i++) {
+      pool.Add(ExtractColorsFromImages,
+               std::cref(*reconstruction),
+               std::cref(view_ids),
+               std::cref(track_indices),
+               &image_loader,
+               &accumulators[i]);
+    }
   }
-  pool.reset(nullptr);
 
-  // The colors map now contains a sum of all colors, so to get the mean we must
+  // The accumulators contain a sum of all colors, so to get the mean we must
   // divide by the number of observations in each track.
-  for (const TrackId track_id : track_ids) {
-    Eigen::Vector3f color = FindOrDie(colors, track_id);
+  for (int i = 1; i < num_threads; i++) {
+    accumulators[0].Add(accumulators[i]);
+  }
+  SetTrackColors(track_ids, accumulators[0], reconstruction);
+}
 
-    Track* track = reconstruction->MutableTrack(track_id);
-    color /= static_cast<float>(track->NumViews());
-    *track->MutableColor() = color.cast<uint8_t>();
+KeypointColors::KeypointColors(const FloatImage& image,
+                               const Eigen::Vector2d& scale,
+                               const std::vector<Keypoint>& keypoints) {
+  CHECK(image.Channels() == 3 || image.Channels() == 1)
+      << "The image is not an RGB or a grayscale image so the color cannot be "
+         "extracted.";
+  keypoints_.resize(keypoints.size());
+  for (int i = 0; i < keypoints.size(); i++) {
+    const Feature feature(keypoints[i].x(), keypoints[i].y());
+    int x, y;
+    NearestPixel(image, scale, feature, &x, &y);
+    const Eigen::Vector3f color = PixelColor(image, x, y);
+
+    keypoints_[i].x = static_cast<float>(feature.x());
+    keypoints_[i].y = static_cast<float>(feature.y());
+    for (int c = 0; c < 3; c++) {
+      keypoints_[i].color[c] = static_cast<uint8_t>(color[c]);
+    }
+  }
+
+  std::sort(keypoints_.begin(), keypoints_.end(),
+            [](const ColoredKeypoint& keypoint1,
+               const ColoredKeypoint& keypoint2) {
+              return PositionIsLess(Eigen::Vector2f(keypoint1.x, keypoint1.y),
+                                    Eigen::Vector2f(keypoint2.x, keypoint2.y));
+            });
+}
+
+bool KeypointColors::GetColor(const Feature& feature,
+                              Eigen::Matrix<uint8_t, 3, 1>* color) const {
+  const Eigen::Vector2f position = feature.cast<float>();
+  const auto it = std::lower_bound(
+      keypoints_.begin(), keypoints_.end(), position,
+      [](const ColoredKeypoint& keypoint, const Eigen::Vector2f& position) {
+        return PositionIsLess(Eigen::Vector2f(keypoint.x, keypoint.y),
+                              position);
+      });
+  if (it == keypoints_.end() || it->x != position.x() ||
+      it->y != position.y()) {
+    return false;
+  }
+
+  *CHECK_NOTNULL(color) << it->color[0], it->color[1], it->color[2];
+  return true;
+}
+
+void ColorizeReconstructionFromKeypointColors(
+    const std::unordered_map<std::string, KeypointColors>& keypoint_colors,
+    Reconstruction* reconstruction) {
+  CHECK_NOTNULL(reconstruction);
+
+  std::vector<TrackId> track_ids;
+  std::unordered_map<TrackId, int> track_indices;
+  GetTrackIndices(*reconstruction, &track_ids, &track_indices);
+
+  ColorAccumulator accumulator(track_ids.size());
+  for (const ViewId view_id : reconstruction->ViewIds()) {
+    const View* view = reconstruction->View(view_id);
+    const KeypointColors* colors = FindOrNull(keypoint_colors, view->Name());
+    if (colors == nullptr) {
+      continue;
+    }
+
+    for (const TrackId track_id : view->TrackIds()) {
+      Eigen::Matrix<uint8_t, 3, 1> color;
+      if (!colors->GetColor(*view->GetFeature(track_id), &color)) {
+        continue;
+      }
+      const int track_index = FindOrDie(track_indices, track_id);
+      accumulator.color_sums[track_index] += color.cast<float>();
+      ++accumulator.num_observations[track_index];
+    }
   }
+  SetTrackColors(track_ids, accumulator, reconstruction);
 }
 
 }  // namespace theia
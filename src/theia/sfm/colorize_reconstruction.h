@@ -35,7 +35,15 @@
 #ifndef THEIA_SFM_COLORIZE_RECONSTRUCTION_H_
 #define THEIA_SFM_COLORIZE_RECONSTRUCTION_H_
 
+#include <Eigen/Core>
+#include <stdint.h>
 #include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "theia/image/image.h"
+#include "theia/image/keypoint_detector/keypoint.h"
+#include "theia/sfm/feature.h"
 
 namespace theia {
 
@@ -46,11 +54,55 @@ class Reconstruction;
 // observations that see the point. All images must be contained in the image
 // directory. This task is easily parallelizable and multithreading may be used.
 //
+// The images are decoded ahead of their use by num_threads threads, with at
+// most num_threads images buffered at any time. Each thread sums the colors of
+// its images into its own array indexed by the track, and the arrays are
+// reduced once all images are processed so that no locking is needed.
+//
 // NOTE: Currently, we simply take the nearest pixel value.
 void ColorizeReconstruction(const std::string& image_directory,
                             const int num_threads,
                             Reconstruction* reconstruction);
 
+// The colors of the keypoints of an image. The colors may be recorded while the
+// features are extracted (see FeatureExtractorAndMatcher::Options) so that the
+// reconstruction can be colored without reading the images again. Colors are
+// looked up by the exact position of the keypoint, which is the position of the
+// feature in the reconstruction.
+class KeypointColors {
+ public:
+  KeypointColors() {}
+
+  // Records the colors of the image at the keypoints. The keypoints are in the
+  // coordinates of the original image, and scale is the ratio of the original
+  // image dimensions to the dimensions of the image (see LoadImage).
+  KeypointColors(const FloatImage& image,
+                 const Eigen::Vector2d& scale,
+                 const std::vector<Keypoint>& keypoints);
+
+  int NumKeypoints() const { return keypoints_.size(); }
+
+  // Returns false if no color was recorded for the feature.
+  bool GetColor(const Feature& feature,
+                Eigen::Matrix<uint8_t, 3, 1>* color) const;
+
+ private:
+  struct ColoredKeypoint {
+    float x, y;
+    uint8_t color[3];
+  };
+
+  // Sorted by position so that colors are found with a binary search.
+  std::vector<ColoredKeypoint> keypoints_;
+};
+
+// Colors the points of the reconstruction with the mean color of the
+// keypoints that observe them. The keypoint colors are given for each view
+// name. Observations without a keypoint color are ignored.
+void ColorizeReconstructionFromKeypointColors(
+    const std::unordered_map<std::string, KeypointColors>& keypoint_colors,
+    Reconstruction* reconstruction);
+
 }  // namespace theia
 
 #endif  // THEIA_SFM_COLORIZE_RECONSTRUCTION_H_
@@ -0,0 +1,136 @@
+// Copyright (C) 2016 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include <Eigen/Core>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "theia/image/image.h"
+#include "theia/image/keypoint_detector/keypoint.h"
+#include "theia/sfm/colorize_reconstruction.h"
+#include "theia/sfm/reconstruction.h"
+#include "theia/sfm/track.h"
+#include "theia/sfm/types.h"
+
+namespace theia {
+
+namespace {
+
+typedef Eigen::Matrix<uint8_t, 3, 1> Color;
+
+// An image where the color of each pixel is determined by its position.
+FloatImage CreateImage() {
+  FloatImage image(40, 30, 3);
+  for (int y = 0; y < image.Height(); y++) {
+    for (int x = 0; x < image.Width(); x++) {
+      image(x, y, 0) = x;
+      image(x, y, 1) = y;
+      image(x, y, 2) = x + y;
+    }
+  }
+  return image;
+}
+
+}  // namespace
+
+TEST(KeypointColors, GetColor) {
+  const FloatImage image = CreateImage();
+  const std::vector<Keypoint> keypoints = {
+    Keypoint(10.2, 20.4, Keypoint::OTHER),
+    Keypoint(3.0, 7.0, Keypoint::OTHER),
+    Keypoint(39.4, 0.1, Keypoint::OTHER)
+  };
+  const KeypointColors keypoint_colors(image, Eigen::Vector2d::Ones(),
+                                       keypoints);
+  EXPECT_EQ(keypoint_colors.NumKeypoints(), 3);
+
+  Color color;
+  EXPECT_TRUE(keypoint_colors.GetColor(Feature(10.2, 20.4), &color));
+  EXPECT_EQ(color, Color(10, 20, 30));
+  EXPECT_TRUE(keypoint_colors.GetColor(Feature(3.0, 7.0), &color));
+  EXPECT_EQ(color, Color(3, 7, 10));
+  EXPECT_TRUE(keypoint_colors.GetColor(Feature(39.4, 0.1), &color));
+  EXPECT_EQ(color, Color(39, 0, 39));
+
+  // Features that are not keypoints have no color.
+  EXPECT_FALSE(keypoint_colors.GetColor(Feature(3.0, 7.5), &color));
+  EXPECT_FALSE(keypoint_colors.GetColor(Feature(50.0, 7.0), &color));
+}
+
+TEST(KeypointColors, DownscaledImage) {
+  // The image was decoded at half of the original resolution so the keypoints
+  // are twice as far from the origin.
+  const FloatImage image = CreateImage();
+  const std::vector<Keypoint> keypoints = {
+    Keypoint(20.5, 40.5, Keypoint::OTHER)
+  };
+  const KeypointColors keypoint_colors(image, Eigen::Vector2d(2.0, 2.0),
+                                       keypoints);
+
+  Color color;
+  EXPECT_TRUE(keypoint_colors.GetColor(Feature(20.5, 40.5), &color));
+  EXPECT_EQ(color, Color(10, 20, 30));
+}
+
+TEST(ColorizeReconstructionFromKeypointColors, MeanColorOfObservations) {
+  const FloatImage image = CreateImage();
+  Reconstruction reconstruction;
+  const ViewId view_id1 = reconstruction.AddView("1");
+  const ViewId view_id2 = reconstruction.AddView("2");
+  const ViewId view_id3 = reconstruction.AddView("3");
+
+  const Feature feature1(2.0, 4.0), feature2(6.0, 8.0), feature3(1.0, 1.0);
+  const TrackId track_id = reconstruction.AddTrack(
+      {{view_id1, feature1}, {view_id2, feature2}, {view_id3, feature3}});
+
+  // The third view has no keypoint colors and is ignored.
+  std::unordered_map<std::string, KeypointColors> keypoint_colors;
+  keypoint_colors.emplace(
+      "1",
+      KeypointColors(image, Eigen::Vector2d::Ones(),
+                     {Keypoint(2.0, 4.0, Keypoint::OTHER)}));
+  keypoint_colors.emplace(
+      "2",
+      KeypointColors(image, Eigen::Vector2d::Ones(),
+                     {Keypoint(6.0, 8.0, Keypoint::OTHER),
+                      Keypoint(1.0, 1.0, Keypoint::OTHER)}));
+
+  ColorizeReconstructionFromKeypointColors(keypoint_colors, &reconstruction);
+  EXPECT_EQ(reconstruction.Track(track_id)->Color(), Color(4, 6, 10));
+}
+
+}  // namespace theia
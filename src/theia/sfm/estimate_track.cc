@@ -35,92 +35,108 @@
 #include "theia/sfm/estimate_track.h"
 
 #include <Eigen/Core>
+#include <Eigen/Cholesky>
 #include <Eigen/Geometry>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "theia/math/util.h"
 #include "theia/sfm/bundle_adjustment/bundle_adjustment.h"
-#include "theia/sfm/estimators/estimate_triangulation.h"
+#include "theia/sfm/camera/camera.h"
+#include "theia/sfm/camera/radial_distortion.h"
+#include "theia/sfm/camera/radial_undistortion_table.h"
 #include "theia/sfm/feature.h"
 #include "theia/sfm/reconstruction.h"
-#include "theia/sfm/reconstruction_estimator_utils.h"
 #include "theia/sfm/track.h"
-#include "theia/sfm/triangulation/triangulation.h"
 #include "theia/sfm/types.h"
 #include "theia/util/map_util.h"
+#include "theia/util/profiler.h"
 #include "theia/util/threadpool.h"
 
 namespace theia {
 
 namespace {
 
-void GetObservationsFromTrackViews(
-    const TrackId track_id,
-    const Reconstruction& reconstruction,
-    std::vector<ViewId>* view_ids,
-    std::vector<Eigen::Vector3d>* origins,
-    std::vector<Eigen::Vector3d>* ray_directions) {
-  const Track track = *reconstruction.Track(track_id);
-  for (const ViewId view_id : track.ViewIds()) {
-    const View* view = reconstruction.View(view_id);
-
-    // Skip this view if it does not exist or has not been estimated yet.
-    if (view == nullptr || !view->IsEstimated()) {
-      continue;
-    }
-
-    // If the feature is not in the view then we have an ill-formed
-    // reconstruction.
-    const Feature* feature = CHECK_NOTNULL(view->GetFeature(track_id));
-    const Eigen::Vector3d image_ray =
-        view->Camera().PixelToUnitDepthRay(*feature).normalized();
-
-    view_ids->emplace_back(view_id);
-    origins->emplace_back(view->Camera().GetPosition());
-    ray_directions->emplace_back(image_ray);
+// The minimum number of observations of the tracks to estimate for which a view
+// builds a lookup table to remove the radial distortion.
+static const int kMinNumObservationsForUndistortionTable = 1000;
+
+// Returns the unit-norm ray through the pixel in the world frame, given the
+// rotation matrix of the camera. If the undistortion table is not null it is
+// used to remove the radial distortion.
+Eigen::Vector3d PixelToRay(const Camera& camera,
+                           const Eigen::Matrix3d& rotation,
+                           const RadialUndistortionTable* undistortion_table,
+                           const Feature& pixel) {
+  // First, undo the calibration.
+  const Eigen::Vector2d normalized_point = camera.PixelToNormalizedPoint(pixel);
+
+  // Undo radial distortion.
+  Eigen::Vector2d undistorted_point;
+  if (undistortion_table != nullptr) {
+    undistortion_table->UndistortPoint(normalized_point, &undistorted_point);
+  } else {
+    RadialUndistortPoint(normalized_point,
+                         camera.RadialDistortion1(),
+                         camera.RadialDistortion2(),
+                         &undistorted_point);
   }
-}
 
-// Returns false if the reprojection error of the triangulated point is greater
-// than the max allowable reprojection error (for any observation) and true
-// otherwise.
-bool AcceptableReprojectionError(
-    const Reconstruction& reconstruction,
-    const TrackId& track_id,
-    const double sq_max_reprojection_error_pixels) {
-  const Track& track = *reconstruction.Track(track_id);
-  int num_projections = 0;
-  double mean_sq_reprojection_error = 0;
-  for (const ViewId view_id : track.ViewIds()) {
-    const View* view = reconstruction.View(view_id);
-    if (view == nullptr || !view->IsEstimated()) {
-      continue;
-    }
-    const Camera& camera = view->Camera();
-    const Feature* feature = view->GetFeature(track_id);
-    Eigen::Vector2d reprojection;
-    if (camera.ProjectPoint(track.Point(), &reprojection) < 0) {
-      return false;
-    }
+  // Apply rotation.
+  return (rotation.transpose() * undistorted_point.homogeneous()).normalized();
+}
 
-    mean_sq_reprojection_error += (*feature - reprojection).squaredNorm();
-    ++num_projections;
-  }
+// Projects the homogeneous point into the camera given the rotation matrix and
+// position of the camera. This is equivalent to Camera::ProjectPoint but does
+// not convert the orientation of the camera for each point. Returns the depth
+// of the point.
+double ProjectPoint(const Camera& camera,
+                    const Eigen::Matrix3d& rotation,
+                    const Eigen::Vector3d& position,
+                    const Eigen::Vector4d& point,
+                    Eigen::Vector2d* pixel) {
+  const Eigen::Vector3d rotated_point =
+      rotation * (point.head<3>() - point[3] * position);
+  *pixel = camera.NormalizedPointToPixel(rotated_point.hnormalized());
+  return rotated_point[2] / point[3];
+}
 
-  return (mean_sq_reprojection_error / static_cast<double>(num_projections)) <
-         sq_max_reprojection_error_pixels;
+// Returns true if at least one pair of rays has an angle larger than the
+// minimum triangulation angle. The cosines of all angles are computed at once
+// from the Gram matrix of the (unit-norm) rays.
+bool HasSufficientTriangulationAngle(
+    const Eigen::Ref<const Eigen::Matrix3Xd>& ray_directions,
+    const double cos_of_min_angle) {
+  return (ray_directions.transpose() * ray_directions).minCoeff() <
+         cos_of_min_angle;
 }
 
-int NumEstimatedViewsObservingTrack(const Reconstruction& reconstruction,
-                                    const Track& track) {
-  int num_estimated_views = 0;
-  for (const ViewId view_id : track.ViewIds()) {
-    const View* view = reconstruction.View(view_id);
-    if (view != nullptr && view->IsEstimated()) {
-      ++num_estimated_views;
-    }
+// Triangulates the point that minimizes the sum of squared distances to all
+// rays. This is the same as TriangulateMidpoint, but the normal equations are
+// formed directly from the ray buffers.
+bool TriangulateMidpointFromRays(
+    const Eigen::Ref<const Eigen::Matrix3Xd>& origins,
+    const Eigen::Ref<const Eigen::Matrix3Xd>& directions,
+    Eigen::Vector4d* triangulated_point) {
+  //   sum_i (I - d_i * d_i^t) * X = sum_i (I - d_i * d_i^t) * c_i
+  const Eigen::Matrix3d lhs =
+      directions.cols() * Eigen::Matrix3d::Identity() -
+      directions * directions.transpose();
+  const Eigen::Vector3d rhs =
+      origins.rowwise().sum() -
+      directions *
+          directions.cwiseProduct(origins).colwise().sum().transpose();
+
+  const Eigen::LDLT<Eigen::Matrix3d> ldlt(lhs);
+  if (ldlt.info() != Eigen::Success) {
+    return false;
   }
-  return num_estimated_views;
+  *triangulated_point = ldlt.solve(rhs).homogeneous();
+  return triangulated_point->allFinite();
 }
 
 }  // namespace
@@ -134,8 +150,9 @@ TrackEstimator::Summary TrackEstimator::EstimateAllTracks() {
 
 TrackEstimator::Summary TrackEstimator::EstimateTracks(
     const std::unordered_set<TrackId>& track_ids) {
+  ScopedProfile profile("EstimateTracks");
   tracks_to_estimate_.clear();
-  successfully_estimated_tracks_.clear();
+  CacheEstimatedViews();
 
   TrackEstimator::Summary summary;
 
@@ -148,13 +165,23 @@ TrackEstimator::Summary TrackEstimator::EstimateTracks(
       continue;
     }
 
-    const int num_views_observing_track =
-        NumEstimatedViewsObservingTrack(*reconstruction_, *track);
+    int num_views_observing_track = 0;
+    for (const ViewId view_id : track->ViewIds()) {
+      if (ContainsKey(estimated_views_, view_id)) {
+        ++num_views_observing_track;
+      }
+    }
     // Skip tracks that do not have enough observations.
     if (num_views_observing_track < 2) {
       continue;
     }
     tracks_to_estimate_.emplace_back(track_id);
+    for (const ViewId view_id : track->ViewIds()) {
+      EstimatedView* estimated_view = FindOrNull(estimated_views_, view_id);
+      if (estimated_view != nullptr) {
+        ++estimated_view->num_observations;
+      }
+    }
   }
   summary.num_triangulation_attempts = tracks_to_estimate_.size();
 
@@ -163,8 +190,10 @@ TrackEstimator::Summary TrackEstimator::EstimateTracks(
     return summary;
   }
 
+  CacheUndistortionTables();
+
   // Estimate the tracks in parallel. Instead of 1 threadpool worker per track,
-  // we let each worker estimate a fixed number of tracks at a time (e.g. 20
+  // we let each worker estimate a batch of tracks at a time (e.g. 100
   // tracks). Since estimating the tracks is so fast, this strategy is better
   // helps speed up multithreaded estimation by reducing the overhead of
   // starting/stopping threads.
@@ -197,63 +226,182 @@ TrackEstimator::Summary TrackEstimator::EstimateTracks(
   return summary;
 }
 
-void TrackEstimator::EstimateTrackSet(const int start, const int end) {
-  for (int i = start; i < end; i++) {
-    EstimateTrack(tracks_to_estimate_[i]);
+void TrackEstimator::CacheEstimatedViews() {
+  estimated_views_.clear();
+  for (const ViewId view_id : reconstruction_->ViewIds()) {
+    const View* view = reconstruction_->View(view_id);
+    if (!view->IsEstimated()) {
+      continue;
+    }
+
+    EstimatedView& estimated_view = estimated_views_[view_id];
+    estimated_view.view = view;
+    estimated_view.rotation = view->Camera().GetOrientationAsRotationMatrix();
+    estimated_view.position = view->Camera().GetPosition();
   }
 }
 
-bool TrackEstimator::EstimateTrack(const TrackId track_id) {
-  Track* track = reconstruction_->MutableTrack(track_id);
-  CHECK(!track->IsEstimated()) << "Track " << track_id
-                               << " is already estimated.";
-
-  // Gather projection matrices and features.
-  std::vector<ViewId> view_ids;
-  std::vector<Eigen::Vector3d> origins, ray_directions;
-  GetObservationsFromTrackViews(track_id,
-                                *reconstruction_,
-                                &view_ids,
-                                &origins,
-                                &ray_directions);
-
-  // Check the angle between views.
-  if (!SufficientTriangulationAngle(ray_directions,
-                                    options_.min_triangulation_angle_degrees)) {
-    return false;
+void TrackEstimator::CacheUndistortionTables() {
+  for (auto& estimated_view : estimated_views_) {
+    const Camera& camera = estimated_view.second.view->Camera();
+    if (estimated_view.second.num_observations <
+            kMinNumObservationsForUndistortionTable ||
+        (camera.RadialDistortion1() == 0 && camera.RadialDistortion2() == 0)) {
+      continue;
+    }
+    estimated_view.second.undistortion_table.reset(
+        new RadialUndistortionTable(camera));
   }
+}
 
-  // Triangulate the track.
-  if (!TriangulateMidpoint(origins, ray_directions, track->MutablePoint())) {
-    return false;
+void TrackEstimator::EstimateTrackSet(const int start, const int end) {
+  const int num_tracks = end - start;
+
+  // Gather the observations of all tracks in the batch into contiguous
+  // buffers. The observations of track i are in the columns
+  // [observation_offsets[i], observation_offsets[i + 1]).
+  int max_num_observations = 0;
+  for (int i = start; i < end; i++) {
+    max_num_observations +=
+        reconstruction_->Track(tracks_to_estimate_[i])->NumViews();
+  }
+  std::vector<int> observation_offsets(num_tracks + 1);
+  std::vector<const EstimatedView*> observed_views(max_num_observations);
+  Eigen::Matrix2Xd features(2, max_num_observations);
+  Eigen::Matrix3Xd origins(3, max_num_observations);
+  Eigen::Matrix3Xd ray_directions(3, max_num_observations);
+  int num_observations = 0;
+  for (int i = 0; i < num_tracks; i++) {
+    observation_offsets[i] = num_observations;
+    const TrackId track_id = tracks_to_estimate_[start + i];
+    for (const ViewId view_id : reconstruction_->Track(track_id)->ViewIds()) {
+      // Skip this view if it does not exist or has not been estimated yet.
+      const EstimatedView* estimated_view =
+          FindOrNull(estimated_views_, view_id);
+      if (estimated_view == nullptr) {
+        continue;
+      }
+
+      // If the feature is not in the view then we have an ill-formed
+      // reconstruction.
+      features.col(num_observations) =
+          *CHECK_NOTNULL(estimated_view->view->GetFeature(track_id));
+      origins.col(num_observations) = estimated_view->position;
+      observed_views[num_observations] = estimated_view;
+      ++num_observations;
+    }
+  }
+  observation_offsets[num_tracks] = num_observations;
+
+  for (int i = 0; i < num_observations; i++) {
+    ray_directions.col(i) =
+        PixelToRay(observed_views[i]->view->Camera(),
+                   observed_views[i]->rotation,
+                   observed_views[i]->undistortion_table.get(),
+                   features.col(i));
   }
 
-  // Bundle adjust the track. The 2-view triangulation method is optimal so we
-  // do not need to run BA for that case.
-  if (options_.bundle_adjustment) {
-    track->SetEstimated(true);
+  // Triangulate all tracks that have a sufficient triangulation angle.
+  const double cos_of_min_angle =
+      std::cos(DegToRad(options_.min_triangulation_angle_degrees));
+  std::vector<Eigen::Vector4d> points(num_tracks);
+  std::vector<bool> is_triangulated(num_tracks, false);
+  std::unordered_set<TrackId> triangulated_tracks;
+  for (int i = 0; i < num_tracks; i++) {
+    const int first = observation_offsets[i];
+    const int num_track_observations = observation_offsets[i + 1] - first;
+    if (num_track_observations < 2 ||
+        !HasSufficientTriangulationAngle(
+            ray_directions.middleCols(first, num_track_observations),
+            cos_of_min_angle)) {
+      continue;
+    }
+
+    if (TriangulateMidpointFromRays(
+            origins.middleCols(first, num_track_observations),
+            ray_directions.middleCols(first, num_track_observations),
+            &points[i])) {
+      is_triangulated[i] = true;
+      triangulated_tracks.insert(tracks_to_estimate_[start + i]);
+    }
+  }
+
+  // Bundle adjust all triangulated tracks of the batch together.
+  if (options_.bundle_adjustment && !triangulated_tracks.empty()) {
+    for (const TrackId track_id : triangulated_tracks) {
+      reconstruction_->MutableTrack(track_id)->SetEstimated(true);
+    }
+    for (int i = 0; i < num_tracks; i++) {
+      if (is_triangulated[i]) {
+        *reconstruction_->MutableTrack(tracks_to_estimate_[start + i])
+             ->MutablePoint() = points[i];
+      }
+    }
+
     BundleAdjustmentOptions ba_options;
     const BundleAdjustmentSummary summary =
-        BundleAdjustTrack(ba_options, track_id, reconstruction_);
-    track->SetEstimated(false);
-    if (!summary.success) {
-      return false;
+        BundleAdjustTracks(ba_options, triangulated_tracks, reconstruction_);
+    for (int i = 0; i < num_tracks; i++) {
+      if (!is_triangulated[i]) {
+        continue;
+      }
+
+      const TrackId track_id = tracks_to_estimate_[start + i];
+      Track* track = reconstruction_->MutableTrack(track_id);
+      // A single poorly conditioned track can make the bundle adjustment of
+      // the whole batch fail. In that case the tracks are bundle adjusted one
+      // at a time from their triangulated points so that only the failing
+      // tracks are discarded.
+      if (!summary.success) {
+        *track->MutablePoint() = points[i];
+        is_triangulated[i] =
+            BundleAdjustTrack(ba_options, track_id, reconstruction_).success;
+      }
+      track->SetEstimated(false);
+      points[i] = track->Point();
     }
   }
 
-  // Ensure the reprojection errors are acceptable.
+  // Ensure the reprojection errors are acceptable and write back the
+  // results.
   const double sq_max_reprojection_error_pixels =
       options_.max_acceptable_reprojection_error_pixels *
       options_.max_acceptable_reprojection_error_pixels;
+  for (int i = 0; i < num_tracks; i++) {
+    if (!is_triangulated[i]) {
+      continue;
+    }
 
-  if (!AcceptableReprojectionError(*reconstruction_,
-                                   track_id,
-                                   sq_max_reprojection_error_pixels)) {
-    return false;
-  }
+    const int first = observation_offsets[i];
+    const int last = observation_offsets[i + 1];
+    bool point_is_in_front_of_cameras = true;
+    double sq_reprojection_error_sum = 0;
+    for (int j = first; j < last; j++) {
+      const EstimatedView& estimated_view = *observed_views[j];
+      Eigen::Vector2d reprojection;
+      if (ProjectPoint(estimated_view.view->Camera(),
+                       estimated_view.rotation,
+                       estimated_view.position,
+                       points[i],
+                       &reprojection) < 0) {
+        point_is_in_front_of_cameras = false;
+        break;
+      }
+      sq_reprojection_error_sum +=
+          (features.col(j) - reprojection).squaredNorm();
+    }
+
+    if (!point_is_in_front_of_cameras ||
+        sq_reprojection_error_sum / static_cast<double>(last - first) >=
+            sq_max_reprojection_error_pixels) {
+      continue;
+    }
 
-  track->SetEstimated(true);
-  return true;
+    Track* track =
+        reconstruction_->MutableTrack(tracks_to_estimate_[start + i]);
+    *track->MutablePoint() = points[i];
+    track->SetEstimated(true);
+  }
 }
 
 }  // namespace theia
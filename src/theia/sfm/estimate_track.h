@@ -35,11 +35,17 @@
 #ifndef THEIA_SFM_ESTIMATE_TRACK_H_
 #define THEIA_SFM_ESTIMATE_TRACK_H_
 
+#include <Eigen/Core>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 #include "theia/sfm/bundle_adjustment/bundle_adjustment.h"
+#include "theia/sfm/camera/radial_undistortion_table.h"
 #include "theia/sfm/reconstruction.h"
 #include "theia/sfm/types.h"
-
-#include <unordered_set>
+#include "theia/sfm/view.h"
 
 namespace theia {
 
@@ -63,13 +69,16 @@ class TrackEstimator {
     // of views has this an angle this large.
     double min_triangulation_angle_degrees = 3.0;
 
-    // Perform bundle adjustment on the track as soon as a position is
-    // estimated.
+    // Perform bundle adjustment on the tracks as soon as their positions are
+    // estimated. The tracks of each batch (see below) are bundle adjusted
+    // together. If that fails, the tracks are bundle adjusted individually.
     bool bundle_adjustment = true;
 
-    // For thread-level parallelism, it is better to estimate a small fixed
-    // number of tracks per thread worker instead of 1 track per worker. This
-    // number controls how many points are estimated per worker.
+    // Tracks are estimated in batches: the observations of all tracks in a
+    // batch are gathered into contiguous buffers once and all tracks of the
+    // batch are then triangulated, verified and (optionally) bundle adjusted
+    // together. Each thread worker estimates one batch at a time. This number
+    // controls how many tracks are in each batch.
     int multithreaded_step_size = 100;
   };
 
@@ -101,13 +110,32 @@ class TrackEstimator {
   Summary EstimateTracks(const std::unordered_set<TrackId>& track_ids);
 
  private:
-  void EstimateTrackSet(const int start, const int stop);
-  bool EstimateTrack(const TrackId track_id);
+  // An estimated view along with its camera pose. The rotation matrix is
+  // computed once instead of for every observation. Views that observe many of
+  // the tracks to estimate remove the radial distortion of their features with
+  // a lookup table.
+  struct EstimatedView {
+    const View* view;
+    Eigen::Matrix3d rotation;
+    Eigen::Vector3d position;
+    int num_observations = 0;
+    std::unique_ptr<RadialUndistortionTable> undistortion_table;
+  };
+
+  // Caches the estimated views of the reconstruction.
+  void CacheEstimatedViews();
+
+  // Builds the undistortion tables of the views with enough observations of
+  // the tracks to estimate.
+  void CacheUndistortionTables();
+
+  // Estimates the tracks in [start, end) as a single batch.
+  void EstimateTrackSet(const int start, const int end);
 
   const Options options_;
   Reconstruction* reconstruction_;
   std::vector<TrackId> tracks_to_estimate_;
-  std::unordered_set<TrackId> successfully_estimated_tracks_;
+  std::unordered_map<ViewId, EstimatedView> estimated_views_;
 };
 
 }  // namespace theia
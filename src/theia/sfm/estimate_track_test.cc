@@ -0,0 +1,202 @@
+// Copyright (C) 2015 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include <Eigen/Core>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "theia/sfm/camera/camera.h"
+#include "theia/sfm/estimate_track.h"
+#include "theia/sfm/reconstruction.h"
+#include "theia/sfm/track.h"
+#include "theia/sfm/types.h"
+#include "theia/sfm/view.h"
+#include "theia/util/stringprintf.h"
+
+namespace theia {
+
+namespace {
+
+// Creates a reconstruction with estimated views placed along the x-axis that
+// observe random points in front of them. The tracks are not estimated.
+void SetupReconstruction(const int num_views,
+                         const int num_tracks,
+                         const double baseline,
+                         Reconstruction* reconstruction,
+                         std::vector<Eigen::Vector4d>* points) {
+  srand(1234);
+  for (int i = 0; i < num_views; i++) {
+    const ViewId view_id = reconstruction->AddView(StringPrintf("%d", i));
+    View* view = reconstruction->MutableView(view_id);
+    Camera* camera = view->MutableCamera();
+    camera->SetPosition(Eigen::Vector3d(baseline * i, 0, 0));
+    camera->SetOrientationFromAngleAxis(0.05 * Eigen::Vector3d::Random());
+    camera->SetFocalLength(800);
+    camera->SetPrincipalPoint(500.0, 500.0);
+    camera->SetRadialDistortion(-0.01, 0.001);
+    view->SetEstimated(true);
+  }
+
+  for (int i = 0; i < num_tracks; i++) {
+    Eigen::Vector4d point = Eigen::Vector4d::Random();
+    point[2] += 10.0;
+    point[3] = 1.0;
+
+    std::vector<std::pair<ViewId, Feature> > features;
+    for (const ViewId view_id : reconstruction->ViewIds()) {
+      Feature feature;
+      reconstruction->View(view_id)->Camera().ProjectPoint(point, &feature);
+      features.emplace_back(view_id, feature);
+    }
+    reconstruction->AddTrack(features);
+    points->emplace_back(point);
+  }
+}
+
+}  // namespace
+
+TEST(TrackEstimator, EstimateAllTracks) {
+  static const double kTolerance = 1e-6;
+  static const int kNumViews = 5;
+  static const int kNumTracks = 1000;
+
+  Reconstruction reconstruction;
+  std::vector<Eigen::Vector4d> points;
+  SetupReconstruction(kNumViews, kNumTracks, 1.0, &reconstruction, &points);
+
+  TrackEstimator::Options options;
+  options.num_threads = 4;
+  options.bundle_adjustment = false;
+  TrackEstimator track_estimator(options, &reconstruction);
+  const TrackEstimator::Summary summary = track_estimator.EstimateAllTracks();
+  EXPECT_EQ(summary.input_num_estimated_tracks, 0);
+  EXPECT_EQ(summary.num_triangulation_attempts, kNumTracks);
+  EXPECT_EQ(summary.estimated_tracks.size(), kNumTracks);
+
+  // Track ids are assigned in the order that the tracks were added.
+  for (int i = 0; i < kNumTracks; i++) {
+    const Track* track = reconstruction.Track(i);
+    EXPECT_TRUE(track->IsEstimated());
+    EXPECT_LT((track->Point().hnormalized() - points[i].hnormalized()).norm(),
+              kTolerance);
+  }
+}
+
+TEST(TrackEstimator, EstimateTracksInBatchesWithBundleAdjustment) {
+  static const double kTolerance = 1e-6;
+  static const int kNumViews = 3;
+  static const int kNumTracks = 250;
+
+  Reconstruction reconstruction;
+  std::vector<Eigen::Vector4d> points;
+  SetupReconstruction(kNumViews, kNumTracks, 1.0, &reconstruction, &points);
+
+  // Only estimate a subset of the tracks.
+  std::unordered_set<TrackId> tracks_to_estimate;
+  for (int i = 0; i < kNumTracks; i += 2) {
+    tracks_to_estimate.insert(i);
+  }
+
+  TrackEstimator::Options options;
+  options.num_threads = 2;
+  options.multithreaded_step_size = 16;
+  TrackEstimator track_estimator(options, &reconstruction);
+  const TrackEstimator::Summary summary =
+      track_estimator.EstimateTracks(tracks_to_estimate);
+  EXPECT_EQ(summary.estimated_tracks, tracks_to_estimate);
+
+  for (int i = 0; i < kNumTracks; i++) {
+    const Track* track = reconstruction.Track(i);
+    EXPECT_EQ(track->IsEstimated(), i % 2 == 0);
+    if (track->IsEstimated()) {
+      EXPECT_LT(
+          (track->Point().hnormalized() - points[i].hnormalized()).norm(),
+          kTolerance);
+    }
+  }
+}
+
+TEST(TrackEstimator, InsufficientTriangulationAngle) {
+  static const int kNumViews = 2;
+  static const int kNumTracks = 100;
+
+  // With a tiny baseline, the triangulation angle of all tracks is far below
+  // the minimum.
+  Reconstruction reconstruction;
+  std::vector<Eigen::Vector4d> points;
+  SetupReconstruction(kNumViews, kNumTracks, 0.01, &reconstruction, &points);
+
+  TrackEstimator::Options options;
+  options.bundle_adjustment = false;
+  options.min_triangulation_angle_degrees = 3.0;
+  TrackEstimator track_estimator(options, &reconstruction);
+  const TrackEstimator::Summary summary = track_estimator.EstimateAllTracks();
+  EXPECT_EQ(summary.num_triangulation_attempts, kNumTracks);
+  EXPECT_EQ(summary.estimated_tracks.size(), 0);
+}
+
+TEST(TrackEstimator, UnestimatedViewsAreIgnored) {
+  static const int kNumViews = 3;
+  static const int kNumTracks = 10;
+
+  Reconstruction reconstruction;
+  std::vector<Eigen::Vector4d> points;
+  SetupReconstruction(kNumViews, kNumTracks, 1.0, &reconstruction, &points);
+
+  // Corrupt one view. It must not affect the triangulation once it is no
+  // longer estimated.
+  View* view = reconstruction.MutableView(0);
+  view->MutableCamera()->SetPosition(Eigen::Vector3d(5.0, 5.0, 5.0));
+  view->SetEstimated(false);
+
+  TrackEstimator::Options options;
+  options.bundle_adjustment = false;
+  TrackEstimator track_estimator(options, &reconstruction);
+  const TrackEstimator::Summary summary = track_estimator.EstimateAllTracks();
+  EXPECT_EQ(summary.estimated_tracks.size(), kNumTracks);
+
+  // With only one estimated view, no track may be estimated.
+  reconstruction.MutableView(1)->SetEstimated(false);
+  for (const TrackId track_id : reconstruction.TrackIds()) {
+    reconstruction.MutableTrack(track_id)->SetEstimated(false);
+  }
+  TrackEstimator single_view_estimator(options, &reconstruction);
+  const TrackEstimator::Summary single_view_summary =
+      single_view_estimator.EstimateAllTracks();
+  EXPECT_EQ(single_view_summary.num_triangulation_attempts, 0);
+}
+
+}  // namespace theia
@@ -42,6 +42,7 @@
 
 #include "theia/solvers/sample_consensus_estimator.h"
 #include "theia/sfm/camera_intrinsics_prior.h"
+#include "theia/sfm/estimators/estimate_homography.h"
 #include "theia/sfm/estimators/estimate_relative_pose.h"
 #include "theia/sfm/estimators/estimate_uncalibrated_relative_pose.h"
 #include "theia/matching/feature_correspondence.h"
@@ -121,6 +122,27 @@ void NormalizeFeatures(
   }
 }
 
+// Compute a homography with a separate RANSAC and return the number of
+// inliers. The correspondences are expected to be in pixels.
+int CountHomographyInliers(
+    const EstimateTwoViewInfoOptions& options,
+    const std::vector<FeatureCorrespondence>& correspondences) {
+  RansacParameters homography_params;
+  homography_params.error_thresh =
+      options.max_sampson_error_pixels * options.max_sampson_error_pixels;
+  homography_params.max_iterations = options.max_ransac_iterations;
+  homography_params.min_iterations = options.min_ransac_iterations;
+  homography_params.use_mle = options.use_mle;
+  homography_params.failure_probability =
+      1.0 - options.expected_ransac_confidence;
+  homography_params.rng = options.rng;
+  RansacSummary homography_summary;
+  Eigen::Matrix3d unused_homography;
+  EstimateHomography(homography_params, options.ransac_type, correspondences,
+                     &unused_homography, &homography_summary);
+  return homography_summary.inliers.size();
+}
+
 bool EstimateTwoViewInfoCalibrated(
     const EstimateTwoViewInfoOptions& options,
     const CameraIntrinsicsPrior& intrinsics1,
@@ -144,15 +166,39 @@ bool EstimateTwoViewInfoCalibrated(
       options.max_sampson_error_pixels * options.max_sampson_error_pixels /
       (intrinsics1.focal_length.value * intrinsics2.focal_length.value);
   ransac_options.use_mle = options.use_mle;
+  ransac_options.rng = options.rng;
 
   RelativePose relative_pose;
   RansacSummary summary;
-  if (!EstimateRelativePose(ransac_options,
-                            options.ransac_type,
-                            normalized_correspondences,
-                            &relative_pose,
-                            &summary)) {
-    return false;
+  if (options.estimate_homography) {
+    // The transfer error of the homography is measured in image 2.
+    const double homography_error_thresh =
+        options.max_sampson_error_pixels * options.max_sampson_error_pixels /
+        (intrinsics2.focal_length.value * intrinsics2.focal_length.value);
+    Matrix3d unused_homography;
+    RelativePoseAndHomographySummary joint_summary;
+    if (!EstimateRelativePoseAndHomography(ransac_options,
+                                           options.ransac_type,
+                                           homography_error_thresh,
+                                           options.defer_cheirality_checks,
+                                           normalized_correspondences,
+                                           &relative_pose,
+                                           &unused_homography,
+                                           &joint_summary)) {
+      return false;
+    }
+    summary = joint_summary.relative_pose_summary;
+    twoview_info->num_homography_inliers =
+        joint_summary.homography_inliers.size();
+  } else {
+    if (!EstimateRelativePose(ransac_options,
+                              options.ransac_type,
+                              options.defer_cheirality_checks,
+                              normalized_correspondences,
+                              &relative_pose,
+                              &summary)) {
+      return false;
+    }
   }
 
   AngleAxisd rotation(relative_pose.rotation);
@@ -190,6 +236,7 @@ bool EstimateTwoViewInfoUncalibrated(
   ransac_options.max_iterations = options.max_ransac_iterations;
   ransac_options.error_thresh =
       options.max_sampson_error_pixels * options.max_sampson_error_pixels;
+  ransac_options.rng = options.rng;
 
   UncalibratedRelativePose relative_pose;
   RansacSummary summary;
@@ -213,6 +260,11 @@ bool EstimateTwoViewInfoUncalibrated(
   twoview_info->num_verified_matches = summary.inliers.size();
   *inlier_indices = summary.inliers;
 
+  if (options.estimate_homography) {
+    twoview_info->num_homography_inliers =
+        CountHomographyInliers(options, centered_correspondences);
+  }
+
   return true;
 }
 
@@ -260,4 +312,35 @@ bool EstimateTwoViewInfo(
                                          inlier_indices);
 }
 
+bool EstimateTwoViewInfo(
+    const EstimateTwoViewInfoOptions& options,
+    const CameraIntrinsicsPrior& intrinsics1,
+    const CameraIntrinsicsPrior& intrinsics2,
+    const std::vector<FeatureCorrespondence>& correspondences,
+    TwoViewInfo* twoview_info,
+    std::vector<int>* inlier_indices,
+    bool* is_degenerate) {
+  CHECK_NOTNULL(is_degenerate);
+  *is_degenerate = false;
+  if (!EstimateTwoViewInfo(options,
+                           intrinsics1,
+                           intrinsics2,
+                           correspondences,
+                           twoview_info,
+                           inlier_indices)) {
+    return false;
+  }
+
+  if (options.estimate_homography) {
+    *is_degenerate = IsRelativePoseDegenerate(
+        twoview_info->num_homography_inliers, inlier_indices->size());
+    VLOG_IF(2, *is_degenerate)
+        << "The relative pose is degenerate: "
+        << twoview_info->num_homography_inliers << " of "
+        << inlier_indices->size()
+        << " inliers are explained by a homography.";
+  }
+  return true;
+}
+
 }  // namespace theia
@@ -35,8 +35,10 @@
 #ifndef THEIA_SFM_ESTIMATE_TWOVIEW_INFO_H_
 #define THEIA_SFM_ESTIMATE_TWOVIEW_INFO_H_
 
+#include <memory>
 #include <vector>
 #include "theia/sfm/create_and_initialize_ransac_variant.h"
+#include "theia/util/random.h"
 
 namespace theia {
 
@@ -57,6 +59,23 @@ struct EstimateTwoViewInfoOptions {
   int min_ransac_iterations = 10;
   int max_ransac_iterations = 1000;
   bool use_mle = true;
+
+  // If true, the relative pose hypotheses of calibrated view pairs are scored
+  // with the Sampson error only and the cheirality of the correspondences is
+  // checked for the final relative pose alone. This is much faster than
+  // triangulating every correspondence for every hypothesis, though outliers
+  // that are behind the cameras may affect which hypothesis is chosen.
+  bool defer_cheirality_checks = false;
+
+  // If true, a homography is estimated as well and its number of inliers is
+  // stored in TwoViewInfo::num_homography_inliers. The homography is
+  // estimated with a separate RANSAC of the same type. VerifyTwoViewMatches
+  // always enables this.
+  bool estimate_homography = false;
+
+  // The random number generator used by RANSAC. If null, a generator seeded
+  // from the current time is used.
+  std::shared_ptr<RandomNumberGenerator> rng;
 };
 
 // Estimates two view info for the given view pair from the correspondences. The
@@ -82,6 +101,20 @@ bool EstimateTwoViewInfo(
     TwoViewInfo* twoview_info,
     std::vector<int>* inlier_indices);
 
+// Same as above, and if options.estimate_homography is true then is_degenerate
+// is set to whether the homography explains nearly all of the inliers (see
+// IsRelativePoseDegenerate). Such view pairs are planar or rotation-only and
+// their relative translations are unreliable. TwoViewInfo does not hold the
+// flag because it is serialized.
+bool EstimateTwoViewInfo(
+    const EstimateTwoViewInfoOptions& options,
+    const CameraIntrinsicsPrior& intrinsics1,
+    const CameraIntrinsicsPrior& intrinsics2,
+    const std::vector<FeatureCorrespondence>& correspondences,
+    TwoViewInfo* twoview_info,
+    std::vector<int>* inlier_indices,
+    bool* is_degenerate);
+
 }  // namespace theia
 
 #endif  // THEIA_SFM_ESTIMATE_TWOVIEW_INFO_H_
@@ -61,6 +61,19 @@ class EssentialMatrixEstimator
   // Estimates candidate essential matrices from correspondences.
   bool EstimateModel(const std::vector<FeatureCorrespondence>& correspondences,
                      std::vector<Eigen::Matrix3d>* essential_matrices) const {
+    // Minimal samples are solved with the fixed-size solver so that no memory
+    // is allocated for each RANSAC hypothesis.
+    if (correspondences.size() == 5) {
+      Eigen::Vector2d image1_points[5], image2_points[5];
+      for (int i = 0; i < 5; i++) {
+        image1_points[i] = correspondences[i].feature1;
+        image2_points[i] = correspondences[i].feature2;
+      }
+      return FivePointRelativePose(image1_points,
+                                   image2_points,
+                                   essential_matrices);
+    }
+
     std::vector<Eigen::Vector2d> image1_points, image2_points;
     image1_points.reserve(correspondences.size());
     image2_points.reserve(correspondences.size());
@@ -36,12 +36,15 @@
 
 #include <Eigen/Core>
 #include <Eigen/Geometry>
+#include <glog/logging.h>
+
 #include <limits>
 #include <memory>
 #include <vector>
 
 #include "theia/matching/feature_correspondence.h"
 #include "theia/sfm/create_and_initialize_ransac_variant.h"
+#include "theia/sfm/estimators/estimate_homography.h"
 #include "theia/sfm/pose/essential_matrix_utils.h"
 #include "theia/sfm/pose/five_point_relative_pose.h"
 #include "theia/sfm/pose/util.h"
@@ -56,13 +59,43 @@ namespace {
 using Eigen::Matrix3d;
 using Eigen::Vector3d;
 
+// Computes the candidate essential matrices from the correspondences. Minimal
+// samples are solved with the fixed-size solver so that no memory is allocated
+// for the correspondences of each RANSAC hypothesis.
+bool ComputeEssentialMatrices(
+    const std::vector<FeatureCorrespondence>& correspondences,
+    std::vector<Matrix3d>* essential_matrices) {
+  if (correspondences.size() == 5) {
+    Eigen::Vector2d image1_points[5], image2_points[5];
+    for (int i = 0; i < 5; i++) {
+      image1_points[i] = correspondences[i].feature1;
+      image2_points[i] = correspondences[i].feature2;
+    }
+    return FivePointRelativePose(image1_points,
+                                 image2_points,
+                                 essential_matrices);
+  }
+
+  std::vector<Eigen::Vector2d> image1_points, image2_points;
+  image1_points.reserve(correspondences.size());
+  image2_points.reserve(correspondences.size());
+  for (int i = 0; i < correspondences.size(); i++) {
+    image1_points.emplace_back(correspondences[i].feature1);
+    image2_points.emplace_back(correspondences[i].feature2);
+  }
+  return FivePointRelativePose(image1_points,
+                               image2_points,
+                               essential_matrices);
+}
+
 // An estimator for computing the relative pose from 5 feature
 // correspondences. The feature correspondences should be normalized
 // by the focal length with the principal point at (0, 0).
 class RelativePoseEstimator
     : public Estimator<FeatureCorrespondence, RelativePose> {
  public:
-  RelativePoseEstimator() {}
+  explicit RelativePoseEstimator(const bool defer_cheirality_checks)
+      : defer_cheirality_checks_(defer_cheirality_checks) {}
 
   // 5 correspondences are needed to determine an essential matrix and thus a
   // relative pose..
@@ -71,18 +104,8 @@ class RelativePoseEstimator
   // Estimates candidate relative poses from correspondences.
   bool EstimateModel(const std::vector<FeatureCorrespondence>& correspondences,
                      std::vector<RelativePose>* relative_poses) const {
-    std::vector<Eigen::Vector2d> image1_points, image2_points;
-    image1_points.reserve(correspondences.size());
-    image2_points.reserve(correspondences.size());
-    for (int i = 0; i < correspondences.size(); i++) {
-      image1_points.emplace_back(correspondences[i].feature1);
-      image2_points.emplace_back(correspondences[i].feature2);
-    }
-
     std::vector<Matrix3d> essential_matrices;
-    if (!FivePointRelativePose(image1_points,
-                               image2_points,
-                               &essential_matrices)) {
+    if (!ComputeEssentialMatrices(correspondences, &essential_matrices)) {
       return false;
     }
 
@@ -107,10 +130,12 @@ class RelativePoseEstimator
   }
 
   // The error for a correspondences given a model. This is the squared sampson
-  // error.
+  // error. Unless the cheirality checks are deferred, correspondences that do
+  // not triangulate in front of both cameras have an infinite error.
   double Error(const FeatureCorrespondence& correspondence,
                const RelativePose& relative_pose) const {
-    if (IsTriangulatedPointInFrontOfCameras(correspondence,
+    if (defer_cheirality_checks_ ||
+        IsTriangulatedPointInFrontOfCameras(correspondence,
                                             relative_pose.rotation,
                                             relative_pose.position)) {
       return SquaredSampsonDistance(relative_pose.essential_matrix,
@@ -121,9 +146,46 @@ class RelativePoseEstimator
   }
 
  private:
+  const bool defer_cheirality_checks_;
+
   DISALLOW_COPY_AND_ASSIGN(RelativePoseEstimator);
 };
 
+// Resolves the four-fold ambiguity of the relative pose decomposition of the
+// essential matrix using all inliers and removes the inliers that are not
+// triangulated in front of both cameras.
+bool ResolveCheiralityOfInliers(
+    const std::vector<FeatureCorrespondence>& normalized_correspondences,
+    RelativePose* relative_pose,
+    std::vector<int>* inliers) {
+  std::vector<FeatureCorrespondence> inlier_correspondences;
+  inlier_correspondences.reserve(inliers->size());
+  for (const int inlier : *inliers) {
+    inlier_correspondences.emplace_back(normalized_correspondences[inlier]);
+  }
+
+  const int num_points_in_front_of_cameras = GetBestPoseFromEssentialMatrix(
+      relative_pose->essential_matrix,
+      inlier_correspondences,
+      &relative_pose->rotation,
+      &relative_pose->position);
+  if (num_points_in_front_of_cameras == 0) {
+    return false;
+  }
+
+  std::vector<int> inliers_in_front_of_cameras;
+  inliers_in_front_of_cameras.reserve(num_points_in_front_of_cameras);
+  for (int i = 0; i < inliers->size(); i++) {
+    if (IsTriangulatedPointInFrontOfCameras(inlier_correspondences[i],
+                                            relative_pose->rotation,
+                                            relative_pose->position)) {
+      inliers_in_front_of_cameras.emplace_back((*inliers)[i]);
+    }
+  }
+  inliers->swap(inliers_in_front_of_cameras);
+  return true;
+}
+
 }  // namespace
 
 bool EstimateRelativePose(
@@ -132,15 +194,93 @@ bool EstimateRelativePose(
     const std::vector<FeatureCorrespondence>& normalized_correspondences,
     RelativePose* relative_pose,
     RansacSummary* ransac_summary) {
-  RelativePoseEstimator relative_pose_estimator;
+  return EstimateRelativePose(ransac_params,
+                              ransac_type,
+                              false,
+                              normalized_correspondences,
+                              relative_pose,
+                              ransac_summary);
+}
+
+bool EstimateRelativePose(
+    const RansacParameters& ransac_params,
+    const RansacType& ransac_type,
+    const bool defer_cheirality_checks,
+    const std::vector<FeatureCorrespondence>& normalized_correspondences,
+    RelativePose* relative_pose,
+    RansacSummary* ransac_summary) {
+  RelativePoseEstimator relative_pose_estimator(defer_cheirality_checks);
   std::unique_ptr<SampleConsensusEstimator<RelativePoseEstimator> > ransac =
       CreateAndInitializeRansacVariant(ransac_type,
                                        ransac_params,
                                        relative_pose_estimator);
   // Estimate the relative pose.
-  return ransac->Estimate(normalized_correspondences,
-                          relative_pose,
-                          ransac_summary);
+  if (!ransac->Estimate(normalized_correspondences,
+                        relative_pose,
+                        ransac_summary)) {
+    return false;
+  }
+
+  if (!defer_cheirality_checks) {
+    return true;
+  }
+  return ResolveCheiralityOfInliers(normalized_correspondences,
+                                    relative_pose,
+                                    &ransac_summary->inliers);
+}
+
+bool IsRelativePoseDegenerate(const int num_homography_inliers,
+                              const int num_relative_pose_inliers) {
+  // If the best homography has at least this ratio of the number of relative
+  // pose inliers then the relative pose is considered degenerate.
+  static const double kDegenerateHomographyInlierRatio = 0.8;
+  return num_homography_inliers >=
+         kDegenerateHomographyInlierRatio * num_relative_pose_inliers;
+}
+
+bool EstimateRelativePoseAndHomography(
+    const RansacParameters& ransac_params,
+    const RansacType& ransac_type,
+    const double homography_error_thresh,
+    const bool defer_cheirality_checks,
+    const std::vector<FeatureCorrespondence>& normalized_correspondences,
+    RelativePose* relative_pose,
+    Eigen::Matrix3d* homography,
+    RelativePoseAndHomographySummary* summary) {
+  CHECK_GT(homography_error_thresh, 0);
+  CHECK_NOTNULL(relative_pose);
+  CHECK_NOTNULL(homography);
+  CHECK_NOTNULL(summary);
+
+  RansacSummary& relative_pose_summary = summary->relative_pose_summary;
+  if (!EstimateRelativePose(ransac_params,
+                            ransac_type,
+                            defer_cheirality_checks,
+                            normalized_correspondences,
+                            relative_pose,
+                            &relative_pose_summary) ||
+      relative_pose_summary.inliers.empty()) {
+    return false;
+  }
+
+  // The homography needs its own samples: the inliers of the relative pose are
+  // generally not coplanar, so the samples that find the relative pose rarely
+  // contain 4 correspondences on the dominant plane.
+  RansacParameters homography_params = ransac_params;
+  homography_params.error_thresh = homography_error_thresh;
+  RansacSummary homography_summary;
+  if (!EstimateHomography(homography_params,
+                          ransac_type,
+                          normalized_correspondences,
+                          homography,
+                          &homography_summary)) {
+    homography_summary.inliers.clear();
+  }
+  summary->homography_inliers.swap(homography_summary.inliers);
+  summary->is_degenerate =
+      IsRelativePoseDegenerate(summary->homography_inliers.size(),
+                               relative_pose_summary.inliers.size());
+  return true;
 }
 
 }  // namespace theia
@@ -39,12 +39,11 @@
 #include <vector>
 
 #include "theia/sfm/create_and_initialize_ransac_variant.h"
+#include "theia/solvers/sample_consensus_estimator.h"
 
 namespace theia {
 
 struct FeatureCorrespondence;
-struct RansacParameters;
-struct RansacSummary;
 
 struct RelativePose {
   Eigen::Matrix3d essential_matrix;
@@ -52,6 +51,21 @@ struct RelativePose {
   Eigen::Vector3d position;
 };
 
+// The output of jointly estimating a relative pose and a homography.
+struct RelativePoseAndHomographySummary {
+  // The ransac summary of the relative pose.
+  RansacSummary relative_pose_summary;
+
+  // The inliers of the best homography.
+  std::vector<int> homography_inliers;
+
+  // True if the best homography explains nearly all of the relative pose
+  // inliers. This indicates that the scene is planar or that the cameras only
+  // rotate, so the relative pose (and the translation in particular) is
+  // ill-conditioned.
+  bool is_degenerate = false;
+};
+
 // Estimates the relative pose using the ransac variant of choice (e.g. Ransac,
 // Prosac, etc.). Correspondences must be normalized by the camera
 // intrinsics. Returns true if a pose could be succesfully estimated, and false
@@ -64,6 +78,45 @@ bool EstimateRelativePose(
     RelativePose* relative_pose,
     RansacSummary* ransac_summary);
 
+// Same as above, but if defer_cheirality_checks is true then the hypotheses are
+// scored with the Sampson error alone instead of also triangulating each
+// correspondence to check that it lies in front of both cameras. The four-fold
+// pose ambiguity and the cheirality of the inliers are then only resolved for
+// the winning essential matrix: the relative pose is decomposed using all of
+// its inliers and the inliers that triangulate behind either camera are removed
+// from the summary. This is much faster since the scoring loop only evaluates
+// the Sampson error.
+bool EstimateRelativePose(
+    const RansacParameters& ransac_params,
+    const RansacType& ransac_type,
+    const bool defer_cheirality_checks,
+    const std::vector<FeatureCorrespondence>& normalized_correspondences,
+    RelativePose* relative_pose,
+    RansacSummary* ransac_summary);
+
+// Returns true if a homography explains nearly all of the relative pose
+// inliers, i.e. at least 80% of them. This indicates that the scene is planar
+// or that the cameras only rotate, so the relative pose (and the translation in
+// particular) is ill-conditioned.
+bool IsRelativePoseDegenerate(const int num_homography_inliers,
+                              const int num_relative_pose_inliers);
+
+// Estimates the relative pose and a homography with the ransac variant of
+// choice and flags the relative pose as degenerate if the homography explains
+// nearly all of its inliers (see IsRelativePoseDegenerate). The homography is
+// estimated with its own RANSAC since the relative pose inliers are generally
+// not coplanar. The homography error is the squared transfer error in image 2
+// and homographies are only scored against homography_error_thresh.
+bool EstimateRelativePoseAndHomography(
+    const RansacParameters& ransac_params,
+    const RansacType& ransac_type,
+    const double homography_error_thresh,
+    const bool defer_cheirality_checks,
+    const std::vector<FeatureCorrespondence>& normalized_correspondences,
+    RelativePose* relative_pose,
+    Eigen::Matrix3d* homography,
+    RelativePoseAndHomographySummary* summary);
+
 }  // namespace theia
 
 #endif  // THEIA_SFM_ESTIMATORS_ESTIMATE_RELATIVE_POSE_H_
@@ -74,6 +74,7 @@ void GeneratePoints(std::vector<Vector3d>* points) {
 }
 
 void ExecuteRandomTest(const RansacParameters& options,
+                       const bool defer_cheirality_checks,
                        const Matrix3d& rotation,
                        const Vector3d& position,
                        const double inlier_ratio,
@@ -115,6 +116,7 @@ void ExecuteRandomTest(const RansacParameters& options,
   RansacSummary ransac_summary;
   EXPECT_TRUE(EstimateRelativePose(options,
                                    RansacType::RANSAC,
+                                   defer_cheirality_checks,
                                    correspondences,
                                    &relative_pose,
                                    &ransac_summary));
@@ -153,6 +155,7 @@ TEST(EstimateRelativePose, AllInliersNoNoise) {
   for (int i = 0; i < rotations.size(); i++) {
     for (int j = 0; j < positions.size(); j++) {
       ExecuteRandomTest(options,
+                        false,
                         rotations[i],
                         positions[j],
                         kInlierRatio,
@@ -183,6 +186,7 @@ TEST(EstimateRelativePose, AllInliersWithNoise) {
   for (int i = 0; i < rotations.size(); i++) {
     for (int j = 0; j < positions.size(); j++) {
       ExecuteRandomTest(options,
+                        false,
                         rotations[i],
                         positions[j],
                         kInlierRatio,
@@ -211,6 +215,7 @@ TEST(EstimateRelativePose, OutliersNoNoise) {
   for (int i = 0; i < rotations.size(); i++) {
     for (int j = 0; j < positions.size(); j++) {
       ExecuteRandomTest(options,
+                        false,
                         rotations[i],
                         positions[j],
                         kInlierRatio,
@@ -239,6 +244,7 @@ TEST(EstimateRelativePose, OutliersWithNoise) {
   for (int i = 0; i < rotations.size(); i++) {
     for (int j = 0; j < positions.size(); j++) {
       ExecuteRandomTest(options,
+                        false,
                         rotations[i],
                         positions[j],
                         kInlierRatio,
@@ -248,4 +254,149 @@ TEST(EstimateRelativePose, OutliersWithNoise) {
   }
 }
 
+TEST(EstimateRelativePose, DeferredCheiralityAllInliersNoNoise) {
+  RansacParameters options;
+  options.use_mle = true;
+  options.error_thresh = kErrorThreshold;
+  options.failure_probability = 0.001;
+  const double kInlierRatio = 1.0;
+  const double kNoise = 0.0;
+  const double kPoseTolerance = 1e-4;
+
+  const std::vector<Matrix3d> rotations = {
+    Matrix3d::Identity(),
+    AngleAxisd(DegToRad(12.0), Vector3d::UnitY()).toRotationMatrix(),
+    AngleAxisd(DegToRad(-9.0), Vector3d(1.0, 0.2, -0.8).normalized())
+        .toRotationMatrix()
+  };
+  const std::vector<Vector3d> positions = { Vector3d(-1.3, 0, 0),
+                                            Vector3d(0, 0, 0.5) };
+  for (int i = 0; i < rotations.size(); i++) {
+    for (int j = 0; j < positions.size(); j++) {
+      ExecuteRandomTest(options,
+                        true,
+                        rotations[i],
+                        positions[j],
+                        kInlierRatio,
+                        kNoise,
+                        kPoseTolerance);
+    }
+  }
+}
+
+TEST(EstimateRelativePose, DeferredCheiralityOutliersWithNoise) {
+  RansacParameters options;
+  options.use_mle = true;
+  options.error_thresh = kErrorThreshold;
+  options.failure_probability = 0.001;
+  const double kInlierRatio = 0.7;
+  const double kNoise = 1.0;
+  const double kPoseTolerance = 1e-2;
+
+  const std::vector<Matrix3d> rotations = {
+    Matrix3d::Identity(),
+    ProjectToRotationMatrix(Matrix3d::Identity() + 0.3 * Matrix3d::Random())
+  };
+  const std::vector<Vector3d> positions = { Vector3d(1, 0, 0),
+                                            Vector3d(0, 1, 0) };
+
+  for (int i = 0; i < rotations.size(); i++) {
+    for (int j = 0; j < positions.size(); j++) {
+      ExecuteRandomTest(options,
+                        true,
+                        rotations[i],
+                        positions[j],
+                        kInlierRatio,
+                        kNoise,
+                        kPoseTolerance);
+    }
+  }
+}
+
+// Estimates the relative pose and homography jointly for points that are
+// either in general position or on a plane.
+void ExecuteJointTest(const bool planar_scene,
+                      const Matrix3d& rotation,
+                      const Vector3d& position,
+                      RelativePoseAndHomographySummary* summary,
+                      RelativePose* relative_pose) {
+  InitRandomGenerator();
+
+  std::vector<Vector3d> points3d;
+  GeneratePoints(&points3d);
+  if (planar_scene) {
+    for (Vector3d& point : points3d) {
+      point.z() = 5.0 + 0.1 * point.x() - 0.2 * point.y();
+    }
+  }
+
+  const Vector3d translation = (-rotation * position).normalized();
+  std::vector<FeatureCorrespondence> correspondences;
+  for (int i = 0; i < points3d.size(); i++) {
+    FeatureCorrespondence correspondence;
+    correspondence.feature1 = points3d[i].hnormalized();
+    correspondence.feature2 =
+        (rotation * points3d[i] + translation).hnormalized();
+    correspondences.emplace_back(correspondence);
+  }
+  // Add a few outliers.
+  for (int i = 0; i < 5; i++) {
+    FeatureCorrespondence correspondence;
+    correspondence.feature1 = Vector2d::Random();
+    correspondence.feature2 = Vector2d::Random();
+    correspondences.emplace_back(correspondence);
+  }
+
+  RansacParameters options;
+  options.use_mle = true;
+  options.error_thresh = kErrorThreshold;
+  options.failure_probability = 0.001;
+  Matrix3d homography;
+  EXPECT_TRUE(EstimateRelativePoseAndHomography(options,
+                                                RansacType::RANSAC,
+                                                kErrorThreshold,
+                                                false,
+                                                correspondences,
+                                                relative_pose,
+                                                &homography,
+                                                summary));
+}
+
+TEST(EstimateRelativePose, JointHomographyGeneralScene) {
+  const Matrix3d rotation =
+      AngleAxisd(DegToRad(12.0), Vector3d::UnitY()).toRotationMatrix();
+  const Vector3d position(-1.3, 0, 0);
+  RelativePoseAndHomographySummary summary;
+  RelativePose relative_pose;
+  ExecuteJointTest(false, rotation, position, &summary, &relative_pose);
+
+  // All points in general position are relative pose inliers but a homography
+  // only explains a subset of them.
+  EXPECT_EQ(summary.relative_pose_summary.inliers.size(), 27);
+  EXPECT_LT(summary.homography_inliers.size(), 27);
+  EXPECT_FALSE(summary.is_degenerate);
+  EXPECT_TRUE(test::ArraysEqualUpToScale(9,
+                                         rotation.data(),
+                                         relative_pose.rotation.data(),
+                                         1e-4));
+  EXPECT_TRUE(test::ArraysEqualUpToScale(3,
+                                         position.data(),
+                                         relative_pose.position.data(),
+                                         1e-4));
+}
+
+TEST(EstimateRelativePose, JointHomographyPlanarScene) {
+  const Matrix3d rotation =
+      AngleAxisd(DegToRad(12.0), Vector3d::UnitY()).toRotationMatrix();
+  const Vector3d position(-1.3, 0, 0);
+  RelativePoseAndHomographySummary summary;
+  RelativePose relative_pose;
+  ExecuteJointTest(true, rotation, position, &summary, &relative_pose);
+
+  // A homography explains all points on the plane so the relative pose is
+  // flagged as degenerate.
+  EXPECT_EQ(summary.homography_inliers.size(), 27);
+  EXPECT_TRUE(summary.is_degenerate);
+}
+
 }  // namespace theia
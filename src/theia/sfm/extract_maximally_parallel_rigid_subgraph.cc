@@ -40,6 +40,7 @@
 
 #include <algorithm>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "theia/sfm/pose/util.h"
@@ -55,28 +56,33 @@ void FormAngleMeasurementMatrix(
     const ViewGraph& view_graph,
     const std::unordered_map<ViewId, int>& view_ids_to_index,
     Eigen::MatrixXd* angle_measurements) {
-  const auto& view_pairs = view_graph.GetAllEdges();
   angle_measurements->setZero();
 
   // Set up the matrix such that t_{i,j} x (c_j - c_i) = 0.
   int i = 0;
-  for (const auto& view_pair : view_pairs) {
+  for (int edge_slot = 0; edge_slot < view_graph.NumEdgeSlots(); edge_slot++) {
+    if (view_graph.IsEdgeSlotRemoved(edge_slot)) {
+      continue;
+    }
+    const ViewIdPair& view_id_pair = view_graph.EdgeViewIdPair(edge_slot);
+
     // Get t_{i,j} and rotate it such that it is oriented in the global
     // reference frame.
     Eigen::Matrix3d world_to_view1_rotation;
     ceres::AngleAxisToRotationMatrix(
-        FindOrDie(orientations, view_pair.first.first).data(),
+        FindOrDie(orientations, view_id_pair.first).data(),
         ceres::ColumnMajorAdapter3x3(world_to_view1_rotation.data()));
     const Eigen::Vector3d rotated_translation =
-        world_to_view1_rotation.transpose() * view_pair.second.position_2;
+        world_to_view1_rotation.transpose() *
+        view_graph.EdgeValue(edge_slot).position_2;
     const Eigen::Matrix3d cross_product_mat =
         CrossProductMatrix(rotated_translation);
 
     // Find the column locations of the two views.
     const int view1_col =
-        3 * FindOrDie(view_ids_to_index, view_pair.first.first);
+        3 * FindOrDie(view_ids_to_index, view_id_pair.first);
     const int view2_col =
-        3 * FindOrDie(view_ids_to_index, view_pair.first.second);
+        3 * FindOrDie(view_ids_to_index, view_id_pair.second);
 
     angle_measurements->block<3, 3>(3 * i, view1_col) = -cross_product_mat;
     angle_measurements->block<3, 3>(3 * i, view2_col) = cross_product_mat;
@@ -214,17 +220,17 @@ void ExtractMaximallyParallelRigidSubgraph(
   }
 
   // Only keep the nodes in the largest maximally parallel rigid component.
+  std::unordered_set<ViewId> views_to_remove;
   for (const auto& orientation : orientations) {
     const int index = FindOrDie(view_ids_to_index, orientation.first);
     // If the view is not in the maximal rigid component then remove it from the
     // view graph.
     if (!ContainsKey(maximal_rigid_component, index) &&
         view_graph->HasView(orientation.first)) {
-      CHECK(view_graph->RemoveView(orientation.first))
-          << "Could not remove view id " << orientation.first
-          << " from the view graph because it does not exist.";
+      views_to_remove.insert(orientation.first);
     }
   }
+  view_graph->RemoveViews(views_to_remove);
 }
 
 }  // namespace theia
@@ -38,17 +38,43 @@
 #include <algorithm>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "theia/image/descriptor/create_descriptor_extractor.h"
 #include "theia/image/descriptor/descriptor_extractor.h"
 #include "theia/io/write_keypoints_and_descriptors.h"
 #include "theia/image/image.h"
+#include "theia/image/image_loader.h"
+#include "theia/image/keypoint_detector/keypoint_selection.h"
 #include "theia/util/filesystem.h"
 #include "theia/util/threadpool.h"
 
 namespace theia {
 
+namespace {
+
+CreateDescriptorExtractorOptions GetDescriptorExtractorOptions(
+    const FeatureExtractor::Options& options) {
+  CreateDescriptorExtractorOptions descriptor_extractor_options;
+  descriptor_extractor_options.descriptor_extractor_type =
+      options.descriptor_extractor_type;
+  descriptor_extractor_options.sift_options = options.sift_parameters;
+  // The images are already extracted in parallel, so each image is extracted
+  // on a single thread instead of nesting a thread pool for its tiles.
+  if (options.num_threads > 1) {
+    descriptor_extractor_options.sift_options.num_threads = 1;
+  }
+  return descriptor_extractor_options;
+}
+
+}  // namespace
+
+FeatureExtractor::FeatureExtractor(const Options& options)
+    : options_(options),
+      write_features_to_disk_(false),
+      descriptor_extractor_pool_(GetDescriptorExtractorOptions(options)) {}
+
 bool FeatureExtractor::Extract(
     const std::vector<std::string>& filenames,
     std::vector<std::vector<Keypoint> >* keypoints,
@@ -59,23 +85,38 @@ bool FeatureExtractor::Extract(
   CHECK_NOTNULL(keypoints)->resize(filenames.size());
   CHECK_NOTNULL(descriptors)->resize(filenames.size());
 
-  // The thread pool will wait to finish all jobs when it goes out of scope.
-  const int num_threads =
-      std::min(options_.num_threads, static_cast<int>(filenames.size()));
-  ThreadPool feature_extractor_pool(num_threads);
+  std::vector<std::string> existing_filenames;
+  std::vector<int> image_indices;
   for (int i = 0; i < filenames.size(); i++) {
     if (!FileExists(filenames[i])) {
       LOG(ERROR) << "Could not extract features for " << filenames[i]
                  << " because the file cannot be found.";
       continue;
     }
+    existing_filenames.emplace_back(filenames[i]);
+    image_indices.emplace_back(i);
+  }
 
+  // The images are decoded in the background so that decoding overlaps with
+  // the feature extraction. Descriptors are always computed on grayscale
+  // images.
+  ImageLoaderOptions image_loader_options = options_.image_loader_options;
+  image_loader_options.grayscale = true;
+  StreamingImageLoader image_loader(image_loader_options, existing_filenames);
+
+  // The thread pool will wait to finish all jobs when it goes out of scope,
+  // which happens before the image loader is destroyed.
+  const int num_threads =
+      std::min(options_.num_threads, static_cast<int>(filenames.size()));
+  ThreadPool feature_extractor_pool(num_threads);
+  for (int i = 0; i < existing_filenames.size(); i++) {
     feature_extractor_pool.Add(
-        &FeatureExtractor::ExtractFeatures,
+        &FeatureExtractor::ExtractFeaturesFromNextImage,
         this,
-        filenames[i],
-        &(*keypoints)[i],
-        &(*descriptors)[i]);
+        &image_loader,
+        &image_indices,
+        keypoints,
+        descriptors);
   }
   return true;
 }
@@ -96,38 +137,60 @@ bool FeatureExtractor::ExtractToDisk(
   return Extract(filenames, &keypoints, &descriptors);
 }
 
+bool FeatureExtractor::ExtractFeaturesFromNextImage(
+    StreamingImageLoader* image_loader,
+    const std::vector<int>* image_indices,
+    std::vector<std::vector<Keypoint> >* keypoints,
+    std::vector<std::vector<Eigen::VectorXf> >* descriptors) {
+  LoadedImage loaded_image;
+  CHECK(image_loader->GetNextImage(&loaded_image));
+  if (!loaded_image.success) {
+    LOG(ERROR) << "Could not extract features for " << loaded_image.filepath
+               << " because the image could not be read.";
+    return false;
+  }
+
+  const int image_index = (*image_indices)[loaded_image.index];
+  return ExtractFeatures(loaded_image.filepath,
+                         *loaded_image.image,
+                         loaded_image.scale,
+                         &(*keypoints)[image_index],
+                         &(*descriptors)[image_index]);
+}
+
 bool FeatureExtractor::ExtractFeatures(
     const std::string& filename,
+    const FloatImage& image,
+    const Eigen::Vector2d& image_scale,
     std::vector<Keypoint>* keypoints,
     std::vector<Eigen::VectorXf>* descriptors) {
-  std::unique_ptr<FloatImage> image(new FloatImage(filename));
-
-  // We create these variable here instead of upon the construction of the
-  // object so that they can be thread-safe. We *should* be able to use the
-  // static thread_local keywords, but apparently Mac OS-X's version of clang
-  // does not actually support it!
-  //
-  // TODO(cmsweeney): Change this so that each thread in the threadpool receives
-  // exactly one object.
-  CreateDescriptorExtractorOptions options;
-  options.descriptor_extractor_type = options_.descriptor_extractor_type;
-  options.sift_options = options_.sift_parameters;
-
+  // Descriptor extractors are not thread-safe, so each thread acquires an
+  // extractor that is not in use. We *should* be able to use the static
+  // thread_local keywords, but apparently Mac OS-X's version of clang does not
+  // actually support it!
   std::unique_ptr<DescriptorExtractor> descriptor_extractor =
-      CreateDescriptorExtractor(options);
+      descriptor_extractor_pool_.Acquire();
+  const bool extraction_success =
+      descriptor_extractor->DetectAndExtractDescriptors(image,
+                                                        keypoints,
+                                                        descriptors);
+  descriptor_extractor_pool_.Release(std::move(descriptor_extractor));
 
   // Exit if the descriptor extraction fails.
-  if (!descriptor_extractor->DetectAndExtractDescriptors(*image,
-                                                         keypoints,
-                                                         descriptors)) {
+  if (!extraction_success) {
     LOG(ERROR) << "Could not extract descriptors in image " << filename;
     return false;
   }
 
-  if (keypoints->size() > options_.max_num_features) {
-    keypoints->resize(options_.max_num_features);
-    descriptors->resize(options_.max_num_features);
-  }
+  // Convert the keypoints to the full resolution image if the image was
+  // downscaled when decoding.
+  ScaleKeypointsToOriginalImage(image_scale, keypoints);
+
+  // Keep the strongest and best distributed features.
+  SelectKeypointsAndDescriptors(options_.keypoint_selection_options,
+                                options_.max_num_features,
+                                keypoints,
+                                descriptors);
 
   VLOG(1) << "Successfully extracted " << descriptors->size()
           << " features from image " << filename;
@@ -43,6 +43,8 @@
 #include "theia/alignment/alignment.h"
 #include "theia/image/descriptor/create_descriptor_extractor.h"
 #include "theia/image/image.h"
+#include "theia/image/image_loader.h"
+#include "theia/image/keypoint_detector/keypoint_selection.h"
 #include "theia/image/keypoint_detector/sift_parameters.h"
 
 namespace theia {
@@ -59,6 +61,15 @@ class FeatureExtractor {
     SiftParameters sift_parameters;
     // The features returned will be no larger than this size.
     int max_num_features = 16384;
+    // Determines which features are kept when more than max_num_features
+    // features are detected.
+    KeypointSelectionOptions keypoint_selection_options;
+
+    // Options for decoding the images. Images are decoded ahead of the feature
+    // extraction by the image loader threads, and may be decoded at a reduced
+    // resolution. Keypoints are always returned in the coordinates of the
+    // full resolution image.
+    ImageLoaderOptions image_loader_options;
 
     // If we wish to write the features to disk, they will be output in this
     // directory with the same name as the input image and a ".features"
@@ -66,8 +77,7 @@ class FeatureExtractor {
     std::string output_directory = "";
   };
 
-  explicit FeatureExtractor(const Options& options)
-      : options_(options), write_features_to_disk_(false) {}
+  explicit FeatureExtractor(const Options& options);
   ~FeatureExtractor() {}
 
   // Method to extract descriptors.
@@ -80,15 +90,29 @@ class FeatureExtractor {
   bool ExtractToDisk(const std::vector<std::string>& filenames);
 
  private:
-  // Extracts the features and metadata for a single image. This function is
-  // called by the threadpool and is thus thread safe.
+  // Extracts the features and metadata for the next image that is decoded by
+  // the image loader. The features are stored at the index of the image in
+  // image_indices. This function is called by the threadpool and is thus
+  // thread safe.
+  bool ExtractFeaturesFromNextImage(
+      StreamingImageLoader* image_loader,
+      const std::vector<int>* image_indices,
+      std::vector<std::vector<Keypoint> >* keypoints,
+      std::vector<std::vector<Eigen::VectorXf> >* descriptors);
+
+  // Extracts the features and metadata for a single image.
   bool ExtractFeatures(const std::string& filename,
+                       const FloatImage& image,
+                       const Eigen::Vector2d& image_scale,
                        std::vector<Keypoint>* keypoints,
                        std::vector<Eigen::VectorXf>* descriptors);
 
   const Options options_;
   bool write_features_to_disk_;
 
+  // Descriptor extractors are reused across images by the threads.
+  DescriptorExtractorPool descriptor_extractor_pool_;
+
   DISALLOW_COPY_AND_ASSIGN(FeatureExtractor);
 };
 
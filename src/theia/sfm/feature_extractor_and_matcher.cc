@@ -39,20 +39,25 @@
 #include <algorithm>
 #include <string>
 #include <thread>  // NOLINT
+#include <utility>
 #include <vector>
 
 #include "theia/image/image.h"
+#include "theia/image/image_loader.h"
 #include "theia/image/descriptor/create_descriptor_extractor.h"
 #include "theia/image/keypoint_detector/keypoint.h"
+#include "theia/image/keypoint_detector/keypoint_selection.h"
 #include "theia/matching/create_feature_matcher.h"
 #include "theia/matching/feature_correspondence.h"
 #include "theia/matching/feature_matcher_options.h"
 #include "theia/matching/image_pair_match.h"
 #include "theia/sfm/camera_intrinsics_prior.h"
+#include "theia/sfm/colorize_reconstruction.h"
 #include "theia/sfm/estimate_twoview_info.h"
 #include "theia/sfm/exif_reader.h"
 #include "theia/sfm/verify_two_view_matches.h"
 #include "theia/util/filesystem.h"
+#include "theia/util/profiler.h"
 #include "theia/util/threadpool.h"
 
 namespace theia {
@@ -61,37 +66,68 @@ namespace {
 void ExtractFeatures(
     const FeatureExtractorAndMatcher::Options& options,
     const std::string& image_filepath,
+    DescriptorExtractorPool* descriptor_extractor_pool,
     std::vector<Keypoint>* keypoints,
-    std::vector<Eigen::VectorXf>* descriptors) {
-  std::unique_ptr<FloatImage> image(new FloatImage(image_filepath));
-
-  // We create these variable here instead of upon the construction of the
-  // object so that they can be thread-safe. We *should* be able to use the
-  // static thread_local keywords, but apparently Mac OS-X's version of clang
-  // does not actually support it!
-  //
-  // TODO(cmsweeney): Change this so that each thread in the threadpool receives
-  // exactly one object.
-  CreateDescriptorExtractorOptions descriptor_options;
-  descriptor_options.descriptor_extractor_type =
-      options.descriptor_extractor_type;
-  descriptor_options.sift_options = options.sift_parameters;
+    std::vector<Eigen::VectorXf>* descriptors,
+    KeypointColors* keypoint_colors) {
+  ScopedProfile profile("ExtractFeatures");
 
+  // Descriptors are always computed on grayscale images, so the color
+  // channels are only decoded if the keypoint colors are needed.
+  ImageLoaderOptions image_loader_options = options.image_loader_options;
+  image_loader_options.grayscale = !options.extract_keypoint_colors;
+  std::unique_ptr<FloatImage> image(new FloatImage());
+  Eigen::Vector2d image_scale;
+  {
+    ScopedProfile load_image_profile("LoadImage");
+    if (!LoadImage(image_loader_options, image_filepath, image.get(),
+                   &image_scale)) {
+      LOG(ERROR) << "Could not read the image " << image_filepath;
+      return;
+    }
+  }
+  std::unique_ptr<FloatImage> color_image;
+  if (options.extract_keypoint_colors) {
+    color_image = std::move(image);
+    image.reset(new FloatImage(color_image->AsGrayscaleImage()));
+  }
+
+  // Descriptor extractors are not thread-safe, so each thread acquires an
+  // extractor that is not in use. We *should* be able to use the static
+  // thread_local keywords, but apparently Mac OS-X's version of clang does not
+  // actually support it!
   std::unique_ptr<DescriptorExtractor> descriptor_extractor =
-      CreateDescriptorExtractor(descriptor_options);
+      descriptor_extractor_pool->Acquire();
+  bool extraction_success;
+  {
+    ScopedProfile extraction_profile("DetectAndExtractDescriptors");
+    extraction_success =
+        descriptor_extractor->DetectAndExtractDescriptors(*image,
+                                                          keypoints,
+                                                          descriptors);
+  }
+  descriptor_extractor_pool->Release(std::move(descriptor_extractor));
 
   // Exit if the descriptor extraction fails.
-  if (!descriptor_extractor->DetectAndExtractDescriptors(*image,
-                                                         keypoints,
-                                                         descriptors)) {
+  if (!extraction_success) {
     LOG(ERROR) << "Could not extract descriptors in image " << image_filepath;
     return;
   }
 
-  if (keypoints->size() > options.max_num_features) {
-    keypoints->resize(options.max_num_features);
-    descriptors->resize(options.max_num_features);
+  // Convert the keypoints to the full resolution image if the image was
+  // downscaled when decoding.
+  ScaleKeypointsToOriginalImage(image_scale, keypoints);
+
+  // Keep the strongest and best distributed features.
+  SelectKeypointsAndDescriptors(options.keypoint_selection_options,
+                                options.max_num_features,
+                                keypoints,
+                                descriptors);
+
+  if (options.extract_keypoint_colors) {
+    *keypoint_colors = KeypointColors(*color_image, image_scale, *keypoints);
   }
+  AddProfileCount("num_extracted_features", descriptors->size());
 
   VLOG(1) << "Successfully extracted " << descriptors->size()
           << " features from image " << image_filepath;
@@ -107,6 +143,18 @@ FeatureExtractorAndMatcher::FeatureExtractorAndMatcher(
   matcher_options.num_threads = options_.num_threads;
   matcher_options.min_num_feature_matches = options_.min_num_inlier_matches;
   matcher_ = CreateFeatureMatcher(options_.matching_strategy, matcher_options);
+
+  CreateDescriptorExtractorOptions descriptor_extractor_options;
+  descriptor_extractor_options.descriptor_extractor_type =
+      options_.descriptor_extractor_type;
+  descriptor_extractor_options.sift_options = options_.sift_parameters;
+  // The images are already extracted in parallel, so each image is extracted
+  // on a single thread instead of nesting a thread pool for its tiles.
+  if (options_.num_threads > 1) {
+    descriptor_extractor_options.sift_options.num_threads = 1;
+  }
+  descriptor_extractor_pool_.reset(
+      new DescriptorExtractorPool(descriptor_extractor_options));
 }
 
 bool FeatureExtractorAndMatcher::AddImage(const std::string& image_filepath) {
@@ -199,7 +247,13 @@ void FeatureExtractorAndMatcher::ProcessImage(
   // Extract Features.
   std::vector<Keypoint> keypoints;
   std::vector<Eigen::VectorXf> descriptors;
-  ExtractFeatures(options_, image_filepath, &keypoints, &descriptors);
+  KeypointColors keypoint_colors;
+  ExtractFeatures(options_,
+                  image_filepath,
+                  descriptor_extractor_pool_.get(),
+                  &keypoints,
+                  &descriptors,
+                  &keypoint_colors);
 
   // Add the relevant image and feature data to the feature matcher. This allows
   // the feature matcher to control fine-grained things like multi-threading and
@@ -209,6 +263,9 @@ void FeatureExtractorAndMatcher::ProcessImage(
   CHECK(GetFilenameFromFilepath(image_filepath, true, &image_filename));
   matcher_mutex_.lock();
   matcher_->AddImage(image_filename, keypoints, descriptors, intrinsics);
+  if (options_.extract_keypoint_colors) {
+    keypoint_colors_.emplace(image_filename, std::move(keypoint_colors));
+  }
   matcher_mutex_.unlock();
 }
 
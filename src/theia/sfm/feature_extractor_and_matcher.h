@@ -37,13 +37,17 @@
 
 #include <string>
 #include <thread>  // NOLINT
+#include <unordered_map>
 #include <vector>
 
 #include "theia/image/descriptor/create_descriptor_extractor.h"
+#include "theia/image/image_loader.h"
+#include "theia/image/keypoint_detector/keypoint_selection.h"
 #include "theia/matching/create_feature_matcher.h"
 #include "theia/matching/feature_matcher_options.h"
 #include "theia/matching/image_pair_match.h"
 #include "theia/sfm/camera_intrinsics_prior.h"
+#include "theia/sfm/colorize_reconstruction.h"
 #include "theia/sfm/estimate_twoview_info.h"
 #include "theia/sfm/exif_reader.h"
 #include "theia/sfm/verify_two_view_matches.h"
@@ -71,6 +75,22 @@ class FeatureExtractorAndMatcher {
     // The features returned will be no larger than this size.
     int max_num_features = 16384;
 
+    // Determines which features are kept when more than max_num_features
+    // features are detected.
+    KeypointSelectionOptions keypoint_selection_options;
+
+    // Options for decoding the images, which may be decoded at a reduced
+    // resolution. Keypoints are always returned in the coordinates of the full
+    // resolution image. Images are decoded by the threads that extract the
+    // features, so the streaming options are not used.
+    ImageLoaderOptions image_loader_options;
+
+    // If true, the images are decoded in color and the colors at the
+    // keypoints are recorded so that the reconstruction can be colored without
+    // reading the images again (see ColorizeReconstructionFromKeypointColors).
+    // Decoding the color channels makes the extraction slightly slower.
+    bool extract_keypoint_colors = false;
+
     // Minimum number of inliers to consider the matches a good match.
     int min_num_inlier_matches = 30;
 
@@ -103,6 +123,13 @@ class FeatureExtractorAndMatcher {
       std::vector<CameraIntrinsicsPrior>* intrinsics,
       std::vector<ImagePairMatch>* matches);
 
+  // The colors of the keypoints of each image, keyed by the image filename.
+  // Only set if the keypoint colors are extracted.
+  const std::unordered_map<std::string, KeypointColors>& keypoint_colors()
+      const {
+    return keypoint_colors_;
+  }
+
  private:
   // Processes a single image by extracting EXIF information, extracting
   // features and descriptors, and adding the image to the matcher.
@@ -114,12 +141,16 @@ class FeatureExtractorAndMatcher {
   // intrinsics.
   std::vector<std::string> image_filepaths_;
   std::unordered_map<std::string, CameraIntrinsicsPrior> intrinsics_;
+  std::unordered_map<std::string, KeypointColors> keypoint_colors_;
 
   // Exif reader for loading exif information. This object is created once so
   // that the EXIF focal length database does not have to be loaded multiple
   // times.
   ExifReader exif_reader_;
 
+  // Descriptor extractors are reused across images by the threads.
+  std::unique_ptr<DescriptorExtractorPool> descriptor_extractor_pool_;
+
   // Feature matcher and mutex for thread-safe access.
   std::unique_ptr<FeatureMatcher<L2> > matcher_;
   std::mutex intrinsics_mutex_, matcher_mutex_;
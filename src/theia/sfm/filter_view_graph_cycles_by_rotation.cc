@@ -131,9 +131,7 @@ void FilterViewGraphCyclesByRotation(const double max_loop_error_degrees,
           << view_pairs.size() << " view pairs from loop rotation filtering.";
 
   // Remove any view pairs not in the list of valid edges.
-  for (const ViewIdPair& view_pair_id : invalid_view_pairs) {
-    view_graph->RemoveEdge(view_pair_id.first, view_pair_id.second);
-  }
+  view_graph->RemoveEdges(invalid_view_pairs);
 }
 
 }  // namespace theia
@@ -96,21 +96,25 @@ void FilterViewPairsFromOrientation(
   CHECK_GE(max_relative_rotation_difference_degrees, 0.0);
 
   std::unordered_set<ViewIdPair> view_pairs_to_remove;
-  const auto& view_pairs = view_graph->GetAllEdges();
-  for (const auto& view_pair : view_pairs) {
+  for (int i = 0; i < view_graph->NumEdgeSlots(); i++) {
+    if (view_graph->IsEdgeSlotRemoved(i)) {
+      continue;
+    }
+
+    const ViewIdPair& view_id_pair = view_graph->EdgeViewIdPair(i);
     const Eigen::Vector3d* orientation1 =
-        FindOrNull(orientations, view_pair.first.first);
+        FindOrNull(orientations, view_id_pair.first);
     const Eigen::Vector3d* orientation2 =
-        FindOrNull(orientations, view_pair.first.second);
+        FindOrNull(orientations, view_id_pair.second);
 
     // If the view pair contains a view that does not have an orientation then
     // remove it.
     if (orientation1 == nullptr || orientation2 == nullptr) {
       LOG(WARNING)
-          << "View pair (" << view_pair.first.first << ", "
-          << view_pair.first.second
+          << "View pair (" << view_id_pair.first << ", "
+          << view_id_pair.second
           << ") contains a view that does not exist! Removing the view pair.";
-      view_pairs_to_remove.insert(view_pair.first);
+      view_pairs_to_remove.insert(view_id_pair);
       continue;
     }
 
@@ -119,16 +123,14 @@ void FilterViewPairsFromOrientation(
     if (!AngularDifferenceIsAcceptable(
             *orientation1,
             *orientation2,
-            view_pair.second.rotation_2,
+            view_graph->EdgeValue(i).rotation_2,
             max_relative_rotation_difference_degrees)) {
-      view_pairs_to_remove.insert(view_pair.first);
+      view_pairs_to_remove.insert(view_id_pair);
     }
   }
 
   // Remove all the "bad" relative poses.
-  for (const ViewIdPair view_id_pair : view_pairs_to_remove) {
-    view_graph->RemoveEdge(view_id_pair.first, view_id_pair.second);
-  }
+  view_graph->RemoveEdges(view_pairs_to_remove);
   VLOG(1) << "Removed " << view_pairs_to_remove.size()
           << " view pairs by rotation filtering.";
 }
@@ -40,6 +40,7 @@
 #include <memory>
 #include <mutex>  // NOLINT
 #include <unordered_map>
+#include <unordered_set>
 
 #include "theia/math/util.h"
 #include "theia/util/hash.h"
@@ -194,21 +195,13 @@ void ComputeMeanVariance(
   *variance /= static_cast<double>(relative_translations.size() - 1);
 }
 
-// Performs a single iterations of the translation filtering. This method is
-// thread-safe.
+// Performs a single iterations of the translation filtering by projecting all
+// relative translations onto the random axis. This method is thread-safe.
 void TranslationFilteringIteration(
     const std::unordered_map<ViewIdPair, Vector3d>& relative_translations,
-    const Vector3d& direction_mean,
-    const Vector3d& direction_variance,
+    const Vector3d& random_axis,
     std::mutex* mutex,
     std::unordered_map<ViewIdPair, double>* bad_edge_weight) {
-  // Get a random vector to project all relative translations on to.
-  const Vector3d random_axis =
-      Vector3d(RandGaussian(direction_mean[0], direction_variance[0]),
-               RandGaussian(direction_mean[1], direction_variance[1]),
-               RandGaussian(direction_mean[2], direction_variance[2]))
-          .normalized();
-
   // Project all vectors.
   const std::unordered_map<ViewIdPair, double>&
       translation_direction_projections =
@@ -266,13 +259,22 @@ void FilterViewPairsFromRelativeTranslation(
                       &translation_mean,
                       &translation_variance);
 
+  // The random axes are drawn before the iterations are distributed to the
+  // threads so that they do not depend on the order in which the threads run.
+  std::shared_ptr<RandomNumberGenerator> rng =
+      options.rng ? options.rng : std::make_shared<RandomNumberGenerator>();
   std::unique_ptr<ThreadPool> pool(new ThreadPool(options.num_threads));
   std::mutex mutex;
   for (int i = 0; i < options.num_iterations; i++) {
+    Vector3d random_axis;
+    for (int j = 0; j < 3; j++) {
+      random_axis[j] =
+          rng->RandGaussian(translation_mean[j], translation_variance[j]);
+    }
+    random_axis.normalize();
     pool->Add(TranslationFilteringIteration,
               rotated_translations,
-              translation_mean,
-              translation_variance,
+              random_axis,
               &mutex,
               &bad_edge_weight);
   }
@@ -281,15 +283,16 @@ void FilterViewPairsFromRelativeTranslation(
   // Remove all the bad edges.
   const double max_aggregated_projection_tolerance =
       options.translation_projection_tolerance * options.num_iterations;
-  int num_view_pairs_removed = 0;
+  std::unordered_set<ViewIdPair> view_pairs_to_remove;
   for (const auto& view_pair : bad_edge_weight) {
     VLOG(3) << "View pair (" << view_pair.first.first << ", "
             << view_pair.first.second << ") projection = " << view_pair.second;
     if (view_pair.second > max_aggregated_projection_tolerance) {
-      view_graph->RemoveEdge(view_pair.first.first, view_pair.first.second);
-      ++num_view_pairs_removed;
+      view_pairs_to_remove.insert(view_pair.first);
     }
   }
+  const int num_view_pairs_removed =
+      view_graph->RemoveEdges(view_pairs_to_remove);
 
   VLOG(1) << "Removed " << num_view_pairs_removed
           << " view pairs by relative translation filtering.";
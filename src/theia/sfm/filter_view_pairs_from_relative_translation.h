@@ -36,9 +36,11 @@
 #define THEIA_SFM_FILTER_VIEW_PAIRS_FROM_RELATIVE_TRANSLATION_H_
 
 #include <Eigen/Core>
+#include <memory>
 #include <unordered_map>
 
 #include "theia/sfm/types.h"
+#include "theia/util/random.h"
 
 namespace theia {
 
@@ -57,6 +59,10 @@ struct FilterViewPairsFromRelativeTranslationOptions {
   // translations are considered "bad" after analyzing their projections over
   // many iterations (it corresponds to tau in the paper).
   double translation_projection_tolerance = 0.08;
+
+  // The random number generator used to sample the projection axes. If null, a
+  // generator seeded from the current time is used.
+  std::shared_ptr<RandomNumberGenerator> rng;
 };
 
 // Filters view pairs based on the relative translation estimations according to
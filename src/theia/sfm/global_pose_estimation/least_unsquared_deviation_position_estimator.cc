@@ -42,6 +42,7 @@
 #include "theia/sfm/global_pose_estimation/pairwise_translation_and_scale_error.h"
 #include "theia/sfm/types.h"
 #include "theia/util/map_util.h"
+#include "theia/util/random.h"
 #include "theia/util/util.h"
 
 namespace theia {
@@ -132,10 +133,15 @@ void LeastUnsquaredDeviationPositionEstimator::InitializeRandomPositions(
     constrained_positions.insert(view_pair.first.second);
   }
 
+  std::shared_ptr<RandomNumberGenerator> rng =
+      options_.rng ? options_.rng : std::make_shared<RandomNumberGenerator>();
   positions->reserve(orientations.size());
   for (const auto& orientation : orientations) {
     if (ContainsKey(constrained_positions, orientation.first)) {
-      (*positions)[orientation.first] = 100.0 * Vector3d::Random();
+      (*positions)[orientation.first] =
+          Vector3d(rng->RandDouble(-100.0, 100.0),
+                   rng->RandDouble(-100.0, 100.0),
+                   rng->RandDouble(-100.0, 100.0));
     }
   }
 }
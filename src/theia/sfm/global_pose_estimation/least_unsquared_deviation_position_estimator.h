@@ -42,6 +42,7 @@
 #include <vector>
 
 #include "theia/util/hash.h"
+#include "theia/util/random.h"
 #include "theia/util/util.h"
 #include "theia/sfm/global_pose_estimation/position_estimator.h"
 #include "theia/sfm/types.h"
@@ -72,6 +73,10 @@ class LeastUnsquaredDeviationPositionEstimator : public PositionEstimator {
 
     // A measurement for convergence criterion.
     double convergence_criterion = 1e-4;
+
+    // The random number generator used to initialize the positions. If null, a
+    // generator seeded from the current time is used.
+    std::shared_ptr<RandomNumberGenerator> rng;
   };
 
   LeastUnsquaredDeviationPositionEstimator(
@@ -37,6 +37,7 @@
 #include <Eigen/Dense>
 #include <Eigen/Geometry>
 #include <algorithm>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -52,6 +53,7 @@
 #include "theia/sfm/transformation/align_point_clouds.h"
 #include "theia/sfm/types.h"
 #include "theia/util/map_util.h"
+#include "theia/util/random.h"
 #include "theia/util/stringprintf.h"
 
 namespace theia {
@@ -149,6 +151,7 @@ class EstimatePositionsLeastUnsquaredDeviationTest : public ::testing::Test {
  protected:
   void SetUp() {
     srand(1234);
+    options_.rng = std::make_shared<RandomNumberGenerator>(1234);
   }
 
   void SetupScene(const int num_views) {
@@ -38,15 +38,20 @@
 #include <ceres/rotation.h>
 #include <Eigen/Core>
 #include <algorithm>
+#include <cmath>
+#include <limits>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "theia/sfm/camera/camera.h"
 #include "theia/sfm/global_pose_estimation/pairwise_translation_error.h"
 #include "theia/sfm/reconstruction.h"
 #include "theia/sfm/types.h"
 #include "theia/util/map_util.h"
+#include "theia/util/random.h"
+#include "theia/util/threadpool.h"
 #include "theia/util/util.h"
 
 namespace theia {
@@ -64,20 +69,159 @@ Vector3d GetRotatedTranslation(const Vector3d& rotation_angle_axis,
   return rotation.transpose() * translation;
 }
 
-Vector3d GetRotatedFeatureRay(const Camera& camera,
-                              const Vector3d& orientation,
-                              const Feature& feature) {
-  Camera temp_camera = camera;
-  temp_camera.SetOrientationFromAngleAxis(orientation);
-  // Get the image ray rotated into the world reference frame.
-  return camera.PixelToUnitDepthRay(feature).normalized();
+// A point to camera constraint that has been set up by a worker thread but
+// not yet added to the problem, since ceres::Problem may not be modified from
+// several threads at once.
+struct PointToCameraConstraint {
+  ceres::CostFunction* cost_function;
+  double* camera_position;
+  double* point;
+};
+
+// Returns true if track 1 is a better candidate for a point to camera
+// constraint than track 2. Tracks that are observed in more views are
+// preferred and ties are broken by the track id so that the selection is
+// deterministic.
+bool IsBetterTrack(const std::pair<TrackId, int>& t1,
+                   const std::pair<TrackId, int>& t2) {
+  return t1.second > t2.second ||
+         (t1.second == t2.second && t1.first < t2.first);
 }
 
-// Sorts the pairs such that the number of views (i.e. the int) is sorted in
-// descending order.
-bool CompareViewsPerTrack(const std::pair<TrackId, int>& t1,
-                          const std::pair<TrackId, int>& t2) {
-  return t1.second > t2.second;
+// Ranks the tracks observed in the view and returns (at most) the
+// num_tracks_to_select best tracks. The image is divided into a grid with
+// roughly num_tracks_to_select cells and the best track of each cell is chosen
+// first so that the selected tracks are well-distributed across the image. Any
+// remaining tracks are chosen by the number of views observing them. This runs
+// in time linear in the number of features of the view.
+void RankTracksForView(const Reconstruction* reconstruction,
+                       const View* view,
+                       const int num_tracks_to_select,
+                       std::vector<TrackId>* ranked_tracks) {
+  std::vector<std::pair<TrackId, int> > candidates;
+  std::vector<Feature> features;
+  candidates.reserve(view->NumFeatures());
+  features.reserve(view->NumFeatures());
+  Eigen::Vector2d min_feature(std::numeric_limits<double>::max(),
+                              std::numeric_limits<double>::max());
+  Eigen::Vector2d max_feature = -min_feature;
+  for (const TrackId track_id : view->TrackIds()) {
+    const Track* track = reconstruction->Track(track_id);
+    if (track == nullptr) {
+      continue;
+    }
+    candidates.emplace_back(track_id, track->NumViews());
+    features.emplace_back(*view->GetFeature(track_id));
+    min_feature = min_feature.cwiseMin(features.back());
+    max_feature = max_feature.cwiseMax(features.back());
+  }
+
+  ranked_tracks->clear();
+  if (candidates.size() <= num_tracks_to_select) {
+    std::sort(candidates.begin(), candidates.end(), IsBetterTrack);
+    for (const auto& candidate : candidates) {
+      ranked_tracks->emplace_back(candidate.first);
+    }
+    return;
+  }
+
+  // Find the best track in each grid cell.
+  const int grid_size =
+      std::ceil(std::sqrt(static_cast<double>(num_tracks_to_select)));
+  const Eigen::Vector2d cell_size =
+      ((max_feature - min_feature) / grid_size)
+          .cwiseMax(Eigen::Vector2d::Constant(1e-8));
+  std::vector<int> best_candidate_in_cell(grid_size * grid_size, -1);
+  for (int i = 0; i < candidates.size(); i++) {
+    const Eigen::Vector2d cell = (features[i] - min_feature).cwiseQuotient(
+        cell_size);
+    const int cell_x = std::min(static_cast<int>(cell.x()), grid_size - 1);
+    const int cell_y = std::min(static_cast<int>(cell.y()), grid_size - 1);
+    int& best_candidate = best_candidate_in_cell[cell_y * grid_size + cell_x];
+    if (best_candidate < 0 ||
+        IsBetterTrack(candidates[i], candidates[best_candidate])) {
+      best_candidate = i;
+    }
+  }
+
+  // Choose the best track of each cell first, then fill up the remaining
+  // tracks with the best tracks overall.
+  std::vector<std::pair<TrackId, int> > cell_winners, remaining_candidates;
+  std::vector<bool> is_cell_winner(candidates.size(), false);
+  for (const int best_candidate : best_candidate_in_cell) {
+    if (best_candidate >= 0) {
+      is_cell_winner[best_candidate] = true;
+      cell_winners.emplace_back(candidates[best_candidate]);
+    }
+  }
+  std::sort(cell_winners.begin(), cell_winners.end(), IsBetterTrack);
+  const int num_cell_winners_to_select =
+      std::min(static_cast<int>(cell_winners.size()), num_tracks_to_select);
+  for (int i = 0; i < num_cell_winners_to_select; i++) {
+    ranked_tracks->emplace_back(cell_winners[i].first);
+  }
+
+  const int num_remaining_tracks =
+      num_tracks_to_select - num_cell_winners_to_select;
+  if (num_remaining_tracks == 0) {
+    return;
+  }
+  remaining_candidates.reserve(candidates.size() - cell_winners.size());
+  for (int i = 0; i < candidates.size(); i++) {
+    if (!is_cell_winner[i]) {
+      remaining_candidates.emplace_back(candidates[i]);
+    }
+  }
+  std::nth_element(remaining_candidates.begin(),
+                   remaining_candidates.begin() + num_remaining_tracks - 1,
+                   remaining_candidates.end(),
+                   IsBetterTrack);
+  std::sort(remaining_candidates.begin(),
+            remaining_candidates.begin() + num_remaining_tracks,
+            IsBetterTrack);
+  for (int i = 0; i < num_remaining_tracks; i++) {
+    ranked_tracks->emplace_back(remaining_candidates[i].first);
+  }
+}
+
+// Sets up the point to camera constraints for the tracks in
+// [track_ids[start], track_ids[end]). The feature rays are rotated into the
+// global orientation frame with the cameras, which must already be set to the
+// estimated orientations.
+void SetupPointToCameraConstraints(
+    const Reconstruction* reconstruction,
+    const std::unordered_map<ViewId, Camera>* cameras,
+    const std::vector<TrackId>* track_ids,
+    const int start,
+    const int end,
+    const double point_to_camera_weight,
+    std::unordered_map<ViewId, Vector3d>* positions,
+    std::unordered_map<TrackId, Vector3d>* points,
+    std::vector<PointToCameraConstraint>* constraints) {
+  for (int i = start; i < end; i++) {
+    const TrackId track_id = (*track_ids)[i];
+    Vector3d& point = FindOrDie(*points, track_id);
+    for (const ViewId view_id : reconstruction->Track(track_id)->ViewIds()) {
+      Vector3d* camera_position = FindOrNull(*positions, view_id);
+      if (camera_position == nullptr) {
+        continue;
+      }
+
+      // Rotate the feature ray to be in the global orientation frame.
+      const Vector3d feature_ray =
+          FindOrDie(*cameras, view_id)
+              .PixelToUnitDepthRay(
+                  *reconstruction->View(view_id)->GetFeature(track_id))
+              .normalized();
+
+      PointToCameraConstraint constraint;
+      constraint.cost_function =
+          PairwiseTranslationError::Create(feature_ray, point_to_camera_weight);
+      constraint.camera_position = camera_position->data();
+      constraint.point = point.data();
+      constraints->emplace_back(constraint);
+    }
+  }
 }
 
 }  // namespace
@@ -90,6 +234,8 @@ NonlinearPositionEstimator::NonlinearPositionEstimator(
   CHECK_GE(options_.min_num_points_per_view, 0);
   CHECK_GT(options_.point_to_camera_weight, 0);
   CHECK_GT(options_.robust_loss_width, 0);
+  rng_ = options_.rng ? options_.rng
+                      : std::make_shared<RandomNumberGenerator>();
 }
 
 bool NonlinearPositionEstimator::EstimatePositions(
@@ -168,7 +314,10 @@ void NonlinearPositionEstimator::InitializeRandomPositions(
   positions->reserve(orientations.size());
   for (const auto& orientation : orientations) {
     if (ContainsKey(constrained_positions, orientation.first)) {
-      (*positions)[orientation.first] = 100.0 * Vector3d::Random();
+      (*positions)[orientation.first] =
+          Vector3d(rng_->RandDouble(-100.0, 100.0),
+                   rng_->RandDouble(-100.0, 100.0),
+                   rng_->RandDouble(-100.0, 100.0));
     }
   }
 }
@@ -222,14 +371,64 @@ void NonlinearPositionEstimator::AddPointToCameraConstraints(
       static_cast<double>(num_camera_to_camera_constraints) /
       static_cast<double>(num_point_to_camera_constraints);
 
-  triangulated_points_.reserve(tracks_to_add.size());
-  for (const TrackId track_id : tracks_to_add) {
-    triangulated_points_[track_id] = 100.0 * Vector3d::Random();
+  // Sort the tracks so that the problem is assembled in the same order
+  // regardless of the number of threads.
+  std::vector<TrackId> sorted_tracks(tracks_to_add.begin(),
+                                     tracks_to_add.end());
+  std::sort(sorted_tracks.begin(), sorted_tracks.end());
+  triangulated_points_.reserve(sorted_tracks.size());
+  for (const TrackId track_id : sorted_tracks) {
+    triangulated_points_[track_id] =
+        Vector3d(rng_->RandDouble(-100.0, 100.0),
+                 rng_->RandDouble(-100.0, 100.0),
+                 rng_->RandDouble(-100.0, 100.0));
+  }
+
+  // Set the cameras to the estimated orientations once so that the feature
+  // rays may be rotated into the global orientation frame.
+  std::unordered_map<ViewId, Camera> cameras;
+  cameras.reserve(positions->size());
+  for (const auto& position : *positions) {
+    Camera& camera = cameras[position.first];
+    camera = reconstruction_.View(position.first)->Camera();
+    camera.SetOrientationFromAngleAxis(
+        FindOrDie(orientations, position.first));
+  }
+
+  // Each thread sets up the constraints for a contiguous block of tracks. The
+  // constraints are then added to the problem in order.
+  const int num_threads =
+      std::min(options_.num_threads, static_cast<int>(sorted_tracks.size()));
+  const int num_tracks_per_thread =
+      (sorted_tracks.size() + num_threads - 1) / num_threads;
+  std::vector<std::vector<PointToCameraConstraint> > constraints(num_threads);
+  {
+    ThreadPool pool(num_threads);
+    for (int i = 0; i < num_threads; i++) {
+      const int start = i * num_tracks_per_thread;
+      const int end = std::min(static_cast<int>(sorted_tracks.size()),
+                               start + num_tracks_per_thread);
+      pool.Add(SetupPointToCameraConstraints,
+               &reconstruction_,
+               &cameras,
+               &sorted_tracks,
+               start,
+               end,
+               point_to_camera_weight,
+               positions,
+               &triangulated_points_,
+               &constraints[i]);
+    }
+  }
 
-    AddTrackToProblem(track_id,
-                      orientations,
-                      point_to_camera_weight,
-                      positions);
+  for (const auto& thread_constraints : constraints) {
+    for (const PointToCameraConstraint& constraint : thread_constraints) {
+      problem_->AddResidualBlock(
+          constraint.cost_function,
+          new ceres::HuberLoss(options_.robust_loss_width),
+          constraint.camera_position,
+          constraint.point);
+    }
   }
 
   VLOG(2) << num_point_to_camera_constraints << " point to camera constriants "
@@ -243,36 +442,51 @@ int NonlinearPositionEstimator::FindTracksForProblem(
   CHECK_NOTNULL(tracks_to_add)->clear();
 
   std::unordered_map<ViewId, int> tracks_per_camera;
+  std::vector<ViewId> view_ids;
+  view_ids.reserve(positions.size());
   for (const auto& position : positions) {
     tracks_per_camera[position.first] = 0;
-  }
-
-  // Add the tracks that see the most views until each camera has the minimum
-  // number of tracks.
-  for (const auto& position : positions) {
     const View* view = reconstruction_.View(position.first);
-    if (view == nullptr ||
-        view->NumFeatures() < options_.min_num_points_per_view) {
-      continue;
+    if (view != nullptr &&
+        view->NumFeatures() >= options_.min_num_points_per_view) {
+      view_ids.emplace_back(position.first);
     }
+  }
+  // Visit the views in a fixed order so that the selection is deterministic.
+  std::sort(view_ids.begin(), view_ids.end());
+
+  // Rank the candidate tracks of each view in parallel.
+  std::vector<std::vector<TrackId> > ranked_tracks(view_ids.size());
+  {
+    ThreadPool pool(options_.num_threads);
+    for (int i = 0; i < view_ids.size(); i++) {
+      pool.Add(RankTracksForView,
+               &reconstruction_,
+               reconstruction_.View(view_ids[i]),
+               options_.min_num_points_per_view,
+               &ranked_tracks[i]);
+    }
+  }
 
-    // Get the tracks in sorted order so that we add the tracks that see the
-    // most cameras first.
-    const std::vector<TrackId>& sorted_tracks =
-        GetTracksSortedByNumViews(reconstruction_, *view, *tracks_to_add);
+  // Add the best tracks of each view until each camera has the minimum number
+  // of tracks. Since all ranked tracks of a view observe that view, the view
+  // is guaranteed to be constrained by enough tracks once its ranked tracks
+  // have been added, whether they were added for this view or another view.
+  for (int i = 0; i < view_ids.size(); i++) {
+    for (const TrackId track_id : ranked_tracks[i]) {
+      if (tracks_per_camera[view_ids[i]] >= options_.min_num_points_per_view) {
+        break;
+      }
+      if (!tracks_to_add->insert(track_id).second) {
+        continue;
+      }
 
-    for (int i = 0;
-         i < sorted_tracks.size() && tracks_per_camera[position.first] <
-                                         options_.min_num_points_per_view;
-         i++) {
       // Update the number of point to camera constraints for each camera.
-      tracks_to_add->insert(sorted_tracks[i]);
-      for (const ViewId view_id :
-           reconstruction_.Track(sorted_tracks[i])->ViewIds()) {
-        if (!ContainsKey(positions, view_id)) {
-          continue;
+      for (const ViewId view_id : reconstruction_.Track(track_id)->ViewIds()) {
+        int* num_tracks = FindOrNull(tracks_per_camera, view_id);
+        if (num_tracks != nullptr) {
+          ++(*num_tracks);
         }
-        ++tracks_per_camera[view_id];
       }
     }
   }
@@ -284,75 +498,6 @@ int NonlinearPositionEstimator::FindTracksForProblem(
   return num_point_to_camera_constraints;
 }
 
-std::vector<TrackId> NonlinearPositionEstimator::GetTracksSortedByNumViews(
-    const Reconstruction& reconstruction,
-    const View& view,
-    const std::unordered_set<TrackId>& existing_tracks) {
-  std::vector<std::pair<TrackId, int> > views_per_track;
-  views_per_track.reserve(view.NumFeatures());
-  const auto& track_ids = view.TrackIds();
-  for (const auto& track_id : track_ids) {
-    const Track* track = reconstruction.Track(track_id);
-
-    if (track == nullptr || ContainsKey(existing_tracks, track_id)) {
-      continue;
-    }
-    views_per_track.emplace_back(track_id, track->NumViews());
-  }
-
-  // Return an empty array if no tracks could be found for this view.
-  std::vector<TrackId> sorted_tracks(views_per_track.size());
-  if (views_per_track.size() == 0) {
-    return sorted_tracks;
-  }
-
-  // Sort the tracks by the number of views. Only sort the first few tracks
-  // since those are the ones that will be added to the problem.
-  const int num_tracks_to_sort =
-      std::min(static_cast<int>(views_per_track.size()),
-               options_.min_num_points_per_view);
-  std::partial_sort(views_per_track.begin(),
-                    views_per_track.begin() + num_tracks_to_sort,
-                    views_per_track.end(), CompareViewsPerTrack);
-
-  for (int i = 0; i < num_tracks_to_sort; i++) {
-    sorted_tracks[i] = views_per_track[i].first;
-  }
-  return sorted_tracks;
-}
-
-void NonlinearPositionEstimator::AddTrackToProblem(
-    const TrackId track_id,
-    const std::unordered_map<ViewId, Vector3d>& orientations,
-    const double point_to_camera_weight,
-    std::unordered_map<ViewId, Vector3d>* positions) {
-  // For each view in the track add the point to camera correspondences.
-  for (const ViewId view_id : reconstruction_.Track(track_id)->ViewIds()) {
-    if (!ContainsKey(*positions, view_id)) {
-      continue;
-    }
-    Vector3d& camera_position = FindOrDie(*positions, view_id);
-    Vector3d& point = FindOrDie(triangulated_points_, track_id);
-
-    // Rotate the feature ray to be in the global orientation frame.
-    const Vector3d feature_ray = GetRotatedFeatureRay(
-        reconstruction_.View(view_id)->Camera(),
-        FindOrDie(orientations, view_id),
-        *reconstruction_.View(view_id)->GetFeature(track_id));
-
-    // Rotate the relative translation so that it is aligned to the global
-    // orientation frame.
-    ceres::CostFunction* cost_function =
-        PairwiseTranslationError::Create(feature_ray, point_to_camera_weight);
-
-    // Add the residual block
-    problem_->AddResidualBlock(cost_function,
-                               new ceres::HuberLoss(options_.robust_loss_width),
-                               camera_position.data(),
-                               point.data());
-  }
-}
-
 void NonlinearPositionEstimator::AddCamerasAndPointsToParameterGroups(
     std::unordered_map<ViewId, Vector3d>* positions) {
   CHECK_GT(triangulated_points_.size(), 0)
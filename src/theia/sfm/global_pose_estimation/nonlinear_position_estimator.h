@@ -39,6 +39,7 @@
 #include <Eigen/Core>
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "theia/util/util.h"
@@ -46,6 +47,7 @@
 #include "theia/sfm/reconstruction.h"
 #include "theia/sfm/types.h"
 #include "theia/sfm/view_triplet.h"
+#include "theia/util/random.h"
 
 namespace theia {
 
@@ -70,6 +72,10 @@ class NonlinearPositionEstimator : public PositionEstimator {
     // The total weight of all point to camera correspondences compared to
     // camera to camera correspondences.
     double point_to_camera_weight = 0.5;
+
+    // The random number generator used to initialize the positions and points.
+    // If null, a generator seeded from the current time is used.
+    std::shared_ptr<RandomNumberGenerator> rng;
   };
 
   NonlinearPositionEstimator(
@@ -94,31 +100,21 @@ class NonlinearPositionEstimator : public PositionEstimator {
       const std::unordered_map<ViewId, Eigen::Vector3d>& orientations,
       std::unordered_map<ViewId, Eigen::Vector3d>* positions);
 
-  // Creates point to camera constraints.
+  // Creates point to camera constraints. The constraints are set up in parallel
+  // and then added to the problem.
   void AddPointToCameraConstraints(
       const std::unordered_map<ViewId, Eigen::Vector3d>& orientations,
       std::unordered_map<ViewId, Eigen::Vector3d>* positions);
 
   // Determines which tracks should be used for point to camera constraints. A
-  // greedy approach is used so that the fewest number of tracks are chosen such
-  // that all cameras have at least k point to camera constraints.
+  // greedy approach is used so that few tracks are chosen such that all
+  // cameras have at least k point to camera constraints. The candidate tracks
+  // of each view are ranked in parallel such that they are well-distributed
+  // across the image. Returns the number of point to camera constraints.
   int FindTracksForProblem(
       const std::unordered_map<ViewId, Eigen::Vector3d>& global_poses,
       std::unordered_set<TrackId>* tracks_to_add);
 
-  // Sort the tracks by the number of views that observe them.
-  std::vector<TrackId> GetTracksSortedByNumViews(
-      const Reconstruction& reconstruction,
-      const View& view,
-      const std::unordered_set<TrackId>& existing_tracks);
-
-  // Adds all point to camera constraints for a given track.
-  void AddTrackToProblem(
-      const TrackId track_id,
-      const std::unordered_map<ViewId, Eigen::Vector3d>& orientations,
-      const double point_to_camera_weight,
-      std::unordered_map<ViewId, Eigen::Vector3d>* positions);
-
   // Adds the points and cameras to parameters groups 0 and 1 respectively. This
   // allows for the Schur-based methods to take advantage of the sparse block
   // structure of the problem by eliminating points first, then cameras. This
@@ -131,6 +127,7 @@ class NonlinearPositionEstimator : public PositionEstimator {
   const Reconstruction& reconstruction_;
   const std::unordered_map<ViewIdPair, TwoViewInfo>* view_pairs_;
 
+  std::shared_ptr<RandomNumberGenerator> rng_;
   std::unordered_map<TrackId, Eigen::Vector3d> triangulated_points_;
   std::unique_ptr<ceres::Problem> problem_;
   ceres::Solver::Options solver_options_;
@@ -37,8 +37,10 @@
 #include <Eigen/Dense>
 #include <Eigen/Geometry>
 #include <algorithm>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -52,6 +54,7 @@
 #include "theia/sfm/transformation/align_point_clouds.h"
 #include "theia/sfm/types.h"
 #include "theia/util/map_util.h"
+#include "theia/util/random.h"
 #include "theia/util/stringprintf.h"
 
 namespace theia {
@@ -158,9 +161,53 @@ class EstimatePositionsNonlinearTest : public ::testing::Test {
     }
   }
 
+  // Returns the number of point to camera constraints.
+  int TestFindTracksForProblem(const int num_views,
+                               const int num_tracks,
+                               const int min_num_points_per_view,
+                               std::unordered_set<TrackId>* tracks_to_add) {
+    SetupReconstruction(num_views, num_tracks);
+    options_.min_num_points_per_view = min_num_points_per_view;
+
+    // The selected tracks must not depend on the number of threads.
+    std::unordered_set<TrackId> single_threaded_tracks;
+    options_.num_threads = 1;
+    NonlinearPositionEstimator single_threaded_estimator(options_,
+                                                         reconstruction_);
+    const int num_constraints = single_threaded_estimator.FindTracksForProblem(
+        positions_, &single_threaded_tracks);
+
+    std::unordered_set<TrackId> multi_threaded_tracks;
+    options_.num_threads = 4;
+    NonlinearPositionEstimator multi_threaded_estimator(options_,
+                                                        reconstruction_);
+    EXPECT_EQ(multi_threaded_estimator.FindTracksForProblem(
+                  positions_, &multi_threaded_tracks),
+              num_constraints);
+    EXPECT_EQ(single_threaded_tracks, multi_threaded_tracks);
+
+    // Each view must be constrained by enough tracks.
+    std::unordered_map<ViewId, int> tracks_per_view;
+    for (const TrackId track_id : single_threaded_tracks) {
+      for (const ViewId view_id : reconstruction_.Track(track_id)->ViewIds()) {
+        ++tracks_per_view[view_id];
+      }
+    }
+    int num_observations = 0;
+    for (const auto& position : positions_) {
+      EXPECT_GE(tracks_per_view[position.first], min_num_points_per_view);
+      num_observations += tracks_per_view[position.first];
+    }
+    EXPECT_EQ(num_observations, num_constraints);
+
+    tracks_to_add->swap(single_threaded_tracks);
+    return num_constraints;
+  }
+
  protected:
   void SetUp() {
     srand(1234);
+    options_.rng = std::make_shared<RandomNumberGenerator>(1234);
   }
 
   void SetupReconstruction(const int num_views, const int num_tracks) {
@@ -281,4 +328,18 @@ TEST_F(EstimatePositionsNonlinearTest, SmallTestWithNoise) {
                                  kTolerance);
 }
 
+TEST_F(EstimatePositionsNonlinearTest, FindTracksForProblem) {
+  static const int kNumViews = 10;
+  static const int kNumTracks = 200;
+  static const int kMinNumPointsPerView = 12;
+  std::unordered_set<TrackId> tracks_to_add;
+  const int num_constraints = TestFindTracksForProblem(
+      kNumViews, kNumTracks, kMinNumPointsPerView, &tracks_to_add);
+
+  // All tracks are observed in all views so the minimum number of tracks is
+  // sufficient to constrain all views.
+  EXPECT_EQ(num_constraints, kNumViews * kMinNumPointsPerView);
+  EXPECT_EQ(tracks_to_add.size(), kMinNumPointsPerView);
+}
+
 }  // namespace theia
@@ -60,6 +60,7 @@
 #include "theia/sfm/view_graph/remove_disconnected_view_pairs.h"
 #include "theia/sfm/view_graph/view_graph.h"
 #include "theia/solvers/sample_consensus_estimator.h"
+#include "theia/util/profiler.h"
 #include "theia/util/random.h"
 #include "theia/util/timer.h"
 
@@ -88,10 +89,11 @@ SetRelativeTranslationFilteringOptions(
   fvpfrt_options.num_iterations = options.translation_filtering_num_iterations;
   fvpfrt_options.translation_projection_tolerance =
       options.translation_filtering_projection_tolerance;
+  fvpfrt_options.rng = options.rng;
   return fvpfrt_options;
 }
 
-ViewId RandomViewId(const ViewGraph& view_graph) {
+ViewId RandomViewId(const ViewGraph& view_graph, RandomNumberGenerator* rng) {
   const auto& view_pairs = view_graph.GetAllEdges();
 
   // Collect all view ids.
@@ -103,37 +105,34 @@ ViewId RandomViewId(const ViewGraph& view_graph) {
 
   // Find a random view id. TODO(cmsweeney): Choose the "best" random view by
   // some criterion such as highest connectivity.
-  InitRandomGenerator();
-  const int num_advances = RandInt(0, views.size() - 1);
+  const int num_advances = rng->RandInt(0, views.size() - 1);
   auto it = views.begin();
   std::advance(it, num_advances);
   return *it;
 }
 
-void SetUnderconstrainedAsUnestimated(Reconstruction* reconstruction) {
-  int num_underconstrained_views = -1;
-  int num_underconstrained_tracks = -1;
-  while (num_underconstrained_views != 0 && num_underconstrained_tracks != 0) {
-    num_underconstrained_views =
-        SetUnderconstrainedViewsToUnestimated(reconstruction);
-    num_underconstrained_tracks =
-        SetUnderconstrainedTracksToUnestimated(reconstruction);
-  }
-}
-
 }  // namespace
 
 GlobalReconstructionEstimator::GlobalReconstructionEstimator(
     const ReconstructionEstimatorOptions& options) {
   options_ = options;
-  translation_filter_options_ = SetRelativeTranslationFilteringOptions(options);
+  // All randomized steps share one generator so that a seeded generator
+  // reproduces the whole reconstruction.
+  if (!options_.rng) {
+    options_.rng = std::make_shared<RandomNumberGenerator>();
+  }
+  translation_filter_options_ =
+      SetRelativeTranslationFilteringOptions(options_);
   options_.nonlinear_position_estimator_options.num_threads =
       options_.num_threads;
   options_.linear_triplet_position_estimator_options.num_threads =
       options_.num_threads;
   options_.least_unsquared_deviation_position_estimator_options.num_threads =
       options_.num_threads;
-  ransac_params_ = SetRansacParameters(options);
+  options_.nonlinear_position_estimator_options.rng = options_.rng;
+  options_.least_unsquared_deviation_position_estimator_options.rng =
+      options_.rng;
+  ransac_params_ = SetRansacParameters(options_);
 }
 
 // The pipeline for estimating camera poses and structure is as follows:
@@ -154,6 +153,7 @@ GlobalReconstructionEstimator::GlobalReconstructionEstimator(
 // to the largest connected component in the view graph.
 ReconstructionEstimatorSummary GlobalReconstructionEstimator::Estimate(
     ViewGraph* view_graph, Reconstruction* reconstruction) {
+  ScopedProfile profile("GlobalReconstructionEstimator");
   CHECK_NOTNULL(reconstruction);
   reconstruction_ = reconstruction;
   view_graph_ = view_graph;
@@ -248,7 +248,7 @@ ReconstructionEstimatorSummary GlobalReconstructionEstimator::Estimate(
     EstimateStructure();
     summary.triangulation_time += timer.ElapsedTimeInSeconds();
 
-    SetUnderconstrainedAsUnestimated(reconstruction_);
+    SetUnderconstrainedAsUnestimated(options_.num_threads, reconstruction_);
 
     // Step 9. Bundle Adjustment.
     LOG(INFO) << "Performing bundle adjustment.";
@@ -260,10 +260,20 @@ ReconstructionEstimatorSummary GlobalReconstructionEstimator::Estimate(
     }
     summary.bundle_adjustment_time += timer.ElapsedTimeInSeconds();
 
+    ReprojectionErrorStatistics reprojection_error_statistics;
     int num_points_removed = RemoveOutlierFeatures(
         options_.max_reprojection_error_in_pixels,
         options_.min_triangulation_angle_degrees,
-        reconstruction_);
+        options_.num_threads,
+        reconstruction_,
+        &reprojection_error_statistics);
+    LOG(INFO) << "Mean reprojection error after bundle adjustment: "
+              << reprojection_error_statistics.mean_reprojection_error
+              << " pixels (RMS "
+              << reprojection_error_statistics.rms_reprojection_error
+              << ") over "
+              << reprojection_error_statistics.num_observations
+              << " observations.";
     LOG(INFO) << num_points_removed << " outlier points were removed.";
   }
 
@@ -299,29 +309,31 @@ ReconstructionEstimatorSummary GlobalReconstructionEstimator::Estimate(
 }
 
 bool GlobalReconstructionEstimator::FilterInitialViewGraph() {
+  ScopedProfile profile("FilterInitialViewGraph");
   // Remove any view pairs that do not have a sufficient number of inliers.
   std::unordered_set<ViewIdPair> view_pairs_to_remove;
-  const auto& view_pairs = view_graph_->GetAllEdges();
-  for (const auto& view_pair : view_pairs) {
-    if (view_pair.second.num_verified_matches <
-        options_.min_num_two_view_inliers) {
-      view_pairs_to_remove.insert(view_pair.first);
+  for (int i = 0; i < view_graph_->NumEdgeSlots(); i++) {
+    if (!view_graph_->IsEdgeSlotRemoved(i) &&
+        view_graph_->EdgeValue(i).num_verified_matches <
+            options_.min_num_two_view_inliers) {
+      view_pairs_to_remove.insert(view_graph_->EdgeViewIdPair(i));
     }
   }
-  for (const ViewIdPair view_id_pair : view_pairs_to_remove) {
-    view_graph_->RemoveEdge(view_id_pair.first, view_id_pair.second);
-  }
+  view_graph_->RemoveEdges(view_pairs_to_remove);
 
   // Only reconstruct the largest connected component.
   RemoveDisconnectedViewPairs(view_graph_);
+  view_graph_->Compact();
   return view_graph_->NumEdges() >= 1;
 }
 
 void GlobalReconstructionEstimator::CalibrateCameras() {
+  ScopedProfile profile("CalibrateCameras");
   SetCameraIntrinsicsFromPriors(reconstruction_);
 }
 
 bool GlobalReconstructionEstimator::EstimateGlobalRotations() {
+  ScopedProfile profile("EstimateGlobalRotations");
   const auto& view_pairs = view_graph_->GetAllEdges();
 
   // Choose the global rotation estimation type.
@@ -333,7 +345,8 @@ bool GlobalReconstructionEstimator::EstimateGlobalRotations() {
       //
       // TODO(cmsweeney): We should use the linear method to initialize the
       // rotation estimations from a spanning tree.
-      const ViewId random_starting_view = RandomViewId(*view_graph_);
+      const ViewId random_starting_view =
+          RandomViewId(*view_graph_, options_.rng.get());
       OrientationsFromViewGraph(*view_graph_,
                                 random_starting_view,
                                 &orientations_);
@@ -348,7 +361,8 @@ bool GlobalReconstructionEstimator::EstimateGlobalRotations() {
       //
       // TODO(cmsweeney): We should use the linear method to initialize the
       // rotation estimations from a spanning tree.
-      const ViewId random_starting_view = RandomViewId(*view_graph_);
+      const ViewId random_starting_view =
+          RandomViewId(*view_graph_, options_.rng.get());
       OrientationsFromViewGraph(*view_graph_,
                                 random_starting_view,
                                 &orientations_);
@@ -371,6 +385,7 @@ bool GlobalReconstructionEstimator::EstimateGlobalRotations() {
 }
 
 void GlobalReconstructionEstimator::FilterRotations() {
+  ScopedProfile profile("FilterRotations");
   // Filter view pairs based on the relative rotation and the estimated global
   // orientations.
   FilterViewPairsFromOrientation(
@@ -386,6 +401,7 @@ void GlobalReconstructionEstimator::FilterRotations() {
 }
 
 void GlobalReconstructionEstimator::OptimizePairwiseTranslations() {
+  ScopedProfile profile("OptimizePairwiseTranslations");
   if (options_.refine_relative_translations_after_rotation_estimation) {
     RefineRelativeTranslationsWithKnownRotations(*reconstruction_,
                                                  orientations_,
@@ -395,6 +411,7 @@ void GlobalReconstructionEstimator::OptimizePairwiseTranslations() {
 }
 
 void GlobalReconstructionEstimator::FilterRelativeTranslation() {
+  ScopedProfile profile("FilterRelativeTranslation");
   if (options_.extract_maximal_rigid_subgraph) {
     LOG(INFO) << "Extracting maximal rigid component of viewing graph to "
                  "determine which cameras are well-constrained for position "
@@ -418,6 +435,7 @@ void GlobalReconstructionEstimator::FilterRelativeTranslation() {
 }
 
 bool GlobalReconstructionEstimator::EstimatePosition() {
+  ScopedProfile profile("EstimatePositions");
   // Estimate position.
   const auto& view_pairs = view_graph_->GetAllEdges();
   std::unique_ptr<PositionEstimator> position_estimator;
@@ -452,6 +470,7 @@ bool GlobalReconstructionEstimator::EstimatePosition() {
 }
 
 void GlobalReconstructionEstimator::EstimateStructure() {
+  ScopedProfile profile("EstimateStructure");
   // Estimate all tracks.
   TrackEstimator::Options triangulation_options;
   triangulation_options.max_acceptable_reprojection_error_pixels =
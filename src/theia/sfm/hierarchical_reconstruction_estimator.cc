@@ -0,0 +1,592 @@
+// Copyright (C) 2015 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include "theia/sfm/hierarchical_reconstruction_estimator.h"
+
+#include <Eigen/Core>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <memory>
+#include <sstream>  // NOLINT
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "theia/sfm/bundle_adjustment/bundle_adjustment.h"
+#include "theia/sfm/estimate_track.h"
+#include "theia/sfm/feature.h"
+#include "theia/sfm/global_reconstruction_estimator.h"
+#include "theia/sfm/reconstruction.h"
+#include "theia/sfm/reconstruction_estimator_options.h"
+#include "theia/sfm/reconstruction_estimator_utils.h"
+#include "theia/sfm/transformation/align_point_clouds.h"
+#include "theia/sfm/transformation/transform_reconstruction.h"
+#include "theia/sfm/twoview_info.h"
+#include "theia/sfm/view_graph/partition_view_graph.h"
+#include "theia/sfm/view_graph/remove_disconnected_view_pairs.h"
+#include "theia/sfm/view_graph/view_graph.h"
+#include "theia/util/map_util.h"
+#include "theia/util/profiler.h"
+#include "theia/util/random.h"
+#include "theia/util/threadpool.h"
+#include "theia/util/timer.h"
+
+namespace theia {
+
+namespace {
+
+// The minimum number of estimated views that a cluster must share with the
+// merged reconstruction in order to compute the similarity transformation
+// between them.
+static const int kMinNumCommonViews = 3;
+
+// Shared views with an alignment error larger than this multiple of the median
+// alignment error are not used to compute the final alignment of a cluster.
+static const double kMaxAlignmentErrorToMedianRatio = 3.0;
+
+// All times are given in seconds.
+struct HierarchicalReconstructionEstimatorTimings {
+  double initial_view_graph_filtering_time = 0.0;
+  double view_graph_partitioning_time = 0.0;
+  double cluster_reconstruction_time = 0.0;
+  double cluster_merging_time = 0.0;
+};
+
+void ReconstructCluster(const ReconstructionEstimatorOptions& options,
+                        ViewGraph* view_graph,
+                        Reconstruction* reconstruction,
+                        ReconstructionEstimatorSummary* summary) {
+  GlobalReconstructionEstimator global_estimator(options);
+  *summary = global_estimator.Estimate(view_graph, reconstruction);
+}
+
+}  // namespace
+
+HierarchicalReconstructionEstimator::HierarchicalReconstructionEstimator(
+    const ReconstructionEstimatorOptions& options) {
+  options_ = options;
+  CHECK_GT(options_.hierarchical_max_num_views_per_cluster, 0);
+}
+
+// The pipeline for estimating camera poses and structure is as follows:
+//   1) Filter the initial view graph and remove weak two view geometries.
+//   2) Partition the view graph into overlapping clusters.
+//   3) Reconstruct each cluster with the GlobalReconstructionEstimator.
+//   4) Merge the cluster reconstructions by aligning the shared views.
+//   5) Triangulate the tracks that span multiple clusters.
+//   6) Bundle adjust the separator views and the tracks they observe.
+//   7) Remove outlier points.
+ReconstructionEstimatorSummary HierarchicalReconstructionEstimator::Estimate(
+    ViewGraph* view_graph, Reconstruction* reconstruction) {
+  ScopedProfile profile("HierarchicalReconstructionEstimator");
+  CHECK_NOTNULL(reconstruction);
+  reconstruction_ = reconstruction;
+  view_graph_ = CHECK_NOTNULL(view_graph);
+  clusters_.clear();
+  separator_views_.clear();
+
+  ReconstructionEstimatorSummary summary;
+  HierarchicalReconstructionEstimatorTimings hierarchical_estimator_timings;
+  Timer total_timer;
+  Timer timer;
+
+  // Step 1. Filter the initial view graph and remove any bad two view
+  // geometries.
+  LOG(INFO) << "Filtering the intial view graph.";
+  timer.Reset();
+  if (!FilterInitialViewGraph()) {
+    LOG(INFO) << "Insufficient view pairs to perform estimation.";
+    return summary;
+  }
+  hierarchical_estimator_timings.initial_view_graph_filtering_time =
+      timer.ElapsedTimeInSeconds();
+
+  // Step 2. Partition the view graph into overlapping clusters.
+  LOG(INFO) << "Partitioning the view graph.";
+  timer.Reset();
+  PartitionViewGraphOptions partition_options;
+  partition_options.max_num_views_per_cluster =
+      options_.hierarchical_max_num_views_per_cluster;
+  partition_options.overlap_ratio = options_.hierarchical_cluster_overlap_ratio;
+  partition_options.min_num_overlapping_views =
+      options_.hierarchical_min_num_overlapping_views;
+  std::vector<std::unordered_set<ViewId> > cluster_view_ids;
+  PartitionViewGraph(partition_options, *view_graph_, &cluster_view_ids);
+  hierarchical_estimator_timings.view_graph_partitioning_time =
+      timer.ElapsedTimeInSeconds();
+
+  // There is nothing to merge if the view graph is small enough to be
+  // reconstructed all at once.
+  if (cluster_view_ids.size() <= 1) {
+    LOG(INFO) << "The view graph fits in a single cluster. Estimating the "
+                 "reconstruction with the global SfM pipeline.";
+    GlobalReconstructionEstimator global_estimator(options_);
+    return global_estimator.Estimate(view_graph_, reconstruction_);
+  }
+  LOG(INFO) << "The view graph was partitioned into "
+            << cluster_view_ids.size() << " clusters.";
+
+  // Step 3. Reconstruct each cluster independently.
+  LOG(INFO) << "Reconstructing all clusters.";
+  timer.Reset();
+  CreateClusters(cluster_view_ids);
+  ReconstructClusters();
+  hierarchical_estimator_timings.cluster_reconstruction_time =
+      timer.ElapsedTimeInSeconds();
+  summary.pose_estimation_time =
+      hierarchical_estimator_timings.cluster_reconstruction_time;
+
+  // Step 4. Merge the clusters into a single reconstruction.
+  LOG(INFO) << "Merging the cluster reconstructions.";
+  timer.Reset();
+  MergeClusters();
+  clusters_.clear();
+  hierarchical_estimator_timings.cluster_merging_time =
+      timer.ElapsedTimeInSeconds();
+  if (NumEstimatedViews(*reconstruction_) == 0) {
+    LOG(WARNING) << "None of the clusters could be reconstructed!";
+    summary.success = false;
+    return summary;
+  }
+
+  // Step 5. Triangulate the tracks that were not estimated in any cluster
+  // (e.g., tracks that span several clusters).
+  LOG(INFO) << "Triangulating all unestimated features.";
+  timer.Reset();
+  std::unordered_set<TrackId> merged_tracks;
+  EstimateStructure(&merged_tracks);
+  SetUnderconstrainedAsUnestimated(options_.num_threads, reconstruction_);
+  summary.triangulation_time = timer.ElapsedTimeInSeconds();
+
+  // Step 6. Bundle adjust the separators.
+  LOG(INFO) << "Performing bundle adjustment of the separator views.";
+  timer.Reset();
+  if (!BundleAdjustSeparators(merged_tracks)) {
+    summary.success = false;
+    LOG(WARNING) << "Bundle adjustment failed!";
+    return summary;
+  }
+  summary.bundle_adjustment_time = timer.ElapsedTimeInSeconds();
+
+  // Step 7. Remove outliers.
+  const int num_points_removed =
+      RemoveOutlierFeatures(options_.max_reprojection_error_in_pixels,
+                            options_.min_triangulation_angle_degrees,
+                            options_.num_threads,
+                            reconstruction_,
+                            nullptr);
+  LOG(INFO) << num_points_removed << " outlier points were removed.";
+  SetUnderconstrainedAsUnestimated(options_.num_threads, reconstruction_);
+
+  // Set the output parameters.
+  GetEstimatedViewsFromReconstruction(*reconstruction_,
+                                      &summary.estimated_views);
+  GetEstimatedTracksFromReconstruction(*reconstruction_,
+                                       &summary.estimated_tracks);
+  summary.success = true;
+  summary.total_time = total_timer.ElapsedTimeInSeconds();
+
+  // Output some timing statistics.
+  std::ostringstream string_stream;
+  string_stream
+      << "Hierarchical Reconstruction Estimator timings:"
+      << "\n\tInitial view graph filtering time = "
+      << hierarchical_estimator_timings.initial_view_graph_filtering_time
+      << "\n\tView graph partitioning time = "
+      << hierarchical_estimator_timings.view_graph_partitioning_time
+      << "\n\tCluster reconstruction time = "
+      << hierarchical_estimator_timings.cluster_reconstruction_time
+      << "\n\tCluster merging time = "
+      << hierarchical_estimator_timings.cluster_merging_time;
+  summary.message = string_stream.str();
+
+  return summary;
+}
+
+bool HierarchicalReconstructionEstimator::FilterInitialViewGraph() {
+  // Remove any view pairs that do not have a sufficient number of inliers.
+  std::unordered_set<ViewIdPair> view_pairs_to_remove;
+  for (int i = 0; i < view_graph_->NumEdgeSlots(); i++) {
+    if (!view_graph_->IsEdgeSlotRemoved(i) &&
+        view_graph_->EdgeValue(i).num_verified_matches <
+            options_.min_num_two_view_inliers) {
+      view_pairs_to_remove.insert(view_graph_->EdgeViewIdPair(i));
+    }
+  }
+  view_graph_->RemoveEdges(view_pairs_to_remove);
+
+  // Only reconstruct the largest connected component.
+  RemoveDisconnectedViewPairs(view_graph_);
+  view_graph_->Compact();
+  return view_graph_->NumEdges() >= 1;
+}
+
+void HierarchicalReconstructionEstimator::CreateClusters(
+    const std::vector<std::unordered_set<ViewId> >& cluster_view_ids) {
+  ScopedProfile profile("CreateClusters");
+  std::unordered_map<ViewId, int> num_clusters_containing_view;
+  clusters_.reserve(cluster_view_ids.size());
+  for (const auto& view_ids : cluster_view_ids) {
+    std::unique_ptr<Cluster> cluster(new Cluster);
+
+    // The views are added in order of increasing view id so that the view ids
+    // of the cluster preserve the ordering of the input view ids. This is
+    // required for the TwoViewInfo of each view pair to remain valid since it
+    // is defined with respect to the view with the smaller view id.
+    std::vector<ViewId> sorted_view_ids(view_ids.begin(), view_ids.end());
+    std::sort(sorted_view_ids.begin(), sorted_view_ids.end());
+
+    std::unordered_map<ViewId, ViewId> cluster_view_ids;
+    for (const ViewId view_id : sorted_view_ids) {
+      const View* view = CHECK_NOTNULL(reconstruction_->View(view_id));
+      const ViewId cluster_view_id =
+          cluster->reconstruction.AddView(view->Name());
+      View* cluster_view = cluster->reconstruction.MutableView(cluster_view_id);
+      *cluster_view->MutableCamera() = view->Camera();
+      *cluster_view->MutableCameraIntrinsicsPrior() =
+          view->CameraIntrinsicsPrior();
+
+      cluster->view_ids[cluster_view_id] = view_id;
+      cluster_view_ids[view_id] = cluster_view_id;
+      ++num_clusters_containing_view[view_id];
+    }
+
+    // Add the view pairs that are contained within the cluster.
+    for (const ViewId view_id : sorted_view_ids) {
+      const std::vector<ViewId>* neighbor_ids =
+          view_graph_->GetNeighborIdsForView(view_id);
+      if (neighbor_ids == nullptr) {
+        continue;
+      }
+      for (const ViewId neighbor_id : *neighbor_ids) {
+        const ViewId* cluster_neighbor_id =
+            FindOrNull(cluster_view_ids, neighbor_id);
+        if (neighbor_id < view_id || cluster_neighbor_id == nullptr) {
+          continue;
+        }
+        cluster->view_graph.AddEdge(FindOrDie(cluster_view_ids, view_id),
+                                    *cluster_neighbor_id,
+                                    *view_graph_->GetEdge(view_id,
+                                                          neighbor_id));
+      }
+    }
+
+    // Add all tracks that are observed by at least two views of the cluster.
+    std::unordered_map<TrackId, std::vector<std::pair<ViewId, Feature> > >
+        track_features;
+    for (const ViewId view_id : sorted_view_ids) {
+      const View* view = reconstruction_->View(view_id);
+      const ViewId cluster_view_id = FindOrDie(cluster_view_ids, view_id);
+      for (const TrackId track_id : view->TrackIds()) {
+        track_features[track_id].emplace_back(cluster_view_id,
+                                              *view->GetFeature(track_id));
+      }
+    }
+    for (const auto& track : track_features) {
+      if (track.second.size() < 2) {
+        continue;
+      }
+      const TrackId cluster_track_id =
+          cluster->reconstruction.AddTrack(track.second);
+      if (cluster_track_id != kInvalidTrackId) {
+        cluster->track_ids[cluster_track_id] = track.first;
+      }
+    }
+
+    VLOG(2) << "Created a cluster with "
+            << cluster->reconstruction.NumViews() << " views, "
+            << cluster->view_graph.NumEdges() << " view pairs, and "
+            << cluster->reconstruction.NumTracks() << " tracks.";
+    clusters_.emplace_back(std::move(cluster));
+  }
+
+  for (const auto& num_clusters : num_clusters_containing_view) {
+    if (num_clusters.second > 1) {
+      separator_views_.insert(num_clusters.first);
+    }
+  }
+}
+
+void HierarchicalReconstructionEstimator::ReconstructClusters() {
+  ScopedProfile profile("ReconstructClusters");
+  // Clusters are reconstructed in parallel. If there are more threads than
+  // clusters then the remaining threads are shared among the cluster
+  // reconstructions.
+  const int num_clusters = clusters_.size();
+  const int num_threads = std::min(options_.num_threads, num_clusters);
+  ReconstructionEstimatorOptions cluster_options = options_;
+  cluster_options.reconstruction_estimator_type =
+      ReconstructionEstimatorType::GLOBAL;
+  cluster_options.num_threads =
+      std::max(1, options_.num_threads / num_clusters);
+
+  // The clusters are reconstructed in parallel, so they must not share a
+  // generator. Each cluster gets its own generator derived from one seed drawn
+  // from the generator of the options, so seeded reconstructions remain
+  // reproducible.
+  const uint64_t cluster_seed = options_.rng ? (*options_.rng)() : 0;
+
+  // The pool must go out of scope before the results are used so that all
+  // tasks are guaranteed to have finished.
+  {
+    ThreadPool pool(num_threads);
+    for (int i = 0; i < clusters_.size(); i++) {
+      if (options_.rng) {
+        cluster_options.rng =
+            std::make_shared<RandomNumberGenerator>(cluster_seed, i);
+      }
+      pool.Add(ReconstructCluster,
+               cluster_options,
+               &clusters_[i]->view_graph,
+               &clusters_[i]->reconstruction,
+               &clusters_[i]->summary);
+    }
+  }
+
+  for (int i = 0; i < clusters_.size(); i++) {
+    VLOG(2) << "Cluster " << i << " estimated "
+            << clusters_[i]->summary.estimated_views.size() << " of "
+            << clusters_[i]->reconstruction.NumViews() << " views.";
+  }
+}
+
+void HierarchicalReconstructionEstimator::MergeClusters() {
+  ScopedProfile profile("MergeClusters");
+  std::vector<Cluster*> unmerged_clusters;
+  for (const auto& cluster : clusters_) {
+    if (cluster->summary.success &&
+        cluster->summary.estimated_views.size() > 0) {
+      unmerged_clusters.emplace_back(cluster.get());
+    } else {
+      LOG(WARNING) << "A cluster of " << cluster->reconstruction.NumViews()
+                   << " views could not be reconstructed.";
+    }
+  }
+  if (unmerged_clusters.empty()) {
+    return;
+  }
+
+  // The largest cluster defines the coordinate system of the merged
+  // reconstruction.
+  std::sort(unmerged_clusters.begin(), unmerged_clusters.end(),
+            [](const Cluster* lhs, const Cluster* rhs) {
+              return lhs->summary.estimated_views.size() >
+                     rhs->summary.estimated_views.size();
+            });
+  AddClusterToReconstruction(*unmerged_clusters.front());
+  unmerged_clusters.erase(unmerged_clusters.begin());
+
+  // Greedily merge the cluster that shares the most estimated views with the
+  // merged reconstruction.
+  while (!unmerged_clusters.empty()) {
+    int best_cluster_index = -1;
+    int max_num_common_views = 0;
+    for (int i = 0; i < unmerged_clusters.size(); i++) {
+      int num_common_views = 0;
+      for (const auto& view_id : unmerged_clusters[i]->view_ids) {
+        const View* cluster_view =
+            unmerged_clusters[i]->reconstruction.View(view_id.first);
+        if (cluster_view->IsEstimated() &&
+            reconstruction_->View(view_id.second)->IsEstimated()) {
+          ++num_common_views;
+        }
+      }
+      if (num_common_views > max_num_common_views) {
+        max_num_common_views = num_common_views;
+        best_cluster_index = i;
+      }
+    }
+
+    if (max_num_common_views < kMinNumCommonViews) {
+      LOG(WARNING) << unmerged_clusters.size()
+                   << " clusters do not have enough views in common with the "
+                      "merged reconstruction and could not be merged.";
+      break;
+    }
+
+    Cluster* cluster = unmerged_clusters[best_cluster_index];
+    if (AlignClusterToReconstruction(cluster)) {
+      AddClusterToReconstruction(*cluster);
+    }
+    unmerged_clusters.erase(unmerged_clusters.begin() + best_cluster_index);
+  }
+}
+
+bool HierarchicalReconstructionEstimator::AlignClusterToReconstruction(
+    Cluster* cluster) {
+  // Collect the positions of the views that are estimated in both the cluster
+  // and the merged reconstruction.
+  std::vector<Eigen::Vector3d> cluster_positions, positions;
+  for (const auto& view_id : cluster->view_ids) {
+    const View* cluster_view = cluster->reconstruction.View(view_id.first);
+    const View* view = reconstruction_->View(view_id.second);
+    if (cluster_view->IsEstimated() && view->IsEstimated()) {
+      cluster_positions.emplace_back(cluster_view->Camera().GetPosition());
+      positions.emplace_back(view->Camera().GetPosition());
+    }
+  }
+  if (positions.size() < kMinNumCommonViews) {
+    return false;
+  }
+
+  Eigen::Matrix3d rotation;
+  Eigen::Vector3d translation;
+  double scale;
+  AlignPointCloudsUmeyama(cluster_positions,
+                          positions,
+                          &rotation,
+                          &translation,
+                          &scale);
+
+  // A separator view that was poorly estimated in one of the clusters will
+  // bias the alignment, so the alignment is recomputed from only the views
+  // that agree with the initial alignment.
+  std::vector<double> alignment_errors(positions.size());
+  for (int i = 0; i < positions.size(); i++) {
+    alignment_errors[i] =
+        (positions[i] -
+         (scale * rotation * cluster_positions[i] + translation)).norm();
+  }
+  std::vector<double> sorted_errors(alignment_errors);
+  std::nth_element(sorted_errors.begin(),
+                   sorted_errors.begin() + sorted_errors.size() / 2,
+                   sorted_errors.end());
+  const double max_alignment_error =
+      kMaxAlignmentErrorToMedianRatio * sorted_errors[sorted_errors.size() / 2];
+
+  std::vector<Eigen::Vector3d> inlier_cluster_positions, inlier_positions;
+  for (int i = 0; i < positions.size(); i++) {
+    if (alignment_errors[i] <= max_alignment_error) {
+      inlier_cluster_positions.emplace_back(cluster_positions[i]);
+      inlier_positions.emplace_back(positions[i]);
+    }
+  }
+  if (inlier_positions.size() >= kMinNumCommonViews &&
+      inlier_positions.size() < positions.size()) {
+    AlignPointCloudsUmeyama(inlier_cluster_positions,
+                            inlier_positions,
+                            &rotation,
+                            &translation,
+                            &scale);
+  }
+
+  TransformReconstruction(rotation, translation, scale,
+                          &cluster->reconstruction);
+  return true;
+}
+
+void HierarchicalReconstructionEstimator::AddClusterToReconstruction(
+    const Cluster& cluster) {
+  // Views and tracks that are already part of the merged reconstruction keep
+  // their current estimates.
+  for (const auto& view_id : cluster.view_ids) {
+    const View* cluster_view = cluster.reconstruction.View(view_id.first);
+    View* view = reconstruction_->MutableView(view_id.second);
+    if (!cluster_view->IsEstimated() || view->IsEstimated()) {
+      continue;
+    }
+    *view->MutableCamera() = cluster_view->Camera();
+    view->SetEstimated(true);
+  }
+
+  for (const auto& track_id : cluster.track_ids) {
+    const Track* cluster_track = cluster.reconstruction.Track(track_id.first);
+    Track* track = reconstruction_->MutableTrack(track_id.second);
+    if (!cluster_track->IsEstimated() || track->IsEstimated()) {
+      continue;
+    }
+    *track->MutablePoint() = cluster_track->Point();
+    track->SetEstimated(true);
+  }
+}
+
+void HierarchicalReconstructionEstimator::EstimateStructure(
+    std::unordered_set<TrackId>* estimated_tracks) {
+  TrackEstimator::Options triangulation_options;
+  triangulation_options.max_acceptable_reprojection_error_pixels =
+      options_.triangulation_max_reprojection_error_in_pixels;
+  triangulation_options.min_triangulation_angle_degrees =
+      options_.min_triangulation_angle_degrees;
+  triangulation_options.bundle_adjustment = options_.bundle_adjust_tracks;
+  triangulation_options.num_threads = options_.num_threads;
+  TrackEstimator track_estimator(triangulation_options, reconstruction_);
+  const TrackEstimator::Summary summary = track_estimator.EstimateAllTracks();
+  *estimated_tracks = summary.estimated_tracks;
+}
+
+bool HierarchicalReconstructionEstimator::BundleAdjustSeparators(
+    const std::unordered_set<TrackId>& merged_tracks) {
+  if (options_.hierarchical_bundle_adjust_all_views_after_merging) {
+    const BundleAdjustmentOptions ba_options = SetBundleAdjustmentOptions(
+        options_, NumEstimatedViews(*reconstruction_));
+    return BundleAdjustReconstruction(ba_options, reconstruction_).success;
+  }
+
+  // Optimize the separator views, all tracks they observe, and the tracks that
+  // were triangulated after merging. All other views are held constant.
+  std::unordered_set<ViewId> views_to_optimize;
+  std::unordered_set<TrackId> tracks_to_optimize;
+  for (const ViewId view_id : separator_views_) {
+    const View* view = reconstruction_->View(view_id);
+    if (!view->IsEstimated()) {
+      continue;
+    }
+    views_to_optimize.insert(view_id);
+    for (const TrackId track_id : view->TrackIds()) {
+      if (reconstruction_->Track(track_id)->IsEstimated()) {
+        tracks_to_optimize.insert(track_id);
+      }
+    }
+  }
+  for (const TrackId track_id : merged_tracks) {
+    if (reconstruction_->Track(track_id)->IsEstimated()) {
+      tracks_to_optimize.insert(track_id);
+    }
+  }
+
+  if (views_to_optimize.empty() && tracks_to_optimize.empty()) {
+    return true;
+  }
+
+  const BundleAdjustmentOptions ba_options =
+      SetBundleAdjustmentOptions(options_, views_to_optimize.size());
+  return BundleAdjustPartialReconstruction(ba_options,
+                                           views_to_optimize,
+                                           tracks_to_optimize,
+                                           reconstruction_).success;
+}
+
+}  // namespace theia
@@ -0,0 +1,118 @@
+// Copyright (C) 2015 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#ifndef THEIA_SFM_HIERARCHICAL_RECONSTRUCTION_ESTIMATOR_H_
+#define THEIA_SFM_HIERARCHICAL_RECONSTRUCTION_ESTIMATOR_H_
+
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "theia/sfm/reconstruction.h"
+#include "theia/sfm/reconstruction_estimator.h"
+#include "theia/sfm/reconstruction_estimator_options.h"
+#include "theia/sfm/types.h"
+#include "theia/sfm/view_graph/view_graph.h"
+#include "theia/util/util.h"
+
+namespace theia {
+
+// Estimates the camera poses and 3D structure of large scenes with a divide and
+// conquer approach. Instead of solving for all camera poses at once, the view
+// graph is partitioned into overlapping clusters that are each small enough to
+// be reconstructed efficiently. The clusters are reconstructed independently
+// (and in parallel) with the global SfM pipeline and are then merged together
+// by aligning the views that are shared between clusters.
+//
+// The pipeline is as follows:
+//   1) Filter the initial view graph and remove weak two view geometries.
+//   2) Partition the view graph into overlapping clusters with a normalized
+//      graph cut.
+//   3) Reconstruct each cluster with the GlobalReconstructionEstimator.
+//   4) Merge the cluster reconstructions, starting from the largest one, by
+//      computing the similarity transformation that aligns the camera
+//      positions of the shared views.
+//   5) Triangulate the tracks that span multiple clusters.
+//   6) Bundle adjust the separator views (i.e., the views that are shared
+//      between clusters) and the tracks they observe.
+//   7) Remove outlier points.
+//
+// If the view graph is small enough to fit into a single cluster then this is
+// equivalent to running the GlobalReconstructionEstimator.
+class HierarchicalReconstructionEstimator : public ReconstructionEstimator {
+ public:
+  HierarchicalReconstructionEstimator(
+      const ReconstructionEstimatorOptions& options);
+
+  ReconstructionEstimatorSummary Estimate(ViewGraph* view_graph,
+                                          Reconstruction* reconstruction);
+
+ private:
+  // A sub-problem of the full reconstruction. View and track ids within the
+  // cluster are mapped back to the ids of the input reconstruction.
+  struct Cluster {
+    ViewGraph view_graph;
+    Reconstruction reconstruction;
+    std::unordered_map<ViewId, ViewId> view_ids;
+    std::unordered_map<TrackId, TrackId> track_ids;
+    ReconstructionEstimatorSummary summary;
+  };
+
+  bool FilterInitialViewGraph();
+  void CreateClusters(
+      const std::vector<std::unordered_set<ViewId> >& cluster_view_ids);
+  void ReconstructClusters();
+  void MergeClusters();
+  bool AlignClusterToReconstruction(Cluster* cluster);
+  void AddClusterToReconstruction(const Cluster& cluster);
+  void EstimateStructure(std::unordered_set<TrackId>* estimated_tracks);
+  bool BundleAdjustSeparators(const std::unordered_set<TrackId>& merged_tracks);
+
+  ViewGraph* view_graph_;
+  Reconstruction* reconstruction_;
+
+  ReconstructionEstimatorOptions options_;
+
+  std::vector<std::unique_ptr<Cluster> > clusters_;
+
+  // Views that are contained in more than one cluster.
+  std::unordered_set<ViewId> separator_views_;
+
+  DISALLOW_COPY_AND_ASSIGN(HierarchicalReconstructionEstimator);
+};
+
+}  // namespace theia
+
+#endif  // THEIA_SFM_HIERARCHICAL_RECONSTRUCTION_ESTIMATOR_H_
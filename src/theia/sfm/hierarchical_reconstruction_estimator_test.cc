@@ -0,0 +1,250 @@
+// Copyright (C) 2014 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <glog/logging.h>
+#include <math.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "theia/sfm/camera/camera.h"
+#include "theia/sfm/hierarchical_reconstruction_estimator.h"
+#include "theia/sfm/reconstruction.h"
+#include "theia/sfm/reconstruction_estimator.h"
+#include "theia/sfm/reconstruction_estimator_options.h"
+#include "theia/sfm/transformation/align_reconstructions.h"
+#include "theia/sfm/twoview_info.h"
+#include "theia/sfm/types.h"
+#include "theia/sfm/view.h"
+#include "theia/sfm/view_graph/view_graph.h"
+#include "theia/util/random.h"
+#include "theia/util/stringprintf.h"
+
+namespace theia {
+
+namespace {
+
+static const double kRingRadius = 10.0;
+static const double kFocalLength = 1000.0;
+static const int kImageSize = 1000;
+static const int kNumNeighbors = 3;
+
+// Creates the ground truth reconstruction with cameras on a ring that look at
+// the center, and points around the center that are observed by a few
+// consecutive cameras. A second reconstruction with the same views and
+// observations but without any estimated poses or points is created as the
+// input of the estimator, along with the view graph of the relative poses
+// between each view and its next kNumNeighbors views.
+void SetupRingScene(const int num_views,
+                    const int num_tracks,
+                    RandomNumberGenerator* rng,
+                    Reconstruction* gt_reconstruction,
+                    Reconstruction* reconstruction,
+                    ViewGraph* view_graph) {
+  static const int kTrackLength = 4;
+  static const double kPointSpread = 2.0;
+
+  std::vector<ViewId> view_ids(num_views);
+  for (int i = 0; i < num_views; i++) {
+    const std::string name = StringPrintf("view_%d", i);
+    view_ids[i] = gt_reconstruction->AddView(name);
+    CHECK_EQ(reconstruction->AddView(name), view_ids[i]);
+
+    const double angle = 2.0 * M_PI * i / num_views;
+    const Eigen::Vector3d position(kRingRadius * cos(angle),
+                                   rng->RandDouble(-1.0, 1.0),
+                                   kRingRadius * sin(angle));
+    const Eigen::Vector3d z_axis = -position.normalized();
+    const Eigen::Vector3d x_axis =
+        Eigen::Vector3d::UnitY().cross(z_axis).normalized();
+    Eigen::Matrix3d rotation;
+    rotation.row(0) = x_axis;
+    rotation.row(1) = z_axis.cross(x_axis);
+    rotation.row(2) = z_axis;
+
+    View* gt_view = gt_reconstruction->MutableView(view_ids[i]);
+    gt_view->SetEstimated(true);
+    Camera* camera = gt_view->MutableCamera();
+    camera->SetPosition(position);
+    camera->SetOrientationFromRotationMatrix(rotation);
+    camera->SetFocalLength(kFocalLength);
+    camera->SetPrincipalPoint(kImageSize / 2.0, kImageSize / 2.0);
+    camera->SetImageSize(kImageSize, kImageSize);
+
+    CameraIntrinsicsPrior* prior = reconstruction->MutableView(view_ids[i])
+                                       ->MutableCameraIntrinsicsPrior();
+    prior->image_width = kImageSize;
+    prior->image_height = kImageSize;
+    prior->focal_length.is_set = true;
+    prior->focal_length.value = kFocalLength;
+    prior->principal_point[0].is_set = true;
+    prior->principal_point[0].value = kImageSize / 2.0;
+    prior->principal_point[1].is_set = true;
+    prior->principal_point[1].value = kImageSize / 2.0;
+  }
+
+  std::vector<std::pair<ViewId, Feature> > observations;
+  for (int i = 0; i < num_tracks; i++) {
+    const Eigen::Vector4d point(rng->RandDouble(-kPointSpread, kPointSpread),
+                                rng->RandDouble(-kPointSpread, kPointSpread),
+                                rng->RandDouble(-kPointSpread, kPointSpread),
+                                1.0);
+    const int first_view = i % num_views;
+    observations.clear();
+    for (int j = 0; j < kTrackLength; j++) {
+      const ViewId view_id = view_ids[(first_view + j) % num_views];
+      Feature feature;
+      gt_reconstruction->View(view_id)->Camera().ProjectPoint(point, &feature);
+      observations.emplace_back(view_id, feature);
+    }
+    const TrackId track_id = gt_reconstruction->AddTrack(observations);
+    *gt_reconstruction->MutableTrack(track_id)->MutablePoint() = point;
+    gt_reconstruction->MutableTrack(track_id)->SetEstimated(true);
+    reconstruction->AddTrack(observations);
+  }
+
+  for (int i = 0; i < num_views; i++) {
+    for (int j = 1; j <= kNumNeighbors; j++) {
+      const ViewId neighbor_id = view_ids[(i + j) % num_views];
+      const ViewId view_id1 = std::min(view_ids[i], neighbor_id);
+      const ViewId view_id2 = std::max(view_ids[i], neighbor_id);
+      const Camera& camera1 = gt_reconstruction->View(view_id1)->Camera();
+      const Camera& camera2 = gt_reconstruction->View(view_id2)->Camera();
+      const Eigen::Matrix3d rotation1 =
+          camera1.GetOrientationAsRotationMatrix();
+      const Eigen::Matrix3d rotation2 =
+          camera2.GetOrientationAsRotationMatrix();
+
+      TwoViewInfo info;
+      info.focal_length_1 = kFocalLength;
+      info.focal_length_2 = kFocalLength;
+      const Eigen::AngleAxisd relative_rotation(rotation2 *
+                                                rotation1.transpose());
+      info.rotation_2 = relative_rotation.angle() * relative_rotation.axis();
+      info.position_2 =
+          (rotation1 * (camera2.GetPosition() - camera1.GetPosition()))
+              .normalized();
+      info.num_verified_matches = 100;
+      view_graph->AddEdge(view_id1, view_id2, info);
+    }
+  }
+}
+
+ReconstructionEstimatorOptions HierarchicalOptions() {
+  ReconstructionEstimatorOptions options;
+  options.reconstruction_estimator_type =
+      ReconstructionEstimatorType::HIERARCHICAL;
+  options.global_position_estimator_type =
+      GlobalPositionEstimatorType::LINEAR_TRIPLET;
+  options.rng = std::make_shared<RandomNumberGenerator>(52);
+  return options;
+}
+
+// Checks that all views are estimated and that their positions agree with the
+// ground truth up to a similarity transformation.
+void ExpectViewsMatchGroundTruth(const Reconstruction& gt_reconstruction,
+                                 Reconstruction* reconstruction) {
+  static const double kMaxPositionError = 1e-2 * kRingRadius;
+
+  for (const ViewId view_id : reconstruction->ViewIds()) {
+    EXPECT_TRUE(reconstruction->View(view_id)->IsEstimated());
+  }
+  AlignReconstructions(gt_reconstruction, reconstruction);
+  for (const ViewId view_id : gt_reconstruction.ViewIds()) {
+    const Eigen::Vector3d gt_position =
+        gt_reconstruction.View(view_id)->Camera().GetPosition();
+    const Eigen::Vector3d position =
+        reconstruction->View(view_id)->Camera().GetPosition();
+    EXPECT_LT((position - gt_position).norm(), kMaxPositionError);
+  }
+}
+
+}  // namespace
+
+TEST(HierarchicalReconstructionEstimator, ReconstructsAndMergesClusters) {
+  static const int kNumViews = 24;
+  static const int kNumTracks = 1200;
+  RandomNumberGenerator rng(59);
+  Reconstruction gt_reconstruction, reconstruction;
+  ViewGraph view_graph;
+  SetupRingScene(kNumViews,
+                 kNumTracks,
+                 &rng,
+                 &gt_reconstruction,
+                 &reconstruction,
+                 &view_graph);
+
+  // The ring is split into several clusters that overlap by a few views.
+  ReconstructionEstimatorOptions options = HierarchicalOptions();
+  options.hierarchical_max_num_views_per_cluster = 10;
+  options.hierarchical_min_num_overlapping_views = 4;
+  HierarchicalReconstructionEstimator estimator(options);
+  const ReconstructionEstimatorSummary summary =
+      estimator.Estimate(&view_graph, &reconstruction);
+  EXPECT_TRUE(summary.success);
+  EXPECT_EQ(summary.estimated_views.size(), kNumViews);
+  EXPECT_GT(summary.estimated_tracks.size(), 0.9 * kNumTracks);
+  ExpectViewsMatchGroundTruth(gt_reconstruction, &reconstruction);
+}
+
+TEST(HierarchicalReconstructionEstimator, SmallViewGraphIsASingleCluster) {
+  static const int kNumViews = 12;
+  static const int kNumTracks = 600;
+  RandomNumberGenerator rng(59);
+  Reconstruction gt_reconstruction, reconstruction;
+  ViewGraph view_graph;
+  SetupRingScene(kNumViews,
+                 kNumTracks,
+                 &rng,
+                 &gt_reconstruction,
+                 &reconstruction,
+                 &view_graph);
+
+  // The view graph fits into one cluster, so the global pipeline is run.
+  ReconstructionEstimatorOptions options = HierarchicalOptions();
+  options.hierarchical_max_num_views_per_cluster = kNumViews;
+  HierarchicalReconstructionEstimator estimator(options);
+  const ReconstructionEstimatorSummary summary =
+      estimator.Estimate(&view_graph, &reconstruction);
+  EXPECT_TRUE(summary.success);
+  EXPECT_EQ(summary.estimated_views.size(), kNumViews);
+  ExpectViewsMatchGroundTruth(gt_reconstruction, &reconstruction);
+}
+
+}  // namespace theia
@@ -60,6 +60,7 @@
 #include "theia/sfm/view_graph/view_graph.h"
 #include "theia/solvers/sample_consensus_estimator.h"
 #include "theia/util/map_util.h"
+#include "theia/util/profiler.h"
 #include "theia/util/stringprintf.h"
 #include "theia/util/timer.h"
 #include "theia/util/util.h"
@@ -146,6 +147,7 @@ IncrementalReconstructionEstimator::IncrementalReconstructionEstimator(
 // is very costly) and so incremental SfM is not as efficient or scalable.
 ReconstructionEstimatorSummary IncrementalReconstructionEstimator::Estimate(
     ViewGraph* view_graph, Reconstruction* reconstruction) {
+  ScopedProfile profile("IncrementalReconstructionEstimator");
   reconstruction_ = reconstruction;
   view_graph_ = view_graph;
 
@@ -177,7 +179,7 @@ ReconstructionEstimatorSummary IncrementalReconstructionEstimator::Estimate(
 
   // Try to add as many views as possible to the reconstruction until no more
   // views can be localized.
-  RansacSummary unused_ransac_summary;
+  RansacSummary ransac_summary;
   std::vector<ViewId> views_to_localize;
   int failed_localization_attempts = -1;
   while (!views_to_localize_.empty() &&
@@ -197,14 +199,18 @@ ReconstructionEstimatorSummary IncrementalReconstructionEstimator::Estimate(
     // on the current state of the reconstruction.
     for (int i = 0; i < views_to_localize.size(); i++) {
       timer.Reset();
-      if (!LocalizeViewToReconstruction(views_to_localize[i],
-                                        localization_options_,
-                                        reconstruction_,
-                                        &unused_ransac_summary)) {
+      if (!LocalizeViewToReconstruction(
+              views_to_localize[i],
+              GetLocalizationOptions(views_to_localize[i]),
+              reconstruction_,
+              &ransac_summary)) {
         ++failed_localization_attempts;
         continue;
       }
       summary_.pose_estimation_time += timer.ElapsedTimeInSeconds();
+      localization_inlier_ratios_[views_to_localize[i]] =
+          static_cast<double>(ransac_summary.inliers.size()) /
+          NumEstimatedTracksInView(views_to_localize[i]);
 
       reconstructed_views_.push_back(views_to_localize[i]);
       views_to_localize_.erase(views_to_localize[i]);
@@ -296,6 +302,7 @@ void IncrementalReconstructionEstimator::InitializeCamerasFromTwoViewInfo(
 }
 
 bool IncrementalReconstructionEstimator::ChooseInitialViewPair() {
+  ScopedProfile profile("ChooseInitialViewPair");
   static const int kMinNumInitialTracks = 100;
 
   // Sort the view pairs by the number of geometrically verified matches.
@@ -397,8 +404,55 @@ void IncrementalReconstructionEstimator::
   }
 }
 
+LocalizeViewToReconstructionOptions
+IncrementalReconstructionEstimator::GetLocalizationOptions(
+    const ViewId view_id) const {
+  // The inlier ratio of a view is assumed to be at least this fraction of the
+  // lowest inlier ratio of its localized neighbors. This leaves a margin for
+  // views that see the scene at a different scale or under different lighting.
+  static const double kPriorInlierRatioFraction = 0.5;
+
+  LocalizeViewToReconstructionOptions localization_options =
+      localization_options_;
+  const auto* neighbor_ids = view_graph_->GetNeighborIdsForView(view_id);
+  if (neighbor_ids == nullptr) {
+    return localization_options;
+  }
+
+  double min_neighbor_inlier_ratio = 1.0;
+  bool has_localized_neighbor = false;
+  for (const ViewId neighbor_id : *neighbor_ids) {
+    const double* inlier_ratio =
+        FindOrNull(localization_inlier_ratios_, neighbor_id);
+    if (inlier_ratio != nullptr) {
+      min_neighbor_inlier_ratio =
+          std::min(min_neighbor_inlier_ratio, *inlier_ratio);
+      has_localized_neighbor = true;
+    }
+  }
+
+  if (has_localized_neighbor) {
+    localization_options.ransac_params.min_inlier_ratio =
+        std::max(localization_options.ransac_params.min_inlier_ratio,
+                 kPriorInlierRatioFraction * min_neighbor_inlier_ratio);
+  }
+  return localization_options;
+}
+
+int IncrementalReconstructionEstimator::NumEstimatedTracksInView(
+    const ViewId view_id) const {
+  int num_estimated_tracks = 0;
+  for (const TrackId track_id : reconstruction_->View(view_id)->TrackIds()) {
+    if (reconstruction_->Track(track_id)->IsEstimated()) {
+      ++num_estimated_tracks;
+    }
+  }
+  return num_estimated_tracks;
+}
+
 void IncrementalReconstructionEstimator::FindViewsToLocalize(
     std::vector<ViewId>* views_to_localize) {
+  ScopedProfile profile("FindViewsToLocalize");
   // We localize all views that observe 75% or more than the number of 3D points
   // observed by the view with the largest number of observed 3D points.
   static const double kObserved3dPointsRatio = 0.75;
@@ -439,6 +493,7 @@ void IncrementalReconstructionEstimator::FindViewsToLocalize(
 
 void IncrementalReconstructionEstimator::EstimateStructure(
     const ViewId view_id) {
+  ScopedProfile profile("EstimateStructure");
   // Estimate all tracks.
   TrackEstimator track_estimator(triangulation_options_, reconstruction_);
   const std::vector<TrackId>& tracks_in_view =
@@ -535,7 +590,9 @@ void IncrementalReconstructionEstimator::RemoveOutlierTracks(
       tracks_to_check,
       max_reprojection_error_in_pixels,
       options_.min_triangulation_angle_degrees,
-      reconstruction_);
+      options_.num_threads,
+      reconstruction_,
+      nullptr);
   LOG(INFO) << num_points_removed << " outlier points were removed.";
 }
 
@@ -544,9 +601,11 @@ void IncrementalReconstructionEstimator::SetUnderconstrainedAsUnestimated() {
   int num_underconstrained_tracks = -1;
   while (num_underconstrained_views != 0 && num_underconstrained_tracks != 0) {
     num_underconstrained_views =
-        SetUnderconstrainedViewsToUnestimated(reconstruction_);
+        SetUnderconstrainedViewsToUnestimated(options_.num_threads,
+                                              reconstruction_);
     num_underconstrained_tracks =
-        SetUnderconstrainedTracksToUnestimated(reconstruction_);
+        SetUnderconstrainedTracksToUnestimated(options_.num_threads,
+                                               reconstruction_);
   }
 
   // If any views were removed then we need to update the localization container
@@ -125,6 +125,15 @@ class IncrementalReconstructionEstimator : public ReconstructionEstimator {
   // to using the calibrated or uncalibrated absolute pose algorithm.
   void FindViewsToLocalize(std::vector<ViewId>* views_to_localize);
 
+  // Returns the localization options for the view. The expected number of
+  // RANSAC iterations is set from the inlier ratios of the neighboring views in
+  // the view graph that have already been localized.
+  LocalizeViewToReconstructionOptions GetLocalizationOptions(
+      const ViewId view_id) const;
+
+  // Returns the number of estimated tracks that the view observes.
+  int NumEstimatedTracksInView(const ViewId view_id) const;
+
   // Remove any features that have too high of reprojection errors or are not
   // well-constrained. Only the input features are checked for outliers.
   void RemoveOutlierTracks(const std::unordered_set<TrackId>& tracks_to_check,
@@ -153,6 +162,9 @@ class IncrementalReconstructionEstimator : public ReconstructionEstimator {
   // partial BA.
   std::vector<ViewId> reconstructed_views_;
 
+  // The inlier ratio of the 2D-3D correspondences of each localized view.
+  std::unordered_map<ViewId, double> localization_inlier_ratios_;
+
   // Indicates the number of views that have been optimized with full BA.
   int num_optimized_views_;
 
@@ -34,17 +34,23 @@
 
 #include "theia/sfm/localize_view_to_reconstruction.h"
 
+#include <Eigen/Core>
 #include <glog/logging.h>
+#include <algorithm>
+#include <cmath>
+#include <utility>
 #include <vector>
 
 #include "theia/sfm/bundle_adjustment/bundle_adjustment.h"
 #include "theia/sfm/estimators/feature_correspondence_2d_3d.h"
 #include "theia/sfm/estimators/estimate_calibrated_absolute_pose.h"
 #include "theia/sfm/estimators/estimate_uncalibrated_absolute_pose.h"
+#include "theia/math/util.h"
 #include "theia/sfm/camera/camera.h"
 #include "theia/sfm/reconstruction.h"
 #include "theia/sfm/types.h"
 #include "theia/solvers/sample_consensus_estimator.h"
+#include "theia/util/profiler.h"
 
 namespace theia {
 namespace {
@@ -60,28 +66,111 @@ void NormalizeFeature(const Camera& camera,
       focal_length;
 }
 
+// Returns a score for how reliable the 3D point of the track is. Points that
+// are observed by more estimated views are more likely to be correct, but only
+// if they are well-constrained (i.e., have a sufficient triangulation angle)
+// and agree with their observations (i.e., have a low reprojection error).
+double ComputeTrackQuality(const Reconstruction& reconstruction,
+                           const TrackId track_id,
+                           const double reprojection_error_threshold_pixels) {
+  // Points with at least this triangulation angle are considered to be
+  // well-constrained.
+  static const double kWellConstrainedAngleDegrees = 5.0;
+
+  const Track* track = reconstruction.Track(track_id);
+  const Eigen::Vector3d point = track->Point().hnormalized();
+  // The triangulation angle is measured between the first ray and each of the
+  // other rays so that the track is scored in a single pass. This is at least
+  // half of the largest angle between any two rays and is only used to rank
+  // the tracks.
+  Eigen::Vector3d first_ray;
+  double min_cos_angle = 1.0;
+  int num_estimated_views = 0;
+  double sq_reprojection_error_sum = 0;
+  for (const ViewId view_id : track->ViewIds()) {
+    const View* view = reconstruction.View(view_id);
+    if (!view->IsEstimated()) {
+      continue;
+    }
+
+    // Points behind one of the cameras are unreliable.
+    const Camera& camera = view->Camera();
+    Eigen::Vector2d reprojection;
+    if (camera.ProjectPoint(track->Point(), &reprojection) < 0) {
+      return 0;
+    }
+    sq_reprojection_error_sum +=
+        (reprojection - *view->GetFeature(track_id)).squaredNorm();
+
+    const Eigen::Vector3d ray = (point - camera.GetPosition()).normalized();
+    if (num_estimated_views == 0) {
+      first_ray = ray;
+    } else {
+      min_cos_angle = std::min(min_cos_angle, first_ray.dot(ray));
+    }
+    ++num_estimated_views;
+  }
+  if (num_estimated_views == 0) {
+    return 0;
+  }
+
+  const double triangulation_angle_degrees =
+      RadToDeg(std::acos(std::max(-1.0, min_cos_angle)));
+  const double mean_sq_reprojection_error =
+      sq_reprojection_error_sum / num_estimated_views;
+  return num_estimated_views *
+         std::min(1.0,
+                  triangulation_angle_degrees / kWellConstrainedAngleDegrees) /
+         (1.0 + mean_sq_reprojection_error /
+                    (reprojection_error_threshold_pixels *
+                     reprojection_error_threshold_pixels));
+}
+
 void GetNormalized2D3DCorrespondencesForView(
         const View& view,
         const Reconstruction& reconstruction,
         const double focal_length,
+        const double reprojection_error_threshold_pixels,
         std::vector<FeatureCorrespondence2D3D>* correspondences) {
   const auto& tracks_in_view = view.TrackIds();
   const Camera& camera = view.Camera();
-  correspondences->reserve(tracks_in_view.size());
 
+  // Score the tracks so that the correspondences can be sorted by quality.
+  std::vector<std::pair<double, TrackId> > ranked_tracks;
+  ranked_tracks.reserve(tracks_in_view.size());
   for (const TrackId track_id : tracks_in_view) {
     const Track* track = reconstruction.Track(track_id);
     // We only use 3D points that have been estimated.
     if (!track->IsEstimated()) {
       continue;
     }
+    ranked_tracks.emplace_back(
+        ComputeTrackQuality(reconstruction,
+                            track_id,
+                            reprojection_error_threshold_pixels),
+        track_id);
+  }
+
+  // Sort by decreasing quality. Ties are broken by the track id so that the
+  // order does not depend on the order of the tracks in the view.
+  std::sort(ranked_tracks.begin(),
+            ranked_tracks.end(),
+            [](const std::pair<double, TrackId>& lhs,
+               const std::pair<double, TrackId>& rhs) {
+              return lhs.first > rhs.first ||
+                     (lhs.first == rhs.first && lhs.second < rhs.second);
+            });
 
+  correspondences->reserve(ranked_tracks.size());
+  for (const auto& ranked_track : ranked_tracks) {
+    const TrackId track_id = ranked_track.second;
     FeatureCorrespondence2D3D correspondence;
     correspondence.feature = *view.GetFeature(track_id);
     // Normalize the feature by the intrinsics.
     NormalizeFeature(camera, focal_length, &correspondence.feature);
 
-    correspondence.world_point = track->Point().hnormalized();
+    correspondence.world_point =
+        reconstruction.Track(track_id)->Point().hnormalized();
     correspondences->emplace_back(correspondence);
   }
 }
@@ -93,6 +182,7 @@ bool LocalizeViewToReconstruction(
     const LocalizeViewToReconstructionOptions options,
     Reconstruction* reconstruction,
     RansacSummary* summary) {
+  ScopedProfile profile("LocalizeView");
   CHECK_NOTNULL(reconstruction);
   CHECK_NOTNULL(summary);
 
@@ -108,12 +198,14 @@ bool LocalizeViewToReconstruction(
   const double focal_length =
       known_focal_length ? camera->FocalLength() : kUnknownFocalLength;
 
-  // Gather all 2D-3D correspondences.
+  // Gather all 2D-3D correspondences, sorted by the quality of their tracks.
   std::vector<FeatureCorrespondence2D3D> matches;
-  GetNormalized2D3DCorrespondencesForView(*view,
-                                          *reconstruction,
-                                          focal_length,
-                                          &matches);
+  GetNormalized2D3DCorrespondencesForView(
+      *view,
+      *reconstruction,
+      focal_length,
+      options.reprojection_error_threshold_pixels,
+      &matches);
   if (matches.size() < options.min_num_inliers) {
     VLOG(2) << "Not enough 2D-3D correspondences to localize view "
             << view_to_localize;
@@ -133,7 +225,7 @@ bool LocalizeViewToReconstruction(
   if (known_focal_length) {
     CalibratedAbsolutePose pose;
     success = EstimateCalibratedAbsolutePose(
-        ransac_parameters, RansacType::RANSAC, matches, &pose, summary);
+        ransac_parameters, options.ransac_type, matches, &pose, summary);
     camera->SetOrientationFromRotationMatrix(pose.rotation);
     camera->SetPosition(pose.position);
   } else {
@@ -141,7 +233,7 @@ bool LocalizeViewToReconstruction(
     // together.
     UncalibratedAbsolutePose pose;
     success = EstimateUncalibratedAbsolutePose(
-        ransac_parameters, RansacType::RANSAC, matches, &pose, summary);
+        ransac_parameters, options.ransac_type, matches, &pose, summary);
     camera->SetOrientationFromRotationMatrix(pose.rotation);
     camera->SetPosition(pose.position);
     camera->SetFocalLength(pose.focal_length);
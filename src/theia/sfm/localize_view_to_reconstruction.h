@@ -35,6 +35,7 @@
 #ifndef THEIA_SFM_LOCALIZE_VIEW_TO_RECONSTRUCTION_H_
 #define THEIA_SFM_LOCALIZE_VIEW_TO_RECONSTRUCTION_H_
 
+#include "theia/sfm/create_and_initialize_ransac_variant.h"
 #include "theia/sfm/types.h"
 #include "theia/solvers/sample_consensus_estimator.h"
 
@@ -49,6 +50,13 @@ struct LocalizeViewToReconstructionOptions {
   double reprojection_error_threshold_pixels;
   RansacParameters ransac_params;
 
+  // The 2D-3D correspondences are sorted by the quality of their tracks: points
+  // that are observed by many estimated views, with a wide triangulation angle
+  // and a low reprojection error come first. PROSAC samples the best
+  // correspondences first, which finds a good pose after far fewer iterations
+  // than RANSAC.
+  RansacType ransac_type = RansacType::PROSAC;
+
   // The view will be bundle adjusted (while all tracks are held constant) if
   // this is set to true.
   bool bundle_adjust_view = true;
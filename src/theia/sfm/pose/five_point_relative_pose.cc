@@ -50,13 +50,11 @@ using Eigen::Map;
 using Eigen::Matrix3d;
 using Eigen::Matrix4d;
 using Eigen::Matrix;
-using Eigen::MatrixXd;
 using Eigen::RowVector3d;
 using Eigen::RowVector4d;
 using Eigen::Vector2d;
 using Eigen::Vector3d;
 using Eigen::Vector4d;
-using Eigen::VectorXd;
 
 typedef Matrix<double, 10, 10> Matrix10d;
 
@@ -205,54 +203,29 @@ Matrix<double, 10, 20> BuildConstraintMatrix(
   return constraint_matrix;
 }
 
-}  // namespace
-
-// Implementation of Nister from "An Efficient Solution to the Five-Point
-// Relative Pose Problem"
-bool FivePointRelativePose(const std::vector<Vector2d>& image1_points,
-                           const std::vector<Vector2d>& image2_points,
-                           std::vector<Matrix3d>* essential_matrices) {
-  CHECK_EQ(image1_points.size(), image2_points.size());
-  CHECK_GE(image1_points.size(), 5) << "You must supply at least 5 "
-                                       "correspondences for the 5 point "
-                                       "essential matrix algorithm.";
-
-  // Step 1. Create the nx9 matrix containing epipolar constraints.
-  //   Essential matrix is a linear combination of the 4 vectors spanning the
-  //   null space of this matrix.
-  MatrixXd epipolar_constraint(image1_points.size(), 9);
-  for (int i = 0; i < image1_points.size(); i++) {
-    // Fill matrix with the epipolar constraint from q'_t*E*q = 0. Where q is
-    // from the first image, and q' is from the second.
-    epipolar_constraint.row(i) <<
-        image2_points[i].x() * image1_points[i].x(),
-        image2_points[i].y() * image1_points[i].x(),
-        image1_points[i].x(),
-        image2_points[i].x() * image1_points[i].y(),
-        image2_points[i].y() * image1_points[i].y(),
-        image1_points[i].y(),
-        image2_points[i].x(),
-        image2_points[i].y(),
-        1.0;
-  }
-
-  Matrix<double, 9, 4> null_space;
-
-  // Extract the null space from a minimal sampling (using LU) or non-minimal
-  // sampling (using SVD).
-  if (image1_points.size() == 5) {
-    const Eigen::FullPivLU<MatrixXd> lu(epipolar_constraint);
-    if (lu.dimensionOfKernel() != 4) {
-      return false;
-    }
-    null_space = lu.kernel();
-  } else {
-    const Eigen::JacobiSVD<MatrixXd> svd(
-        epipolar_constraint.transpose() * epipolar_constraint,
-        Eigen::ComputeFullV);
-    null_space = svd.matrixV().rightCols<4>();
-  }
+// Fills the row of the epipolar constraint from q'_t*E*q = 0. Where q is from
+// the first image, and q' is from the second.
+Matrix<double, 1, 9> EpipolarConstraint(const Vector2d& image1_point,
+                                        const Vector2d& image2_point) {
+  Matrix<double, 1, 9> constraint;
+  constraint <<
+      image2_point.x() * image1_point.x(),
+      image2_point.y() * image1_point.x(),
+      image1_point.x(),
+      image2_point.x() * image1_point.y(),
+      image2_point.y() * image1_point.y(),
+      image1_point.y(),
+      image2_point.x(),
+      image2_point.y(),
+      1.0;
+  return constraint;
+}
 
+// Given the 4 vectors spanning the null space of the epipolar constraints,
+// computes the essential matrices that satisfy the trace and determinant
+// constraints.
+bool EssentialMatricesFromNullSpace(const Matrix<double, 9, 4>& null_space,
+                                    std::vector<Matrix3d>* essential_matrices) {
   const Matrix<double, 1, 4> null_space_matrix[3][3] = {
     { null_space.row(0), null_space.row(3), null_space.row(6) },
     { null_space.row(1), null_space.row(4), null_space.row(7) },
@@ -298,4 +271,65 @@ bool FivePointRelativePose(const std::vector<Vector2d>& image1_points,
   return essential_matrices->size() > 0;
 }
 
+}  // namespace
+
+// Implementation of Nister from "An Efficient Solution to the Five-Point
+// Relative Pose Problem"
+bool FivePointRelativePose(const Vector2d image1_points[5],
+                           const Vector2d image2_points[5],
+                           std::vector<Matrix3d>* essential_matrices) {
+  // Step 1. Create the 5x9 matrix containing epipolar constraints.
+  //   Essential matrix is a linear combination of the 4 vectors spanning the
+  //   null space of this matrix. The null space is the orthogonal complement of
+  //   the column space of the transposed constraint matrix, which is spanned by
+  //   the last 4 columns of Q in its QR decomposition.
+  Matrix<double, 9, 5> epipolar_constraint_transpose;
+  for (int i = 0; i < 5; i++) {
+    epipolar_constraint_transpose.col(i) =
+        EpipolarConstraint(image1_points[i], image2_points[i]).transpose();
+  }
+
+  const Eigen::FullPivHouseholderQR<Matrix<double, 9, 5> > qr(
+      epipolar_constraint_transpose);
+  if (qr.rank() != 5) {
+    return false;
+  }
+  const Matrix<double, 9, 9> q = qr.matrixQ();
+  const Matrix<double, 9, 4> null_space = q.rightCols<4>();
+
+  return EssentialMatricesFromNullSpace(null_space, essential_matrices);
+}
+
+bool FivePointRelativePose(const std::vector<Vector2d>& image1_points,
+                           const std::vector<Vector2d>& image2_points,
+                           std::vector<Matrix3d>* essential_matrices) {
+  CHECK_EQ(image1_points.size(), image2_points.size());
+  CHECK_GE(image1_points.size(), 5) << "You must supply at least 5 "
+                                       "correspondences for the 5 point "
+                                       "essential matrix algorithm.";
+
+  if (image1_points.size() == 5) {
+    return FivePointRelativePose(image1_points.data(),
+                                 image2_points.data(),
+                                 essential_matrices);
+  }
+
+  // Step 1. Accumulate the normal equations of the nx9 matrix containing the
+  //   epipolar constraints. The null space is spanned by the eigenvectors
+  //   corresponding to the 4 smallest eigenvalues of the normal matrix.
+  Matrix<double, 9, 9> normal_matrix = Matrix<double, 9, 9>::Zero();
+  for (int i = 0; i < image1_points.size(); i++) {
+    const Matrix<double, 1, 9> constraint =
+        EpipolarConstraint(image1_points[i], image2_points[i]);
+    normal_matrix.noalias() += constraint.transpose() * constraint;
+  }
+
+  const Eigen::SelfAdjointEigenSolver<Matrix<double, 9, 9> > eigensolver(
+      normal_matrix);
+  const Matrix<double, 9, 4> null_space =
+      eigensolver.eigenvectors().leftCols<4>();
+
+  return EssentialMatricesFromNullSpace(null_space, essential_matrices);
+}
+
 }  // namespace theia
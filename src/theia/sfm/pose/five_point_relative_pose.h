@@ -60,6 +60,14 @@ namespace theia {
 bool FivePointRelativePose(const std::vector<Eigen::Vector2d>& image1_points,
                            const std::vector<Eigen::Vector2d>& image2_points,
                            std::vector<Eigen::Matrix3d>* essential_matrices);
+
+// Same as above, but for exactly 5 correspondences. This minimal version only
+// uses fixed-size types and does not allocate any memory besides the output so
+// that it may be called for each hypothesis in the inner loop of RANSAC.
+bool FivePointRelativePose(const Eigen::Vector2d image1_points[5],
+                           const Eigen::Vector2d image2_points[5],
+                           std::vector<Eigen::Matrix3d>* essential_matrices);
+
 }  // namespace theia
 
 #endif  // THEIA_SFM_POSE_FIVE_POINT_RELATIVE_POSE_H_
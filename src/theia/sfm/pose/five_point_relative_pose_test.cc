@@ -272,5 +272,44 @@ TEST(FivePointRelativePose, NoRotationNonminimal) {
                                kEMatrixTolerance);
 }
 
+// The fixed-size minimal solver should recover the ground truth essential
+// matrix for random, well-conditioned configurations.
+TEST(FivePointRelativePose, RandomMinimalFixedSize) {
+  static const int kNumTrials = 100;
+  static const double kEMatrixTolerance = 1e-6;
+  InitRandomGenerator();
+
+  for (int trial = 0; trial < kNumTrials; trial++) {
+    const Matrix3d rotation =
+        AngleAxisd(DegToRad(RandDouble(-30.0, 30.0)),
+                   Vector3d::Random().normalized()).toRotationMatrix();
+    const Vector3d translation = Vector3d::Random().normalized();
+
+    Vector2d image1_points[5], image2_points[5];
+    for (int i = 0; i < 5; i++) {
+      const Vector3d point(RandDouble(-2.0, 2.0),
+                           RandDouble(-2.0, 2.0),
+                           RandDouble(4.0, 8.0));
+      image1_points[i] = point.hnormalized();
+      image2_points[i] = (rotation * point + translation).hnormalized();
+    }
+
+    std::vector<Matrix3d> essential_matrices;
+    EXPECT_TRUE(FivePointRelativePose(image1_points,
+                                      image2_points,
+                                      &essential_matrices));
+
+    const Matrix3d gt_ematrix = CrossProductMatrix(translation) * rotation;
+    bool matched_transform = false;
+    for (const Matrix3d& essential_matrix : essential_matrices) {
+      if (test::ArraysEqualUpToScale(9, essential_matrix.data(),
+                                     gt_ematrix.data(), kEMatrixTolerance)) {
+        matched_transform = true;
+      }
+    }
+    EXPECT_TRUE(matched_transform);
+  }
+}
+
 }  // namespace
 }  // namespace theia
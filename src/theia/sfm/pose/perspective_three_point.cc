@@ -40,7 +40,7 @@
 #include <complex>
 #include <algorithm>
 
-#include "theia/math/polynomial.h"
+#include "theia/math/find_polynomial_roots_sturm.h"
 #include "theia/sfm/pose/util.h"
 
 namespace theia {
@@ -95,7 +95,7 @@ int SolvePlaneRotation(const Vector3d normalized_image_points[3],
   const double b_pw2 = (*b) * (*b);
 
   // Computation of coefficients of 4th degree polynomial.
-  Eigen::VectorXd coefficients(5);
+  Eigen::Matrix<double, 5, 1> coefficients;
   coefficients(0) = -f_2_pw2 * p_2_pw4 - p_2_pw4 * f_1_pw2 - p_2_pw4;
   coefficients(1) =
       2.0 * p_2_pw3 * d_12 * (*b) + 2.0 * f_2_pw2 * p_2_pw3 * d_12 * (*b) -
@@ -117,18 +117,18 @@ int SolvePlaneRotation(const Vector3d normalized_image_points[3],
       2.0 * f_2_pw2 * p_2_pw2 * p_1 * d_12 + p_2_pw2 * f_1_pw2 * p_1_pw2 +
       f_2_pw2 * p_2_pw2 * d_12_pw2 * b_pw2;
 
-  // Computation of roots.
-  Eigen::VectorXd roots;
-  FindPolynomialRoots(coefficients, &roots, NULL);
+  // Computation of the real roots.
+  double roots[4];
+  const int num_roots = FindRealPolynomialRootsSturm<4>(coefficients, roots);
 
   // Calculate cot(alpha) needed for back-substitution.
-  for (int i = 0; i < roots.size(); i++) {
-    cos_theta[i] = roots(i);
+  for (int i = 0; i < num_roots; i++) {
+    cos_theta[i] = roots[i];
     cot_alphas[i] = (-f_1 * p_1 / f_2 - cos_theta[i] * p_2 + d_12 * (*b)) /
                     (-f_1 * cos_theta[i] * p_2 / f_2 + p_1 - d_12);
   }
 
-  return roots.size();
+  return num_roots;
 }
 
 // Given the complete transformation between intermediate world and camera
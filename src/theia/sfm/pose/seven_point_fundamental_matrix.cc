@@ -35,11 +35,11 @@
 #include "theia/sfm/pose/seven_point_fundamental_matrix.h"
 
 #include <Eigen/Core>
-#include <Eigen/LU>
+#include <Eigen/QR>
 #include <glog/logging.h>
 #include <vector>
 
-#include "theia/math/polynomial.h"
+#include "theia/math/find_polynomial_roots_sturm.h"
 #include "theia/sfm/pose/util.h"
 
 namespace theia {
@@ -93,22 +93,27 @@ bool SevenPointFundamentalMatrix(
   const Matrix<double, 7, 9>& epipolar_constraint =
       SetupEpipolarConstraint(norm_img1_points, norm_img2_points);
 
-  const Eigen::FullPivLU<Matrix<double, 7, 9> > lu(epipolar_constraint);
-  if (lu.dimensionOfKernel() != 2) {
+  // The null space of the constraint is the orthogonal complement of the
+  // column space of its transpose, which is spanned by the last two columns of
+  // Q in the QR decomposition.
+  const Eigen::FullPivHouseholderQR<Matrix<double, 9, 7> > qr(
+      epipolar_constraint.transpose());
+  if (qr.rank() != 7) {
     return false;
   }
+  const Matrix<double, 9, 9> q = qr.matrixQ();
 
   // Represent F in terms of its null space such that F = x * F1' + (1 - x) * F2
   // where F1 and F2 are vectors in the null space of F. Note that this can also
   // be parameterized such that:
   //   F = x * F1' + (1 - x) * F2 = x * (F1' - F2) + F2 = x * F1 + F2.
-  const Matrix<double, 9, 2>& null_space = lu.kernel();
+  const Matrix<double, 9, 2> null_space = q.rightCols<2>();
   const Matrix<double, 9, 1> F1_vec = null_space.col(0) - null_space.col(1);
   const Eigen::Map<const Eigen::Matrix3d> F1(F1_vec.data());
   const Eigen::Map<const Eigen::Matrix3d> F2(null_space.col(1).data());
 
   // This is the cubic equation resulting from det(x * F1 + F2) = 0.
-  Eigen::VectorXd determinant_constraint(4);
+  Eigen::Vector4d determinant_constraint;
   determinant_constraint(0) =
       -(F2(1, 2) * F2(2, 1) - F2(1, 1) * F2(2, 2)) * F2(0, 0) +
       (F2(0, 2) * F2(2, 1) - F2(0, 1) * F2(2, 2)) * F2(1, 0) -
@@ -145,14 +150,15 @@ bool SevenPointFundamentalMatrix(
       (F1(0, 2) * F1(1, 1) - F1(0, 1) * F1(1, 2)) * F1(2, 0);
 
   // Solve the cubic equation for x.
-  Eigen::VectorXd roots;
-  FindPolynomialRoots(determinant_constraint, &roots, NULL);
+  double roots[3];
+  const int num_roots =
+      FindRealPolynomialRootsSturm<3>(determinant_constraint, roots);
 
-  for (int i = 0; i < roots.size(); i++) {
+  for (int i = 0; i < num_roots; i++) {
     // Compose the fundamental matrix solution from the null space and
     // determinant constraint: F = x * F1 + F2;
     fundamental_matrices->emplace_back(img2_norm_mat.transpose() *
-                                       (roots(i) * F1 + F2) * img1_norm_mat);
+                                       (roots[i] * F1 + F2) * img1_norm_mat);
   }
   return fundamental_matrices->size() > 0;
 }
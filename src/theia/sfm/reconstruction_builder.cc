@@ -40,6 +40,7 @@
 #include <vector>
 
 #include "theia/sfm/camera_intrinsics_prior.h"
+#include "theia/sfm/colorize_reconstruction.h"
 #include "theia/sfm/reconstruction.h"
 #include "theia/sfm/reconstruction_estimator.h"
 #include "theia/sfm/track_builder.h"
@@ -47,6 +48,7 @@
 #include "theia/sfm/view.h"
 #include "theia/sfm/view_graph/view_graph.h"
 #include "theia/util/filesystem.h"
+#include "theia/util/profiler.h"
 
 namespace theia {
 
@@ -151,6 +153,9 @@ ReconstructionBuilder::ReconstructionBuilder(
   feam_options.descriptor_extractor_type =
       options_.descriptor_type;
   feam_options.sift_parameters = options_.sift_parameters;
+  feam_options.image_loader_options.max_image_dimension =
+      options_.max_image_dimension;
+  feam_options.extract_keypoint_colors = options_.extract_keypoint_colors;
   feam_options.min_num_inlier_matches = options_.min_num_inlier_matches;
   feam_options.matching_strategy = options_.matching_strategy;
   feam_options.feature_matcher_options = options_.matching_options;
@@ -201,6 +206,7 @@ bool ReconstructionBuilder::ExtractAndMatchFeatures() {
   CHECK_EQ(view_graph_->NumViews(), 0) << "Cannot call ExtractAndMatchFeatures "
                                           "after TwoViewMatches has been "
                                           "called.";
+  ScopedProfile profile("ExtractAndMatchFeatures");
 
   // Extract features and obtain the feature matches.
   std::vector<ImagePairMatch> matches;
@@ -301,9 +307,11 @@ bool ReconstructionBuilder::BuildReconstruction(
   CHECK_GE(view_graph_->NumViews(), 2) << "At least 2 images must be provided "
                                           "in order to create a "
                                           "reconstruction.";
+  ScopedProfile profile("BuildReconstruction");
 
   // Build tracks if they were not explicitly specified.
   if (reconstruction_->NumTracks() == 0) {
+    ScopedProfile build_tracks_profile("BuildTracks");
     track_builder_->BuildTracks(reconstruction_.get());
   }
 
@@ -346,6 +354,12 @@ bool ReconstructionBuilder::BuildReconstruction(
     // from the remaining unestimated parts.
     reconstructions->emplace_back(
         CreateEstimatedSubreconstruction(*reconstruction_));
+    if (!feature_extractor_and_matcher_->keypoint_colors().empty()) {
+      ScopedProfile colorize_profile("ColorizeReconstruction");
+      ColorizeReconstructionFromKeypointColors(
+          feature_extractor_and_matcher_->keypoint_colors(),
+          reconstructions->back());
+    }
     RemoveEstimatedViewsAndTracks(reconstruction_.get(), view_graph_.get());
 
     // Exit after the first reconstruction estimation if only the single largest
@@ -85,6 +85,18 @@ struct ReconstructionBuilderOptions {
   // See //theia/image/keypoint_detector/sift_parameters.h
   SiftParameters sift_parameters;
 
+  // If positive, images are decoded such that their larger dimension is at most
+  // this many pixels before extracting features.
+  // See //theia/image/image_loader.h
+  int max_image_dimension = 0;
+
+  // If true, the colors of the keypoints are recorded during feature
+  // extraction and the estimated reconstructions are colored with them, so
+  // that ColorizeReconstruction does not need to read the images again. Only
+  // used when the features are extracted from images.
+  // See //theia/sfm/colorize_reconstruction.h
+  bool extract_keypoint_colors = false;
+
   // Matching strategy type.
   // See //theia/matching/create_feature_matcher.h
   MatchingStrategy matching_strategy = MatchingStrategy::BRUTE_FORCE;
@@ -38,6 +38,7 @@
 
 #include "theia/sfm/incremental_reconstruction_estimator.h"
 #include "theia/sfm/global_reconstruction_estimator.h"
+#include "theia/sfm/hierarchical_reconstruction_estimator.h"
 #include "theia/sfm/reconstruction_estimator_options.h"
 
 namespace theia {
@@ -51,6 +52,9 @@ ReconstructionEstimator* ReconstructionEstimator::Create(
     case ReconstructionEstimatorType::INCREMENTAL:
       return new IncrementalReconstructionEstimator(options);
       break;
+    case ReconstructionEstimatorType::HIERARCHICAL:
+      return new HierarchicalReconstructionEstimator(options);
+      break;
     default:
       LOG(FATAL) << "Invalid reconstruction estimator specified.";
   }
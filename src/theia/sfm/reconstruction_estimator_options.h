@@ -35,18 +35,24 @@
 #ifndef THEIA_SFM_RECONSTRUCTION_ESTIMATOR_OPTIONS_H_
 #define THEIA_SFM_RECONSTRUCTION_ESTIMATOR_OPTIONS_H_
 
+#include <memory>
+
 #include "theia/sfm/bundle_adjustment/bundle_adjustment.h"
 #include "theia/sfm/global_pose_estimation/least_unsquared_deviation_position_estimator.h"
 #include "theia/sfm/global_pose_estimation/linear_position_estimator.h"
 #include "theia/sfm/global_pose_estimation/nonlinear_position_estimator.h"
+#include "theia/util/random.h"
 
 namespace theia {
 
 // Global SfM methods are considered to be more scalable while incremental SfM
-// is less scalable but often more robust.
+// is less scalable but often more robust. Hierarchical SfM partitions the view
+// graph into clusters that are reconstructed with global SfM and then merged,
+// which allows for very large datasets to be reconstructed.
 enum class ReconstructionEstimatorType {
   GLOBAL = 0,
-  INCREMENTAL = 1
+  INCREMENTAL = 1,
+  HIERARCHICAL = 2
 };
 
 // The recommended type of rotations solver is the Robust L1-L2 method. This
@@ -112,6 +118,11 @@ struct ReconstructionEstimatorOptions {
   int ransac_max_iterations = 1000;
   bool ransac_use_mle = true;
 
+  // The random number generator used for RANSAC and the other randomized steps
+  // of the reconstruction. Set this to a seeded generator to reproduce a
+  // reconstruction. If null, generators seeded from the current time are used.
+  std::shared_ptr<RandomNumberGenerator> rng;
+
   // --------------- Rotation Filtering Options --------------- //
 
   // After orientations are estimated, view pairs may be filtered/removed if the
@@ -189,6 +200,24 @@ struct ReconstructionEstimatorOptions {
   // controls how many views should be part of the partial BA.
   int partial_bundle_adjustment_num_views = 20;
 
+  // --------------------- Hierarchical SfM Options --------------------- //
+
+  // The view graph is recursively partitioned until each cluster contains at
+  // most this many views. Each cluster is then reconstructed with global SfM.
+  int hierarchical_max_num_views_per_cluster = 500;
+
+  // Each cluster is grown by adding views from neighboring clusters so that
+  // the clusters may be aligned to each other. A cluster of N views is grown by
+  // max(hierarchical_min_num_overlapping_views,
+  //     hierarchical_cluster_overlap_ratio * N) views.
+  double hierarchical_cluster_overlap_ratio = 0.1;
+  int hierarchical_min_num_overlapping_views = 10;
+
+  // After merging the clusters, only the views shared between clusters (and
+  // the tracks they observe) are bundle adjusted. Set this to true to perform
+  // a full bundle adjustment of the merged reconstruction instead.
+  bool hierarchical_bundle_adjust_all_views_after_merging = false;
+
   // --------------- Triangulation Options --------------- //
 
   // Minimum angle required between a 3D point and 2 viewing rays in order to
@@ -39,6 +39,7 @@
 #include <Eigen/LU>
 
 #include <algorithm>
+#include <cmath>
 #include <unordered_map>
 #include <vector>
 
@@ -102,6 +103,120 @@ void GetFeatureCorrespondences(const View& view1, const View& view2,
   }
 }
 
+// The outlier and underconstrained passes are evaluated in blocks of a fixed
+// size so that the per-block outputs, and therefore the order in which they
+// are merged, do not depend on the number of threads.
+static const int kNumItemsPerBlock = 1024;
+
+// Splits the range [0, num_items) into blocks and calls
+// evaluate_block(block_begin, block_end, &(*outputs)[block_index]) for each
+// block in parallel. The function must not modify any shared state.
+template <typename BlockOutput, typename Function>
+void EvaluateInBlocks(const int num_items,
+                      const int num_threads,
+                      const Function& evaluate_block,
+                      std::vector<BlockOutput>* outputs) {
+  const int num_blocks =
+      (num_items + kNumItemsPerBlock - 1) / kNumItemsPerBlock;
+  outputs->clear();
+  outputs->resize(num_blocks);
+  if (num_threads == 1 || num_blocks <= 1) {
+    for (int i = 0; i < num_blocks; i++) {
+      evaluate_block(i * kNumItemsPerBlock,
+                     std::min(num_items, (i + 1) * kNumItemsPerBlock),
+                     &(*outputs)[i]);
+    }
+    return;
+  }
+
+  ThreadPool pool(std::min(num_threads, num_blocks));
+  for (int i = 0; i < num_blocks; i++) {
+    pool.Add(evaluate_block,
+             i * kNumItemsPerBlock,
+             std::min(num_items, (i + 1) * kNumItemsPerBlock),
+             &(*outputs)[i]);
+  }
+}
+
+// The tracks found to be outliers within one block of RemoveOutlierFeatures
+// along with the reprojection error statistics of the block.
+struct OutlierTrackBlock {
+  std::vector<TrackId> bad_reprojection_tracks;
+  std::vector<TrackId> insufficient_angle_tracks;
+
+  int num_observations = 0;
+  double sum_reprojection_error = 0.0;
+  double sum_sq_reprojection_error = 0.0;
+  double max_reprojection_error = 0.0;
+};
+
+// Determines whether the track is an outlier because of a bad reprojection
+// (either behind a camera or a large mean reprojection error) or because it is
+// poorly constrained by a small viewing angle. The reprojection errors of all
+// observations in front of the cameras are accumulated into the block
+// statistics.
+void ClassifyTrack(const Reconstruction& reconstruction,
+                   const TrackId track_id,
+                   const double max_sq_reprojection_error,
+                   const double min_triangulation_angle_degrees,
+                   OutlierTrackBlock* block) {
+  const Track* track = reconstruction.Track(track_id);
+  if (!track->IsEstimated()) {
+    return;
+  }
+
+  std::vector<Eigen::Vector3d> ray_directions;
+  bool is_behind_camera = false;
+  int num_projections = 0;
+  double mean_sq_reprojection_error = 0;
+  for (const ViewId view_id : track->ViewIds()) {
+    const View* view = CHECK_NOTNULL(reconstruction.View(view_id));
+    if (!view->IsEstimated()) {
+      continue;
+    }
+
+    const Camera& camera = view->Camera();
+    const Eigen::Vector3d ray_direction =
+        track->Point().hnormalized() - camera.GetPosition();
+    ray_directions.push_back(ray_direction.normalized());
+
+    // Reproject the observations.
+    const Feature* feature = view->GetFeature(track_id);
+    Eigen::Vector2d projection;
+    const double depth = camera.ProjectPoint(track->Point(), &projection);
+    // The track is an outlier if the reprojection is behind the camera.
+    if (depth < 0) {
+      is_behind_camera = true;
+      continue;
+    }
+    const double sq_reprojection_error = (projection - *feature).squaredNorm();
+    mean_sq_reprojection_error += sq_reprojection_error;
+    ++num_projections;
+
+    const double reprojection_error = std::sqrt(sq_reprojection_error);
+    ++block->num_observations;
+    block->sum_reprojection_error += reprojection_error;
+    block->sum_sq_reprojection_error += sq_reprojection_error;
+    block->max_reprojection_error =
+        std::max(block->max_reprojection_error, reprojection_error);
+  }
+
+  mean_sq_reprojection_error /= static_cast<double>(num_projections);
+  if (is_behind_camera ||
+      mean_sq_reprojection_error > max_sq_reprojection_error) {
+    block->bad_reprojection_tracks.emplace_back(track_id);
+    return;
+  }
+
+  // The track will remain estimated if the reprojection errors were all
+  // good. We then test that the track is properly constrained by having at
+  // least two cameras view it with a sufficient viewing angle.
+  if (!SufficientTriangulationAngle(ray_directions,
+                                    min_triangulation_angle_degrees)) {
+    block->insufficient_angle_tracks.emplace_back(track_id);
+  }
+}
+
 }  // namespace
 
 // Sets the bundle adjustment options from the reconstruction estimator options.
@@ -138,6 +253,7 @@ RansacParameters SetRansacParameters(
   ransac_params.min_iterations = options.ransac_min_iterations;
   ransac_params.max_iterations = options.ransac_max_iterations;
   ransac_params.use_mle = options.ransac_use_mle;
+  ransac_params.rng = options.rng;
   return ransac_params;
 }
 
@@ -267,79 +383,94 @@ void RefineRelativeTranslationsWithKnownRotations(
 
 int RemoveOutlierFeatures(const double max_inlier_reprojection_error,
                           const double min_triangulation_angle_degrees,
-                          Reconstruction* reconstruction) {
-  const auto& track_ids = reconstruction->TrackIds();
-  const std::unordered_set<TrackId> all_tracks(track_ids.begin(),
-                                               track_ids.end());
-  return RemoveOutlierFeatures(all_tracks,
+                          const int num_threads,
+                          Reconstruction* reconstruction,
+                          ReprojectionErrorStatistics* statistics) {
+  const std::vector<TrackId> track_ids = reconstruction->TrackIds();
+  return RemoveOutlierFeatures(track_ids,
                                max_inlier_reprojection_error,
                                min_triangulation_angle_degrees,
-                               reconstruction);
+                               num_threads,
+                               reconstruction,
+                               statistics);
 }
 
 int RemoveOutlierFeatures(const std::unordered_set<TrackId>& track_ids,
                           const double max_inlier_reprojection_error,
                           const double min_triangulation_angle_degrees,
-                          Reconstruction* reconstruction) {
+                          const int num_threads,
+                          Reconstruction* reconstruction,
+                          ReprojectionErrorStatistics* statistics) {
+  const std::vector<TrackId> tracks_to_check(track_ids.begin(),
+                                             track_ids.end());
+  return RemoveOutlierFeatures(tracks_to_check,
+                               max_inlier_reprojection_error,
+                               min_triangulation_angle_degrees,
+                               num_threads,
+                               reconstruction,
+                               statistics);
+}
+
+int RemoveOutlierFeatures(const std::vector<TrackId>& track_ids,
+                          const double max_inlier_reprojection_error,
+                          const double min_triangulation_angle_degrees,
+                          const int num_threads,
+                          Reconstruction* reconstruction,
+                          ReprojectionErrorStatistics* statistics) {
+  CHECK_GE(num_threads, 1);
+  CHECK_NOTNULL(reconstruction);
   const double max_sq_reprojection_error =
       max_inlier_reprojection_error * max_inlier_reprojection_error;
 
-  int num_estimated_tracks = 0;
-  int num_bad_reprojections = 0;
-  int num_insufficient_viewing_angles = 0;
-
-  for (const TrackId track_id : track_ids) {
-    Track* track = reconstruction->MutableTrack(track_id);
-    if (!track->IsEstimated()) {
-      continue;
+  // Classify all tracks without modifying the reconstruction.
+  const Reconstruction& const_reconstruction = *reconstruction;
+  const auto evaluate_block = [&](const int block_begin,
+                                  const int block_end,
+                                  OutlierTrackBlock* block) {
+    for (int i = block_begin; i < block_end; i++) {
+      ClassifyTrack(const_reconstruction,
+                    track_ids[i],
+                    max_sq_reprojection_error,
+                    min_triangulation_angle_degrees,
+                    block);
     }
-    ++num_estimated_tracks;
+  };
+  std::vector<OutlierTrackBlock> blocks;
+  EvaluateInBlocks(track_ids.size(), num_threads, evaluate_block, &blocks);
 
-    std::vector<Eigen::Vector3d> ray_directions;
-    const auto& view_ids = track->ViewIds();
-    int num_projections = 0;
-    double mean_sq_reprojection_error = 0;
-    for (const ViewId view_id : view_ids) {
-      const View* view = CHECK_NOTNULL(reconstruction->View(view_id));
-      if (!view->IsEstimated()) {
-        continue;
-      }
-
-      const Camera& camera = view->Camera();
-      const Eigen::Vector3d ray_direction =
-          track->Point().hnormalized() - camera.GetPosition();
-      ray_directions.push_back(ray_direction.normalized());
-
-      // Check the reprojection error.
-      const Feature* feature = view->GetFeature(track_id);
-      // Reproject the observations.
-      Eigen::Vector2d projection;
-      const double depth = camera.ProjectPoint(track->Point(), &projection);
-      // Remove the feature if the reprojection is behind the camera.
-      if (depth < 0) {
-        ++num_bad_reprojections;
-        track->SetEstimated(false);
-        break;
-      }
-      mean_sq_reprojection_error += (projection - *feature).squaredNorm();
-      ++num_projections;
+  // Apply the removals and merge the statistics in block order.
+  int num_bad_reprojections = 0;
+  int num_insufficient_viewing_angles = 0;
+  int num_observations = 0;
+  double sum_reprojection_error = 0.0;
+  double sum_sq_reprojection_error = 0.0;
+  double max_reprojection_error = 0.0;
+  for (const OutlierTrackBlock& block : blocks) {
+    for (const TrackId track_id : block.bad_reprojection_tracks) {
+      reconstruction->MutableTrack(track_id)->SetEstimated(false);
     }
-
-    mean_sq_reprojection_error /= static_cast<double>(num_projections);
-    if (track->IsEstimated() &&
-        mean_sq_reprojection_error > max_sq_reprojection_error) {
-      ++num_bad_reprojections;
-      track->SetEstimated(false);
+    for (const TrackId track_id : block.insufficient_angle_tracks) {
+      reconstruction->MutableTrack(track_id)->SetEstimated(false);
     }
+    num_bad_reprojections += block.bad_reprojection_tracks.size();
+    num_insufficient_viewing_angles += block.insufficient_angle_tracks.size();
+
+    num_observations += block.num_observations;
+    sum_reprojection_error += block.sum_reprojection_error;
+    sum_sq_reprojection_error += block.sum_sq_reprojection_error;
+    max_reprojection_error =
+        std::max(max_reprojection_error, block.max_reprojection_error);
+  }
 
-    // The track will remain estimated if the reprojection errors were all
-    // good. We then test that the track is properly constrained by having at
-    // least two cameras view it with a sufficient viewing angle.
-    if (track->IsEstimated() &&
-        !SufficientTriangulationAngle(ray_directions,
-                                      min_triangulation_angle_degrees)) {
-      ++num_insufficient_viewing_angles;
-      track->SetEstimated(false);
+  if (statistics != nullptr) {
+    *statistics = ReprojectionErrorStatistics();
+    statistics->num_observations = num_observations;
+    statistics->max_reprojection_error = max_reprojection_error;
+    if (num_observations > 0) {
+      statistics->mean_reprojection_error =
+          sum_reprojection_error / num_observations;
+      statistics->rms_reprojection_error =
+          std::sqrt(sum_sq_reprojection_error / num_observations);
     }
   }
 
@@ -353,67 +484,114 @@ int RemoveOutlierFeatures(const std::unordered_set<TrackId>& track_ids,
   return num_bad_reprojections + num_insufficient_viewing_angles;
 }
 
-int SetUnderconstrainedTracksToUnestimated(Reconstruction* reconstruction) {
+int SetUnderconstrainedTracksToUnestimated(const int num_threads,
+                                           Reconstruction* reconstruction) {
   static const int kMinNumViews = 2;
-  int num_underconstrained_tracks = 0;
-  // Set all underconstrained tracks to be unestimated.
-  for (const TrackId track_id : reconstruction->TrackIds()) {
-    Track* track = CHECK_NOTNULL(reconstruction->MutableTrack(track_id));
-    if (!track->IsEstimated()) {
-      continue;
-    }
+  CHECK_GE(num_threads, 1);
+  CHECK_NOTNULL(reconstruction);
+
+  // Find all underconstrained tracks without modifying the reconstruction.
+  const std::vector<TrackId> track_ids = reconstruction->TrackIds();
+  const Reconstruction& const_reconstruction = *reconstruction;
+  const auto evaluate_block = [&](const int block_begin,
+                                  const int block_end,
+                                  std::vector<TrackId>* underconstrained) {
+    for (int i = block_begin; i < block_end; i++) {
+      const Track* track = const_reconstruction.Track(track_ids[i]);
+      if (!track->IsEstimated()) {
+        continue;
+      }
 
-    // Count the number of estimated views observing it.
-    int num_estimated_views = 0;
-    for (const ViewId view_id : track->ViewIds()) {
-      if (reconstruction->View(view_id)->IsEstimated()) {
-        ++num_estimated_views;
+      // Count the number of estimated views observing it.
+      int num_estimated_views = 0;
+      for (const ViewId view_id : track->ViewIds()) {
+        if (const_reconstruction.View(view_id)->IsEstimated()) {
+          ++num_estimated_views;
+        }
+        if (num_estimated_views >= kMinNumViews) {
+          break;
+        }
       }
-      if (num_estimated_views >= kMinNumViews) {
-        break;
+
+      if (num_estimated_views < kMinNumViews) {
+        underconstrained->emplace_back(track_ids[i]);
       }
     }
+  };
+  std::vector<std::vector<TrackId> > blocks;
+  EvaluateInBlocks(track_ids.size(), num_threads, evaluate_block, &blocks);
 
-    if (num_estimated_views < kMinNumViews) {
-      track->SetEstimated(false);
-      ++num_underconstrained_tracks;
+  // Set all underconstrained tracks to be unestimated.
+  int num_underconstrained_tracks = 0;
+  for (const std::vector<TrackId>& block : blocks) {
+    for (const TrackId track_id : block) {
+      reconstruction->MutableTrack(track_id)->SetEstimated(false);
     }
+    num_underconstrained_tracks += block.size();
   }
-
   return num_underconstrained_tracks;
 }
 
-int SetUnderconstrainedViewsToUnestimated(Reconstruction* reconstruction) {
-  // Set all underconstrained views to be unestimated.
+int SetUnderconstrainedViewsToUnestimated(const int num_threads,
+                                          Reconstruction* reconstruction) {
   static const int kMinNumTracks = 3;
-  int num_underconstrained_views = 0;
-  // Set all underconstrained views to be unestimated.
-  for (const ViewId view_id : reconstruction->ViewIds()) {
-    View* view = CHECK_NOTNULL(reconstruction->MutableView(view_id));
-    if (!view->IsEstimated()) {
-      continue;
-    }
+  CHECK_GE(num_threads, 1);
+  CHECK_NOTNULL(reconstruction);
+
+  // Find all underconstrained views without modifying the reconstruction.
+  const std::vector<ViewId> view_ids = reconstruction->ViewIds();
+  const Reconstruction& const_reconstruction = *reconstruction;
+  const auto evaluate_block = [&](const int block_begin,
+                                  const int block_end,
+                                  std::vector<ViewId>* underconstrained) {
+    for (int i = block_begin; i < block_end; i++) {
+      const View* view = const_reconstruction.View(view_ids[i]);
+      if (!view->IsEstimated()) {
+        continue;
+      }
 
-    // Count the number of estimated views observing it.
-    int num_estimated_tracks = 0;
-    for (const TrackId track_id : view->TrackIds()) {
-      if (reconstruction->Track(track_id)->IsEstimated()) {
-        ++num_estimated_tracks;
+      // Count the number of estimated tracks observed by it.
+      int num_estimated_tracks = 0;
+      for (const TrackId track_id : view->TrackIds()) {
+        if (const_reconstruction.Track(track_id)->IsEstimated()) {
+          ++num_estimated_tracks;
+        }
+        if (num_estimated_tracks >= kMinNumTracks) {
+          break;
+        }
       }
-      if (num_estimated_tracks >= kMinNumTracks) {
-        break;
+
+      if (num_estimated_tracks < kMinNumTracks) {
+        underconstrained->emplace_back(view_ids[i]);
       }
     }
+  };
+  std::vector<std::vector<ViewId> > blocks;
+  EvaluateInBlocks(view_ids.size(), num_threads, evaluate_block, &blocks);
 
-    if (num_estimated_tracks < kMinNumTracks) {
-      view->SetEstimated(false);
-      ++num_underconstrained_views;
+  // Set all underconstrained views to be unestimated.
+  int num_underconstrained_views = 0;
+  for (const std::vector<ViewId>& block : blocks) {
+    for (const ViewId view_id : block) {
+      reconstruction->MutableView(view_id)->SetEstimated(false);
     }
+    num_underconstrained_views += block.size();
   }
-
   return num_underconstrained_views;
 }
 
+void SetUnderconstrainedAsUnestimated(const int num_threads,
+                                      Reconstruction* reconstruction) {
+  int num_underconstrained_views = -1;
+  int num_underconstrained_tracks = -1;
+  while (num_underconstrained_views != 0 && num_underconstrained_tracks != 0) {
+    num_underconstrained_views =
+        SetUnderconstrainedViewsToUnestimated(num_threads, reconstruction);
+    num_underconstrained_tracks =
+        SetUnderconstrainedTracksToUnestimated(num_threads, reconstruction);
+  }
+}
+
 int NumEstimatedViews(const Reconstruction& reconstruction) {
   int num_estimated_views = 0;
   for (const ViewId view_id : reconstruction.ViewIds()) {
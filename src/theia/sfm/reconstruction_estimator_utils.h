@@ -37,6 +37,8 @@
 
 #include <Eigen/Core>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "theia/solvers/sample_consensus_estimator.h"
 #include "theia/sfm/bundle_adjustment/bundle_adjustment.h"
@@ -90,26 +92,61 @@ void RefineRelativeTranslationsWithKnownRotations(
     const int num_threads,
     ViewGraph* view_graph);
 
+// Statistics of the reprojection errors of all estimated observations checked
+// by RemoveOutlierFeatures. The statistics are computed before any outliers
+// are removed so that they describe the reconstruction as it was after e.g.
+// bundle adjustment. Observations behind the camera are not included.
+struct ReprojectionErrorStatistics {
+  int num_observations = 0;
+  double mean_reprojection_error = 0.0;
+  double rms_reprojection_error = 0.0;
+  double max_reprojection_error = 0.0;
+};
+
 // Removes features that have a reprojection error larger than the
 // reprojection error threshold. Additionally, any features that are poorly
 // constrained because of a small viewing angle are removed. Returns the number
 // of features removed. Only the input tracks are checked.
+//
+// The tracks are checked in parallel with num_threads threads and the outliers
+// are then removed in a single pass, so the result does not depend on the
+// number of threads. If statistics is not NULL, the reprojection error
+// statistics of the checked tracks are computed in the same pass.
 int RemoveOutlierFeatures(const std::unordered_set<TrackId>& tracks,
                           const double max_inlier_reprojection_error,
                           const double min_triangulation_angle_degrees,
-                          Reconstruction* reconstruction);
+                          const int num_threads,
+                          Reconstruction* reconstruction,
+                          ReprojectionErrorStatistics* statistics);
+int RemoveOutlierFeatures(const std::vector<TrackId>& tracks,
+                          const double max_inlier_reprojection_error,
+                          const double min_triangulation_angle_degrees,
+                          const int num_threads,
+                          Reconstruction* reconstruction,
+                          ReprojectionErrorStatistics* statistics);
 // Same as above, but checks all tracks.
 int RemoveOutlierFeatures(const double max_inlier_reprojection_error,
                           const double min_triangulation_angle_degrees,
-                          Reconstruction* reconstruction);
+                          const int num_threads,
+                          Reconstruction* reconstruction,
+                          ReprojectionErrorStatistics* statistics);
 
 // Sets all tracks that are not seen by enough estimated views to unestimated.
-// Returns the number of tracks set to unestimated.
-int SetUnderconstrainedTracksToUnestimated(Reconstruction* reconstruction);
+// Returns the number of tracks set to unestimated. The tracks are checked in
+// parallel and then set to unestimated in a single pass.
+int SetUnderconstrainedTracksToUnestimated(const int num_threads,
+                                           Reconstruction* reconstruction);
 
 // Sets all vies that are not seen by enough estimated tracks to unestimated.
-// Returns the number of views set to unestimated.
-int SetUnderconstrainedViewsToUnestimated(Reconstruction* reconstruction);
+// Returns the number of views set to unestimated. The views are checked in
+// parallel and then set to unestimated in a single pass.
+int SetUnderconstrainedViewsToUnestimated(const int num_threads,
+                                          Reconstruction* reconstruction);
+
+// Alternates between the two methods above until no more views or tracks are
+// set to unestimated.
+void SetUnderconstrainedAsUnestimated(const int num_threads,
+                                      Reconstruction* reconstruction);
 
 // Return the number of estimated views or tracks in the reconstruction.
 int NumEstimatedViews(const Reconstruction& reconstruction);
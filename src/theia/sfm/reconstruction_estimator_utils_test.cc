@@ -0,0 +1,230 @@
+// Copyright (C) 2015 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include <Eigen/Core>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "theia/sfm/camera/camera.h"
+#include "theia/sfm/reconstruction.h"
+#include "theia/sfm/reconstruction_estimator_utils.h"
+#include "theia/sfm/track.h"
+#include "theia/sfm/types.h"
+#include "theia/sfm/view.h"
+#include "theia/util/stringprintf.h"
+
+namespace theia {
+
+namespace {
+
+static const double kMaxReprojectionError = 4.0;
+static const double kMinTriangulationAngleDegrees = 1.0;
+
+// Creates a reconstruction with estimated views placed along the x-axis that
+// observe estimated points in front of them. Every 10th point is moved so
+// that it has a large reprojection error and every 25th point is placed behind
+// the cameras.
+void SetupReconstruction(const int num_views,
+                         const int num_tracks,
+                         Reconstruction* reconstruction) {
+  srand(1234);
+  for (int i = 0; i < num_views; i++) {
+    const ViewId view_id = reconstruction->AddView(StringPrintf("%d", i));
+    View* view = reconstruction->MutableView(view_id);
+    Camera* camera = view->MutableCamera();
+    camera->SetPosition(Eigen::Vector3d(i, 0, 0));
+    camera->SetFocalLength(800);
+    camera->SetPrincipalPoint(500.0, 500.0);
+    view->SetEstimated(true);
+  }
+
+  for (int i = 0; i < num_tracks; i++) {
+    Eigen::Vector4d point = Eigen::Vector4d::Random();
+    point[2] += 10.0;
+    point[3] = 1.0;
+
+    std::vector<std::pair<ViewId, Feature> > features;
+    for (const ViewId view_id : reconstruction->ViewIds()) {
+      Feature feature;
+      reconstruction->View(view_id)->Camera().ProjectPoint(point, &feature);
+      features.emplace_back(view_id, feature);
+    }
+    const TrackId track_id = reconstruction->AddTrack(features);
+
+    if (i % 25 == 0) {
+      point[2] = -point[2];
+    } else if (i % 10 == 0) {
+      point[1] += 0.5;
+    }
+    Track* track = reconstruction->MutableTrack(track_id);
+    *track->MutablePoint() = point;
+    track->SetEstimated(true);
+  }
+}
+
+std::unordered_set<TrackId> EstimatedTracks(
+    const Reconstruction& reconstruction) {
+  std::unordered_set<TrackId> estimated_tracks;
+  for (const TrackId track_id : reconstruction.TrackIds()) {
+    if (reconstruction.Track(track_id)->IsEstimated()) {
+      estimated_tracks.insert(track_id);
+    }
+  }
+  return estimated_tracks;
+}
+
+}  // namespace
+
+TEST(ReconstructionEstimatorUtils, RemoveOutlierFeatures) {
+  static const int kNumViews = 4;
+  static const int kNumTracks = 5000;
+
+  Reconstruction reconstruction;
+  SetupReconstruction(kNumViews, kNumTracks, &reconstruction);
+
+  ReprojectionErrorStatistics statistics;
+  const int num_removed = RemoveOutlierFeatures(kMaxReprojectionError,
+                                                kMinTriangulationAngleDegrees,
+                                                1,
+                                                &reconstruction,
+                                                &statistics);
+  // Every 10th and every 25th track is an outlier.
+  const int num_outliers = kNumTracks / 10 + kNumTracks / 25 - kNumTracks / 50;
+  EXPECT_EQ(num_removed, num_outliers);
+  for (const TrackId track_id : reconstruction.TrackIds()) {
+    const bool is_outlier = track_id % 10 == 0 || track_id % 25 == 0;
+    EXPECT_EQ(reconstruction.Track(track_id)->IsEstimated(), !is_outlier);
+  }
+
+  // The statistics are computed before the outliers are removed and do not
+  // include the observations behind the cameras.
+  EXPECT_EQ(statistics.num_observations,
+            kNumViews * (kNumTracks - kNumTracks / 25));
+  EXPECT_GT(statistics.max_reprojection_error, kMaxReprojectionError);
+  EXPECT_GT(statistics.mean_reprojection_error, 0.0);
+  EXPECT_GE(statistics.rms_reprojection_error,
+            statistics.mean_reprojection_error);
+
+  // Removing the outliers again should not remove anything else.
+  EXPECT_EQ(RemoveOutlierFeatures(kMaxReprojectionError,
+                                  kMinTriangulationAngleDegrees,
+                                  1,
+                                  &reconstruction,
+                                  &statistics),
+            0);
+  EXPECT_LT(statistics.max_reprojection_error, 1e-6);
+}
+
+TEST(ReconstructionEstimatorUtils, RemoveOutlierFeaturesIsThreadIndependent) {
+  static const int kNumViews = 3;
+  static const int kNumTracks = 5000;
+
+  Reconstruction single_threaded_reconstruction;
+  SetupReconstruction(kNumViews, kNumTracks, &single_threaded_reconstruction);
+  Reconstruction multi_threaded_reconstruction;
+  SetupReconstruction(kNumViews, kNumTracks, &multi_threaded_reconstruction);
+
+  // Only check a subset of the tracks.
+  std::unordered_set<TrackId> tracks_to_check;
+  for (int i = 0; i < kNumTracks; i += 3) {
+    tracks_to_check.insert(i);
+  }
+
+  ReprojectionErrorStatistics single_threaded_statistics;
+  ReprojectionErrorStatistics multi_threaded_statistics;
+  EXPECT_EQ(RemoveOutlierFeatures(tracks_to_check,
+                                  kMaxReprojectionError,
+                                  kMinTriangulationAngleDegrees,
+                                  1,
+                                  &single_threaded_reconstruction,
+                                  &single_threaded_statistics),
+            RemoveOutlierFeatures(tracks_to_check,
+                                  kMaxReprojectionError,
+                                  kMinTriangulationAngleDegrees,
+                                  4,
+                                  &multi_threaded_reconstruction,
+                                  &multi_threaded_statistics));
+  EXPECT_EQ(EstimatedTracks(single_threaded_reconstruction),
+            EstimatedTracks(multi_threaded_reconstruction));
+  EXPECT_EQ(single_threaded_statistics.num_observations,
+            multi_threaded_statistics.num_observations);
+  EXPECT_EQ(single_threaded_statistics.mean_reprojection_error,
+            multi_threaded_statistics.mean_reprojection_error);
+  EXPECT_EQ(single_threaded_statistics.max_reprojection_error,
+            multi_threaded_statistics.max_reprojection_error);
+}
+
+TEST(ReconstructionEstimatorUtils, SetUnderconstrainedToUnestimated) {
+  static const int kNumViews = 4;
+  static const int kNumWellConstrainedTracks = 10;
+
+  Reconstruction reconstruction;
+  for (int i = 0; i < kNumViews; i++) {
+    const ViewId view_id = reconstruction.AddView(StringPrintf("%d", i));
+    reconstruction.MutableView(view_id)->SetEstimated(true);
+  }
+
+  // Views 0 and 1 observe many tracks, while views 2 and 3 only observe two
+  // and one tracks respectively.
+  const Feature feature(0, 0);
+  for (int i = 0; i < kNumWellConstrainedTracks; i++) {
+    reconstruction.AddTrack({{0, feature}, {1, feature}});
+  }
+  const TrackId track1 = reconstruction.AddTrack({{1, feature}, {2, feature}});
+  const TrackId track2 = reconstruction.AddTrack({{2, feature}, {3, feature}});
+  for (const TrackId track_id : reconstruction.TrackIds()) {
+    reconstruction.MutableTrack(track_id)->SetEstimated(true);
+  }
+
+  EXPECT_EQ(SetUnderconstrainedViewsToUnestimated(4, &reconstruction), 2);
+  EXPECT_TRUE(reconstruction.View(0)->IsEstimated());
+  EXPECT_TRUE(reconstruction.View(1)->IsEstimated());
+  EXPECT_FALSE(reconstruction.View(2)->IsEstimated());
+  EXPECT_FALSE(reconstruction.View(3)->IsEstimated());
+
+  // The tracks observed by views 2 and 3 are no longer seen by two estimated
+  // views.
+  EXPECT_EQ(SetUnderconstrainedTracksToUnestimated(4, &reconstruction), 2);
+  EXPECT_FALSE(reconstruction.Track(track1)->IsEstimated());
+  EXPECT_FALSE(reconstruction.Track(track2)->IsEstimated());
+  EXPECT_EQ(EstimatedTracks(reconstruction).size(), kNumWellConstrainedTracks);
+
+  // Nothing else is underconstrained.
+  EXPECT_EQ(SetUnderconstrainedViewsToUnestimated(1, &reconstruction), 0);
+  EXPECT_EQ(SetUnderconstrainedTracksToUnestimated(1, &reconstruction), 0);
+}
+
+}  // namespace theia
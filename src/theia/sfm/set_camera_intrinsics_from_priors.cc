@@ -44,21 +44,8 @@
 
 namespace theia {
 
-void SetViewCameraIntrinsicsFromPriors(View* view) {
-  Camera* camera = view->MutableCamera();
-  const CameraIntrinsicsPrior prior = view->CameraIntrinsicsPrior();
-
-  // Set the image dimensions.
-  camera->SetImageSize(prior.image_width, prior.image_height);
-
-  // Set the focal length.
-  if (prior.focal_length.is_set) {
-    camera->SetFocalLength(prior.focal_length.value);
-  } else {
-    camera->SetFocalLength(1.2 * static_cast<double>(std::max(
-        prior.image_width, prior.image_height)));
-  }
-
+void SetCameraIntrinsicsFromPriors(const CameraIntrinsicsPrior& prior,
+                                   Camera* camera) {
   // Set the principal point.
   if (prior.principal_point[0].is_set && prior.principal_point[1].is_set) {
     camera->SetPrincipalPoint(prior.principal_point[0].value,
@@ -77,6 +64,24 @@ void SetViewCameraIntrinsicsFromPriors(View* view) {
   if (prior.skew.is_set) {
     camera->SetSkew(prior.skew.value);
   }
+}
+
+void SetViewCameraIntrinsicsFromPriors(View* view) {
+  Camera* camera = view->MutableCamera();
+  const CameraIntrinsicsPrior prior = view->CameraIntrinsicsPrior();
+
+  // Set the image dimensions.
+  camera->SetImageSize(prior.image_width, prior.image_height);
+
+  // Set the focal length.
+  if (prior.focal_length.is_set) {
+    camera->SetFocalLength(prior.focal_length.value);
+  } else {
+    camera->SetFocalLength(1.2 * static_cast<double>(std::max(
+        prior.image_width, prior.image_height)));
+  }
+
+  SetCameraIntrinsicsFromPriors(prior, camera);
 
   // Set radial distortion if available.
   if (prior.radial_distortion[0].is_set &&
@@ -37,9 +37,18 @@
 
 namespace theia {
 
+class Camera;
+struct CameraIntrinsicsPrior;
 class Reconstruction;
 class View;
 
+// Sets the principal point, aspect ratio, and skew of the camera from the
+// prior. The principal point is initialized as the center of the image if the
+// prior does not provide it. The focal length and radial distortion are left
+// unchanged.
+void SetCameraIntrinsicsFromPriors(const CameraIntrinsicsPrior& prior,
+                                   Camera* camera);
+
 // Sets the camera intrinsics from the CameraIntrinsicsPrior of a view. If the
 // view does not have a focal length prior will set a value corresponding to a
 // median viewing angle. Principal points that are not provided by the priors
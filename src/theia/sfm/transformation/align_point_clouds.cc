@@ -39,35 +39,35 @@
 
 namespace theia {
 
-void AlignPointCloudsUmeyama(const std::vector<Eigen::Vector3d>& left,
-                             const std::vector<Eigen::Vector3d>& right,
-                             Eigen::Matrix3d* rotation,
-                             Eigen::Vector3d* translation,
-                             double* scale) {
-  CHECK_EQ(left.size(), right.size());
-  CHECK_NOTNULL(rotation);
-  CHECK_NOTNULL(translation);
-  CHECK_NOTNULL(scale);
+namespace {
 
-  const int num_points = left.size();
-  Eigen::Map<const Eigen::Matrix<double, 3, Eigen::Dynamic> > left_points(
-      left[0].data(), 3, num_points);
-  Eigen::Map<const Eigen::Matrix<double, 3, Eigen::Dynamic> > right_points(
-      right[0].data(), 3, num_points);
+// Triplets whose points span a triangle with a smaller angle than this (in
+// radians) are considered collinear.
+static const double kMinTripletAngle = 1e-6;
 
+// Computes the similarity transformation between the points, which are the
+// columns of the matrices. The matrices may be fixed-size or maps of dynamic
+// size.
+template <typename LeftPoints, typename RightPoints>
+void AlignPoints(const Eigen::MatrixBase<LeftPoints>& left_points,
+                 const Eigen::MatrixBase<RightPoints>& right_points,
+                 Eigen::Matrix3d* rotation,
+                 Eigen::Vector3d* translation,
+                 double* scale) {
+  const int num_points = left_points.cols();
   Eigen::Vector3d left_centroid, right_centroid;
   left_centroid.setZero();
   right_centroid.setZero();
-  for (int i = 0; i < left.size(); i++) {
-    left_centroid += left[i];
-    right_centroid += right[i];
+  for (int i = 0; i < num_points; i++) {
+    left_centroid += left_points.col(i);
+    right_centroid += right_points.col(i);
   }
   left_centroid /= static_cast<double>(num_points);
   right_centroid /= static_cast<double>(num_points);
 
   double sigma = 0;
-  for (int i = 0; i < left.size(); i++) {
-    sigma += (left[i] - left_centroid).squaredNorm();
+  for (int i = 0; i < num_points; i++) {
+    sigma += (left_points.col(i) - left_centroid).squaredNorm();
   }
   sigma /= static_cast<double>(num_points);
 
@@ -99,4 +99,47 @@ void AlignPointCloudsUmeyama(const std::vector<Eigen::Vector3d>& left,
   *translation = right_centroid - (*scale) * (*rotation) * left_centroid;
 }
 
+bool IsCollinear(const Eigen::Matrix3d& points) {
+  const Eigen::Vector3d edge1 = points.col(1) - points.col(0);
+  const Eigen::Vector3d edge2 = points.col(2) - points.col(0);
+  return edge1.cross(edge2).norm() <=
+         kMinTripletAngle * edge1.norm() * edge2.norm();
+}
+
+}  // namespace
+
+void AlignPointCloudsUmeyama(const std::vector<Eigen::Vector3d>& left,
+                             const std::vector<Eigen::Vector3d>& right,
+                             Eigen::Matrix3d* rotation,
+                             Eigen::Vector3d* translation,
+                             double* scale) {
+  CHECK_EQ(left.size(), right.size());
+  CHECK_NOTNULL(rotation);
+  CHECK_NOTNULL(translation);
+  CHECK_NOTNULL(scale);
+
+  const int num_points = left.size();
+  Eigen::Map<const Eigen::Matrix<double, 3, Eigen::Dynamic> > left_points(
+      left[0].data(), 3, num_points);
+  Eigen::Map<const Eigen::Matrix<double, 3, Eigen::Dynamic> > right_points(
+      right[0].data(), 3, num_points);
+  AlignPoints(left_points, right_points, rotation, translation, scale);
+}
+
+bool AlignPointTripletsUmeyama(const Eigen::Matrix3d& left,
+                               const Eigen::Matrix3d& right,
+                               Eigen::Matrix3d* rotation,
+                               Eigen::Vector3d* translation,
+                               double* scale) {
+  CHECK_NOTNULL(rotation);
+  CHECK_NOTNULL(translation);
+  CHECK_NOTNULL(scale);
+  if (IsCollinear(left) || IsCollinear(right)) {
+    return false;
+  }
+
+  AlignPoints(left, right, rotation, translation, scale);
+  return true;
+}
+
 }  // namespace theia
@@ -54,6 +54,17 @@ void AlignPointCloudsUmeyama(const std::vector<Eigen::Vector3d>& left,
                              Eigen::Vector3d* translation,
                              double* scale);
 
+// Same as above for exactly three correspondences, the minimal case of the
+// similarity transformation. The columns of the matrices are the points. This
+// does not allocate memory, so it is meant for the minimal samples of robust
+// estimators. Returns false if either triplet is (nearly) collinear, in which
+// case the rotation about the line of the points is not defined.
+bool AlignPointTripletsUmeyama(const Eigen::Matrix3d& left,
+                               const Eigen::Matrix3d& right,
+                               Eigen::Matrix3d* rotation,
+                               Eigen::Vector3d* translation,
+                               double* scale);
+
 }  // namespace theia
 
 #endif  // THEIA_SFM_TRANSFORMATION_ALIGN_POINT_CLOUDS_H_
@@ -97,4 +97,42 @@ TEST(AlignPointCloudsUmeyama, SimpleTest) {
   UmeyamaSimpleTest();
 }
 
+TEST(AlignPointTripletsUmeyama, MinimalSample) {
+  Matrix3d left;
+  left.col(0) = Vector3d(0.4, -3.105, 2.147);
+  left.col(1) = Vector3d(1.293, 7.1982, -.068);
+  left.col(2) = Vector3d(-5.34, 0.708, -3.69);
+
+  const Matrix3d rotation_mat =
+      Eigen::AngleAxisd(DegToRad(73.0), Vector3d(0.3, 1.0, -0.4).normalized())
+          .toRotationMatrix();
+  const Vector3d translation_vec(-1.0, 0.5, 3.0);
+  const double expected_scale = 0.7;
+  const Matrix3d right =
+      (expected_scale * rotation_mat * left).colwise() + translation_vec;
+
+  Matrix3d rotation;
+  Vector3d translation;
+  double scale;
+  ASSERT_TRUE(
+      AlignPointTripletsUmeyama(left, right, &rotation, &translation, &scale));
+  EXPECT_LT((rotation - rotation_mat).norm(), kEpsilon);
+  EXPECT_LT((translation - translation_vec).norm(), kEpsilon);
+  EXPECT_LT(std::abs(scale - expected_scale), kEpsilon);
+}
+
+TEST(AlignPointTripletsUmeyama, CollinearPoints) {
+  Matrix3d left;
+  left.col(0) = Vector3d(0.0, 0.0, 0.0);
+  left.col(1) = Vector3d(1.0, 2.0, 3.0);
+  left.col(2) = Vector3d(2.0, 4.0, 6.0);
+  const Matrix3d right = left.colwise() + Vector3d(1.0, 0.0, 0.0);
+
+  Matrix3d rotation;
+  Vector3d translation;
+  double scale;
+  EXPECT_FALSE(
+      AlignPointTripletsUmeyama(left, right, &rotation, &translation, &scale));
+}
+
 }  // namespace theia
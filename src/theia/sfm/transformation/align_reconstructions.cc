@@ -36,61 +36,297 @@
 
 #include <Eigen/Core>
 #include <glog/logging.h>
+#include <algorithm>
+#include <cmath>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "theia/sfm/find_common_views_by_name.h"
 #include "theia/sfm/reconstruction.h"
 #include "theia/sfm/similarity_transformation.h"
+#include "theia/sfm/track.h"
 #include "theia/sfm/transformation/align_point_clouds.h"
 #include "theia/sfm/transformation/transform_reconstruction.h"
 #include "theia/sfm/types.h"
-#include "theia/solvers/ransac.h"
-#include "theia/solvers/sample_consensus_estimator.h"
+#include "theia/sfm/view.h"
+#include "theia/util/hash.h"
+#include "theia/util/map_util.h"
+#include "theia/util/random.h"
+#include "theia/util/threadpool.h"
 
 namespace theia {
 namespace {
 
-struct CameraCorrespondence {
-  Eigen::Vector3d camera1;
-  Eigen::Vector3d camera2;
+// The number of attempts to draw a non-degenerate minimal sample for each
+// hypothesis.
+static const int kMaxNumSamplingAttemptsPerHypothesis = 3;
+
+// Corresponding positions of the two reconstructions. The coordinates are
+// stored as separate arrays so that the hypotheses are scored with contiguous
+// loads.
+struct PositionCorrespondences {
+  int size() const { return x1.size(); }
+
+  void Add(const Eigen::Vector3d& position1, const Eigen::Vector3d& position2) {
+    x1.emplace_back(position1.x());
+    y1.emplace_back(position1.y());
+    z1.emplace_back(position1.z());
+    x2.emplace_back(position2.x());
+    y2.emplace_back(position2.y());
+    z2.emplace_back(position2.z());
+  }
+
+  Eigen::Vector3d Position1(const int i) const {
+    return Eigen::Vector3d(x1[i], y1[i], z1[i]);
+  }
+
+  Eigen::Vector3d Position2(const int i) const {
+    return Eigen::Vector3d(x2[i], y2[i], z2[i]);
+  }
+
+  std::vector<double> x1, y1, z1;
+  std::vector<double> x2, y2, z2;
+};
+
+// A similarity transformation from reconstruction2 to reconstruction1, stored
+// as the scaled rotation so that a position is transformed with 12 flops.
+struct AlignmentHypothesis {
+  Eigen::Matrix3d scaled_rotation;
+  Eigen::Vector3d translation;
+  double cost = 0.0;
 };
 
-class CameraAlignmentEstimator
-    : public Estimator<CameraCorrespondence, SimilarityTransformation> {
- public:
-  CameraAlignmentEstimator() {}
-
-  double SampleSize() const { return 4; }
-
-  bool EstimateModel(
-      const std::vector<CameraCorrespondence>& correspondences,
-      std::vector<SimilarityTransformation>* sim_transforms) const {
-    SimilarityTransformation sim_transform;
-    std::vector<Eigen::Vector3d> positions1(correspondences.size());
-    std::vector<Eigen::Vector3d> positions2(correspondences.size());
-    for (int i = 0; i < correspondences.size(); i++) {
-      positions1[i] = correspondences[i].camera1;
-      positions2[i] = correspondences[i].camera2;
+// Returns the positions of the estimated views that both reconstructions
+// share.
+void GetCommonCameraPositions(const Reconstruction& reconstruction1,
+                              const Reconstruction& reconstruction2,
+                              PositionCorrespondences* correspondences) {
+  const std::vector<std::string> common_view_names =
+      FindCommonViewsByName(reconstruction1, reconstruction2);
+  for (const std::string& view_name : common_view_names) {
+    const View* view1 =
+        reconstruction1.View(reconstruction1.ViewIdFromName(view_name));
+    const View* view2 =
+        reconstruction2.View(reconstruction2.ViewIdFromName(view_name));
+    if (view1->IsEstimated() && view2->IsEstimated()) {
+      correspondences->Add(view1->Camera().GetPosition(),
+                           view2->Camera().GetPosition());
+    }
+  }
+}
+
+// Returns the points of the estimated tracks that both reconstructions share.
+// Two tracks are the same if they observe the same feature in a common view.
+void GetCommonTrackPoints(const Reconstruction& reconstruction1,
+                          const Reconstruction& reconstruction2,
+                          PositionCorrespondences* correspondences) {
+  std::unordered_map<TrackId, TrackId> common_tracks;
+  const std::vector<std::string> common_view_names =
+      FindCommonViewsByName(reconstruction1, reconstruction2);
+  for (const std::string& view_name : common_view_names) {
+    const View* view1 =
+        reconstruction1.View(reconstruction1.ViewIdFromName(view_name));
+    const View* view2 =
+        reconstruction2.View(reconstruction2.ViewIdFromName(view_name));
+
+    // Features that are observed by more than one track are ambiguous and
+    // are not used.
+    std::unordered_map<std::pair<double, double>, TrackId> tracks_by_feature;
+    for (const TrackId track_id : view1->TrackIds()) {
+      if (!reconstruction1.Track(track_id)->IsEstimated()) {
+        continue;
+      }
+      const Feature& feature = *view1->GetFeature(track_id);
+      const auto inserted = tracks_by_feature.emplace(
+          std::make_pair(feature.x(), feature.y()), track_id);
+      if (!inserted.second) {
+        inserted.first->second = kInvalidTrackId;
+      }
     }
 
-    AlignPointCloudsUmeyama(positions2,
-                            positions1,
-                            &sim_transform.rotation,
-                            &sim_transform.translation,
-                            &sim_transform.scale);
-    sim_transforms->emplace_back(sim_transform);
-    return true;
+    for (const TrackId track_id2 : view2->TrackIds()) {
+      if (!reconstruction2.Track(track_id2)->IsEstimated()) {
+        continue;
+      }
+      const Feature& feature = *view2->GetFeature(track_id2);
+      const TrackId* track_id1 = FindOrNull(
+          tracks_by_feature, std::make_pair(feature.x(), feature.y()));
+      if (track_id1 != nullptr && *track_id1 != kInvalidTrackId) {
+        common_tracks.emplace(track_id2, *track_id1);
+      }
+    }
   }
 
-  double Error(const CameraCorrespondence& cameras,
-               const SimilarityTransformation& sim_transform) const {
-    const Eigen::Vector3d transformed_camera =
-        sim_transform.scale * sim_transform.rotation * cameras.camera2 +
-        sim_transform.translation;
-    return (cameras.camera1 - transformed_camera).squaredNorm();
+  for (const auto& common_track : common_tracks) {
+    correspondences->Add(
+        reconstruction1.Track(common_track.second)->Point().hnormalized(),
+        reconstruction2.Track(common_track.first)->Point().hnormalized());
   }
-};
+}
+
+// Estimates the transformation from the three correspondences with the closed
+// form solver. Returns false if the sample is degenerate.
+bool EstimateHypothesis(const PositionCorrespondences& correspondences,
+                        const int sample[3],
+                        AlignmentHypothesis* hypothesis) {
+  Eigen::Matrix3d positions1, positions2;
+  for (int i = 0; i < 3; i++) {
+    positions1.col(i) = correspondences.Position1(sample[i]);
+    positions2.col(i) = correspondences.Position2(sample[i]);
+  }
+
+  Eigen::Matrix3d rotation;
+  double scale;
+  if (!AlignPointTripletsUmeyama(positions2,
+                                 positions1,
+                                 &rotation,
+                                 &hypothesis->translation,
+                                 &scale)) {
+    return false;
+  }
+  hypothesis->scaled_rotation = scale * rotation;
+  hypothesis->cost = 0.0;
+  return true;
+}
+
+// Adds the truncated squared errors of the correspondences in [begin, end) to
+// the cost of the hypothesis.
+void ScoreHypothesis(const PositionCorrespondences& correspondences,
+                     const int begin,
+                     const int end,
+                     const double squared_threshold,
+                     AlignmentHypothesis* hypothesis) {
+  const Eigen::Matrix3d& r = hypothesis->scaled_rotation;
+  const Eigen::Vector3d& t = hypothesis->translation;
+  const double* x1 = correspondences.x1.data();
+  const double* y1 = correspondences.y1.data();
+  const double* z1 = correspondences.z1.data();
+  const double* x2 = correspondences.x2.data();
+  const double* y2 = correspondences.y2.data();
+  const double* z2 = correspondences.z2.data();
+  double cost = 0.0;
+  for (int i = begin; i < end; i++) {
+    const double dx =
+        r(0, 0) * x2[i] + r(0, 1) * y2[i] + r(0, 2) * z2[i] + t[0] - x1[i];
+    const double dy =
+        r(1, 0) * x2[i] + r(1, 1) * y2[i] + r(1, 2) * z2[i] + t[1] - y1[i];
+    const double dz =
+        r(2, 0) * x2[i] + r(2, 1) * y2[i] + r(2, 2) * z2[i] + t[2] - z1[i];
+    cost += std::min(dx * dx + dy * dy + dz * dz, squared_threshold);
+  }
+  hypothesis->cost += cost;
+}
+
+// Returns the correspondences that the transformation aligns within the
+// threshold.
+void FindInliers(const PositionCorrespondences& correspondences,
+                 const Eigen::Matrix3d& scaled_rotation,
+                 const Eigen::Vector3d& translation,
+                 const double squared_threshold,
+                 std::vector<int>* inliers) {
+  inliers->clear();
+  for (int i = 0; i < correspondences.size(); i++) {
+    const Eigen::Vector3d error = scaled_rotation *
+                                      correspondences.Position2(i) +
+                                  translation - correspondences.Position1(i);
+    if (error.squaredNorm() < squared_threshold) {
+      inliers->emplace_back(i);
+    }
+  }
+}
+
+// Estimates the transformation between the camera positions with preemptive
+// RANSAC. Returns false if no non-degenerate sample could be drawn.
+bool EstimateAlignmentPreemptively(const AlignReconstructionsOptions& options,
+                                   const PositionCorrespondences& cameras,
+                                   RandomNumberGenerator* rng,
+                                   AlignmentHypothesis* best_hypothesis) {
+  const int num_cameras = cameras.size();
+  const double squared_threshold =
+      options.robust_error_threshold * options.robust_error_threshold;
+
+  // Preemptive scoring visits the correspondences in a random order.
+  std::vector<int> order(num_cameras);
+  for (int i = 0; i < num_cameras; i++) {
+    order[i] = i;
+  }
+  std::shuffle(order.begin(), order.end(), *rng);
+  PositionCorrespondences shuffled_cameras;
+  for (const int i : order) {
+    shuffled_cameras.Add(cameras.Position1(i), cameras.Position2(i));
+  }
+
+  std::vector<AlignmentHypothesis> hypotheses;
+  hypotheses.reserve(options.num_hypotheses);
+  const int max_num_samples =
+      kMaxNumSamplingAttemptsPerHypothesis * options.num_hypotheses;
+  for (int i = 0;
+       i < max_num_samples && hypotheses.size() < options.num_hypotheses;
+       i++) {
+    int sample[3];
+    sample[0] = rng->RandInt(0, num_cameras - 1);
+    do {
+      sample[1] = rng->RandInt(0, num_cameras - 1);
+    } while (sample[1] == sample[0]);
+    do {
+      sample[2] = rng->RandInt(0, num_cameras - 1);
+    } while (sample[2] == sample[0] || sample[2] == sample[1]);
+
+    AlignmentHypothesis hypothesis;
+    if (EstimateHypothesis(shuffled_cameras, sample, &hypothesis)) {
+      hypotheses.emplace_back(hypothesis);
+    }
+  }
+  if (hypotheses.empty()) {
+    return false;
+  }
+
+  // Score the hypotheses block by block and keep the better half after each
+  // block.
+  const auto has_lower_cost = [](const AlignmentHypothesis& hypothesis1,
+                                 const AlignmentHypothesis& hypothesis2) {
+    return hypothesis1.cost < hypothesis2.cost;
+  };
+  const int block_size = options.preemption_block_size;
+  for (int begin = 0; begin < num_cameras; begin += block_size) {
+    const int end = std::min(begin + block_size, num_cameras);
+    for (AlignmentHypothesis& hypothesis : hypotheses) {
+      ScoreHypothesis(shuffled_cameras,
+                      begin,
+                      end,
+                      squared_threshold,
+                      &hypothesis);
+    }
+    if (hypotheses.size() == 1) {
+      continue;
+    }
+
+    const int num_remaining_hypotheses = hypotheses.size() / 2;
+    std::nth_element(hypotheses.begin(),
+                     hypotheses.begin() + num_remaining_hypotheses - 1,
+                     hypotheses.end(),
+                     has_lower_cost);
+    hypotheses.resize(num_remaining_hypotheses);
+  }
+
+  *best_hypothesis = *std::min_element(hypotheses.begin(), hypotheses.end(),
+                                       has_lower_cost);
+  return true;
+}
+
+// Collects the inlier positions of the correspondences.
+void AddInlierPositions(const PositionCorrespondences& correspondences,
+                        const std::vector<int>& inliers,
+                        std::vector<Eigen::Vector3d>* positions1,
+                        std::vector<Eigen::Vector3d>* positions2) {
+  for (const int i : inliers) {
+    positions1->emplace_back(correspondences.Position1(i));
+    positions2->emplace_back(correspondences.Position2(i));
+  }
+}
 
 }  // namespace
 
@@ -133,63 +369,151 @@ void AlignReconstructionsRobust(
     const double robust_error_threshold,
     const Reconstruction& reconstruction1,
     Reconstruction* reconstruction2) {
+  // Keep the behavior of this method: the transformation is estimated once
+  // from the inlier cameras, without track points.
+  AlignReconstructionsOptions options;
+  options.robust_error_threshold = robust_error_threshold;
+  options.refine_with_tracks = false;
+  options.max_num_refinement_iterations = 1;
+  AlignReconstructionsSummary summary;
+  CHECK(AlignReconstructionsRobust(options,
+                                   reconstruction1,
+                                   reconstruction2,
+                                   &summary))
+      << "Could not align models. Try using a higher error threshold.";
+}
+
+bool AlignReconstructionsRobust(const AlignReconstructionsOptions& options,
+                                const Reconstruction& reconstruction1,
+                                Reconstruction* reconstruction2,
+                                AlignReconstructionsSummary* summary) {
+  CHECK_GT(options.robust_error_threshold, 0.0);
+  CHECK_GT(options.num_hypotheses, 0);
+  CHECK_GT(options.preemption_block_size, 0);
   CHECK_NOTNULL(reconstruction2);
+  CHECK_NOTNULL(summary);
+  *summary = AlignReconstructionsSummary();
 
-  const std::vector<std::string> common_view_names =
-      FindCommonViewsByName(reconstruction1, *reconstruction2);
+  PositionCorrespondences cameras;
+  GetCommonCameraPositions(reconstruction1, *reconstruction2, &cameras);
+  summary->num_common_views = cameras.size();
+  if (cameras.size() < 3) {
+    VLOG(2) << "At least 3 common views are needed to align the "
+               "reconstructions but only " << cameras.size() << " were found.";
+    return false;
+  }
 
-  // Collect the positions of all common views.
-  std::vector<CameraCorrespondence> correspondences(common_view_names.size());
-  for (int i = 0; i < common_view_names.size(); i++) {
-    const ViewId view_id1 =
-        reconstruction1.ViewIdFromName(common_view_names[i]);
-    const ViewId view_id2 =
-        reconstruction2->ViewIdFromName(common_view_names[i]);
-    correspondences[i].camera1 =
-        reconstruction1.View(view_id1)->Camera().GetPosition();
-    correspondences[i].camera2 =
-        reconstruction2->View(view_id2)->Camera().GetPosition();
+  std::unique_ptr<RandomNumberGenerator> local_rng;
+  RandomNumberGenerator* rng = options.rng.get();
+  if (rng == nullptr) {
+    local_rng.reset(new RandomNumberGenerator());
+    rng = local_rng.get();
   }
 
-  // Estimate with RANSAC.
-  RansacParameters params;
-  params.max_iterations = 1000;
-  params.use_mle = true;
-  params.error_thresh = robust_error_threshold * robust_error_threshold;
-  params.failure_probability = 1e-4;
-
-  CameraAlignmentEstimator estimator;
-  Ransac<CameraAlignmentEstimator> ransac(params, estimator);
-  CHECK(ransac.Initialize()) << "Could not initialize RANSAC for similarity "
-                                "transformation estimation.";
-  SimilarityTransformation sim_transform;
-  RansacSummary summary;
-  CHECK(ransac.Estimate(correspondences, &sim_transform, &summary))
-      << "Could not align models with RANSAC";
-  CHECK_GT(summary.inliers.size(), 0)
-      << "No inliers could be found for estimating the similarity "
-         "transformation. Try using a higher error threshold.";
-
-  // Align the reconstructions using the inliers.
-  std::vector<Eigen::Vector3d> positions1(summary.inliers.size());
-  std::vector<Eigen::Vector3d> positions2(summary.inliers.size());
-  for (int i = 0; i < summary.inliers.size(); i++) {
-    positions1[i] = correspondences[summary.inliers[i]].camera1;
-    positions2[i] = correspondences[summary.inliers[i]].camera2;
+  AlignmentHypothesis hypothesis;
+  if (!EstimateAlignmentPreemptively(options, cameras, rng, &hypothesis)) {
+    VLOG(2) << "All camera positions are collinear.";
+    return false;
   }
 
-  // Align the positions.
-  Eigen::Matrix3d rotation;
-  Eigen::Vector3d translation;
-  double scale;
-  AlignPointCloudsUmeyama(positions2,
-                          positions1,
-                          &rotation,
-                          &translation,
-                          &scale);
+  const double squared_threshold =
+      options.robust_error_threshold * options.robust_error_threshold;
+  std::vector<int> camera_inliers, track_inliers;
+  FindInliers(cameras,
+              hypothesis.scaled_rotation,
+              hypothesis.translation,
+              squared_threshold,
+              &camera_inliers);
+  if (camera_inliers.size() < 3) {
+    return false;
+  }
+
+  PositionCorrespondences tracks;
+  if (options.refine_with_tracks) {
+    GetCommonTrackPoints(reconstruction1, *reconstruction2, &tracks);
+    FindInliers(tracks,
+                hypothesis.scaled_rotation,
+                hypothesis.translation,
+                squared_threshold,
+                &track_inliers);
+  }
+  summary->num_common_tracks = tracks.size();
+
+  // Refine the transformation with all inlier cameras and points.
+  double scale = std::cbrt(hypothesis.scaled_rotation.determinant());
+  Eigen::Matrix3d rotation = hypothesis.scaled_rotation / scale;
+  Eigen::Vector3d translation = hypothesis.translation;
+  for (int i = 0; i < options.max_num_refinement_iterations; i++) {
+    std::vector<Eigen::Vector3d> positions1, positions2;
+    AddInlierPositions(cameras, camera_inliers, &positions1, &positions2);
+    AddInlierPositions(tracks, track_inliers, &positions1, &positions2);
+    AlignPointCloudsUmeyama(positions2,
+                            positions1,
+                            &rotation,
+                            &translation,
+                            &scale);
+
+    std::vector<int> new_camera_inliers, new_track_inliers;
+    FindInliers(cameras,
+                scale * rotation,
+                translation,
+                squared_threshold,
+                &new_camera_inliers);
+    FindInliers(tracks,
+                scale * rotation,
+                translation,
+                squared_threshold,
+                &new_track_inliers);
+    if (new_camera_inliers.size() < 3 ||
+        (new_camera_inliers == camera_inliers &&
+         new_track_inliers == track_inliers)) {
+      break;
+    }
+    camera_inliers.swap(new_camera_inliers);
+    track_inliers.swap(new_track_inliers);
+  }
+
+  summary->success = true;
+  summary->num_camera_inliers = camera_inliers.size();
+  summary->num_track_inliers = track_inliers.size();
+  summary->transformation.rotation = rotation;
+  summary->transformation.translation = translation;
+  summary->transformation.scale = scale;
 
   // Apply the similarity transformation to the reconstruction.
   TransformReconstruction(rotation, translation, scale, reconstruction2);
+  return true;
+}
+
+void AlignReconstructionPairsRobust(
+    const AlignReconstructionsOptions& options,
+    const std::vector<const Reconstruction*>& reconstructions1,
+    const std::vector<Reconstruction*>& reconstructions2,
+    std::vector<AlignReconstructionsSummary>* summaries) {
+  CHECK_EQ(reconstructions1.size(), reconstructions2.size());
+  CHECK_GT(options.num_threads, 0);
+  CHECK_NOTNULL(summaries)->resize(reconstructions1.size());
+
+  // Each pair gets its own generator so that the pairs are aligned
+  // independently of the scheduling of the threads.
+  std::vector<AlignReconstructionsOptions> pair_options(
+      reconstructions1.size(), options);
+  const uint64_t seed = options.rng ? (*options.rng)() : 0;
+  for (int i = 0; i < pair_options.size(); i++) {
+    if (options.rng) {
+      pair_options[i].rng = std::make_shared<RandomNumberGenerator>(seed, i);
+    }
+  }
+
+  ThreadPool pool(options.num_threads);
+  for (int i = 0; i < reconstructions1.size(); i++) {
+    pool.Add([&, i]() {
+      AlignReconstructionsRobust(pair_options[i],
+                                 *reconstructions1[i],
+                                 reconstructions2[i],
+                                 &(*summaries)[i]);
+    });
+  }
 }
 
 }  // namespace theia
@@ -35,7 +35,12 @@
 #ifndef THEIA_SFM_TRANSFORMATION_ALIGN_RECONSTRUCTIONS_H_
 #define THEIA_SFM_TRANSFORMATION_ALIGN_RECONSTRUCTIONS_H_
 
+#include <memory>
+#include <vector>
+
 #include "theia/sfm/reconstruction.h"
+#include "theia/sfm/similarity_transformation.h"
+#include "theia/util/random.h"
 
 namespace theia {
 
@@ -44,16 +49,84 @@ namespace theia {
 void AlignReconstructions(const Reconstruction& reconstruction1,
                           Reconstruction* reconstruction2);
 
+struct AlignReconstructionsOptions {
+  // Correspondences that are farther apart than this threshold after the
+  // alignment are outliers. The threshold is in the units of reconstruction1.
+  double robust_error_threshold = 0.0;
+
+  // The number of similarity transformations that are hypothesized from
+  // minimal samples of three common cameras.
+  int num_hypotheses = 256;
+
+  // The hypotheses are scored preemptively as in Nister, "Preemptive RANSAC for
+  // live structure and motion estimation" (ICCV 2003): the camera
+  // correspondences are visited in blocks of this size in a random order and
+  // the worse half of the hypotheses is discarded after each block.
+  int preemption_block_size = 16;
+
+  // If true, the 3D points of the tracks that both reconstructions share are
+  // used to refine the alignment along with the camera positions. Two tracks
+  // are the same if they observe the same feature in a common view.
+  bool refine_with_tracks = true;
+
+  // The alignment is refined by alternating between estimating the
+  // transformation from all inliers and recomputing the inliers until the
+  // inliers do not change or this many iterations are reached.
+  int max_num_refinement_iterations = 10;
+
+  // The number of threads used by AlignReconstructionPairsRobust.
+  int num_threads = 1;
+
+  // The random number generator used to draw the samples. Set this to a seeded
+  // generator to reproduce the results. If null, a generator that is seeded
+  // from the current time is used.
+  std::shared_ptr<RandomNumberGenerator> rng;
+};
+
+struct AlignReconstructionsSummary {
+  bool success = false;
+
+  // The transformation that was applied to reconstruction2.
+  SimilarityTransformation transformation;
+
+  int num_common_views = 0;
+  int num_camera_inliers = 0;
+  int num_common_tracks = 0;
+  int num_track_inliers = 0;
+};
+
 // Aligns the reconstructions so that their commons cameras have the closest
 // positions. This method is robust by using RANSAC to compute similarity
 // transformations with inliers having a position distance less than
 // robust_error_threshold. A final alignment is run on the inliers of the best
-// RANSAC estimation.
+// RANSAC estimation. The program is aborted if no alignment is found.
 void AlignReconstructionsRobust(
     const double robust_error_threshold,
     const Reconstruction& reconstruction1,
     Reconstruction* reconstruction2);
 
+// Same as above with more control over the estimation. The similarity
+// transformation is estimated from the positions of the estimated views that
+// both reconstructions share (by name) with preemptive RANSAC and the
+// closed-form three point solver, then refined with the inlier cameras and
+// common track points. Returns false and leaves reconstruction2 unchanged if
+// no transformation with at least three inlier cameras is found.
+bool AlignReconstructionsRobust(const AlignReconstructionsOptions& options,
+                                const Reconstruction& reconstruction1,
+                                Reconstruction* reconstruction2,
+                                AlignReconstructionsSummary* summary);
+
+// Aligns each of reconstructions2 to the corresponding reconstruction of
+// reconstructions1 with the method above, using options.num_threads threads.
+// If options.rng is set, each pair uses a generator seeded from it and the
+// index of the pair so that the results do not depend on the scheduling of
+// the threads.
+void AlignReconstructionPairsRobust(
+    const AlignReconstructionsOptions& options,
+    const std::vector<const Reconstruction*>& reconstructions1,
+    const std::vector<Reconstruction*>& reconstructions2,
+    std::vector<AlignReconstructionsSummary>* summaries);
+
 }  // namespace theia
 
 #endif  // THEIA_SFM_TRANSFORMATION_ALIGN_RECONSTRUCTIONS_H_
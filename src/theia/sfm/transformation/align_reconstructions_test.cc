@@ -36,6 +36,7 @@
 #include <Eigen/Geometry>
 #include <glog/logging.h>
 #include <algorithm>
+#include <memory>
 #include <utility>
 #include <vector>
 #include <string>
@@ -43,9 +44,11 @@
 #include "gtest/gtest.h"
 
 #include "theia/sfm/reconstruction.h"
+#include "theia/sfm/similarity_transformation.h"
 #include "theia/sfm/types.h"
 #include "theia/sfm/transformation/align_reconstructions.h"
 #include "theia/sfm/transformation/transform_reconstruction.h"
+#include "theia/util/random.h"
 #include "theia/util/stringprintf.h"
 
 namespace theia {
@@ -189,5 +192,247 @@ TEST(AlignReconstructions, SimilarityTransformation) {
   TestAlignReconstructions(kNumViews, kNumTracks, rotation, translation, scale);
 }
 
+// Builds two reconstructions related by the similarity transformation where
+// every track has a unique feature in each view so that the tracks of the two
+// reconstructions can be matched. The positions of the first num_outliers
+// views of reconstruction2 are perturbed.
+void BuildReconstructionsWithOutliers(const int num_views,
+                                      const int num_outliers,
+                                      const int num_tracks,
+                                      const SimilarityTransformation& transform,
+                                      RandomNumberGenerator* rng,
+                                      Reconstruction* reconstruction1,
+                                      Reconstruction* reconstruction2) {
+  for (int i = 0; i < num_views; i++) {
+    const std::string name = StringPrintf("%d", i);
+    const ViewId view_id1 = reconstruction1->AddView(name);
+    const ViewId view_id2 = reconstruction2->AddView(name);
+
+    Camera camera;
+    camera.SetPosition(Eigen::Vector3d(rng->RandDouble(-10.0, 10.0),
+                                       rng->RandDouble(-10.0, 10.0),
+                                       rng->RandDouble(-10.0, 10.0)));
+    *reconstruction2->MutableView(view_id2)->MutableCamera() = camera;
+    camera.SetPosition(transform.scale * transform.rotation *
+                           camera.GetPosition() +
+                       transform.translation);
+    *reconstruction1->MutableView(view_id1)->MutableCamera() = camera;
+    if (i < num_outliers) {
+      reconstruction2->MutableView(view_id2)->MutableCamera()->SetPosition(
+          Eigen::Vector3d(rng->RandDouble(-100.0, 100.0),
+                          rng->RandDouble(-100.0, 100.0),
+                          rng->RandDouble(-100.0, 100.0)));
+    }
+    reconstruction1->MutableView(view_id1)->SetEstimated(true);
+    reconstruction2->MutableView(view_id2)->SetEstimated(true);
+  }
+
+  for (int i = 0; i < num_tracks; i++) {
+    const std::vector<std::pair<ViewId, Feature> > track = {
+      {0, Feature(i, 0)}, {num_views - 1, Feature(i, 1)}
+    };
+    const TrackId track_id1 = reconstruction1->AddTrack(track);
+    const TrackId track_id2 = reconstruction2->AddTrack(track);
+
+    const Eigen::Vector3d point(rng->RandDouble(-10.0, 10.0),
+                                rng->RandDouble(-10.0, 10.0),
+                                rng->RandDouble(-10.0, 10.0));
+    *reconstruction2->MutableTrack(track_id2)->MutablePoint() =
+        point.homogeneous();
+    *reconstruction1->MutableTrack(track_id1)->MutablePoint() =
+        (transform.scale * transform.rotation * point + transform.translation)
+            .homogeneous();
+    reconstruction1->MutableTrack(track_id1)->SetEstimated(true);
+    reconstruction2->MutableTrack(track_id2)->SetEstimated(true);
+  }
+}
+
+SimilarityTransformation RandomSimilarityTransformation(
+    RandomNumberGenerator* rng) {
+  const Eigen::Vector3d rotation_aa(rng->RandDouble(-1.0, 1.0),
+                                    rng->RandDouble(-1.0, 1.0),
+                                    rng->RandDouble(-1.0, 1.0));
+  SimilarityTransformation transform;
+  transform.rotation =
+      Eigen::AngleAxisd(rotation_aa.norm(), rotation_aa.normalized())
+          .toRotationMatrix();
+  transform.translation = Eigen::Vector3d(rng->RandDouble(-5.0, 5.0),
+                                          rng->RandDouble(-5.0, 5.0),
+                                          rng->RandDouble(-5.0, 5.0));
+  transform.scale = rng->RandDouble(0.5, 3.0);
+  return transform;
+}
+
+void VerifyRobustAlignment(const int num_outliers,
+                           const Reconstruction& reconstruction1,
+                           const Reconstruction& reconstruction2) {
+  static const double kTolerance = 1e-8;
+  for (const ViewId view_id : reconstruction1.ViewIds()) {
+    if (view_id < num_outliers) {
+      continue;
+    }
+    const Eigen::Vector3d position1 =
+        reconstruction1.View(view_id)->Camera().GetPosition();
+    const Eigen::Vector3d position2 =
+        reconstruction2.View(view_id)->Camera().GetPosition();
+    EXPECT_LT((position1 - position2).norm(), kTolerance);
+  }
+
+  for (const TrackId track_id : reconstruction1.TrackIds()) {
+    const Eigen::Vector3d point1 =
+        reconstruction1.Track(track_id)->Point().hnormalized();
+    const Eigen::Vector3d point2 =
+        reconstruction2.Track(track_id)->Point().hnormalized();
+    EXPECT_LT((point1 - point2).norm(), kTolerance);
+  }
+}
+
+TEST(AlignReconstructionsRobust, CameraOutliers) {
+  static const int kNumViews = 100;
+  static const int kNumOutliers = 30;
+  static const int kNumTracks = 50;
+  RandomNumberGenerator rng(47);
+  const SimilarityTransformation transform =
+      RandomSimilarityTransformation(&rng);
+
+  Reconstruction reconstruction1, reconstruction2;
+  BuildReconstructionsWithOutliers(kNumViews,
+                                   kNumOutliers,
+                                   kNumTracks,
+                                   transform,
+                                   &rng,
+                                   &reconstruction1,
+                                   &reconstruction2);
+
+  AlignReconstructionsOptions options;
+  options.robust_error_threshold = 0.1;
+  options.rng = std::make_shared<RandomNumberGenerator>(59);
+  AlignReconstructionsSummary summary;
+  EXPECT_TRUE(AlignReconstructionsRobust(options,
+                                         reconstruction1,
+                                         &reconstruction2,
+                                         &summary));
+  EXPECT_TRUE(summary.success);
+  EXPECT_EQ(summary.num_common_views, kNumViews);
+  EXPECT_EQ(summary.num_camera_inliers, kNumViews - kNumOutliers);
+  EXPECT_EQ(summary.num_common_tracks, kNumTracks);
+  EXPECT_EQ(summary.num_track_inliers, kNumTracks);
+  EXPECT_NEAR(summary.transformation.scale, transform.scale, 1e-8);
+  VerifyRobustAlignment(kNumOutliers, reconstruction1, reconstruction2);
+}
+
+TEST(AlignReconstructionsRobust, WithoutTracks) {
+  static const int kNumViews = 20;
+  static const int kNumOutliers = 5;
+  RandomNumberGenerator rng(61);
+  const SimilarityTransformation transform =
+      RandomSimilarityTransformation(&rng);
+
+  Reconstruction reconstruction1, reconstruction2;
+  BuildReconstructionsWithOutliers(kNumViews,
+                                   kNumOutliers,
+                                   0,
+                                   transform,
+                                   &rng,
+                                   &reconstruction1,
+                                   &reconstruction2);
+
+  AlignReconstructionsOptions options;
+  options.robust_error_threshold = 0.1;
+  options.refine_with_tracks = false;
+  options.rng = std::make_shared<RandomNumberGenerator>(67);
+  AlignReconstructionsSummary summary;
+  EXPECT_TRUE(AlignReconstructionsRobust(options,
+                                         reconstruction1,
+                                         &reconstruction2,
+                                         &summary));
+  EXPECT_EQ(summary.num_camera_inliers, kNumViews - kNumOutliers);
+  EXPECT_EQ(summary.num_common_tracks, 0);
+  VerifyRobustAlignment(kNumOutliers, reconstruction1, reconstruction2);
+}
+
+TEST(AlignReconstructionsRobust, TooFewCommonViews) {
+  RandomNumberGenerator rng(71);
+  Reconstruction reconstruction1, reconstruction2;
+  BuildReconstructionsWithOutliers(2,
+                                   0,
+                                   0,
+                                   RandomSimilarityTransformation(&rng),
+                                   &rng,
+                                   &reconstruction1,
+                                   &reconstruction2);
+
+  AlignReconstructionsOptions options;
+  options.robust_error_threshold = 0.1;
+  AlignReconstructionsSummary summary;
+  EXPECT_FALSE(AlignReconstructionsRobust(options,
+                                          reconstruction1,
+                                          &reconstruction2,
+                                          &summary));
+  EXPECT_FALSE(summary.success);
+}
+
+TEST(AlignReconstructionPairsRobust, ReproducibleInParallel) {
+  static const int kNumPairs = 6;
+  static const int kNumViews = 40;
+  static const int kNumOutliers = 10;
+  static const int kNumTracks = 20;
+  RandomNumberGenerator rng(73);
+
+  std::vector<Reconstruction> reconstructions1(kNumPairs);
+  std::vector<Reconstruction> reconstructions2(kNumPairs);
+  std::vector<const Reconstruction*> reconstruction_ptrs1(kNumPairs);
+  std::vector<Reconstruction*> reconstruction_ptrs2(kNumPairs);
+  for (int i = 0; i < kNumPairs; i++) {
+    BuildReconstructionsWithOutliers(kNumViews,
+                                     kNumOutliers,
+                                     kNumTracks,
+                                     RandomSimilarityTransformation(&rng),
+                                     &rng,
+                                     &reconstructions1[i],
+                                     &reconstructions2[i]);
+    reconstruction_ptrs1[i] = &reconstructions1[i];
+    reconstruction_ptrs2[i] = &reconstructions2[i];
+  }
+  const std::vector<Reconstruction> unaligned_reconstructions2 =
+      reconstructions2;
+
+  AlignReconstructionsOptions options;
+  options.robust_error_threshold = 0.1;
+  options.num_threads = 3;
+  options.rng = std::make_shared<RandomNumberGenerator>(79);
+  std::vector<AlignReconstructionsSummary> summaries;
+  AlignReconstructionPairsRobust(options,
+                                 reconstruction_ptrs1,
+                                 reconstruction_ptrs2,
+                                 &summaries);
+  ASSERT_EQ(summaries.size(), kNumPairs);
+  for (int i = 0; i < kNumPairs; i++) {
+    EXPECT_TRUE(summaries[i].success);
+    EXPECT_EQ(summaries[i].num_camera_inliers, kNumViews - kNumOutliers);
+    VerifyRobustAlignment(kNumOutliers,
+                          reconstructions1[i],
+                          reconstructions2[i]);
+  }
+
+  // Aligning the pairs again with the same seed on a single thread gives the
+  // same transformations.
+  reconstructions2 = unaligned_reconstructions2;
+  options.num_threads = 1;
+  options.rng = std::make_shared<RandomNumberGenerator>(79);
+  std::vector<AlignReconstructionsSummary> serial_summaries;
+  AlignReconstructionPairsRobust(options,
+                                 reconstruction_ptrs1,
+                                 reconstruction_ptrs2,
+                                 &serial_summaries);
+  for (int i = 0; i < kNumPairs; i++) {
+    EXPECT_TRUE(serial_summaries[i].transformation.rotation ==
+                summaries[i].transformation.rotation);
+    EXPECT_TRUE(serial_summaries[i].transformation.translation ==
+                summaries[i].transformation.translation);
+    EXPECT_EQ(serial_summaries[i].transformation.scale,
+              summaries[i].transformation.scale);
+  }
+}
 
 }  // namespace theia
@@ -35,14 +35,16 @@
 #include "theia/sfm/verify_two_view_matches.h"
 
 #include <glog/logging.h>
+#include <limits>
 #include <vector>
 
 #include "theia/sfm/bundle_adjustment/bundle_adjustment.h"
 #include "theia/sfm/bundle_adjustment/bundle_adjust_two_views.h"
+#include "theia/sfm/bundle_adjustment/refine_two_view_geometry.h"
 #include "theia/sfm/camera_intrinsics_prior.h"
 #include "theia/sfm/estimate_twoview_info.h"
-#include "theia/sfm/estimators/estimate_homography.h"
 #include "theia/matching/feature_correspondence.h"
+#include "theia/sfm/set_camera_intrinsics_from_priors.h"
 #include "theia/sfm/triangulation/triangulation.h"
 #include "theia/sfm/twoview_info.h"
 
@@ -50,25 +52,6 @@ namespace theia {
 
 namespace {
 
-void SetCameraIntrinsicsFromPriors(const CameraIntrinsicsPrior& prior,
-                                   Camera* camera) {
-  if (prior.principal_point[0].is_set && prior.principal_point[1].is_set) {
-    camera->SetPrincipalPoint(prior.principal_point[0].value,
-                              prior.principal_point[1].value);
-  } else {
-    camera->SetPrincipalPoint(prior.image_width / 2.0,
-                              prior.image_height / 2.0);
-  }
-
-  if (prior.aspect_ratio.is_set) {
-    camera->SetAspectRatio(prior.aspect_ratio.value);
-  }
-
-  if (prior.skew.is_set) {
-    camera->SetSkew(prior.skew.value);
-  }
-}
-
 void SetupCameras(const CameraIntrinsicsPrior& intrinsics1,
                   const CameraIntrinsicsPrior& intrinsics2,
                   const TwoViewInfo& info,
@@ -175,24 +158,31 @@ bool BundleAdjustRelativePose(
   return summary.success;
 }
 
-// Compute a homography and return the number of inliers. This determines how
-// well a plane fits the two view geometry.
-int CountHomographyInliers(
+// Refines the relative pose with the Sampson error of the inliers and then
+// re-triangulates the points with the refined cameras.
+bool RefineRelativePose(
+    const CameraIntrinsicsPrior& intrinsics1,
+    const CameraIntrinsicsPrior& intrinsics2,
     const std::vector<FeatureCorrespondence>& correspondences,
-    const EstimateTwoViewInfoOptions& etvi_options) {
-  RansacParameters homography_params;
-  homography_params.error_thresh = etvi_options.max_sampson_error_pixels *
-                                   etvi_options.max_sampson_error_pixels;
-  homography_params.max_iterations = etvi_options.max_ransac_iterations;
-  homography_params.min_iterations = etvi_options.min_ransac_iterations;
-  homography_params.use_mle = etvi_options.use_mle;
-  homography_params.failure_probability =
-      1.0 - etvi_options.expected_ransac_confidence;
-  RansacSummary homography_summary;
-  Eigen::Matrix3d unused_homography;
-  EstimateHomography(homography_params, etvi_options.ransac_type,
-                     correspondences, &unused_homography, &homography_summary);
-  return homography_summary.inliers.size();
+    std::vector<int>* inliers,
+    Camera* camera1,
+    Camera* camera2,
+    std::vector<Eigen::Vector4d>* triangulated_points) {
+  TwoViewRefinementOptions refinement_options;
+  refinement_options.refine_focal_length1 = !intrinsics1.focal_length.is_set;
+  refinement_options.refine_focal_length2 = !intrinsics2.focal_length.is_set;
+  TwoViewRefinementSummary summary;
+  if (!RefineTwoViewGeometry(refinement_options, correspondences, *inliers,
+                             camera1, camera2, &summary)) {
+    return false;
+  }
+
+  // The reprojection errors are checked after refinement so only the
+  // triangulation itself may fail here.
+  triangulated_points->clear();
+  TriangulatePoints(std::numeric_limits<double>::max(), *camera1, *camera2,
+                    correspondences, inliers, triangulated_points);
+  return true;
 }
 
 }  // namespace
@@ -208,9 +198,13 @@ bool VerifyTwoViewMatches(
     return false;
   }
 
-  // Estimate the two view info. If we fail to estimate a two view info then do
-  // not add this view pair to the verified matches.
-  if (!EstimateTwoViewInfo(options.estimate_twoview_info_options,
+  // Estimate the two view info and the number of homography inliers. If we
+  // fail to estimate a two view info then do not add this view pair to the
+  // verified matches.
+  EstimateTwoViewInfoOptions estimate_twoview_info_options =
+      options.estimate_twoview_info_options;
+  estimate_twoview_info_options.estimate_homography = true;
+  if (!EstimateTwoViewInfo(estimate_twoview_info_options,
                            intrinsics1,
                            intrinsics2,
                            correspondences,
@@ -235,12 +229,20 @@ bool VerifyTwoViewMatches(
       return false;
     }
 
-    // Bundle adjust the relative pose and points.
-    TwoViewBundleAdjustmentOptions ba_options =
-        SetTwoViewBundleAdjustmentOptions(intrinsics1, intrinsics2);
-    if (!BundleAdjustRelativePose(ba_options, correspondences, *inlier_indices,
-                                  &camera1, &camera2, &tracks)) {
-      return false;
+    // Refine the relative pose (and points).
+    if (options.use_sampson_refinement) {
+      if (!RefineRelativePose(intrinsics1, intrinsics2, correspondences,
+                              inlier_indices, &camera1, &camera2, &tracks)) {
+        return false;
+      }
+    } else {
+      TwoViewBundleAdjustmentOptions ba_options =
+          SetTwoViewBundleAdjustmentOptions(intrinsics1, intrinsics2);
+      if (!BundleAdjustRelativePose(ba_options, correspondences,
+                                    *inlier_indices, &camera1, &camera2,
+                                    &tracks)) {
+        return false;
+      }
     }
 
     // Remove points with high reprojection errors.
@@ -270,10 +272,9 @@ bool VerifyTwoViewMatches(
     twoview_info->focal_length_2 = camera2.FocalLength();
   }
 
-  // Set the number of verified matches and number of homography matches.
+  // Set the number of verified matches. The number of homography inliers is
+  // computed along with the two view info.
   twoview_info->num_verified_matches = inlier_indices->size();
-  twoview_info->num_homography_inliers = CountHomographyInliers(
-      correspondences, options.estimate_twoview_info_options);
   return inlier_indices->size() > options.min_num_inlier_matches;
 }
 
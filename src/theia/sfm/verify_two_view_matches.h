@@ -54,6 +54,13 @@ struct VerifyTwoViewMatchesOptions {
   // Bundle adjust the two view geometry using inliers.
   bool bundle_adjustment = true;
 
+  // If true, the two view geometry is refined with a small fixed-size
+  // Levenberg-Marquardt on the Sampson error of the inliers (see
+  // RefineTwoViewGeometry) instead of a full Ceres bundle adjustment of the
+  // relative pose and the triangulated points. This is much cheaper per view
+  // pair. Focal lengths without a prior are refined in both cases.
+  bool use_sampson_refinement = true;
+
   // If performing bundle adjustment, the 3D points are only considered inliers
   // if the initial triangulation error is less than this. This value is in
   // pixels.
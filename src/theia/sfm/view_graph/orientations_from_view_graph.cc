@@ -88,7 +88,7 @@ void AddEdgesToHeap(
     const std::unordered_map<ViewId, Eigen::Vector3d>& orientations,
     const ViewId view_id,
     std::vector<HeapElement >* heap) {
-  const std::unordered_set<ViewId>* edge_ids =
+  const std::vector<ViewId>* edge_ids =
       view_graph.GetNeighborIdsForView(view_id);
   for (const ViewId edge_id : *edge_ids) {
     // Only add edges to the heap that contain a vertex that has not been seen.
@@ -0,0 +1,315 @@
+// Copyright (C) 2015 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include "theia/sfm/view_graph/partition_view_graph.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "theia/math/graph/connected_components.h"
+#include "theia/math/graph/normalized_graph_cut.h"
+#include "theia/sfm/twoview_info.h"
+#include "theia/sfm/types.h"
+#include "theia/sfm/view_graph/view_graph.h"
+#include "theia/util/hash.h"
+#include "theia/util/map_util.h"
+
+namespace theia {
+
+namespace {
+
+// The normalized graph cut needs a handful of nodes for the sparse eigen
+// decomposition to be well-defined, so clusters smaller than this are never
+// cut.
+static const int kMinNumViewsToPartition = 8;
+
+// Collects the edges of the view graph that have both views inside the
+// cluster. Edges are weighted by the number of verified matches so that the
+// normalized cut prefers to cut through weakly connected view pairs.
+void GetClusterEdges(const ViewGraph& view_graph,
+                     const std::unordered_set<ViewId>& cluster,
+                     std::unordered_map<ViewIdPair, double>* edges) {
+  for (const ViewId view_id : cluster) {
+    const std::vector<ViewId>* neighbor_ids =
+        view_graph.GetNeighborIdsForView(view_id);
+    if (neighbor_ids == nullptr) {
+      continue;
+    }
+
+    for (const ViewId neighbor_id : *neighbor_ids) {
+      // Only add each edge once.
+      if (neighbor_id < view_id || !ContainsKey(cluster, neighbor_id)) {
+        continue;
+      }
+      const TwoViewInfo* info = view_graph.GetEdge(view_id, neighbor_id);
+      (*edges)[ViewIdPair(view_id, neighbor_id)] =
+          1.0 + info->num_verified_matches;
+    }
+  }
+}
+
+// Returns the largest connected component of the subgraph, or an empty set if
+// the subgraph has no edges. Ties are broken by the root id so that the
+// partitioning is deterministic.
+std::unordered_set<ViewId> GetLargestConnectedComponent(
+    const std::unordered_map<ViewIdPair, double>& edges,
+    const std::unordered_set<ViewId>& subgraph) {
+  ConnectedComponents<ViewId> connected_components;
+  for (const auto& edge : edges) {
+    if (ContainsKey(subgraph, edge.first.first) &&
+        ContainsKey(subgraph, edge.first.second)) {
+      connected_components.AddEdge(edge.first.first, edge.first.second);
+    }
+  }
+  std::unordered_map<ViewId, std::unordered_set<ViewId> > components;
+  connected_components.Extract(&components);
+
+  ViewId largest_component_id = kInvalidViewId;
+  for (const auto& component : components) {
+    if (largest_component_id == kInvalidViewId ||
+        component.second.size() > components[largest_component_id].size() ||
+        (component.second.size() == components[largest_component_id].size() &&
+         component.first < largest_component_id)) {
+      largest_component_id = component.first;
+    }
+  }
+  if (largest_component_id == kInvalidViewId) {
+    return std::unordered_set<ViewId>();
+  }
+  return components[largest_component_id];
+}
+
+// The normalized cut does not guarantee that the two subgraphs are connected,
+// but a cluster can only be reconstructed as a whole if its views are
+// connected. This keeps the largest connected component of each subgraph and
+// grows the two components along the cluster edges until all views that are
+// reachable have been assigned. Views that cannot be reached stay in the
+// subgraph they were cut into.
+void ConnectSubgraphs(const std::unordered_map<ViewIdPair, double>& edges,
+                      std::unordered_set<ViewId>* subgraph1,
+                      std::unordered_set<ViewId>* subgraph2) {
+  std::unordered_set<ViewId> component1 =
+      GetLargestConnectedComponent(edges, *subgraph1);
+  std::unordered_set<ViewId> component2 =
+      GetLargestConnectedComponent(edges, *subgraph2);
+  if (component1.empty() || component2.empty() ||
+      (component1.size() == subgraph1->size() &&
+       component2.size() == subgraph2->size())) {
+    return;
+  }
+
+  bool assigned_view = true;
+  while (assigned_view) {
+    assigned_view = false;
+    for (const auto& edge : edges) {
+      const ViewId view_id1 = edge.first.first;
+      const ViewId view_id2 = edge.first.second;
+      const bool view1_is_assigned = ContainsKey(component1, view_id1) ||
+                                     ContainsKey(component2, view_id1);
+      const bool view2_is_assigned = ContainsKey(component1, view_id2) ||
+                                     ContainsKey(component2, view_id2);
+      if (view1_is_assigned == view2_is_assigned) {
+        continue;
+      }
+
+      const ViewId assigned_id = view1_is_assigned ? view_id1 : view_id2;
+      const ViewId unassigned_id = view1_is_assigned ? view_id2 : view_id1;
+      if (ContainsKey(component1, assigned_id)) {
+        component1.insert(unassigned_id);
+      } else {
+        component2.insert(unassigned_id);
+      }
+      assigned_view = true;
+    }
+  }
+
+  for (const ViewId view_id : *subgraph1) {
+    if (!ContainsKey(component2, view_id)) {
+      component1.insert(view_id);
+    }
+  }
+  for (const ViewId view_id : *subgraph2) {
+    if (!ContainsKey(component1, view_id)) {
+      component2.insert(view_id);
+    }
+  }
+  subgraph1->swap(component1);
+  subgraph2->swap(component2);
+}
+
+// Recursively bisects the view graph until all clusters are small enough.
+void BisectViewGraph(const PartitionViewGraphOptions& options,
+                     const ViewGraph& view_graph,
+                     std::vector<std::unordered_set<ViewId> >* clusters) {
+  std::vector<std::unordered_set<ViewId> > clusters_to_partition;
+  clusters_to_partition.emplace_back(view_graph.ViewIds());
+
+  while (!clusters_to_partition.empty()) {
+    std::unordered_set<ViewId> cluster;
+    cluster.swap(clusters_to_partition.back());
+    clusters_to_partition.pop_back();
+
+    if (cluster.size() <= options.max_num_views_per_cluster ||
+        cluster.size() < kMinNumViewsToPartition) {
+      clusters->emplace_back();
+      clusters->back().swap(cluster);
+      continue;
+    }
+
+    std::unordered_map<ViewIdPair, double> edges;
+    GetClusterEdges(view_graph, cluster, &edges);
+
+    NormalizedGraphCut<ViewId>::Options cut_options;
+    NormalizedGraphCut<ViewId> normalized_graph_cut(cut_options);
+    std::unordered_set<ViewId> subgraph1, subgraph2;
+    normalized_graph_cut.ComputeCut(edges, &subgraph1, &subgraph2, nullptr);
+
+    // Views that have no edges within the cluster do not participate in the
+    // cut. Assign them to the smaller of the two subgraphs so that they are
+    // not lost.
+    std::unordered_set<ViewId>* smaller_subgraph =
+        (subgraph1.size() < subgraph2.size()) ? &subgraph1 : &subgraph2;
+    for (const ViewId view_id : cluster) {
+      if (!ContainsKey(subgraph1, view_id) &&
+          !ContainsKey(subgraph2, view_id)) {
+        smaller_subgraph->insert(view_id);
+      }
+    }
+
+    // If the cut was degenerate we cannot make any more progress on this
+    // cluster so we keep it as is.
+    if (subgraph1.empty() || subgraph2.empty()) {
+      LOG(WARNING) << "Could not partition a cluster of " << cluster.size()
+                   << " views. The cluster will not be partitioned further.";
+      clusters->emplace_back();
+      clusters->back().swap(cluster);
+      continue;
+    }
+
+    ConnectSubgraphs(edges, &subgraph1, &subgraph2);
+
+    clusters_to_partition.emplace_back();
+    clusters_to_partition.back().swap(subgraph1);
+    clusters_to_partition.emplace_back();
+    clusters_to_partition.back().swap(subgraph2);
+  }
+}
+
+// Grows each cluster along the strongest edges that were cut during the
+// partitioning so that neighboring clusters share some views.
+void AddOverlappingViews(const PartitionViewGraphOptions& options,
+                         const ViewGraph& view_graph,
+                         std::vector<std::unordered_set<ViewId> >* clusters) {
+  std::unordered_map<ViewId, int> cluster_index_of_view;
+  for (int i = 0; i < clusters->size(); i++) {
+    for (const ViewId view_id : (*clusters)[i]) {
+      cluster_index_of_view[view_id] = i;
+    }
+  }
+
+  // For each cluster, collect the views outside of the cluster that are
+  // connected to it along with the strength of the connection.
+  std::vector<std::vector<std::pair<int, ViewId> > > candidate_views(
+      clusters->size());
+  const auto& view_pairs = view_graph.GetAllEdges();
+  for (const auto& view_pair : view_pairs) {
+    const ViewId view_id1 = view_pair.first.first;
+    const ViewId view_id2 = view_pair.first.second;
+    const int cluster_index1 = FindOrDie(cluster_index_of_view, view_id1);
+    const int cluster_index2 = FindOrDie(cluster_index_of_view, view_id2);
+    if (cluster_index1 == cluster_index2) {
+      continue;
+    }
+
+    const int num_matches = view_pair.second.num_verified_matches;
+    candidate_views[cluster_index1].emplace_back(num_matches, view_id2);
+    candidate_views[cluster_index2].emplace_back(num_matches, view_id1);
+  }
+
+  for (int i = 0; i < clusters->size(); i++) {
+    std::unordered_set<ViewId>& cluster = (*clusters)[i];
+    std::vector<std::pair<int, ViewId> >& candidates = candidate_views[i];
+    // Sort by decreasing number of matches. Ties are broken by the view id so
+    // that the partitioning is deterministic.
+    std::sort(candidates.begin(), candidates.end(),
+              [](const std::pair<int, ViewId>& lhs,
+                 const std::pair<int, ViewId>& rhs) {
+                return lhs.first > rhs.first ||
+                       (lhs.first == rhs.first && lhs.second < rhs.second);
+              });
+
+    const int num_views_to_add =
+        std::max(options.min_num_overlapping_views,
+                 static_cast<int>(options.overlap_ratio * cluster.size()));
+    int num_added_views = 0;
+    for (const auto& candidate : candidates) {
+      if (num_added_views >= num_views_to_add) {
+        break;
+      }
+      if (cluster.insert(candidate.second).second) {
+        ++num_added_views;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+void PartitionViewGraph(const PartitionViewGraphOptions& options,
+                        const ViewGraph& view_graph,
+                        std::vector<std::unordered_set<ViewId> >* clusters) {
+  CHECK_NOTNULL(clusters)->clear();
+  CHECK_GT(options.max_num_views_per_cluster, 0);
+  CHECK_GE(options.overlap_ratio, 0.0);
+  CHECK_GE(options.min_num_overlapping_views, 0);
+
+  if (view_graph.NumViews() == 0) {
+    return;
+  }
+
+  BisectViewGraph(options, view_graph, clusters);
+  if (clusters->size() > 1) {
+    AddOverlappingViews(options, view_graph, clusters);
+  }
+
+  VLOG(2) << "Partitioned a view graph with " << view_graph.NumViews()
+          << " views into " << clusters->size() << " clusters.";
+}
+
+}  // namespace theia
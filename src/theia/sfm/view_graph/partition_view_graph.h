@@ -0,0 +1,73 @@
+// Copyright (C) 2015 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#ifndef THEIA_SFM_VIEW_GRAPH_PARTITION_VIEW_GRAPH_H_
+#define THEIA_SFM_VIEW_GRAPH_PARTITION_VIEW_GRAPH_H_
+
+#include <unordered_set>
+#include <vector>
+
+#include "theia/sfm/types.h"
+
+namespace theia {
+
+class ViewGraph;
+
+struct PartitionViewGraphOptions {
+  // The view graph is recursively cut until every cluster contains at most
+  // this many views (before the overlapping views are added).
+  int max_num_views_per_cluster = 500;
+
+  // Once the graph has been partitioned, each cluster is grown by adding views
+  // from neighboring clusters so that adjacent clusters share a set of
+  // "separator" views that may be used to align them. Each cluster is grown by
+  // overlap_ratio * cluster_size views, but by no fewer than
+  // min_num_overlapping_views.
+  double overlap_ratio = 0.1;
+  int min_num_overlapping_views = 10;
+};
+
+// Partitions the view graph into a set of overlapping clusters. The view graph
+// is recursively split with a normalized graph cut where the edges are weighted
+// by the number of verified matches, so that the cuts pass through the weakest
+// connections of the view graph. Each cluster is then expanded along the
+// strongest edges that were cut so that neighboring clusters overlap. Every
+// view of the view graph is contained in at least one of the output clusters.
+void PartitionViewGraph(const PartitionViewGraphOptions& options,
+                        const ViewGraph& view_graph,
+                        std::vector<std::unordered_set<ViewId> >* clusters);
+
+}  // namespace theia
+
+#endif  // THEIA_SFM_VIEW_GRAPH_PARTITION_VIEW_GRAPH_H_
@@ -0,0 +1,175 @@
+// Copyright (C) 2015 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include <unordered_set>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "theia/sfm/twoview_info.h"
+#include "theia/sfm/types.h"
+#include "theia/sfm/view_graph/partition_view_graph.h"
+#include "theia/sfm/view_graph/view_graph.h"
+#include "theia/util/map_util.h"
+
+namespace theia {
+
+namespace {
+
+// Adds a fully connected set of views with the given ids to the view graph.
+void AddClique(const ViewId first_view_id,
+               const int num_views,
+               const int num_matches,
+               ViewGraph* view_graph) {
+  TwoViewInfo info;
+  info.num_verified_matches = num_matches;
+  for (int i = 0; i < num_views; i++) {
+    for (int j = i + 1; j < num_views; j++) {
+      view_graph->AddEdge(first_view_id + i, first_view_id + j, info);
+    }
+  }
+}
+
+}  // namespace
+
+TEST(PartitionViewGraph, SmallViewGraphIsNotPartitioned) {
+  ViewGraph view_graph;
+  AddClique(0, 10, 100, &view_graph);
+
+  PartitionViewGraphOptions options;
+  options.max_num_views_per_cluster = 20;
+  std::vector<std::unordered_set<ViewId> > clusters;
+  PartitionViewGraph(options, view_graph, &clusters);
+  ASSERT_EQ(clusters.size(), 1);
+  EXPECT_EQ(clusters[0].size(), view_graph.NumViews());
+}
+
+TEST(PartitionViewGraph, TwoWeaklyConnectedCliques) {
+  static const int kNumViewsPerClique = 12;
+  ViewGraph view_graph;
+  AddClique(0, kNumViewsPerClique, 100, &view_graph);
+  AddClique(kNumViewsPerClique, kNumViewsPerClique, 100, &view_graph);
+
+  // Connect the cliques with a few weak edges.
+  TwoViewInfo info;
+  info.num_verified_matches = 10;
+  view_graph.AddEdge(0, kNumViewsPerClique, info);
+  view_graph.AddEdge(1, kNumViewsPerClique + 1, info);
+
+  PartitionViewGraphOptions options;
+  options.max_num_views_per_cluster = kNumViewsPerClique;
+  options.min_num_overlapping_views = 0;
+  options.overlap_ratio = 0.0;
+  std::vector<std::unordered_set<ViewId> > clusters;
+  PartitionViewGraph(options, view_graph, &clusters);
+  ASSERT_EQ(clusters.size(), 2);
+
+  // Without any overlap the cut should exactly separate the two cliques.
+  for (const auto& cluster : clusters) {
+    EXPECT_EQ(cluster.size(), kNumViewsPerClique);
+    const bool is_first_clique = ContainsKey(cluster, 0);
+    for (const ViewId view_id : cluster) {
+      EXPECT_EQ(view_id < kNumViewsPerClique, is_first_clique);
+    }
+  }
+}
+
+TEST(PartitionViewGraph, ClustersOverlap) {
+  static const int kNumViewsPerClique = 12;
+  ViewGraph view_graph;
+  AddClique(0, kNumViewsPerClique, 100, &view_graph);
+  AddClique(kNumViewsPerClique, kNumViewsPerClique, 100, &view_graph);
+
+  TwoViewInfo info;
+  info.num_verified_matches = 10;
+  for (int i = 0; i < 4; i++) {
+    view_graph.AddEdge(i, kNumViewsPerClique + i, info);
+  }
+
+  PartitionViewGraphOptions options;
+  options.max_num_views_per_cluster = kNumViewsPerClique;
+  options.min_num_overlapping_views = 3;
+  options.overlap_ratio = 0.0;
+  std::vector<std::unordered_set<ViewId> > clusters;
+  PartitionViewGraph(options, view_graph, &clusters);
+  ASSERT_EQ(clusters.size(), 2);
+
+  // Each cluster is grown by the requested number of views.
+  EXPECT_EQ(clusters[0].size(), kNumViewsPerClique + 3);
+  EXPECT_EQ(clusters[1].size(), kNumViewsPerClique + 3);
+
+  // All views are covered and the clusters share some views.
+  std::unordered_set<ViewId> all_views;
+  int num_shared_views = 0;
+  for (const ViewId view_id : clusters[0]) {
+    all_views.insert(view_id);
+    if (ContainsKey(clusters[1], view_id)) {
+      ++num_shared_views;
+    }
+  }
+  all_views.insert(clusters[1].begin(), clusters[1].end());
+  EXPECT_EQ(all_views.size(), view_graph.NumViews());
+  EXPECT_EQ(num_shared_views, 6);
+}
+
+TEST(PartitionViewGraph, RecursivePartitioning) {
+  static const int kNumCliques = 4;
+  static const int kNumViewsPerClique = 10;
+  ViewGraph view_graph;
+  for (int i = 0; i < kNumCliques; i++) {
+    AddClique(i * kNumViewsPerClique, kNumViewsPerClique, 100, &view_graph);
+  }
+
+  // Connect the cliques in a chain.
+  TwoViewInfo info;
+  info.num_verified_matches = 5;
+  for (int i = 0; i + 1 < kNumCliques; i++) {
+    view_graph.AddEdge(i * kNumViewsPerClique,
+                       (i + 1) * kNumViewsPerClique,
+                       info);
+  }
+
+  PartitionViewGraphOptions options;
+  options.max_num_views_per_cluster = kNumViewsPerClique;
+  options.min_num_overlapping_views = 0;
+  options.overlap_ratio = 0.0;
+  std::vector<std::unordered_set<ViewId> > clusters;
+  PartitionViewGraph(options, view_graph, &clusters);
+  EXPECT_EQ(clusters.size(), kNumCliques);
+  for (const auto& cluster : clusters) {
+    EXPECT_LE(cluster.size(), options.max_num_views_per_cluster);
+  }
+}
+
+}  // namespace theia
@@ -51,9 +51,11 @@ std::unordered_set<ViewId> RemoveDisconnectedViewPairs(ViewGraph* view_graph) {
 
   // Extract all connected components.
   ConnectedComponents<ViewId> cc_extractor;
-  const auto& view_pairs = view_graph->GetAllEdges();
-  for (const auto& view_pair : view_pairs) {
-    cc_extractor.AddEdge(view_pair.first.first, view_pair.first.second);
+  for (int i = 0; i < view_graph->NumEdgeSlots(); i++) {
+    if (!view_graph->IsEdgeSlotRemoved(i)) {
+      const ViewIdPair& view_id_pair = view_graph->EdgeViewIdPair(i);
+      cc_extractor.AddEdge(view_id_pair.first, view_id_pair.second);
+    }
   }
   std::unordered_map<ViewId, std::unordered_set<ViewId> > connected_components;
   cc_extractor.Extract(&connected_components);
@@ -79,11 +81,10 @@ std::unordered_set<ViewId> RemoveDisconnectedViewPairs(ViewGraph* view_graph) {
     // NOTE: The connected component will contain the root id as well, so we do
     // not explicity have to remove connected_component.first since it will
     // exist in connected_components.second
-    for (const ViewId view_id2 : connected_component.second) {
-      view_graph->RemoveView(view_id2);
-      removed_views.insert(view_id2);
-    }
+    removed_views.insert(connected_component.second.begin(),
+                         connected_component.second.end());
   }
+  view_graph->RemoveViews(removed_views);
 
   const int num_removed_view_pairs =
       num_view_pairs_before_filtering - view_graph->NumEdges();
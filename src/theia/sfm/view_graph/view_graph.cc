@@ -34,8 +34,11 @@
 
 #include "theia/sfm/view_graph/view_graph.h"
 
+#include <glog/logging.h>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "theia/util/hash.h"
 #include "theia/util/map_util.h"
@@ -44,57 +47,93 @@
 
 namespace theia {
 
+namespace {
+
+ViewIdPair OrderedViewIdPair(const ViewId view_id_1, const ViewId view_id_2) {
+  return (view_id_1 < view_id_2) ? ViewIdPair(view_id_1, view_id_2)
+                                 : ViewIdPair(view_id_2, view_id_1);
+}
+
+}  // namespace
+
 // Number of views in the graph.
-int ViewGraph::NumViews() const { return vertices_.size(); }
+int ViewGraph::NumViews() const { return view_id_to_vertex_index_.size(); }
 
 int ViewGraph::NumEdges() const {
-  return edges_.size();
+  return view_id_pair_to_edge_slot_.size();
 }
 
 // Returns a set of the ViewIds contained in the view graph.
 std::unordered_set<ViewId> ViewGraph::ViewIds() const {
   std::unordered_set<ViewId> view_ids;
-  view_ids.reserve(vertices_.size());
-  for (const auto& vertex : vertices_) {
+  view_ids.reserve(view_id_to_vertex_index_.size());
+  for (const auto& vertex : view_id_to_vertex_index_) {
     view_ids.insert(vertex.first);
   }
   return view_ids;
 }
 
 bool ViewGraph::HasView(const ViewId view_id) const {
-  return ContainsKey(vertices_, view_id);
+  return ContainsKey(view_id_to_vertex_index_, view_id);
 }
 
 bool ViewGraph::HasEdge(const ViewId view_id_1, const ViewId view_id_2) const {
-  const ViewIdPair view_id_pair = (view_id_1 < view_id_2)
-                                  ? ViewIdPair(view_id_1, view_id_2)
-                                  : ViewIdPair(view_id_2, view_id_1);
-  return ContainsKey(edges_, view_id_pair);
+  return FindEdgeSlot(view_id_1, view_id_2) >= 0;
 }
 
 // Removes the view from the view graph and removes all edges connected to the
 // view. Returns true on success and false if the view did not exist in the
 // view graph.
 bool ViewGraph::RemoveView(const ViewId view_id) {
-  const auto* neighbor_ids = FindOrNull(vertices_, view_id);
-  if (neighbor_ids == nullptr) {
+  const int* vertex_index = FindOrNull(view_id_to_vertex_index_, view_id);
+  if (vertex_index == nullptr) {
     return false;
   }
 
   // Remove the edges to the view from adjacent vertices.
-  for (const ViewId neighbor_id : *neighbor_ids) {
-    vertices_[neighbor_id].erase(view_id);
-    const ViewIdPair view_id_pair = (view_id < neighbor_id)
-                                        ? ViewIdPair(view_id, neighbor_id)
-                                        : ViewIdPair(neighbor_id, view_id);
-    edges_.erase(view_id_pair);
+  Vertex& vertex = vertices_[*vertex_index];
+  for (int i = 0; i < vertex.edge_slots.size(); i++) {
+    MarkEdgeSlotRemoved(vertex.edge_slots[i]);
+    PruneRemovedEdgesFromVertex(
+        FindOrDie(view_id_to_vertex_index_, vertex.neighbor_ids[i]));
   }
 
   // Remove the view as a vertex.
-  vertices_.erase(view_id);
+  vertex = Vertex();
+  view_id_to_vertex_index_.erase(view_id);
   return true;
 }
 
+int ViewGraph::RemoveViews(const std::unordered_set<ViewId>& view_ids) {
+  // Remove all of the edges first and collect the neighbors whose adjacency
+  // lists must be updated.
+  std::unordered_set<int> vertices_to_prune;
+  int num_removed_views = 0;
+  for (const ViewId view_id : view_ids) {
+    const int* vertex_index = FindOrNull(view_id_to_vertex_index_, view_id);
+    if (vertex_index == nullptr) {
+      continue;
+    }
+
+    Vertex& vertex = vertices_[*vertex_index];
+    for (int i = 0; i < vertex.edge_slots.size(); i++) {
+      MarkEdgeSlotRemoved(vertex.edge_slots[i]);
+      if (!ContainsKey(view_ids, vertex.neighbor_ids[i])) {
+        vertices_to_prune.insert(
+            FindOrDie(view_id_to_vertex_index_, vertex.neighbor_ids[i]));
+      }
+    }
+    vertex = Vertex();
+    view_id_to_vertex_index_.erase(view_id);
+    ++num_removed_views;
+  }
+
+  for (const int vertex_index : vertices_to_prune) {
+    PruneRemovedEdgesFromVertex(vertex_index);
+  }
+  return num_removed_views;
+}
+
 // Adds an edge between the two views with the edge value of
 // two_view_info. New vertices are added to the graph if they did not already
 // exist. If an edge already existed between the two views then the edge value
@@ -107,69 +146,219 @@ void ViewGraph::AddEdge(const ViewId view_id_1, const ViewId view_id_2,
     return;
   }
 
-  const ViewIdPair view_id_pair = (view_id_1 < view_id_2)
-                                      ? ViewIdPair(view_id_1, view_id_2)
-                                      : ViewIdPair(view_id_2, view_id_1);
+  all_edges_is_valid_ = false;
+  const int edge_slot = FindEdgeSlot(view_id_1, view_id_2);
+  if (edge_slot >= 0) {
+    DLOG(WARNING) << "An edge already exists between view " << view_id_1
+                  << " and view " << view_id_2;
+    edge_values_[edge_slot] = two_view_info;
+    return;
+  }
 
-  DLOG_IF(WARNING, ContainsKey(edges_, view_id_pair))
-      << "An edge already exists between view " << view_id_1 << " and view "
-      << view_id_2;
+  const ViewIdPair view_id_pair = OrderedViewIdPair(view_id_1, view_id_2);
+  const int new_edge_slot = edge_view_id_pairs_.size();
+  view_id_pair_to_edge_slot_[view_id_pair] = new_edge_slot;
+  edge_view_id_pairs_.emplace_back(view_id_pair);
+  edge_values_.emplace_back(two_view_info);
+  edge_is_removed_.emplace_back(false);
 
-  vertices_[view_id_1].insert(view_id_2);
-  vertices_[view_id_2].insert(view_id_1);
-  edges_[view_id_pair] = two_view_info;
+  Vertex& vertex1 = vertices_[FindOrAddVertex(view_id_1)];
+  vertex1.neighbor_ids.emplace_back(view_id_2);
+  vertex1.edge_slots.emplace_back(new_edge_slot);
+  Vertex& vertex2 = vertices_[FindOrAddVertex(view_id_2)];
+  vertex2.neighbor_ids.emplace_back(view_id_1);
+  vertex2.edge_slots.emplace_back(new_edge_slot);
 }
 
 // Removes the edge from the view graph. Returns true if the edge is removed
 // and false if the edge did not exist.
 bool ViewGraph::RemoveEdge(const ViewId view_id_1, const ViewId view_id_2) {
-  const ViewIdPair view_id_pair = (view_id_1 < view_id_2)
-                                      ? ViewIdPair(view_id_1, view_id_2)
-                                      : ViewIdPair(view_id_2, view_id_1);
-  if (!ContainsKey(edges_, view_id_pair)) {
+  const int edge_slot = FindEdgeSlot(view_id_1, view_id_2);
+  if (edge_slot < 0) {
     return false;
   }
 
-  // Erase the edge from each vertex.
-  if (vertices_[view_id_1].erase(view_id_2) == 0 ||
-      vertices_[view_id_2].erase(view_id_1) == 0 ||
-      edges_.erase(view_id_pair) == 0) {
-    return false;
+  MarkEdgeSlotRemoved(edge_slot);
+  PruneRemovedEdgesFromVertex(
+      FindOrDie(view_id_to_vertex_index_, view_id_1));
+  PruneRemovedEdgesFromVertex(
+      FindOrDie(view_id_to_vertex_index_, view_id_2));
+  return true;
+}
+
+int ViewGraph::RemoveEdges(
+    const std::unordered_set<ViewIdPair>& view_id_pairs) {
+  std::unordered_set<int> vertices_to_prune;
+  int num_removed_edges = 0;
+  for (const ViewIdPair& view_id_pair : view_id_pairs) {
+    const int edge_slot = FindEdgeSlot(view_id_pair.first, view_id_pair.second);
+    if (edge_slot < 0) {
+      continue;
+    }
+
+    MarkEdgeSlotRemoved(edge_slot);
+    vertices_to_prune.insert(
+        FindOrDie(view_id_to_vertex_index_, view_id_pair.first));
+    vertices_to_prune.insert(
+        FindOrDie(view_id_to_vertex_index_, view_id_pair.second));
+    ++num_removed_edges;
   }
 
-  return true;
+  for (const int vertex_index : vertices_to_prune) {
+    PruneRemovedEdgesFromVertex(vertex_index);
+  }
+  return num_removed_edges;
 }
 
 // Returns all the edges for a given
-const std::unordered_set<ViewId>* ViewGraph::GetNeighborIdsForView(
+const std::vector<ViewId>* ViewGraph::GetNeighborIdsForView(
     const ViewId view_id) const {
-  return FindOrNull(vertices_, view_id);
+  const int* vertex_index = FindOrNull(view_id_to_vertex_index_, view_id);
+  if (vertex_index == nullptr) {
+    return nullptr;
+  }
+  return &vertices_[*vertex_index].neighbor_ids;
 }
 
 // Returns the edge value or NULL if it does not exist.
 const TwoViewInfo* ViewGraph::GetEdge(const ViewId view_id_1,
                                       const ViewId view_id_2) const {
-  const ViewIdPair view_id_pair = (view_id_1 < view_id_2)
-                                      ? ViewIdPair(view_id_1, view_id_2)
-                                      : ViewIdPair(view_id_2, view_id_1);
-  return FindOrNull(edges_, view_id_pair);
+  const int edge_slot = FindEdgeSlot(view_id_1, view_id_2);
+  return (edge_slot >= 0) ? &edge_values_[edge_slot] : nullptr;
 }
 
 TwoViewInfo* ViewGraph::GetMutableEdge(const ViewId view_id_1,
                                        const ViewId view_id_2) {
-  const ViewIdPair view_id_pair = (view_id_1 < view_id_2)
-                                      ? ViewIdPair(view_id_1, view_id_2)
-                                      : ViewIdPair(view_id_2, view_id_1);
-  return FindOrNull(edges_, view_id_pair);
-}
+  const int edge_slot = FindEdgeSlot(view_id_1, view_id_2);
+  if (edge_slot < 0) {
+    return nullptr;
+  }
 
+  // The edge may be modified through the returned pointer so the map of all
+  // edges must be rebuilt.
+  all_edges_is_valid_ = false;
+  return &edge_values_[edge_slot];
+}
 
 // Returns a map of all edges. Each edge is found exactly once in the map and
 // is indexed by the ViewIdPair (view id 1, view id 2) such that view id 1 <
 // view id 2.
 const std::unordered_map<ViewIdPair, TwoViewInfo>& ViewGraph::GetAllEdges()
     const {
-  return edges_;
+  if (all_edges_is_valid_) {
+    return all_edges_;
+  }
+
+  all_edges_.clear();
+  all_edges_.reserve(NumEdges());
+  for (int i = 0; i < edge_view_id_pairs_.size(); i++) {
+    if (!edge_is_removed_[i]) {
+      all_edges_.emplace(edge_view_id_pairs_[i], edge_values_[i]);
+    }
+  }
+  all_edges_is_valid_ = true;
+  return all_edges_;
+}
+
+int ViewGraph::NumEdgeSlots() const {
+  return edge_view_id_pairs_.size();
+}
+
+bool ViewGraph::IsEdgeSlotRemoved(const int edge_slot) const {
+  return edge_is_removed_[edge_slot];
+}
+
+const ViewIdPair& ViewGraph::EdgeViewIdPair(const int edge_slot) const {
+  return edge_view_id_pairs_[edge_slot];
+}
+
+const TwoViewInfo& ViewGraph::EdgeValue(const int edge_slot) const {
+  return edge_values_[edge_slot];
+}
+
+void ViewGraph::Compact() {
+  // Move all valid edges to the front of the edge arrays.
+  std::vector<int> new_edge_slots(edge_view_id_pairs_.size(), -1);
+  int num_edges = 0;
+  for (int i = 0; i < edge_view_id_pairs_.size(); i++) {
+    if (edge_is_removed_[i]) {
+      continue;
+    }
+    if (num_edges != i) {
+      edge_view_id_pairs_[num_edges] = edge_view_id_pairs_[i];
+      edge_values_[num_edges] = edge_values_[i];
+    }
+    new_edge_slots[i] = num_edges;
+    view_id_pair_to_edge_slot_[edge_view_id_pairs_[num_edges]] = num_edges;
+    ++num_edges;
+  }
+  edge_view_id_pairs_.resize(num_edges);
+  edge_values_.resize(num_edges);
+  edge_is_removed_.assign(num_edges, false);
+
+  // Move all valid vertices to the front of the vertex array and update the
+  // edge slots of their adjacency lists.
+  int num_vertices = 0;
+  for (int i = 0; i < vertices_.size(); i++) {
+    if (vertices_[i].view_id == kInvalidViewId) {
+      continue;
+    }
+    if (num_vertices != i) {
+      vertices_[num_vertices] = std::move(vertices_[i]);
+    }
+
+    Vertex& vertex = vertices_[num_vertices];
+    for (int& edge_slot : vertex.edge_slots) {
+      edge_slot = new_edge_slots[edge_slot];
+    }
+    view_id_to_vertex_index_[vertex.view_id] = num_vertices;
+    ++num_vertices;
+  }
+  vertices_.resize(num_vertices);
+}
+
+int ViewGraph::FindEdgeSlot(const ViewId view_id_1,
+                            const ViewId view_id_2) const {
+  const int* edge_slot = FindOrNull(view_id_pair_to_edge_slot_,
+                                    OrderedViewIdPair(view_id_1, view_id_2));
+  return (edge_slot == nullptr) ? -1 : *edge_slot;
+}
+
+int ViewGraph::FindOrAddVertex(const ViewId view_id) {
+  const int* vertex_index = FindOrNull(view_id_to_vertex_index_, view_id);
+  if (vertex_index != nullptr) {
+    return *vertex_index;
+  }
+
+  const int new_vertex_index = vertices_.size();
+  vertices_.emplace_back();
+  vertices_.back().view_id = view_id;
+  view_id_to_vertex_index_[view_id] = new_vertex_index;
+  return new_vertex_index;
+}
+
+void ViewGraph::MarkEdgeSlotRemoved(const int edge_slot) {
+  if (edge_is_removed_[edge_slot]) {
+    return;
+  }
+  edge_is_removed_[edge_slot] = true;
+  view_id_pair_to_edge_slot_.erase(edge_view_id_pairs_[edge_slot]);
+  all_edges_is_valid_ = false;
+}
+
+void ViewGraph::PruneRemovedEdgesFromVertex(const int vertex_index) {
+  Vertex& vertex = vertices_[vertex_index];
+  int num_valid_edges = 0;
+  for (int i = 0; i < vertex.edge_slots.size(); i++) {
+    if (edge_is_removed_[vertex.edge_slots[i]]) {
+      continue;
+    }
+    vertex.neighbor_ids[num_valid_edges] = vertex.neighbor_ids[i];
+    vertex.edge_slots[num_valid_edges] = vertex.edge_slots[i];
+    ++num_valid_edges;
+  }
+  vertex.neighbor_ids.resize(num_valid_edges);
+  vertex.edge_slots.resize(num_valid_edges);
 }
 
 }  // namespace theia
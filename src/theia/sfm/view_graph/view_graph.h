@@ -37,6 +37,7 @@
 
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "theia/util/hash.h"
 #include "theia/sfm/twoview_info.h"
@@ -48,8 +49,12 @@ namespace theia {
 // efficienctly created by only holding view ids at the vertices and
 // TwoViewInfos for edge values.
 //
-// The implementation for an undirected view graph was insprired from:
-// https://github.com/thunghan/coursera-courses/blob/master/UC%20Santa%20Cruz%20-%20C%2B%2B%20For%20C%20Programmers/Homework%202/UndirectedGraph.hpp
+// Vertices and edges are indexed densely: the edges are stored in contiguous
+// arrays and each vertex holds a compact list of its neighbors and incident
+// edge slots. Removing an edge only marks its slot as removed (a tombstone) so
+// that removals are cheap and edge slots remain stable while the graph is being
+// filtered. The storage used by removed edges and views is reclaimed with
+// Compact().
 class ViewGraph {
  public:
   ViewGraph() {}
@@ -72,6 +77,12 @@ class ViewGraph {
   // view graph.
   bool RemoveView(const ViewId view_id);
 
+  // Removes all of the views and the edges connected to them. This is
+  // considerably faster than calling RemoveView for each view since the
+  // adjacency lists of the neighboring views are only updated once. Returns the
+  // number of views that were removed.
+  int RemoveViews(const std::unordered_set<ViewId>& view_ids);
+
   // Adds an edge between the two views with the edge value of
   // two_view_info. New vertices are added to the graph if they did not already
   // exist. If an edge already existed between the two views then the edge value
@@ -83,12 +94,17 @@ class ViewGraph {
   // and false if the edge did not exist.
   bool RemoveEdge(const ViewId view_id_1, const ViewId view_id_2);
 
+  // Removes all of the edges in a single pass over the affected adjacency
+  // lists. Edges that do not exist are ignored. Returns the number of edges that
+  // were removed.
+  int RemoveEdges(const std::unordered_set<ViewIdPair>& view_id_pairs);
+
   // Returns the neighbor view ids for a given view, or nullptr if the view does
   // not exist.
-  const std::unordered_set<ViewId>* GetNeighborIdsForView(
-      const ViewId view_id) const;
+  const std::vector<ViewId>* GetNeighborIdsForView(const ViewId view_id) const;
 
-  // Returns the edge value or NULL if it does not exist.
+  // Returns the edge value or NULL if it does not exist. The pointer is valid
+  // until the next call to AddEdge or Compact.
   const TwoViewInfo* GetEdge(const ViewId view_id_1,
                              const ViewId view_id_2) const;
 
@@ -97,14 +113,61 @@ class ViewGraph {
   // Returns a map of all edges. Each edge is found exactly once in the map and
   // is indexed by the ViewIdPair (view id 1, view id 2) such that view id 1 <
   // view id 2.
+  //
+  // NOTE: The map is assembled from the dense edge storage on demand and is
+  // rebuilt on the next call after the graph has been modified. It is cheaper
+  // to scan the edge slots below when the map itself is not needed. This method
+  // must not be called concurrently from multiple threads.
   const std::unordered_map<ViewIdPair, TwoViewInfo>& GetAllEdges() const;
 
+  // The edges may be scanned directly with the slot indices
+  // [0, NumEdgeSlots()), e.g., to split a scan over the edges among several
+  // threads. Slots of removed edges remain in the storage until Compact() is
+  // called and must be skipped. Slot indices are stable until Compact() is
+  // called.
+  int NumEdgeSlots() const;
+  bool IsEdgeSlotRemoved(const int edge_slot) const;
+  const ViewIdPair& EdgeViewIdPair(const int edge_slot) const;
+  const TwoViewInfo& EdgeValue(const int edge_slot) const;
+
+  // Reclaims the storage of removed edges and views so that the edge slots are
+  // contiguous again. This invalidates all edge slots and edge pointers.
+  void Compact();
+
  private:
-  // The underlying adjacency map. ViewIds are the vertices which are mapped to
-  // a collection of its neighbors and the edges themselves are stored
-  // separately.
-  std::unordered_map<ViewId, std::unordered_set<ViewId> > vertices_;
-  std::unordered_map<ViewIdPair, TwoViewInfo> edges_;
+  // Returns the edge slot for the view pair or -1 if the edge does not exist.
+  int FindEdgeSlot(const ViewId view_id_1, const ViewId view_id_2) const;
+
+  // Returns the index of the vertex, adding a new vertex if necessary.
+  int FindOrAddVertex(const ViewId view_id);
+
+  // Marks the edge slot as removed. The adjacency lists of the two views must
+  // be updated separately.
+  void MarkEdgeSlotRemoved(const int edge_slot);
+
+  // Removes all removed edges from the adjacency list of the vertex.
+  void PruneRemovedEdgesFromVertex(const int vertex_index);
+
+  // A vertex holds the view ids of its neighbors along with the slot of the
+  // edge to each neighbor. Removed vertices have an invalid view id.
+  struct Vertex {
+    ViewId view_id = kInvalidViewId;
+    std::vector<ViewId> neighbor_ids;
+    std::vector<int> edge_slots;
+  };
+
+  std::unordered_map<ViewId, int> view_id_to_vertex_index_;
+  std::vector<Vertex> vertices_;
+
+  // The edges are stored as parallel arrays indexed by the edge slot.
+  std::unordered_map<ViewIdPair, int> view_id_pair_to_edge_slot_;
+  std::vector<ViewIdPair> edge_view_id_pairs_;
+  std::vector<TwoViewInfo> edge_values_;
+  std::vector<bool> edge_is_removed_;
+
+  // A map of all edges that is rebuilt lazily for GetAllEdges().
+  mutable std::unordered_map<ViewIdPair, TwoViewInfo> all_edges_;
+  mutable bool all_edges_is_valid_ = false;
 };
 
 }  // namespace theia
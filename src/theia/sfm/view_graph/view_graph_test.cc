@@ -108,8 +108,11 @@ TEST(ViewGraph, AddEdge) {
   EXPECT_EQ(*edge_2_0, info2);
   EXPECT_TRUE(graph.GetEdge(2, 1) == nullptr);
 
-  const std::unordered_set<ViewId> edge_ids =
-      *graph.GetNeighborIdsForView(0);
+  const std::vector<ViewId>* neighbor_ids = graph.GetNeighborIdsForView(0);
+  EXPECT_TRUE(neighbor_ids != nullptr);
+  const std::unordered_set<ViewId> edge_ids(neighbor_ids->begin(),
+                                            neighbor_ids->end());
+  EXPECT_EQ(edge_ids.size(), 2);
   EXPECT_TRUE(ContainsKey(edge_ids, 1));
   EXPECT_TRUE(ContainsKey(edge_ids, 2));
 
@@ -141,6 +144,134 @@ TEST(ViewGraph, RemoveEdge) {
   EXPECT_TRUE(graph.RemoveEdge(0, 2));
   EXPECT_EQ(graph.NumEdges(), 1);
   EXPECT_TRUE(graph.GetEdge(0, 2) == nullptr);
+  EXPECT_FALSE(graph.RemoveEdge(0, 2));
+  EXPECT_EQ(graph.GetNeighborIdsForView(0)->size(), 1);
+  EXPECT_EQ(graph.GetNeighborIdsForView(2)->size(), 0);
+}
+
+TEST(ViewGraph, RemoveEdges) {
+  ViewGraph graph;
+  for (int i = 0; i < 5; i++) {
+    for (int j = i + 1; j < 5; j++) {
+      TwoViewInfo info;
+      info.num_verified_matches = i + j;
+      graph.AddEdge(i, j, info);
+    }
+  }
+  EXPECT_EQ(graph.NumEdges(), 10);
+
+  // Edges may be given in any order and edges that do not exist are ignored.
+  const std::unordered_set<ViewIdPair> edges_to_remove = {
+    ViewIdPair(0, 1), ViewIdPair(3, 2), ViewIdPair(0, 4), ViewIdPair(4, 10)
+  };
+  EXPECT_EQ(graph.RemoveEdges(edges_to_remove), 3);
+  EXPECT_EQ(graph.NumEdges(), 7);
+  EXPECT_EQ(graph.NumViews(), 5);
+  EXPECT_FALSE(graph.HasEdge(0, 1));
+  EXPECT_FALSE(graph.HasEdge(2, 3));
+  EXPECT_FALSE(graph.HasEdge(4, 0));
+  EXPECT_TRUE(graph.HasEdge(1, 2));
+
+  EXPECT_EQ(graph.GetNeighborIdsForView(0)->size(), 2);
+  EXPECT_EQ(graph.GetNeighborIdsForView(1)->size(), 3);
+  EXPECT_EQ(graph.GetNeighborIdsForView(2)->size(), 3);
+  EXPECT_EQ(graph.GetNeighborIdsForView(3)->size(), 3);
+  EXPECT_EQ(graph.GetNeighborIdsForView(4)->size(), 3);
+
+  // Removed edges are kept as tombstones until the graph is compacted.
+  int num_valid_edge_slots = 0;
+  for (int i = 0; i < graph.NumEdgeSlots(); i++) {
+    if (graph.IsEdgeSlotRemoved(i)) {
+      continue;
+    }
+    const ViewIdPair& view_id_pair = graph.EdgeViewIdPair(i);
+    EXPECT_LT(view_id_pair.first, view_id_pair.second);
+    EXPECT_EQ(graph.EdgeValue(i).num_verified_matches,
+              view_id_pair.first + view_id_pair.second);
+    ++num_valid_edge_slots;
+  }
+  EXPECT_EQ(num_valid_edge_slots, 7);
+  EXPECT_EQ(graph.NumEdgeSlots(), 10);
+}
+
+TEST(ViewGraph, RemoveViews) {
+  ViewGraph graph;
+  TwoViewInfo info;
+  graph.AddEdge(0, 1, info);
+  graph.AddEdge(1, 2, info);
+  graph.AddEdge(2, 3, info);
+  graph.AddEdge(3, 0, info);
+  graph.AddEdge(0, 2, info);
+
+  const std::unordered_set<ViewId> views_to_remove = { 0, 3, 7 };
+  EXPECT_EQ(graph.RemoveViews(views_to_remove), 2);
+  EXPECT_EQ(graph.NumViews(), 2);
+  EXPECT_EQ(graph.NumEdges(), 1);
+  EXPECT_FALSE(graph.HasView(0));
+  EXPECT_FALSE(graph.HasView(3));
+  EXPECT_TRUE(graph.HasEdge(1, 2));
+  EXPECT_TRUE(graph.GetNeighborIdsForView(0) == nullptr);
+  EXPECT_EQ(*graph.GetNeighborIdsForView(1), std::vector<ViewId>({ 2 }));
+  EXPECT_EQ(*graph.GetNeighborIdsForView(2), std::vector<ViewId>({ 1 }));
+}
+
+TEST(ViewGraph, Compact) {
+  ViewGraph graph;
+  for (int i = 0; i < 10; i++) {
+    TwoViewInfo info;
+    info.num_verified_matches = i;
+    graph.AddEdge(i, i + 1, info);
+  }
+  graph.RemoveView(0);
+  graph.RemoveEdge(4, 5);
+  graph.RemoveEdge(8, 9);
+  EXPECT_EQ(graph.NumEdges(), 7);
+  EXPECT_EQ(graph.NumEdgeSlots(), 10);
+
+  graph.Compact();
+  EXPECT_EQ(graph.NumViews(), 10);
+  EXPECT_EQ(graph.NumEdges(), 7);
+  EXPECT_EQ(graph.NumEdgeSlots(), 7);
+  for (int i = 0; i < graph.NumEdgeSlots(); i++) {
+    EXPECT_FALSE(graph.IsEdgeSlotRemoved(i));
+    const ViewIdPair& view_id_pair = graph.EdgeViewIdPair(i);
+    EXPECT_EQ(graph.EdgeValue(i).num_verified_matches, view_id_pair.first);
+    EXPECT_EQ(graph.GetEdge(view_id_pair.first, view_id_pair.second),
+              &graph.EdgeValue(i));
+  }
+
+  // The graph must remain fully functional after compaction.
+  EXPECT_TRUE(graph.RemoveEdge(2, 3));
+  EXPECT_TRUE(graph.RemoveView(7));
+  graph.AddEdge(0, 9, TwoViewInfo());
+  EXPECT_EQ(graph.NumViews(), 10);
+  EXPECT_EQ(graph.NumEdges(), 5);
+  EXPECT_EQ(*graph.GetNeighborIdsForView(6), std::vector<ViewId>({ 5 }));
+  EXPECT_EQ(*graph.GetNeighborIdsForView(9), std::vector<ViewId>({ 10, 0 }));
+}
+
+TEST(ViewGraph, GetAllEdges) {
+  TwoViewInfo info;
+  info.num_verified_matches = 1;
+
+  ViewGraph graph;
+  graph.AddEdge(0, 1, info);
+  graph.AddEdge(2, 1, info);
+  EXPECT_EQ(graph.GetAllEdges().size(), 2);
+  EXPECT_TRUE(ContainsKey(graph.GetAllEdges(), ViewIdPair(1, 2)));
+
+  // The map of all edges must reflect any changes to the view graph.
+  graph.GetMutableEdge(1, 0)->num_verified_matches = 5;
+  EXPECT_EQ(FindOrDie(graph.GetAllEdges(), ViewIdPair(0, 1))
+                .num_verified_matches,
+            5);
+
+  graph.RemoveEdge(1, 2);
+  graph.AddEdge(3, 4, info);
+  const auto& edges = graph.GetAllEdges();
+  EXPECT_EQ(edges.size(), 2);
+  EXPECT_TRUE(ContainsKey(edges, ViewIdPair(0, 1)));
+  EXPECT_TRUE(ContainsKey(edges, ViewIdPair(3, 4)));
 }
 
 }  // namespace theia
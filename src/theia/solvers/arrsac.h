@@ -166,25 +166,27 @@ int Arrsac<ModelEstimator>::GenerateInitialHypothesisSet(
   double rejected_accum_inlier_ratio = 0;
 
   // RandomSampler and PROSAC Sampler.
-  RandomSampler<Datum> random_sampler(this->estimator_.SampleSize());
-  ProsacSampler<Datum> prosac_sampler(this->estimator_.SampleSize());
+  RandomSampler<Datum> random_sampler(this->ransac_params_.rng,
+                                      this->estimator_.SampleSize());
+  ProsacSampler<Datum> prosac_sampler(this->ransac_params_.rng,
+                                      this->estimator_.SampleSize());
   random_sampler.Initialize();
   prosac_sampler.Initialize();
 
+  std::vector<Datum> data_subset;
+  std::vector<int> inlier_indices;
   while (k <= m_prime) {
     std::vector<Model> hypotheses;
     if (!inner_ransac) {
       // Generate hypothesis h(k) with k-th PROSAC sample.
-      std::vector<Datum> prosac_subset;
       prosac_sampler.SetSampleNumber(k);
-      prosac_sampler.Sample(data_input, &prosac_subset);
-      this->estimator_.EstimateModel(prosac_subset, &hypotheses);
+      prosac_sampler.Sample(data_input, &data_subset);
+      this->estimator_.EstimateModel(data_subset, &hypotheses);
     } else {
       // Generate hypothesis h(k) with subset generated from inliers of a
       // previous hypothesis.
-      std::vector<Datum> random_subset;
-      random_sampler.Sample(data, &random_subset);
-      this->estimator_.EstimateModel(random_subset, &hypotheses);
+      random_sampler.Sample(data, &data_subset);
+      this->estimator_.EstimateModel(data_subset, &hypotheses);
 
       inner_ransac_its++;
       if (inner_ransac_its == max_inner_ransac_its) {
@@ -196,12 +198,17 @@ int Arrsac<ModelEstimator>::GenerateInitialHypothesisSet(
     for (const Model& hypothesis : hypotheses) {
       int num_tested_points;
       double observed_inlier_ratio;
-      // Evaluate hypothesis h(k) with SPRT.
-      std::vector<double> residuals =
-          this->estimator_.Residuals(data_input, hypothesis);
+      // Evaluate hypothesis h(k) with SPRT. The residuals are only computed
+      // until the hypothesis is rejected, and the inliers are collected in the
+      // same pass.
       bool sprt_test = SequentialProbabilityRatioTest(
-          residuals, this->ransac_params_.error_thresh, sigma_, epsilon_,
-          decision_threshold, &num_tested_points, &observed_inlier_ratio);
+          data_input.size(),
+          [&](const int i) {
+            return this->estimator_.Error(data_input[i], hypothesis);
+          },
+          this->ransac_params_.error_thresh, sigma_, epsilon_,
+          decision_threshold, &num_tested_points, &observed_inlier_ratio,
+          &inlier_indices);
 
       // If the model was rejected by the SPRT test.
       if (!sprt_test) {
@@ -227,10 +234,9 @@ int Arrsac<ModelEstimator>::GenerateInitialHypothesisSet(
 
         // Set U_in = support of hypothesis h(k).
         data.clear();
-        for (int i = 0; i < data_input.size(); i++) {
-          if (this->estimator_.Error(data_input[i], hypothesis) <
-              this->ransac_params_.error_thresh)
-            data.push_back(data_input[i]);
+        data.reserve(inlier_indices.size());
+        for (const int inlier_index : inlier_indices) {
+          data.emplace_back(data_input[inlier_index]);
         }
 
         // Re-estimate params of SPRT.
@@ -271,7 +277,8 @@ bool Arrsac<ModelEstimator>::Estimate(const std::vector<Datum>& data,
     }
   }
 
-  RandomSampler<Datum> random_sampler(this->estimator_.SampleSize());
+  RandomSampler<Datum> random_sampler(this->ransac_params_.rng,
+                                      this->estimator_.SampleSize());
   random_sampler.Initialize();
 
   // Preemptive Evaluation
@@ -322,12 +329,13 @@ bool Arrsac<ModelEstimator>::Estimate(const std::vector<Datum>& data,
       // If we need more hypotheses, generate them now.
       if (temp_max_candidate_hyps > k) {
         // Generate and evaluate M' - k new hypotheses on i data points.
+        std::vector<Datum> data_random_subset;
+        std::vector<Model> estimated_models;
         for (int j = 0; j < temp_max_candidate_hyps - k; j++) {
-          std::vector<Datum> data_random_subset;
           random_sampler.Sample(data, &data_random_subset);
 
           // Estimate new hypothesis model.
-          std::vector<Model> estimated_models;
+          estimated_models.clear();
           this->estimator_.EstimateModel(data_random_subset, &estimated_models);
           for (const Model& estimated_model : estimated_models) {
             ScoredData<Model> new_hypothesis(estimated_model, 0.0);
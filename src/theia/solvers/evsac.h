@@ -70,7 +70,8 @@ class Evsac : public SampleConsensusEstimator<ModelEstimator> {
 
   bool Initialize() {
     Sampler<Datum>* prosac_sampler =
-        new EvsacSampler<Datum>(this->estimator_.SampleSize(),
+        new EvsacSampler<Datum>(this->ransac_params_.rng,
+                                this->estimator_.SampleSize(),
                                 this->sorted_distances_,
                                 this->predictor_threshold_,
                                 this->fitting_method_);
@@ -80,17 +80,28 @@ template <class Datum> class EvsacSampler : public Sampler<Datum> {
   // predictor_threshold:  The threshold used to decide correct or incorrect
   //   matches/correspondences. The recommended value is 0.65.
   // fitting_method:  The fiting method to use, i.e.,  MLE or QUANTILE_NLS.
+  // rng:  The random number generator to sample with. If null, a generator
+  //   seeded from the current time is used.
   EvsacSampler(
+      const std::shared_ptr<RandomNumberGenerator>& rng,
       const int min_num_samples,
       const Eigen::MatrixXd& sorted_distances,
       const double predictor_threshold,
       FittingMethod fitting_method)
-      : Sampler<Datum>(min_num_samples), sorted_distances_(sorted_distances),
+      : Sampler<Datum>(rng, min_num_samples),
+        sorted_distances_(sorted_distances),
         predictor_threshold_(predictor_threshold),
         fitting_method_(fitting_method) {
     CHECK_GT(predictor_threshold_, 0.0);
     CHECK_LE(predictor_threshold_, 1.0);
   }
+  EvsacSampler(
+      const int min_num_samples,
+      const Eigen::MatrixXd& sorted_distances,
+      const double predictor_threshold,
+      FittingMethod fitting_method)
+      : EvsacSampler(nullptr, min_num_samples, sorted_distances,
+                     predictor_threshold, fitting_method) {}
 
   ~EvsacSampler(void) {}
 
@@ -173,9 +184,9 @@ template <class Datum> class EvsacSampler : public Sampler<Datum> {
       std::vector<float>* probabilities,
       std::vector<float>* sampling_weights);
 
-  // Implementing the Sample method.
-  bool Sample(
-      const std::vector<Datum>& data, std::vector<Datum>* subset) override;
+  // Implementing the SampleIndices method.
+  bool SampleIndices(const int num_data,
+                     std::vector<int>* sample_indices) override;
 
   // Implementing the Initialize method.
   bool Initialize() override;
@@ -191,8 +202,6 @@ template <class Datum> class EvsacSampler : public Sampler<Datum> {
   FittingMethod fitting_method_;
   // Correspondence sampler following the computed probabilities.
   std::unique_ptr<std::discrete_distribution<>> correspondence_sampler_;
-  // RNG
-  std::mt19937 rng_;
   // Mixture Model Params.
   MixtureModelParams mixture_model_params_;
 
@@ -626,10 +635,6 @@ bool EvsacSampler<Datum>::Initialize() {
   CHECK_GT(this->sorted_distances_.rows(), 0);
   CHECK_GT(this->sorted_distances_.cols(), 0);
 
-  // Initialize RNG.
-  std::random_device rd;
-  rng_.seed(rd());
-
   // Calculate Mixture model.
   std::vector<float> probabilities;
   std::vector<float> sampling_weights;
@@ -648,20 +653,18 @@ bool EvsacSampler<Datum>::Initialize() {
 }
 
 template <class Datum>
-bool EvsacSampler<Datum>::Sample(const std::vector<Datum>& data,
-                                 std::vector<Datum>* subset) {
-  CHECK_EQ(data.size(), sorted_distances_.rows());
-  CHECK_NOTNULL(subset)->resize(this->min_num_samples_);
-  std::vector<int> random_numbers;
+bool EvsacSampler<Datum>::SampleIndices(const int num_data,
+                                        std::vector<int>* sample_indices) {
+  CHECK_EQ(num_data, sorted_distances_.rows());
+  CHECK_NOTNULL(sample_indices)->clear();
   for (int i = 0; i < this->min_num_samples_; i++) {
     int rand_number;
     // Generate a random number that has not already been used.
-    while (std::find(random_numbers.begin(), random_numbers.end(),
-                     (rand_number = (*correspondence_sampler_)(rng_)))
-           != random_numbers.end()) {}
+    while (std::find(sample_indices->begin(), sample_indices->end(),
+                     (rand_number = (*correspondence_sampler_)(*this->rng_)))
+           != sample_indices->end()) {}
 
-    random_numbers.push_back(rand_number);
-    subset->at(i) = data[rand_number];
+    sample_indices->emplace_back(rand_number);
   }
   return true;
 }
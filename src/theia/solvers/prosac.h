@@ -60,9 +60,83 @@ class Prosac : public SampleConsensusEstimator<ModelEstimator> {
 
   bool Initialize() {
     Sampler<Datum>* prosac_sampler =
-        new ProsacSampler<Datum>(this->estimator_.SampleSize());
+        new ProsacSampler<Datum>(this->ransac_params_.rng,
+                                 this->estimator_.SampleSize());
     return SampleConsensusEstimator<ModelEstimator>::Initialize(prosac_sampler);
   }
+
+ protected:
+  // PROSAC terminates once it is unlikely that a model with more inliers among
+  // the top n data points exists for any n (the maximality constraint in
+  // Section 2.2 of Chum and Matas). Since the best data points are sampled
+  // first, a few good data points at the top of the list suffice to terminate
+  // even if the inlier ratio of all data is low. Only sets of top data points
+  // whose number of inliers is unlikely to be due to chance are considered (the
+  // non-randomness constraint).
+  int ComputeMaxIterationsForInliers(
+      const int num_data,
+      const std::vector<int>& inlier_indices,
+      const double log_failure_prob) const override {
+    // The probability that a data point that is not part of the sample is
+    // consistent with an incorrect model.
+    static const double kRandomInlierProbability = 0.05;
+    // The 0.95 quantile of the chi-square distribution with one degree of
+    // freedom, i.e., the number of inliers is random with probability < 5%.
+    static const double kNonRandomnessChiSquareQuantile = 3.841;
+    // Small sets of top data points are not considered because a model
+    // estimated from a few (e.g., nearby) data points may fit all of them while
+    // being far off for the rest of the data.
+    static const int kMinNumTopDataPoints = 20;
+
+    const int sample_size = this->estimator_.SampleSize();
+    int max_iterations = this->ComputeMaxIterations(
+        sample_size,
+        static_cast<double>(inlier_indices.size()) / num_data,
+        log_failure_prob);
+
+    // The inlier indices are sorted, so the number of inliers among the top n
+    // data points can be counted incrementally.
+    int num_inliers = 0;
+    for (int n = sample_size + 1; n <= num_data; n++) {
+      while (num_inliers < inlier_indices.size() &&
+             inlier_indices[num_inliers] < n) {
+        ++num_inliers;
+      }
+      if (n < kMinNumTopDataPoints) {
+        continue;
+      }
+
+      // Non-randomness (Eq. 9): the number of inliers must exceed the number
+      // of inliers of a random model by a significant margin.
+      const double mean = (n - sample_size) * kRandomInlierProbability;
+      const double variance = mean * (1.0 - kRandomInlierProbability);
+      const double min_num_inliers =
+          sample_size + mean +
+          std::sqrt(kNonRandomnessChiSquareQuantile * variance);
+      if (num_inliers < min_num_inliers) {
+        continue;
+      }
+
+      // Maximality (Eq. 10): the probability of sampling only inliers from
+      // the top n data points.
+      double all_inliers_probability = 1.0;
+      for (int j = 0; j < sample_size; j++) {
+        all_inliers_probability *=
+            static_cast<double>(num_inliers - j) / (n - j);
+      }
+      if (all_inliers_probability >= 1.0) {
+        return this->ransac_params_.min_iterations;
+      }
+      const double num_iterations =
+          log_failure_prob / std::log(1.0 - all_inliers_probability);
+      if (num_iterations < max_iterations) {
+        max_iterations = std::max(
+            static_cast<double>(this->ransac_params_.min_iterations),
+            num_iterations);
+      }
+    }
+    return max_iterations;
+  }
 };
 }  // namespace theia
 
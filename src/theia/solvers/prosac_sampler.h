@@ -38,6 +38,7 @@
 #include <glog/logging.h>
 #include <stdlib.h>
 #include <algorithm>
+#include <memory>
 #include <random>
 #include <vector>
 
@@ -49,6 +50,9 @@ namespace theia {
 // - Progressive Sampling Consensus" by Chum and Matas.
 template <class Datum> class ProsacSampler : public Sampler<Datum> {
  public:
+  ProsacSampler(const std::shared_ptr<RandomNumberGenerator>& rng,
+                const int min_num_samples)
+      : Sampler<Datum>(rng, min_num_samples) {}
   explicit ProsacSampler(const int min_num_samples)
       : Sampler<Datum>(min_num_samples) {}
   ~ProsacSampler() {}
@@ -56,30 +60,33 @@ template <class Datum> class ProsacSampler : public Sampler<Datum> {
   bool Initialize() {
     ransac_convergence_iterations_ = 20000;
     kth_sample_number_ = 1;
-    InitRandomGenerator();
     return true;
   }
 
   // Set the sample such that you are sampling the kth prosac sample (Eq. 6).
   void SetSampleNumber(int k) { kth_sample_number_ = k; }
 
-  // Samples the input variable data and fills the vector subset with the prosac
-  // samples.
+  // Samples the indices of the prosac sample into the data.
   // NOTE: This assumes that data is in sorted order by quality where data[i] is
   // of higher quality than data[j] for all i < j.
-  bool Sample(const std::vector<Datum>& data, std::vector<Datum>* subset) {
+  bool SampleIndices(const int num_data,
+                     std::vector<int>* sample_indices) override {
+    if (num_data < this->min_num_samples_) {
+      return false;
+    }
+
     // Set t_n according to the PROSAC paper's recommendation.
     double t_n = ransac_convergence_iterations_;
     int n = this->min_num_samples_;
     // From Equations leading up to Eq 3 in Chum et al.
     for (int i = 0; i < this->min_num_samples_; i++) {
-      t_n *= static_cast<double>(n - i) / (data.size() - i);
+      t_n *= static_cast<double>(n - i) / (num_data - i);
     }
 
     double t_n_prime = 1.0;
     // Choose min n such that T_n_prime >= t (Eq. 5).
     for (int t = 1; t <= kth_sample_number_; t++) {
-      if (t > t_n_prime && n < data.size()) {
+      if (t > t_n_prime && n < num_data) {
         double t_n_plus1 =
             (t_n * (n + 1.0)) / (n + 1.0 - this->min_num_samples_);
         t_n_prime += ceil(t_n_plus1 - t_n);
@@ -87,42 +94,18 @@ template <class Datum> class ProsacSampler : public Sampler<Datum> {
         n++;
       }
     }
-    subset->reserve(this->min_num_samples_);
+
+    sample_indices->clear();
     if (t_n_prime < kth_sample_number_) {
       // Randomly sample m data points from the top n data points.
-      std::vector<int> random_numbers;
-      for (int i = 0; i < this->min_num_samples_; i++) {
-        // Generate a random number that has not already been used.
-        int rand_number;
-        while (std::find(random_numbers.begin(), random_numbers.end(),
-                         (rand_number = RandInt(0, n - 1))) !=
-               random_numbers.end()) {
-        }
-
-        random_numbers.push_back(rand_number);
-
-        // Push the *unique* random index back.
-        subset->push_back(data[rand_number]);
-      }
+      SampleUniqueIndices(n, this->min_num_samples_, sample_indices);
     } else {
-      std::vector<int> random_numbers;
       // Randomly sample m-1 data points from the top n-1 data points.
-      for (int i = 0; i < this->min_num_samples_ - 1; i++) {
-        // Generate a random number that has not already been used.
-        int rand_number;
-        while (std::find(random_numbers.begin(), random_numbers.end(),
-                         (rand_number = RandInt(0, n - 2))) !=
-               random_numbers.end()) {
-        }
-        random_numbers.push_back(rand_number);
-
-        // Push the *unique* random index back.
-        subset->push_back(data[rand_number]);
-      }
+      SampleUniqueIndices(n - 1, this->min_num_samples_ - 1, sample_indices);
       // Make the last point from the nth position.
-      subset->push_back(data[n]);
+      sample_indices->emplace_back(n - 1);
     }
-    CHECK_EQ(subset->size(), this->min_num_samples_)
+    CHECK_EQ(sample_indices->size(), this->min_num_samples_)
         << "Prosac subset is incorrect "
         << "size!";
     kth_sample_number_++;
@@ -130,6 +113,21 @@ template <class Datum> class ProsacSampler : public Sampler<Datum> {
   }
 
  private:
+  // Appends num_samples unique random indices in [0, num_indices) to indices.
+  void SampleUniqueIndices(const int num_indices,
+                           const int num_samples,
+                           std::vector<int>* indices) {
+    for (int i = 0; i < num_samples; i++) {
+      // Generate a random number that has not already been used.
+      int rand_number;
+      while (std::find(indices->begin(), indices->end(),
+                       (rand_number = this->rng_->RandInt(0, num_indices - 1)))
+             != indices->end()) {
+      }
+      indices->emplace_back(rand_number);
+    }
+  }
+
   // Number of iterations of PROSAC before it just acts like ransac.
   int ransac_convergence_iterations_;
 
@@ -33,13 +33,16 @@
 // Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
 
 #include <math.h>
+#include <memory>
 #include <random>
 
 #include "gtest/gtest.h"
 
 #include "theia/solvers/estimator.h"
 #include "theia/solvers/prosac.h"
+#include "theia/solvers/ransac.h"
 #include "theia/test/test_utils.h"
+#include "theia/util/random.h"
 
 namespace theia {
 namespace {
@@ -118,4 +121,49 @@ TEST(ProsacTest, LineFitting) {
   ASSERT_LT(fabs(line.m - 1.0), 0.1);
 }
 
+TEST(ProsacTest, TerminatesEarlyWithGoodDataFirst) {
+  // The first 200 points lie on y = x and the remaining points are random, so
+  // the inlier ratio of all data is only 10%. The ranking of the inliers does
+  // not depend on their position along the line.
+  std::default_random_engine generator(91);
+  std::normal_distribution<double> small_distribution(0.0, 0.05);
+  std::uniform_real_distribution<double> outlier_distribution(0.0, 2000.0);
+  const int num_points = 2000;
+  std::vector<Point> input_points(num_points);
+  for (int i = 0; i < num_points; ++i) {
+    if (i < 200) {
+      const double x = outlier_distribution(generator);
+      input_points[i] = Point(x + small_distribution(generator),
+                              x + small_distribution(generator));
+    } else {
+      input_points[i] = Point(outlier_distribution(generator),
+                              outlier_distribution(generator));
+    }
+  }
+
+  LineEstimator line_estimator;
+  RansacParameters params;
+  params.error_thresh = 0.5;
+  params.min_iterations = 1;
+  params.rng = std::make_shared<RandomNumberGenerator>(57);
+
+  // RANSAC needs the number of iterations for an inlier ratio of 10%.
+  Ransac<LineEstimator> ransac_line(params, line_estimator);
+  ransac_line.Initialize();
+  Line ransac_line_model;
+  RansacSummary ransac_summary;
+  ransac_line.Estimate(input_points, &ransac_line_model, &ransac_summary);
+
+  // PROSAC samples the top points first and terminates once the inlier ratio
+  // among them makes a better model unlikely.
+  Prosac<LineEstimator> prosac_line(params, line_estimator);
+  prosac_line.Initialize();
+  Line line;
+  RansacSummary summary;
+  prosac_line.Estimate(input_points, &line, &summary);
+  EXPECT_LT(fabs(line.m - 1.0), 0.1);
+  EXPECT_GE(summary.inliers.size(), 200);
+  EXPECT_LT(summary.num_iterations, ransac_summary.num_iterations / 10);
+}
+
 }  // namespace theia
@@ -35,9 +35,8 @@
 #ifndef THEIA_SOLVERS_RANDOM_SAMPLER_H_
 #define THEIA_SOLVERS_RANDOM_SAMPLER_H_
 
-#include <stdlib.h>
 #include <algorithm>
-#include <numeric>
+#include <memory>
 #include <vector>
 
 #include "theia/solvers/sampler.h"
@@ -46,31 +45,39 @@
 namespace theia {
 
 // Random sampler used for RANSAC. This is guaranteed to generate a unique
-// sample by performing a Fisher-Yates sampling.
+// sample. The indices are drawn with Floyd's algorithm, which takes O(k^2)
+// time for a sample of size k regardless of the number of data points (k is
+// tiny for minimal samples) instead of shuffling an array of all indices.
 template <class Datum> class RandomSampler : public Sampler<Datum> {
  public:
+  RandomSampler(const std::shared_ptr<RandomNumberGenerator>& rng,
+                const int min_num_samples)
+      : Sampler<Datum>(rng, min_num_samples) {}
   explicit RandomSampler(const int min_num_samples)
       : Sampler<Datum>(min_num_samples) {}
   ~RandomSampler() {}
 
-  bool Initialize() override {
-    InitRandomGenerator();
-    return true;
-  }
+  bool Initialize() override { return true; }
 
-  // Samples the input variable data and fills the vector subset with the
-  // random samples.
-  bool Sample(const std::vector<Datum>& data,
-              std::vector<Datum>* subset) override {
-    subset->resize(this->min_num_samples_);
-    std::vector<int> random_numbers(data.size());
-    std::iota(random_numbers.begin(), random_numbers.end(), 0);
-
-    for (int i = 0; i < this->min_num_samples_; i++) {
-      std::swap(random_numbers[i], random_numbers[RandInt(i, data.size() - 1)]);
-      (*subset)[i] = data[random_numbers[i]];
+  // Samples unique random indices into the data.
+  bool SampleIndices(const int num_data,
+                     std::vector<int>* sample_indices) override {
+    if (num_data < this->min_num_samples_) {
+      return false;
     }
 
+    // For each j in [n - k, n), draw an index in [0, j] and take j instead if
+    // the index was already chosen. Every subset of size k is equally likely.
+    sample_indices->clear();
+    for (int j = num_data - this->min_num_samples_; j < num_data; j++) {
+      const int index = this->rng_->RandInt(0, j);
+      if (std::find(sample_indices->begin(), sample_indices->end(), index) ==
+          sample_indices->end()) {
+        sample_indices->emplace_back(index);
+      } else {
+        sample_indices->emplace_back(j);
+      }
+    }
     return true;
   }
 };
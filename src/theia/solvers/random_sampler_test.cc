@@ -34,10 +34,12 @@
 
 #include <glog/logging.h>
 #include <algorithm>
+#include <memory>
 #include <vector>
 
 #include "gtest/gtest.h"
 #include "theia/solvers/random_sampler.h"
+#include "theia/util/random.h"
 
 namespace theia {
 
@@ -66,4 +68,56 @@ TEST(RandomSampler, UniqueMinimalSample) {
   }
 }
 
+TEST(RandomSampler, SampleIndicesInRange) {
+  static const int kMinNumSamples = 5;
+  static const int kNumData = 20;
+  RandomSampler<int> sampler(std::make_shared<RandomNumberGenerator>(57),
+                             kMinNumSamples);
+  CHECK(sampler.Initialize());
+  std::vector<int> sample_indices;
+  for (int i = 0; i < 100; i++) {
+    EXPECT_TRUE(sampler.SampleIndices(kNumData, &sample_indices));
+    EXPECT_EQ(sample_indices.size(), kMinNumSamples);
+    EXPECT_TRUE(IsUnique(sample_indices));
+    for (const int index : sample_indices) {
+      EXPECT_GE(index, 0);
+      EXPECT_LT(index, kNumData);
+    }
+  }
+
+  // A sample of all data points must contain every index.
+  EXPECT_TRUE(sampler.SampleIndices(kMinNumSamples, &sample_indices));
+  std::sort(sample_indices.begin(), sample_indices.end());
+  for (int i = 0; i < kMinNumSamples; i++) {
+    EXPECT_EQ(sample_indices[i], i);
+  }
+
+  // Not enough data points to sample from.
+  EXPECT_FALSE(sampler.SampleIndices(kMinNumSamples - 1, &sample_indices));
+}
+
+TEST(RandomSampler, UniformSampling) {
+  static const int kMinNumSamples = 3;
+  static const int kNumData = 10;
+  static const int kNumTrials = 30000;
+  RandomSampler<int> sampler(std::make_shared<RandomNumberGenerator>(57),
+                             kMinNumSamples);
+  CHECK(sampler.Initialize());
+  std::vector<int> histogram(kNumData, 0);
+  std::vector<int> sample_indices;
+  for (int i = 0; i < kNumTrials; i++) {
+    EXPECT_TRUE(sampler.SampleIndices(kNumData, &sample_indices));
+    for (const int index : sample_indices) {
+      ++histogram[index];
+    }
+  }
+
+  // Each index should be sampled with probability k / n.
+  const double expected_count =
+      static_cast<double>(kNumTrials * kMinNumSamples) / kNumData;
+  for (const int count : histogram) {
+    EXPECT_NEAR(count, expected_count, 0.05 * expected_count);
+  }
+}
+
 }  // namespace theia
@@ -134,4 +134,32 @@ TEST(RansacTest, TerminationNumInliers) {
   ransac_line.Estimate(input_points, &line, &summary);
   ASSERT_GE(summary.inliers.size(), 2500);
 }
+
+TEST(RansacTest, LineFittingWithSPRT) {
+  // Create a set of points along y=x with a small random pertubation.
+  std::vector<Point> input_points;
+  for (int i = 0; i < 10000; ++i) {
+    if (i % 2 == 0) {
+      double noise_x = RandGaussian(0.0, 0.1);
+      double noise_y = RandGaussian(0.0, 0.1);
+      input_points.push_back(Point(i + noise_x, i + noise_y));
+    } else {
+      double noise_x = RandDouble(0.0, 10000);
+      double noise_y = RandDouble(0.0, 10000);
+      input_points.push_back(Point(noise_x, noise_y));
+    }
+  }
+
+  LineEstimator line_estimator;
+  Line line;
+  RansacParameters params;
+  params.error_thresh = 0.5;
+  params.use_sprt = true;
+  Ransac<LineEstimator> ransac_line(params, line_estimator);
+  ransac_line.Initialize();
+  RansacSummary summary;
+  CHECK(ransac_line.Estimate(input_points, &line, &summary));
+  ASSERT_LT(fabs(line.m - 1.0), 0.1);
+  ASSERT_GE(summary.inliers.size(), 2500);
+}
 }  // namespace theia
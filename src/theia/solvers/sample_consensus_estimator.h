@@ -38,15 +38,19 @@
 #include <glog/logging.h>
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <limits>
 #include <memory>
 #include <vector>
 
+#include "theia/math/probability/sequential_probability_ratio.h"
 #include "theia/solvers/estimator.h"
 #include "theia/solvers/inlier_support.h"
 #include "theia/solvers/mle_quality_measurement.h"
 #include "theia/solvers/quality_measurement.h"
 #include "theia/solvers/sampler.h"
+#include "theia/util/profiler.h"
+#include "theia/util/random.h"
 
 namespace theia {
 
@@ -62,7 +66,8 @@ struct RansacParameters {
         min_iterations(100),
         max_iterations(std::numeric_limits<int>::max()),
         use_mle(false),
-        use_Tdd_test(false) {}
+        use_Tdd_test(false),
+        use_sprt(false) {}
 
   // Error threshold to determin inliers for RANSAC (e.g., squared reprojection
   // error). This is what will be used by the estimator to determine inliers.
@@ -107,6 +112,21 @@ struct RansacParameters {
   //
   // NOTE: Not currently implemented!
   bool use_Tdd_test;
+
+  // Whether to verify the models with the Sequential Probability Ratio Test of
+  // Matas and Chum: Randomized RANSAC with Sequential Probability Ratio Test,
+  // ICCV 2005. The residuals of a model are evaluated one data point at a time
+  // and the model is rejected as soon as it is unlikely to be good, so most bad
+  // models are rejected after a few dozen residuals instead of the residuals of
+  // all data points. The SPRT parameters are estimated as RANSAC progresses.
+  // Note that a good model is rejected with a small probability.
+  bool use_sprt;
+
+  // The random number generator used to draw the samples. Set this to a seeded
+  // generator to reproduce the results. Estimators that run in parallel must
+  // not share a generator. If null, each sampler uses a generator that is
+  // seeded from the current time.
+  std::shared_ptr<RandomNumberGenerator> rng;
 };
 
 // A struct to hold useful outputs of Ransac-like methods.
@@ -161,6 +181,14 @@ template <class ModelEstimator> class SampleConsensusEstimator {
                            const double inlier_ratio,
                            const double log_failure_prob) const;
 
+  // Computes the maximum number of iterations given the inliers of the best
+  // model found so far. By default, this uses the inlier ratio of all data.
+  // Methods that do not sample uniformly (e.g., PROSAC) may override this.
+  virtual int ComputeMaxIterationsForInliers(
+      const int num_data,
+      const std::vector<int>& inlier_indices,
+      const double log_failure_prob) const;
+
   // The sampling strategy.
   std::unique_ptr<Sampler<Datum> > sampler_;
 
@@ -239,6 +267,18 @@ int SampleConsensusEstimator<ModelEstimator>::ComputeMaxIterations(
                            static_cast<double>(ransac_params_.max_iterations)));
 }
 
+template <class ModelEstimator>
+int SampleConsensusEstimator<ModelEstimator>::ComputeMaxIterationsForInliers(
+    const int num_data,
+    const std::vector<int>& inlier_indices,
+    const double log_failure_prob) const {
+  const double inlier_ratio =
+      static_cast<double>(inlier_indices.size()) / num_data;
+  return ComputeMaxIterations(estimator_.SampleSize(),
+                              inlier_ratio,
+                              log_failure_prob);
+}
+
 template <class ModelEstimator>
 bool SampleConsensusEstimator<ModelEstimator>::Estimate(
     const std::vector<Datum>& data,
@@ -250,6 +290,7 @@ bool SampleConsensusEstimator<ModelEstimator>::Estimate(
   CHECK_NOTNULL(quality_measurement_.get());
   CHECK_NOTNULL(summary);
   CHECK_NOTNULL(best_model);
+  ScopedProfile profile("SampleConsensusEstimator");
 
   const double log_failure_prob = log(ransac_params_.failure_probability);
   double best_cost = std::numeric_limits<double>::max();
@@ -264,26 +305,78 @@ bool SampleConsensusEstimator<ModelEstimator>::Estimate(
         ransac_params_.max_iterations);
   }
 
+  // The subset and models are reused across iterations so that the hot loop
+  // does not allocate memory for every sample.
+  std::vector<Datum> data_subset;
+  std::vector<Model> temp_models;
+  std::vector<double> residuals;
+
+  // SPRT parameters: the probability that a data point is consistent with a
+  // bad model (sigma) and the inlier ratio of a good model (epsilon). sigma is
+  // estimated from the rejected models and epsilon from the best model so far.
+  static const double kInitialSPRTSigma = 0.05;
+  static const double kInitialSPRTEpsilon = 0.1;
+  double sprt_sigma = kInitialSPRTSigma;
+  double sprt_epsilon = std::max(ransac_params_.min_inlier_ratio,
+                                 kInitialSPRTEpsilon);
+  double sprt_decision_threshold =
+      CalculateSPRTDecisionThreshold(sprt_sigma, sprt_epsilon);
+  double rejected_accum_inlier_ratio = 0;
+  int num_rejected_models = 0;
+  int64_t num_residual_evaluations = 0;
   for (summary->num_iterations = 0;
        summary->num_iterations < max_iterations;
        summary->num_iterations++) {
     // Sample subset. Proceed if successfully sampled.
-    std::vector<Datum> data_subset;
     if (!sampler_->Sample(data, &data_subset)) {
       continue;
     }
 
     // Estimate model from subset. Skip to next iteration if the model fails to
     // estimate.
-    std::vector<Model> temp_models;
+    temp_models.clear();
     if (!estimator_.EstimateModel(data_subset, &temp_models)) {
       continue;
     }
 
     // Calculate residuals from estimated model.
     for (const Model& temp_model : temp_models) {
-      const std::vector<double> residuals =
-          estimator_.Residuals(data, temp_model);
+      if (ransac_params_.use_sprt) {
+        // Evaluate the residuals one at a time and skip the model as soon as
+        // the SPRT rejects it.
+        residuals.resize(data.size());
+        int num_tested_points;
+        double observed_inlier_ratio;
+        const bool sprt_accepted = SequentialProbabilityRatioTest(
+            data.size(),
+            [&](const int i) {
+              residuals[i] = estimator_.Error(data[i], temp_model);
+              return residuals[i];
+            },
+            ransac_params_.error_thresh,
+            sprt_sigma,
+            sprt_epsilon,
+            sprt_decision_threshold,
+            &num_tested_points,
+            &observed_inlier_ratio,
+            nullptr);
+        num_residual_evaluations += num_tested_points;
+        if (!sprt_accepted) {
+          rejected_accum_inlier_ratio += observed_inlier_ratio;
+          ++num_rejected_models;
+          const double sigma =
+              rejected_accum_inlier_ratio / num_rejected_models;
+          if (sigma > 0 && sigma < sprt_epsilon) {
+            sprt_sigma = sigma;
+            sprt_decision_threshold =
+                CalculateSPRTDecisionThreshold(sprt_sigma, sprt_epsilon);
+          }
+          continue;
+        }
+      } else {
+        residuals = estimator_.Residuals(data, temp_model);
+        num_residual_evaluations += data.size();
+      }
 
       // Determine cost of the generated model.
       std::vector<int> inlier_indices;
@@ -302,12 +395,20 @@ bool SampleConsensusEstimator<ModelEstimator>::Estimate(
           continue;
         }
 
+        if (ransac_params_.use_sprt && inlier_ratio > sprt_epsilon &&
+            inlier_ratio < 1.0) {
+          sprt_epsilon = inlier_ratio;
+          sprt_decision_threshold =
+              CalculateSPRTDecisionThreshold(sprt_sigma, sprt_epsilon);
+        }
+
         // A better cost does not guarantee a higher inlier ratio (i.e, the MLE
         // case) so we only update the max iterations if the number decreases.
-        max_iterations = std::min(ComputeMaxIterations(estimator_.SampleSize(),
-                                                       inlier_ratio,
-                                                       log_failure_prob),
-                                  max_iterations);
+        max_iterations = std::min(
+            ComputeMaxIterationsForInliers(data.size(),
+                                           inlier_indices,
+                                           log_failure_prob),
+            max_iterations);
 
         VLOG(3) << "Inlier ratio = " << inlier_ratio
                 << " and max number of iterations = " << max_iterations;
@@ -326,6 +427,9 @@ bool SampleConsensusEstimator<ModelEstimator>::Estimate(
       1.0 - pow(1.0 - pow(inlier_ratio, estimator_.SampleSize()),
                 summary->num_iterations);
 
+  AddProfileCount("ransac_iterations", summary->num_iterations);
+  AddProfileCount("ransac_residual_evaluations",
+                  num_residual_evaluations + data.size());
   return true;
 }
 
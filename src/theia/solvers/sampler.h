@@ -35,28 +35,59 @@
 #ifndef THEIA_SOLVERS_SAMPLER_H_
 #define THEIA_SOLVERS_SAMPLER_H_
 
+#include <memory>
 #include <vector>
 
+#include "theia/util/random.h"
+
 namespace theia {
 // Purely virtual class used for the sampling consensus methods (e.g. Ransac,
 // Prosac, MLESac, etc.)
 template <class Datum> class Sampler {
  public:
+  // The random numbers are drawn from rng, which allows the samples to be
+  // reproduced. If rng is null, a generator seeded from the current time is
+  // used.
+  Sampler(const std::shared_ptr<RandomNumberGenerator>& rng,
+          const int min_num_samples)
+      : rng_(rng ? rng : std::make_shared<RandomNumberGenerator>()),
+        min_num_samples_(min_num_samples) {}
   explicit Sampler(const int min_num_samples)
-      : min_num_samples_(min_num_samples) {}
+      : Sampler(nullptr, min_num_samples) {}
 
   // Initializes any non-trivial variables and sets up sampler if
   // necessary. Must be called before Sample is called.
   virtual bool Initialize() = 0;
 
   virtual ~Sampler() {}
+
+  // Samples min_num_samples_ unique indices of data points in [0, num_data)
+  // and writes them to sample_indices. The vector is resized to the sample
+  // size, so reusing it across calls avoids allocating memory for every
+  // sample.
+  virtual bool SampleIndices(const int num_data,
+                             std::vector<int>* sample_indices) = 0;
+
   // Samples the input variable data and fills the vector subset with the
-  // samples.
+  // samples. Like the indices, the subset may be reused across calls.
   virtual bool Sample(const std::vector<Datum>& data,
-                      std::vector<Datum>* subset) = 0;
+                      std::vector<Datum>* subset) {
+    if (!SampleIndices(data.size(), &sample_indices_)) {
+      return false;
+    }
+    subset->resize(sample_indices_.size());
+    for (int i = 0; i < sample_indices_.size(); i++) {
+      (*subset)[i] = data[sample_indices_[i]];
+    }
+    return true;
+  }
 
  protected:
+  std::shared_ptr<RandomNumberGenerator> rng_;
   int min_num_samples_;
+
+ private:
+  std::vector<int> sample_indices_;
 };
 
 }  // namespace theia
@@ -0,0 +1,348 @@
+// Copyright (C) 2014 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include "theia/util/profiler.h"
+
+#include <glog/logging.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <fstream>  // NOLINT
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "theia/util/stringprintf.h"
+
+namespace theia {
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// A stage that was opened on a thread. The parent is the index of the
+// enclosing stage in the same thread buffer, so parents always precede their
+// children.
+struct ProfileEvent {
+  const char* name;
+  int parent;
+  int64_t start_in_microseconds;
+  int64_t end_in_microseconds;
+};
+
+}  // namespace
+
+// The buffer that a single thread records its stages and counters into. The
+// mutex is only contended while a report is written. The counters are keyed by
+// the pointers of their names and merged by name when they are reported.
+struct ThreadProfile {
+  int thread_index;
+  std::mutex mutex;
+  std::vector<ProfileEvent> events;
+  std::vector<int> open_events;
+  std::unordered_map<const char*, int64_t> counters;
+};
+
+namespace {
+
+struct ProfilerState {
+  std::atomic<bool> enabled;
+  Clock::time_point start_time;
+  std::mutex mutex;
+  std::vector<std::unique_ptr<ThreadProfile> > thread_profiles;
+};
+
+// The state is never destroyed so that it may be used by threads that outlive
+// the static objects.
+ProfilerState* GetProfilerState() {
+  static ProfilerState* state = [] {
+    ProfilerState* state = new ProfilerState;
+    state->enabled = false;
+    state->start_time = Clock::now();
+    return state;
+  }();
+  return state;
+}
+
+// Returns the buffer of the calling thread, creating it on the first call. The
+// state lock is only taken to register the buffer of a new thread.
+ThreadProfile* GetThreadProfile() {
+  static thread_local ThreadProfile* thread_profile = nullptr;
+  if (thread_profile != nullptr) {
+    return thread_profile;
+  }
+
+  ProfilerState* state = GetProfilerState();
+  std::lock_guard<std::mutex> lock(state->mutex);
+  state->thread_profiles.emplace_back(new ThreadProfile);
+  thread_profile = state->thread_profiles.back().get();
+  thread_profile->thread_index = state->thread_profiles.size() - 1;
+  return thread_profile;
+}
+
+int64_t MicrosecondsSinceStart() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             Clock::now() - GetProfilerState()->start_time)
+      .count();
+}
+
+std::string EscapeJsonString(const std::string& str) {
+  std::string escaped;
+  escaped.reserve(str.size());
+  for (const char c : str) {
+    if (c == '"' || c == '\\') {
+      escaped.push_back('\\');
+      escaped.push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      escaped += StringPrintf("\\u%04x", c);
+    } else {
+      escaped.push_back(c);
+    }
+  }
+  return escaped;
+}
+
+// Calls the function with each thread buffer locked in turn.
+template <typename Function>
+void ForEachThreadProfile(const Function& function) {
+  ProfilerState* state = GetProfilerState();
+  std::lock_guard<std::mutex> state_lock(state->mutex);
+  for (const auto& thread_profile : state->thread_profiles) {
+    std::lock_guard<std::mutex> lock(thread_profile->mutex);
+    function(*thread_profile);
+  }
+}
+
+}  // namespace
+
+void EnableProfiling() {
+  GetProfilerState()->enabled = true;
+}
+
+void DisableProfiling() {
+  GetProfilerState()->enabled = false;
+}
+
+bool IsProfilingEnabled() {
+  return GetProfilerState()->enabled;
+}
+
+void ResetProfiling() {
+  ForEachThreadProfile([](ThreadProfile& thread_profile) {
+    CHECK(thread_profile.open_events.empty())
+        << "The profile cannot be reset while a stage is open.";
+    thread_profile.events.clear();
+    thread_profile.counters.clear();
+  });
+}
+
+void AddProfileCount(const char* name, const int64_t value) {
+  if (!IsProfilingEnabled()) {
+    return;
+  }
+  ThreadProfile* thread_profile = GetThreadProfile();
+  std::lock_guard<std::mutex> lock(thread_profile->mutex);
+  thread_profile->counters[name] += value;
+}
+
+ScopedProfile::ScopedProfile(const char* name)
+    : thread_profile_(nullptr), event_index_(-1) {
+  if (!IsProfilingEnabled()) {
+    return;
+  }
+  thread_profile_ = GetThreadProfile();
+
+  ProfileEvent event;
+  event.name = name;
+  event.start_in_microseconds = MicrosecondsSinceStart();
+  event.end_in_microseconds = -1;
+  std::lock_guard<std::mutex> lock(thread_profile_->mutex);
+  event.parent = thread_profile_->open_events.empty()
+                     ? -1
+                     : thread_profile_->open_events.back();
+  event_index_ = thread_profile_->events.size();
+  thread_profile_->events.emplace_back(event);
+  thread_profile_->open_events.emplace_back(event_index_);
+}
+
+ScopedProfile::~ScopedProfile() {
+  if (thread_profile_ == nullptr) {
+    return;
+  }
+  const int64_t end_in_microseconds = MicrosecondsSinceStart();
+  std::lock_guard<std::mutex> lock(thread_profile_->mutex);
+  thread_profile_->events[event_index_].end_in_microseconds =
+      end_in_microseconds;
+  thread_profile_->open_events.pop_back();
+}
+
+std::vector<ProfileStageStatistics> GetProfileStageStatistics() {
+  std::map<std::string, ProfileStageStatistics> statistics;
+  ForEachThreadProfile([&](const ThreadProfile& thread_profile) {
+    std::vector<std::string> paths(thread_profile.events.size());
+    for (int i = 0; i < thread_profile.events.size(); i++) {
+      const ProfileEvent& event = thread_profile.events[i];
+      paths[i] = event.parent < 0 ? event.name
+                                  : paths[event.parent] + "/" + event.name;
+      if (event.end_in_microseconds < 0) {
+        continue;
+      }
+
+      const double seconds =
+          (event.end_in_microseconds - event.start_in_microseconds) * 1e-6;
+      ProfileStageStatistics& stage = statistics[paths[i]];
+      if (stage.count == 0) {
+        stage.path = paths[i];
+        stage.min_seconds = seconds;
+        stage.max_seconds = seconds;
+      }
+      ++stage.count;
+      stage.total_seconds += seconds;
+      stage.min_seconds = std::min(stage.min_seconds, seconds);
+      stage.max_seconds = std::max(stage.max_seconds, seconds);
+    }
+  });
+
+  std::vector<ProfileStageStatistics> sorted_statistics;
+  sorted_statistics.reserve(statistics.size());
+  for (const auto& stage : statistics) {
+    sorted_statistics.emplace_back(stage.second);
+  }
+  return sorted_statistics;
+}
+
+std::unordered_map<std::string, int64_t> GetProfileCounters() {
+  std::unordered_map<std::string, int64_t> counters;
+  ForEachThreadProfile([&](const ThreadProfile& thread_profile) {
+    for (const auto& counter : thread_profile.counters) {
+      counters[counter.first] += counter.second;
+    }
+  });
+  return counters;
+}
+
+bool WriteProfileToJson(const std::string& output_file) {
+  std::ofstream ofs(output_file.c_str(), std::ios::out);
+  if (!ofs.is_open()) {
+    LOG(ERROR) << "Cannot write the profile to " << output_file;
+    return false;
+  }
+
+  const std::vector<ProfileStageStatistics> statistics =
+      GetProfileStageStatistics();
+  ofs << "{\n  \"stages\": [";
+  for (int i = 0; i < statistics.size(); i++) {
+    const ProfileStageStatistics& stage = statistics[i];
+    ofs << (i == 0 ? "\n" : ",\n")
+        << StringPrintf("    {\"path\": \"%s\", \"count\": %d, "
+                        "\"total_seconds\": %.6f, \"min_seconds\": %.6f, "
+                        "\"max_seconds\": %.6f}",
+                        EscapeJsonString(stage.path).c_str(),
+                        stage.count,
+                        stage.total_seconds,
+                        stage.min_seconds,
+                        stage.max_seconds);
+  }
+  ofs << "\n  ],\n  \"counters\": {";
+
+  // Sort the counters so that the output is deterministic.
+  const std::unordered_map<std::string, int64_t> counters =
+      GetProfileCounters();
+  const std::map<std::string, int64_t> sorted_counters(counters.begin(),
+                                                       counters.end());
+  bool first_counter = true;
+  for (const auto& counter : sorted_counters) {
+    ofs << (first_counter ? "\n" : ",\n") << "    \""
+        << EscapeJsonString(counter.first) << "\": " << counter.second;
+    first_counter = false;
+  }
+  ofs << "\n  }\n}\n";
+  return ofs.good();
+}
+
+bool WriteProfileToChromeTrace(const std::string& output_file) {
+  std::ofstream ofs(output_file.c_str(), std::ios::out);
+  if (!ofs.is_open()) {
+    LOG(ERROR) << "Cannot write the profile trace to " << output_file;
+    return false;
+  }
+
+  ofs << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+  bool first_event = true;
+  int64_t end_of_trace = 0;
+  ForEachThreadProfile([&](const ThreadProfile& thread_profile) {
+    for (const ProfileEvent& event : thread_profile.events) {
+      if (event.end_in_microseconds < 0) {
+        continue;
+      }
+      ofs << (first_event ? "\n" : ",\n")
+          << StringPrintf("{\"name\": \"%s\", \"cat\": \"theia\", "
+                          "\"ph\": \"X\", \"pid\": 0, \"tid\": %d, "
+                          "\"ts\": %lld, \"dur\": %lld}",
+                          EscapeJsonString(event.name).c_str(),
+                          thread_profile.thread_index,
+                          static_cast<long long>(event.start_in_microseconds),
+                          static_cast<long long>(event.end_in_microseconds -
+                                                 event.start_in_microseconds));
+      first_event = false;
+      end_of_trace = std::max(end_of_trace, event.end_in_microseconds);
+    }
+  });
+
+  const std::unordered_map<std::string, int64_t> counters =
+      GetProfileCounters();
+  if (!counters.empty()) {
+    const std::map<std::string, int64_t> sorted_counters(counters.begin(),
+                                                         counters.end());
+    ofs << (first_event ? "\n" : ",\n")
+        << StringPrintf("{\"name\": \"counters\", \"cat\": \"theia\", "
+                        "\"ph\": \"C\", \"pid\": 0, \"ts\": %lld, \"args\": {",
+                        static_cast<long long>(end_of_trace));
+    bool first_counter = true;
+    for (const auto& counter : sorted_counters) {
+      ofs << (first_counter ? "" : ", ") << "\""
+          << EscapeJsonString(counter.first) << "\": " << counter.second;
+      first_counter = false;
+    }
+    ofs << "}}";
+  }
+  ofs << "\n]}\n";
+  return ofs.good();
+}
+
+}  // namespace theia
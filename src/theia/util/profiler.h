@@ -0,0 +1,131 @@
+// Copyright (C) 2014 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#ifndef THEIA_UTIL_PROFILER_H_
+#define THEIA_UTIL_PROFILER_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "theia/util/util.h"
+
+namespace theia {
+
+// A lightweight profiler for the stages of the reconstruction pipeline. Stages
+// are timed with ScopedProfile objects and may be nested; the statistics of a
+// stage are aggregated by its path of nested stage names, e.g.
+// "BuildReconstruction/BundleAdjustment". Each thread records into its own
+// buffer, which is only registered under a shared lock, and nesting is
+// tracked per thread (a stage that runs on a thread pool worker is a root
+// stage of that thread). Counters such as the number of RANSAC iterations are
+// summed over all threads.
+//
+// Profiling is disabled by default, in which case a ScopedProfile costs a
+// single atomic load. Typical use:
+//
+//   EnableProfiling();
+//   {
+//     ScopedProfile profile("MatchImages");
+//     ...
+//     AddProfileCount("num_putative_matches", matches.size());
+//   }
+//   WriteProfileToJson("profile.json");
+//   WriteProfileToChromeTrace("trace.json");
+//
+// NOTE: the names of the stages and counters must be string literals (or
+// otherwise outlive the profile) since only the pointers are stored.
+
+// Starts or stops recording the stages and counters. Stages that are open when
+// profiling is disabled are still recorded when they close.
+void EnableProfiling();
+void DisableProfiling();
+bool IsProfilingEnabled();
+
+// Removes all recorded stages and counters. This must not be called while any
+// stage is open.
+void ResetProfiling();
+
+// Adds the value to the counter with the given name.
+void AddProfileCount(const char* name, const int64_t value);
+
+struct ThreadProfile;
+
+// Times the lifetime of the object as a stage of the pipeline.
+class ScopedProfile {
+ public:
+  explicit ScopedProfile(const char* name);
+  ~ScopedProfile();
+
+ private:
+  // The buffer of the thread that the stage is recorded in, or null if
+  // profiling was disabled when the stage was opened.
+  ThreadProfile* thread_profile_;
+  int event_index_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedProfile);
+};
+
+// The aggregated timings of all closed stages with the same path.
+struct ProfileStageStatistics {
+  std::string path;
+  int count = 0;
+  double total_seconds = 0.0;
+  double min_seconds = 0.0;
+  double max_seconds = 0.0;
+};
+
+// Returns the statistics of the recorded stages sorted by path.
+std::vector<ProfileStageStatistics> GetProfileStageStatistics();
+
+// Returns the counters summed over all threads.
+std::unordered_map<std::string, int64_t> GetProfileCounters();
+
+// Writes the stage statistics and counters as a JSON object of the form
+//   {"stages": [{"path": ..., "count": ..., "total_seconds": ...,
+//                "min_seconds": ..., "max_seconds": ...}, ...],
+//    "counters": {"name": value, ...}}
+// Returns false if the file could not be written.
+bool WriteProfileToJson(const std::string& output_file);
+
+// Writes every recorded stage as a complete event of the Chrome trace event
+// format so that the timeline of the threads can be inspected in
+// chrome://tracing or Perfetto. The counters are written as a counter event at
+// the end of the trace. Returns false if the file could not be written.
+bool WriteProfileToChromeTrace(const std::string& output_file);
+
+}  // namespace theia
+
+#endif  // THEIA_UTIL_PROFILER_H_
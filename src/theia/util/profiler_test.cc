@@ -0,0 +1,161 @@
+// Copyright (C) 2014 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include "theia/util/profiler.h"
+
+#include <stdio.h>
+#include <chrono>  // NOLINT
+#include <fstream>  // NOLINT
+#include <sstream>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "theia/util/threadpool.h"
+
+namespace theia {
+
+namespace {
+
+// Returns the statistics of the stage with the given path, or null if the
+// stage was not recorded.
+const ProfileStageStatistics* FindStage(
+    const std::vector<ProfileStageStatistics>& statistics,
+    const std::string& path) {
+  for (const ProfileStageStatistics& stage : statistics) {
+    if (stage.path == path) {
+      return &stage;
+    }
+  }
+  return nullptr;
+}
+
+void ProfileNestedStages() {
+  ScopedProfile outer_profile("Outer");
+  for (int i = 0; i < 3; i++) {
+    ScopedProfile inner_profile("Inner");
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+}  // namespace
+
+TEST(Profiler, DisabledRecordsNothing) {
+  DisableProfiling();
+  ResetProfiling();
+  ProfileNestedStages();
+  AddProfileCount("count", 1);
+  EXPECT_TRUE(GetProfileStageStatistics().empty());
+  EXPECT_TRUE(GetProfileCounters().empty());
+}
+
+TEST(Profiler, NestedStages) {
+  ResetProfiling();
+  EnableProfiling();
+  ProfileNestedStages();
+  DisableProfiling();
+
+  const std::vector<ProfileStageStatistics> statistics =
+      GetProfileStageStatistics();
+  ASSERT_EQ(statistics.size(), 2);
+  const ProfileStageStatistics* outer = FindStage(statistics, "Outer");
+  const ProfileStageStatistics* inner = FindStage(statistics, "Outer/Inner");
+  ASSERT_TRUE(outer != nullptr);
+  ASSERT_TRUE(inner != nullptr);
+  EXPECT_EQ(outer->count, 1);
+  EXPECT_EQ(inner->count, 3);
+  EXPECT_GE(inner->min_seconds, 1e-3);
+  EXPECT_LE(inner->min_seconds, inner->max_seconds);
+  EXPECT_LE(inner->total_seconds, outer->total_seconds);
+}
+
+TEST(Profiler, CountersAreSummedOverThreads) {
+  static const int kNumTasks = 16;
+  ResetProfiling();
+  EnableProfiling();
+  {
+    ThreadPool pool(4);
+    for (int i = 0; i < kNumTasks; i++) {
+      pool.Add([i]() {
+        ScopedProfile profile("Task");
+        AddProfileCount("num_tasks", 1);
+        AddProfileCount("task_ids", i);
+      });
+    }
+  }
+  DisableProfiling();
+
+  const std::unordered_map<std::string, int64_t> counters =
+      GetProfileCounters();
+  EXPECT_EQ(counters.at("num_tasks"), kNumTasks);
+  EXPECT_EQ(counters.at("task_ids"), kNumTasks * (kNumTasks - 1) / 2);
+
+  // The tasks are root stages of the worker threads.
+  const std::vector<ProfileStageStatistics> statistics =
+      GetProfileStageStatistics();
+  const ProfileStageStatistics* task = FindStage(statistics, "Task");
+  ASSERT_TRUE(task != nullptr);
+  EXPECT_EQ(task->count, kNumTasks);
+}
+
+TEST(Profiler, WriteJsonAndChromeTrace) {
+  ResetProfiling();
+  EnableProfiling();
+  ProfileNestedStages();
+  AddProfileCount("num_\"quoted\"", 7);
+  DisableProfiling();
+
+  const std::string json_file = "/tmp/theia_profiler_test.json";
+  const std::string trace_file = "/tmp/theia_profiler_test_trace.json";
+  ASSERT_TRUE(WriteProfileToJson(json_file));
+  ASSERT_TRUE(WriteProfileToChromeTrace(trace_file));
+
+  std::stringstream json;
+  json << std::ifstream(json_file.c_str()).rdbuf();
+  EXPECT_NE(json.str().find("\"path\": \"Outer/Inner\", \"count\": 3"),
+            std::string::npos);
+  EXPECT_NE(json.str().find("\"num_\\\"quoted\\\"\": 7"), std::string::npos);
+
+  std::stringstream trace;
+  trace << std::ifstream(trace_file.c_str()).rdbuf();
+  EXPECT_NE(trace.str().find("\"name\": \"Inner\""), std::string::npos);
+  EXPECT_NE(trace.str().find("\"ph\": \"C\""), std::string::npos);
+
+  remove(json_file.c_str());
+  remove(trace_file.c_str());
+}
+
+}  // namespace theia
@@ -35,37 +35,147 @@
 #include "theia/util/random.h"
 
 #include <glog/logging.h>
+#include <atomic>
+#include <limits>
 #include <chrono>
+#include <mutex>
 #include <random>
 
 namespace theia {
 namespace {
-std::default_random_engine util_generator;
+
+// The SplitMix64 generator is used to expand a seed into the state of the
+// xoshiro256** generator as recommended by its authors.
+uint64_t SplitMix64(uint64_t* state) {
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+inline uint64_t RotateLeft(const uint64_t x, const int k) {
+  return (x << k) | (x >> (64 - k));
+}
+
+// Generators that are seeded from the time at the same moment (e.g., by
+// parallel threads) would produce the same random numbers, so the time is
+// combined with a counter.
+std::atomic<uint64_t> num_time_seeds(0);
+uint64_t TimeSeed() {
+  uint64_t counter = num_time_seeds++;
+  return std::chrono::high_resolution_clock::now().time_since_epoch().count() ^
+         SplitMix64(&counter);
+}
+
+std::mutex util_generator_mutex;
+RandomNumberGenerator util_generator;
+
 }  // namespace
 
+RandomNumberGenerator::RandomNumberGenerator() {
+  Seed(TimeSeed());
+}
+
+RandomNumberGenerator::RandomNumberGenerator(const uint64_t seed) {
+  Seed(seed);
+}
+
+RandomNumberGenerator::RandomNumberGenerator(const uint64_t seed,
+                                             const uint64_t task_id) {
+  Seed(seed, task_id);
+}
+
+void RandomNumberGenerator::Seed(const uint64_t seed) {
+  uint64_t splitmix_state = seed;
+  for (int i = 0; i < 4; i++) {
+    state_[i] = SplitMix64(&splitmix_state);
+  }
+}
+
+void RandomNumberGenerator::Seed(const uint64_t seed, const uint64_t task_id) {
+  // Hash the task id before combining it with the seed so that the seeds of
+  // consecutive tasks (and of consecutive runs) do not overlap.
+  uint64_t task_state = task_id;
+  Seed(seed ^ SplitMix64(&task_state));
+}
+
+RandomNumberGenerator::result_type RandomNumberGenerator::operator()() {
+  const uint64_t result = RotateLeft(state_[1] * 5, 7) * 9;
+  const uint64_t t = state_[1] << 17;
+  state_[2] ^= state_[0];
+  state_[3] ^= state_[1];
+  state_[1] ^= state_[2];
+  state_[0] ^= state_[3];
+  state_[2] ^= t;
+  state_[3] = RotateLeft(state_[3], 45);
+  return result;
+}
+
+double RandomNumberGenerator::RandDouble(const double lower,
+                                         const double upper) {
+  // Use the upper 53 bits for the mantissa of a double in [0, 1).
+  const double uniform = ((*this)() >> 11) * (1.0 / (1ULL << 53));
+  return lower + (upper - lower) * uniform;
+}
+
+int RandomNumberGenerator::RandInt(const int lower, const int upper) {
+  DCHECK_LE(lower, upper);
+  const uint64_t range = static_cast<int64_t>(upper) - lower + 1;
+  // The full range of int is covered by 32 random bits.
+  if (range > std::numeric_limits<uint32_t>::max()) {
+    return static_cast<int>(lower + static_cast<int64_t>((*this)() >> 32));
+  }
+
+  // Lemire's nearly divisionless method maps 32 random bits to the range
+  // without a modulo bias. The rejection threshold is 2^32 mod range, so the
+  // arithmetic must be done in 32 bits.
+  const uint32_t range32 = static_cast<uint32_t>(range);
+  uint64_t product = ((*this)() >> 32) * range32;
+  uint32_t low_bits = static_cast<uint32_t>(product);
+  if (low_bits < range32) {
+    const uint32_t threshold = (0u - range32) % range32;
+    while (low_bits < threshold) {
+      product = ((*this)() >> 32) * range32;
+      low_bits = static_cast<uint32_t>(product);
+    }
+  }
+  return static_cast<int>(lower + static_cast<int64_t>(product >> 32));
+}
+
+double RandomNumberGenerator::RandGaussian(const double mean,
+                                           const double std_dev) {
+  std::normal_distribution<double> distribution(mean, std_dev);
+  return distribution(*this);
+}
+
 // Initializes the random generator to be based on the current time. Does not
 // have to be called before calling RandDouble, but it works best if it is.
 void InitRandomGenerator() {
-  unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
-  util_generator.seed(seed);
+  std::lock_guard<std::mutex> lock(util_generator_mutex);
+  util_generator.Seed(TimeSeed());
+}
+
+void InitRandomGenerator(const uint64_t seed) {
+  std::lock_guard<std::mutex> lock(util_generator_mutex);
+  util_generator.Seed(seed);
 }
 
 // Get a random double between lower and upper (inclusive).
 double RandDouble(double lower, double upper) {
-  std::uniform_real_distribution<double> distribution(lower, upper);
-  return distribution(util_generator);
+  std::lock_guard<std::mutex> lock(util_generator_mutex);
+  return util_generator.RandDouble(lower, upper);
 }
 
 // Get a random int between lower and upper (inclusive).
 int RandInt(int lower, int upper) {
-  std::uniform_int_distribution<int> distribution(lower, upper);
-  return distribution(util_generator);
+  std::lock_guard<std::mutex> lock(util_generator_mutex);
+  return util_generator.RandInt(lower, upper);
 }
 
 // Gaussian Distribution with the corresponding mean and std dev.
 double RandGaussian(double mean, double std_dev) {
-  std::normal_distribution<double> distribution(mean, std_dev);
-  return distribution(util_generator);
+  std::lock_guard<std::mutex> lock(util_generator_mutex);
+  return util_generator.RandGaussian(mean, std_dev);
 }
 
 }  // namespace theia
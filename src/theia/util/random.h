@@ -35,11 +35,64 @@
 #ifndef THEIA_UTIL_RANDOM_H_
 #define THEIA_UTIL_RANDOM_H_
 
+#include <stdint.h>
+#include <limits>
+
 namespace theia {
+
+// A fast random number generator (xoshiro256**) that can be seeded
+// deterministically. The generator is not thread-safe: each thread or task
+// should own a generator so that the random numbers neither contend for a
+// shared state nor depend on the scheduling of the threads. Generators for
+// parallel tasks should be created from the seed of the run and the id of the
+// task, which gives independent and reproducible random numbers for each task.
+//
+// The class models a uniform random bit generator so it may be used with the
+// distributions and algorithms of the standard library.
+class RandomNumberGenerator {
+ public:
+  typedef uint64_t result_type;
+
+  // Seeds the generator from the current time.
+  RandomNumberGenerator();
+  explicit RandomNumberGenerator(const uint64_t seed);
+  // Seeds the generator from the seed of the run and the id of a task.
+  RandomNumberGenerator(const uint64_t seed, const uint64_t task_id);
+
+  void Seed(const uint64_t seed);
+  void Seed(const uint64_t seed, const uint64_t task_id);
+
+  // Get a random double between lower and upper (inclusive).
+  double RandDouble(const double lower, const double upper);
+
+  // Get a random int between lower and upper (inclusive).
+  int RandInt(const int lower, const int upper);
+
+  // Generate a number drawn from a gaussian distribution.
+  double RandGaussian(const double mean, const double std_dev);
+
+  // Returns 64 random bits.
+  result_type operator()();
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+
+ private:
+  uint64_t state_[4];
+};
+
+// The functions below use a single generator that is shared by all threads and
+// guarded by a mutex. Code that runs in parallel should use its own
+// RandomNumberGenerator instead.
+
 // Initializes the random generator to be based on the current time. Does not
 // have to be called before calling RandDouble, but it works best if it is.
 void InitRandomGenerator();
 
+// Initializes the random generator with the given seed.
+void InitRandomGenerator(const uint64_t seed);
+
 // Get a random double between lower and upper (inclusive).
 double RandDouble(double lower, double upper);
 
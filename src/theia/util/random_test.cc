@@ -0,0 +1,166 @@
+// Copyright (C) 2015 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include "theia/util/random.h"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace theia {
+
+TEST(RandomNumberGenerator, SameSeedGivesSameNumbers) {
+  const int kNumSamples = 1000;
+  RandomNumberGenerator rng1(42);
+  RandomNumberGenerator rng2(42);
+  for (int i = 0; i < kNumSamples; i++) {
+    EXPECT_EQ(rng1(), rng2());
+  }
+
+  // Reseeding restarts the sequence.
+  RandomNumberGenerator rng3(7);
+  const double first_number = rng3.RandDouble(0.0, 1.0);
+  rng3.Seed(7);
+  EXPECT_EQ(rng3.RandDouble(0.0, 1.0), first_number);
+}
+
+TEST(RandomNumberGenerator, TasksGetDifferentNumbers) {
+  const int kNumTasks = 8;
+  std::vector<RandomNumberGenerator::result_type> first_numbers;
+  for (int i = 0; i < kNumTasks; i++) {
+    RandomNumberGenerator rng(42, i);
+    first_numbers.emplace_back(rng());
+    for (int j = 0; j < i; j++) {
+      EXPECT_NE(first_numbers[i], first_numbers[j]);
+    }
+
+    // The generator of a task is reproducible.
+    RandomNumberGenerator same_rng(42, i);
+    EXPECT_EQ(same_rng(), first_numbers[i]);
+  }
+}
+
+TEST(RandomNumberGenerator, TimeSeededGeneratorsDiffer) {
+  RandomNumberGenerator rng1;
+  RandomNumberGenerator rng2;
+  EXPECT_NE(rng1(), rng2());
+}
+
+TEST(RandomNumberGenerator, RandIntIsInRangeAndUniform) {
+  const int kNumSamples = 100000;
+  const int kLower = -3;
+  const int kUpper = 6;
+  RandomNumberGenerator rng(1);
+  std::vector<int> histogram(kUpper - kLower + 1, 0);
+  for (int i = 0; i < kNumSamples; i++) {
+    const int number = rng.RandInt(kLower, kUpper);
+    ASSERT_GE(number, kLower);
+    ASSERT_LE(number, kUpper);
+    ++histogram[number - kLower];
+  }
+
+  const double expected_count =
+      static_cast<double>(kNumSamples) / histogram.size();
+  for (const int count : histogram) {
+    EXPECT_NEAR(count, expected_count, 0.05 * expected_count);
+  }
+
+  EXPECT_EQ(rng.RandInt(5, 5), 5);
+}
+
+TEST(RandomNumberGenerator, RandIntHistogramOfNonPowerOfTwoRange) {
+  // The rejection threshold of the sampler depends on the range, so check a
+  // small range that is not a power of two with a chi-square test.
+  const int kNumSamples = 700000;
+  const int kRange = 7;
+  RandomNumberGenerator rng(7);
+  std::vector<int> histogram(kRange, 0);
+  for (int i = 0; i < kNumSamples; i++) {
+    ++histogram[rng.RandInt(0, kRange - 1)];
+  }
+
+  const double expected_count = static_cast<double>(kNumSamples) / kRange;
+  double chi_square = 0.0;
+  for (const int count : histogram) {
+    chi_square +=
+        (count - expected_count) * (count - expected_count) / expected_count;
+  }
+  // The 0.999 quantile of the chi-square distribution with 6 degrees of
+  // freedom.
+  EXPECT_LT(chi_square, 22.458);
+}
+
+TEST(RandomNumberGenerator, RandIntCoversTheFullRange) {
+  RandomNumberGenerator rng(3);
+  bool has_negative = false, has_positive = false;
+  for (int i = 0; i < 100; i++) {
+    const int number = rng.RandInt(std::numeric_limits<int>::min(),
+                                   std::numeric_limits<int>::max());
+    has_negative |= number < 0;
+    has_positive |= number > 0;
+  }
+  EXPECT_TRUE(has_negative);
+  EXPECT_TRUE(has_positive);
+}
+
+TEST(RandomNumberGenerator, RandDoubleAndRandGaussian) {
+  const int kNumSamples = 100000;
+  RandomNumberGenerator rng(2);
+  double sum = 0.0;
+  double gaussian_sum = 0.0;
+  double gaussian_sq_sum = 0.0;
+  for (int i = 0; i < kNumSamples; i++) {
+    const double number = rng.RandDouble(-1.0, 3.0);
+    ASSERT_GE(number, -1.0);
+    ASSERT_LE(number, 3.0);
+    sum += number;
+
+    const double gaussian = rng.RandGaussian(2.0, 0.5);
+    gaussian_sum += gaussian;
+    gaussian_sq_sum += gaussian * gaussian;
+  }
+
+  const double kTolerance = 0.02;
+  EXPECT_NEAR(sum / kNumSamples, 1.0, kTolerance);
+  const double gaussian_mean = gaussian_sum / kNumSamples;
+  EXPECT_NEAR(gaussian_mean, 2.0, kTolerance);
+  EXPECT_NEAR(
+      std::sqrt(gaussian_sq_sum / kNumSamples - gaussian_mean * gaussian_mean),
+      0.5,
+      kTolerance);
+}
+
+}  // namespace theia